@@ -33,6 +33,8 @@
 #include <string>
 #include <sstream>
 #include <cstdlib>
+#include <cstring>
+#include <cmath>
 
 #include "benching.hpp"
 #include "stenos/stenos.h"
@@ -41,6 +43,15 @@
 #include "blosc2.h"
 // #endif
 
+#ifdef STENOS_STATIC
+// Internal routines, only reachable when linking the static library
+#include "stenos/internal/shuffle-generic.h"
+#include "stenos/internal/shuffle-avx2.h"
+#include "stenos/internal/shuffle-avx512.h"
+#include "stenos/internal/delta.h"
+#include "stenos/internal/simd.h"
+#endif
+
 /* template<int rshift>
 int get_value(int i)
 {
@@ -268,6 +279,219 @@ void test_time_limited(const std::vector<T>& vec, unsigned threads)
 	}
 }
 
+#ifdef STENOS_STATIC
+
+/// @brief Compare shuffle/unshuffle implementations and measure byte delta throughput.
+/// Block sizes of 256 elements are the ones used by the block codec.
+static void bench_simd()
+{
+	static constexpr size_t width = 16;
+	using shuffle_fn = void (*)(int32_t, int32_t, const uint8_t*, uint8_t*);
+	struct Impl
+	{
+		const char* name;
+		shuffle_fn shuffle;
+		shuffle_fn unshuffle;
+		bool available;
+	};
+	const auto& f = stenos::cpu_features();
+	const Impl impls[] = { { "generic", (shuffle_fn)shuffle_generic, (shuffle_fn)unshuffle_generic, true },
+			       { "avx2", (shuffle_fn)shuffle_avx2, (shuffle_fn)unshuffle_avx2, f.HAS_AVX2 },
+			       { "avx512", (shuffle_fn)shuffle_avx512, (shuffle_fn)unshuffle_avx512, f.HAS_AVX2 && f.HAS_AVX512BW && f.HAS_AVX512VBMI } };
+
+	std::mt19937 rng(0);
+	std::vector<uint8_t> src(1 << 20), dst(src.size()), out(src.size());
+	for (auto& v : src)
+		v = (uint8_t)(rng() & 15);
+
+	// Returns throughput in GB/s
+	auto gbs = [](size_t bytes, size_t count, double ns) { return (double)(bytes * count) / ns; };
+	stenos::timer t;
+
+	std::cout << "Shuffle/unshuffle throughput (GB/s)" << std::endl;
+	std::cout << "|" << as_aligned_string(width, "bytesoftype") << "|" << as_aligned_string(width, "block") << "|";
+	for (const Impl& impl : impls)
+		std::cout << as_aligned_string(width, "%s", impl.name) << "|";
+	std::cout << std::endl << "|";
+	for (size_t i = 0; i < 2 + sizeof(impls) / sizeof(impls[0]); ++i)
+		std::cout << std::string(width, '-') << "|";
+	std::cout << std::endl;
+
+	for (int32_t bt : { 2, 4, 8 }) {
+		for (size_t block : { (size_t)bt * 256, src.size() }) {
+			const size_t count = (size_t)(1 << 28) / block;
+			std::cout << "|" << as_aligned_string(width, "%d", bt) << "|" << as_aligned_string(width, "%d", (int)block) << "|";
+			for (const Impl& impl : impls) {
+				if (!impl.available) {
+					std::cout << as_aligned_string(width, "-") << "|";
+					continue;
+				}
+				t.tick();
+				for (size_t i = 0; i < count; ++i)
+					impl.shuffle(bt, (int32_t)block, src.data(), dst.data());
+				double s = gbs(block, count, (double)t.tock());
+				t.tick();
+				for (size_t i = 0; i < count; ++i)
+					impl.unshuffle(bt, (int32_t)block, dst.data(), out.data());
+				double u = gbs(block, count, (double)t.tock());
+				if (memcmp(src.data(), out.data(), block) != 0)
+					std::cout << as_aligned_string(width, "error") << "|";
+				else
+					std::cout << as_aligned_string(width, "%.1f / %.1f", s, u) << "|";
+			}
+			std::cout << std::endl;
+		}
+	}
+
+	// Byte delta, using the best available instruction set
+	const size_t count = (size_t)(1 << 28) / src.size();
+	t.tick();
+	for (size_t i = 0; i < count; ++i)
+		stenos::delta(src.data(), dst.data(), src.size());
+	double d = gbs(src.size(), count, (double)t.tock());
+	t.tick();
+	for (size_t i = 0; i < count; ++i)
+		stenos::delta_inv(dst.data(), out.data(), src.size());
+	double di = gbs(src.size(), count, (double)t.tock());
+	std::cout << "Byte delta: " << d << " GB/s, inverse: " << di << " GB/s" << (memcmp(src.data(), out.data(), src.size()) ? " (error)" : "") << std::endl << std::endl;
+}
+#endif
+
+/// @brief Decompression of many small (128KB) frames, with and without context reuse.
+/// A reused context keeps its zstd decompression contexts across frames.
+static void bench_small_frames()
+{
+	static constexpr size_t frame_size = 128 * 1024;
+	static constexpr size_t frame_count = 256;
+
+	std::mt19937 rng(0);
+	std::cout << "Decompression of " << frame_count << " frames of " << frame_size / 1024 << "KB (MB/s)" << std::endl;
+	for (size_t bytesoftype : { 1, 4 }) {
+		// Build frames of small random values
+		std::vector<uint8_t> src(frame_size * frame_count);
+		for (auto& v : src)
+			v = (uint8_t)(rng() % 16 + 'a');
+		stenos_context* ctx = stenos_make_context();
+		stenos_set_level(ctx, 5);
+		std::vector<std::vector<char>> frames(frame_count);
+		for (size_t i = 0; i < frame_count; ++i) {
+			frames[i].resize(stenos_bound(frame_size));
+			size_t r = stenos_compress_generic(ctx, src.data() + i * frame_size, bytesoftype, frame_size, frames[i].data(), frames[i].size());
+			frames[i].resize(r);
+		}
+
+		std::vector<uint8_t> out(frame_size);
+		stenos::timer t;
+		t.tick();
+		for (size_t i = 0; i < frame_count; ++i)
+			stenos_decompress_generic(ctx, frames[i].data(), bytesoftype, frames[i].size(), out.data(), out.size());
+		double reused = (double)(frame_size * frame_count) / (t.tock() * 1e-3);
+		t.tick();
+		for (size_t i = 0; i < frame_count; ++i)
+			stenos_decompress(frames[i].data(), bytesoftype, frames[i].size(), out.data(), out.size());
+		double fresh = (double)(frame_size * frame_count) / (t.tock() * 1e-3);
+		std::cout << "bytesoftype " << bytesoftype << ": reused context " << (int)reused << ", new context " << (int)fresh
+			  << ", footprint " << stenos_memory_footprint(ctx) / 1024 << "KB" << std::endl;
+		stenos_destroy_context(ctx);
+	}
+	std::cout << std::endl;
+}
+
+/// @brief Measured decompression speed of each superblock mode, compared to
+/// the estimates returned by stenos_mode_decompression_speed(), and effect of
+/// stenos_set_min_decompression_speed() on the compression ratio and decompression speed.
+static void bench_decompression_modes()
+{
+	static constexpr size_t width = 12;
+	static constexpr size_t count = 1 << 22;
+	std::mt19937 rng(0);
+
+	// Sinusoid with noise, small integers and text-like bytes
+	std::vector<float> floats(count);
+	for (size_t i = 0; i < count; ++i)
+		floats[i] = std::sin((float)i * 0.001f) * 100.f + (float)(rng() % 16) * 0.01f;
+	std::vector<int> ints(count);
+	for (size_t i = 0; i < count; ++i)
+		ints[i] = (int)(rng() % 64) - 20;
+	std::vector<char> text(count * 4);
+	const char* words[] = { "the ", "quick ", "brown ", "fox ", "jumps ", "over ", "lazy ", "dog\n" };
+	for (size_t i = 0; i < text.size();) {
+		const char* w = words[rng() % 8];
+		for (; *w && i < text.size(); ++w)
+			text[i++] = *w;
+	}
+	struct Input
+	{
+		const char* name;
+		const void* data;
+		size_t bytesoftype;
+	};
+	const Input inputs[] = { { "floats", floats.data(), 4 }, { "ints", ints.data(), 4 }, { "text", text.data(), 1 } };
+	const size_t bytes = count * 4;
+	std::vector<char> dst(stenos_bound(bytes)), out(bytes);
+	stenos::timer t;
+
+	// Decompression speed per superblock mode (MB/s)
+	double mode_bytes[11] = { 0 }, mode_ns[11] = { 0 };
+	for (const Input& in : inputs) {
+		for (int level = 1; level <= 9; level += 2) {
+			stenos_context* ctx = stenos_make_context();
+			stenos_set_level(ctx, level);
+			size_t r = stenos_compress_generic(ctx, in.data, in.bytesoftype, bytes, dst.data(), dst.size());
+			stenos_info info;
+			stenos_get_info(dst.data(), in.bytesoftype, r, &info);
+			for (size_t i = 0; i < info.superblock_count; ++i) {
+				stenos_superblock_info sinfo;
+				stenos_get_superblock_info(dst.data(), in.bytesoftype, r, i, &sinfo);
+				t.tick();
+				stenos_decompress_range(ctx, dst.data(), in.bytesoftype, r, sinfo.decompressed_offset, sinfo.decompressed_size, out.data());
+				mode_ns[sinfo.mode] += (double)t.tock();
+				mode_bytes[sinfo.mode] += (double)sinfo.decompressed_size;
+			}
+			stenos_destroy_context(ctx);
+		}
+	}
+	const char* names[11] = { "", "block", "zstd", "tr_zstd", "tr_delta", "block_zstd", "copy", "xor_zstd", "int_delta", "int_delta2", "fields" };
+	std::cout << "Decompression speed per mode (MB/s)" << std::endl;
+	std::cout << "|" << as_aligned_string(width, "mode") << "|" << as_aligned_string(width, "measured") << "|" << as_aligned_string(width, "estimated") << "|" << std::endl;
+	std::cout << "|" << std::string(width, '-') << "|" << std::string(width, '-') << "|" << std::string(width, '-') << "|" << std::endl;
+	for (int m = STENOS_MODE_BLOCK; m <= STENOS_MODE_FIELDS; ++m) {
+		std::cout << "|" << as_aligned_string(width, "%s", names[m]) << "|";
+		if (mode_ns[m] > 0)
+			std::cout << as_aligned_string(width, "%d", (int)(mode_bytes[m] * 1000. / mode_ns[m])) << "|";
+		else
+			std::cout << as_aligned_string(width, "-") << "|";
+		std::cout << as_aligned_string(width, "%d", (int)(stenos_mode_decompression_speed(m) / 1000000)) << "|" << std::endl;
+	}
+
+	// Ratio and decompression speed for different minimum decompression speeds at level 5
+	std::cout << std::endl << "Minimum decompression speed at level 5: ratio / decompression speed (MB/s)" << std::endl;
+	const uint64_t speeds[] = { 0, 1100000000ull, 1700000000ull, 2000000000ull };
+	std::cout << "|" << as_aligned_string(width, "input") << "|";
+	for (uint64_t speed : speeds)
+		std::cout << as_aligned_string(width, "%d MB/s", (int)(speed / 1000000)) << "|";
+	std::cout << std::endl << "|" << std::string(width, '-') << "|";
+	for (size_t i = 0; i < sizeof(speeds) / sizeof(speeds[0]); ++i)
+		std::cout << std::string(width, '-') << "|";
+	std::cout << std::endl;
+	for (const Input& in : inputs) {
+		std::cout << "|" << as_aligned_string(width, "%s", in.name) << "|";
+		for (uint64_t speed : speeds) {
+			stenos_context* ctx = stenos_make_context();
+			stenos_set_level(ctx, 5);
+			stenos_set_min_decompression_speed(ctx, speed);
+			size_t r = stenos_compress_generic(ctx, in.data, in.bytesoftype, bytes, dst.data(), dst.size());
+			t.tick();
+			stenos_decompress_generic(ctx, dst.data(), in.bytesoftype, r, out.data(), out.size());
+			double el = (double)t.tock();
+			std::cout << as_aligned_string(width, "%.2f / %d", (double)bytes / r, (int)(bytes * 1000. / el)) << "|";
+			stenos_destroy_context(ctx);
+		}
+		std::cout << std::endl;
+	}
+	std::cout << std::endl;
+}
+
 static unsigned STENOS_THREADS = 1;
 
 template<size_t N, class Type = void>
@@ -297,6 +521,13 @@ int bench_all(int, char** const)
 			STENOS_THREADS = 1;
 	}
 
+#ifdef STENOS_STATIC
+	stenos::print_simd_features();
+	bench_simd();
+#endif
+	bench_small_frames();
+	bench_decompression_modes();
+
 	blosc1_set_compressor("zstd");
 
 	bench_file<1>(STENOS_DATA_DIR "/dataset/1_javascript.js");
@@ -0,0 +1,713 @@
+/**
+ * MIT License
+ *
+ * Copyright (c) 2025 Victor Moncada <vtr.moncada@gmail.com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+// Reproducible benchmark of the stenos library.
+//
+// Compresses and decompresses each input file for all combinations of
+// level x threads x bytesoftype x superblock size, and measures cvector
+// sequential and random access on the same data.
+// Results are printed as a table and optionally written as JSON (one result
+// per line) and CSV. A previous JSON output can be given as baseline, in which
+// case the program reports regressions and returns 1 if any.
+//
+// Usage: stenos_bench [options] [files or directories...]
+// See print_usage() for the list of options.
+
+#include <vector>
+#include <string>
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <random>
+#include <algorithm>
+#include <thread>
+#include <cstring>
+#include <cstdlib>
+#include <cstdio>
+#include <cstdint>
+
+#ifdef _WIN32
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#include <windows.h>
+#else
+#include <dirent.h>
+#include <sys/stat.h>
+#endif
+
+#include "benching.hpp"
+#include "stenos/stenos.h"
+#include "stenos/cvector.hpp"
+#include "stenos/timer.hpp"
+
+#ifdef max
+#undef min
+#undef max
+#endif
+
+/// @brief Benchmark options, see print_usage()
+struct Options
+{
+	std::vector<std::string> inputs;
+	std::vector<int> levels{ 1, 3, 5, 7, 9 };
+	std::vector<int> threads;
+	std::vector<size_t> bytesoftypes{ 0 };		      // 0 means the file bytesoftype
+	std::vector<size_t> block_shifts{ STENOS_NO_BLOCK_SHIFT }; // STENOS_NO_BLOCK_SHIFT means default superblock size
+	int iterations{ 0 };				      // 0 means automatic
+	double min_time{ 0.2 };				      // minimum measurement time in seconds when iterations is 0
+	bool cvector{ true };
+	std::string json;
+	std::string csv;
+	std::string baseline;
+	double tolerance{ 0.1 };
+};
+
+/// @brief Input file
+struct Input
+{
+	std::string name;
+	size_t bytesoftype{ 1 };
+	std::vector<char> data;
+};
+
+/// @brief Single benchmark result.
+/// Key fields identify the configuration, metrics are compared against the baseline.
+struct Result
+{
+	std::string kind; // "frame" or "cvector"
+	std::string file;
+	std::string op; // cvector operation
+	size_t bytesoftype{ 0 };
+	long long block_shift{ -1 };
+	int level{ 0 };
+	int threads{ 0 };
+	size_t bytes{ 0 };
+
+	// frame metrics
+	size_t compressed{ 0 };
+	double ratio{ 0 };
+	double comp_gbs{ 0 };
+	double decomp_gbs{ 0 };
+	double comp_p50_us{ 0 };
+	double comp_p99_us{ 0 };
+	double decomp_p50_us{ 0 };
+	double decomp_p99_us{ 0 };
+	double comp_efficiency{ 1 };
+	double decomp_efficiency{ 1 };
+
+	// cvector metrics
+	double ns_per_element{ 0 };
+	double melem_s{ 0 };
+
+	std::string key() const
+	{
+		std::ostringstream oss;
+		oss << kind << "/" << file << "/" << op << "/" << bytesoftype << "/" << block_shift << "/" << level << "/" << threads;
+		return oss.str();
+	}
+};
+
+static void print_usage()
+{
+	std::cout << "Usage: stenos_bench [options] [files or directories...]" << std::endl
+		  << "Without input, the stenos_dataset files are used." << std::endl
+		  << "File names starting with '<N>_' use N as bytesoftype, '.txt' files contain numerical values." << std::endl
+		  << "Options:" << std::endl
+		  << "  --levels=L1,L2...         compression levels (default 1,3,5,7,9)" << std::endl
+		  << "  --threads=T1,T2...        thread counts (default powers of 2 up to the hardware concurrency)" << std::endl
+		  << "  --bytesoftype=B1,B2...    bytesoftype values, 0 for the file one (default 0)" << std::endl
+		  << "  --block-shift=S1,S2...    superblock size as block shift (see stenos_set_block_size()), 'auto' for default (default auto)" << std::endl
+		  << "  --iterations=N            calls per measurement, 0 for automatic (default 0)" << std::endl
+		  << "  --min-time=S              minimum measurement time in seconds with automatic iterations (default 0.2)" << std::endl
+		  << "  --no-cvector              disable cvector benchmarks" << std::endl
+		  << "  --json=FILE               write results as JSON" << std::endl
+		  << "  --csv=FILE                write results as CSV" << std::endl
+		  << "  --baseline=FILE           compare against a previous JSON output, return 1 on regression" << std::endl
+		  << "  --tolerance=F             relative throughput loss tolerated against the baseline (default 0.1)" << std::endl;
+}
+
+template<class T>
+static bool parse_list(const std::string& str, std::vector<T>& out)
+{
+	out.clear();
+	std::istringstream iss(str);
+	std::string item;
+	while (std::getline(iss, item, ',')) {
+		if (item == "auto") {
+			out.push_back((T)STENOS_NO_BLOCK_SHIFT);
+			continue;
+		}
+		std::istringstream tmp(item);
+		long long val;
+		tmp >> val;
+		if (!tmp || val < 0)
+			return false;
+		out.push_back((T)val);
+	}
+	return !out.empty();
+}
+
+static bool parse_options(int argc, char** argv, Options& opts)
+{
+	for (int i = 1; i < argc; ++i) {
+		std::string arg = argv[i];
+		std::string value;
+		auto pos = arg.find('=');
+		if (pos != std::string::npos) {
+			value = arg.substr(pos + 1);
+			arg = arg.substr(0, pos);
+		}
+		bool ok = true;
+		if (arg == "--levels")
+			ok = parse_list(value, opts.levels);
+		else if (arg == "--threads")
+			ok = parse_list(value, opts.threads);
+		else if (arg == "--bytesoftype")
+			ok = parse_list(value, opts.bytesoftypes);
+		else if (arg == "--block-shift")
+			ok = parse_list(value, opts.block_shifts);
+		else if (arg == "--iterations")
+			opts.iterations = atoi(value.c_str());
+		else if (arg == "--min-time")
+			opts.min_time = atof(value.c_str());
+		else if (arg == "--no-cvector")
+			opts.cvector = false;
+		else if (arg == "--json")
+			opts.json = value;
+		else if (arg == "--csv")
+			opts.csv = value;
+		else if (arg == "--baseline")
+			opts.baseline = value;
+		else if (arg == "--tolerance")
+			opts.tolerance = atof(value.c_str());
+		else if (arg == "--help" || arg == "-h")
+			return false;
+		else if (arg.size() > 1 && arg[0] == '-' && arg[1] == '-')
+			ok = false;
+		else
+			opts.inputs.push_back(argv[i]);
+		if (!ok) {
+			std::cerr << "invalid option " << argv[i] << std::endl;
+			return false;
+		}
+	}
+
+	if (opts.threads.empty()) {
+		int hc = (int)std::thread::hardware_concurrency();
+		for (int t = 1; t < hc; t *= 2)
+			opts.threads.push_back(t);
+		if (hc <= 1 || opts.threads.back() != hc)
+			opts.threads.push_back(std::max(hc, 1));
+	}
+	for (int t : opts.threads)
+		if (t < 1) {
+			std::cerr << "invalid thread count" << std::endl;
+			return false;
+		}
+	return true;
+}
+
+static bool is_directory(const std::string& path)
+{
+#ifdef _WIN32
+	DWORD attr = GetFileAttributesA(path.c_str());
+	return attr != INVALID_FILE_ATTRIBUTES && (attr & FILE_ATTRIBUTE_DIRECTORY);
+#else
+	struct stat st;
+	return stat(path.c_str(), &st) == 0 && S_ISDIR(st.st_mode);
+#endif
+}
+
+/// @brief Returns the sorted list of regular files in given directory
+static std::vector<std::string> list_directory(const std::string& dir)
+{
+	std::vector<std::string> res;
+#ifdef _WIN32
+	WIN32_FIND_DATAA fd;
+	HANDLE h = FindFirstFileA((dir + "/*").c_str(), &fd);
+	if (h == INVALID_HANDLE_VALUE)
+		return res;
+	do {
+		if (!(fd.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY))
+			res.push_back(dir + "/" + fd.cFileName);
+	} while (FindNextFileA(h, &fd));
+	FindClose(h);
+#else
+	DIR* d = opendir(dir.c_str());
+	if (!d)
+		return res;
+	while (dirent* e = readdir(d)) {
+		std::string path = dir + "/" + e->d_name;
+		if (e->d_name[0] != '.' && !is_directory(path))
+			res.push_back(path);
+	}
+	closedir(d);
+#endif
+	std::sort(res.begin(), res.end());
+	return res;
+}
+
+template<class T>
+static std::vector<char> text_to_bytes(const char* filename)
+{
+	auto vals = read_text<T>(filename);
+	std::vector<char> res(vals.size() * sizeof(T));
+	if (!res.empty())
+		memcpy(res.data(), vals.data(), res.size());
+	return res;
+}
+
+/// @brief Load a dataset file.
+/// The bytesoftype is given by the file name prefix ('16_file.bin' -> 16).
+/// Text files ('.txt') contain numerical values converted to uint8_t, uint16_t, float or double
+/// depending on the bytesoftype.
+static bool load_input(const std::string& path, Input& in)
+{
+	in.name = file_name(path);
+	if (in.name.empty())
+		in.name = path;
+	in.bytesoftype = (size_t)strtoul(in.name.c_str(), nullptr, 10);
+	if (in.bytesoftype == 0 || in.name.find('_') == std::string::npos)
+		in.bytesoftype = 1;
+
+	bool text = in.name.size() > 4 && in.name.compare(in.name.size() - 4, 4, ".txt") == 0;
+	if (text && (in.bytesoftype == 1 || in.bytesoftype == 2 || in.bytesoftype == 4 || in.bytesoftype == 8)) {
+		switch (in.bytesoftype) {
+			case 1:
+				in.data = text_to_bytes<uint8_t>(path.c_str());
+				break;
+			case 2:
+				in.data = text_to_bytes<uint16_t>(path.c_str());
+				break;
+			case 4:
+				in.data = text_to_bytes<float>(path.c_str());
+				break;
+			default:
+				in.data = text_to_bytes<double>(path.c_str());
+				break;
+		}
+	}
+	else {
+		std::ifstream iss(path, std::ios::binary);
+		if (!iss)
+			return false;
+		in.data.assign(std::istreambuf_iterator<char>(iss), std::istreambuf_iterator<char>());
+	}
+	return !in.data.empty();
+}
+
+/// @brief Default dataset location: build tree first, then install directory
+static std::string default_dataset()
+{
+	const char* dirs[] = {
+#ifdef STENOS_BENCH_DATASET
+		STENOS_BENCH_DATASET,
+#endif
+#ifdef STENOS_DATA_DIR
+		STENOS_DATA_DIR "/dataset",
+#endif
+		"dataset"
+	};
+	for (const char* d : dirs)
+		if (is_directory(d))
+			return d;
+	return std::string();
+}
+
+/// @brief Call timings in nanoseconds
+struct Timings
+{
+	std::vector<double> ns;
+
+	double percentile(double p)
+	{
+		std::sort(ns.begin(), ns.end());
+		size_t idx = (size_t)(p * (double)ns.size());
+		return ns[std::min(idx, ns.size() - 1)];
+	}
+};
+
+/// @brief Call fun() the requested number of times, or until min_time is reached
+template<class Fun>
+static Timings measure(const Options& opts, Fun&& fun)
+{
+	Timings res;
+	stenos::timer t, total;
+	total.tick();
+	const int max_iter = opts.iterations > 0 ? opts.iterations : 1000;
+	for (int i = 0; i < max_iter; ++i) {
+		t.tick();
+		fun();
+		res.ns.push_back((double)t.tock());
+		if (opts.iterations <= 0 && i >= 4 && (double)total.tock() * 1e-9 >= opts.min_time)
+			break;
+	}
+	return res;
+}
+
+/// @brief Compression and decompression over all levels and thread counts for given input, bytesoftype and block shift
+static void bench_frame(const Options& opts, const Input& in, size_t bytesoftype, size_t shift, std::vector<Result>& results)
+{
+	const size_t bytes = in.data.size();
+	std::vector<char> dst(stenos_bound(bytes));
+	std::vector<char> out(bytes);
+
+	for (int level : opts.levels) {
+		double base_comp = 0, base_decomp = 0;
+		int base_threads = 0;
+		for (int threads : opts.threads) {
+			stenos_context* ctx = stenos_make_context();
+			stenos_set_level(ctx, level);
+			stenos_set_threads(ctx, threads);
+			if (shift != STENOS_NO_BLOCK_SHIFT)
+				stenos_set_block_size(ctx, shift);
+
+			size_t r = stenos_compress_generic(ctx, in.data.data(), bytesoftype, bytes, dst.data(), dst.size());
+			if (stenos_has_error(r)) {
+				std::cerr << in.name << ": compression error " << r << " (bytesoftype " << bytesoftype << ", block shift " << (long long)shift << ")" << std::endl;
+				stenos_destroy_context(ctx);
+				return;
+			}
+			size_t d = stenos_decompress_generic(ctx, dst.data(), bytesoftype, r, out.data(), out.size());
+			if (d != bytes || memcmp(out.data(), in.data.data(), bytes) != 0) {
+				std::cerr << in.name << ": decompression mismatch" << std::endl;
+				stenos_destroy_context(ctx);
+				return;
+			}
+
+			Timings comp = measure(opts, [&]() { stenos_compress_generic(ctx, in.data.data(), bytesoftype, bytes, dst.data(), dst.size()); });
+			Timings decomp = measure(opts, [&]() { stenos_decompress_generic(ctx, dst.data(), bytesoftype, r, out.data(), out.size()); });
+			stenos_destroy_context(ctx);
+
+			Result res;
+			res.kind = "frame";
+			res.file = in.name;
+			res.bytesoftype = bytesoftype;
+			res.block_shift = shift == STENOS_NO_BLOCK_SHIFT ? -1 : (long long)shift;
+			res.level = level;
+			res.threads = threads;
+			res.bytes = bytes;
+			res.compressed = r;
+			res.ratio = (double)bytes / (double)r;
+			// Throughputs are computed on the median call, in bytes per nanosecond (GB/s)
+			res.comp_p50_us = comp.percentile(0.5) * 1e-3;
+			res.comp_p99_us = comp.percentile(0.99) * 1e-3;
+			res.decomp_p50_us = decomp.percentile(0.5) * 1e-3;
+			res.decomp_p99_us = decomp.percentile(0.99) * 1e-3;
+			res.comp_gbs = (double)bytes / (res.comp_p50_us * 1e3);
+			res.decomp_gbs = (double)bytes / (res.decomp_p50_us * 1e3);
+
+			// Thread scaling efficiency relative to the first (smallest) thread count
+			if (!base_threads) {
+				base_threads = threads;
+				base_comp = res.comp_gbs;
+				base_decomp = res.decomp_gbs;
+			}
+			double scale = (double)threads / (double)base_threads;
+			res.comp_efficiency = res.comp_gbs / (base_comp * scale);
+			res.decomp_efficiency = res.decomp_gbs / (base_decomp * scale);
+
+			printf("| %-26.26s | %4d | %5lld | %5d | %7d | %8.2f | %8.3f | %8.3f | %10.1f | %10.1f | %5.2f | %5.2f |\n",
+			       in.name.c_str(),
+			       (int)bytesoftype,
+			       res.block_shift,
+			       level,
+			       threads,
+			       res.ratio,
+			       res.comp_gbs,
+			       res.decomp_gbs,
+			       res.comp_p99_us,
+			       res.decomp_p99_us,
+			       res.comp_efficiency,
+			       res.decomp_efficiency);
+			fflush(stdout);
+			results.push_back(res);
+		}
+	}
+}
+
+template<class T>
+static void bench_cvector_type(const Options& opts, const Input& in, std::vector<Result>& results)
+{
+	const size_t count = in.data.size() / sizeof(T);
+	if (count == 0)
+		return;
+	std::vector<T> vals(count);
+	memcpy(vals.data(), in.data.data(), count * sizeof(T));
+
+	std::vector<size_t> indexes(std::min(count, (size_t)1000000));
+	std::mt19937_64 rng(0);
+	for (auto& i : indexes)
+		i = (size_t)(rng() % count);
+
+	stenos::cvector<T> vec;
+	T sink = 0;
+	auto add = [&](const char* op, size_t elements, Timings t) {
+		Result res;
+		res.kind = "cvector";
+		res.file = in.name;
+		res.op = op;
+		res.bytesoftype = sizeof(T);
+		res.level = 1;
+		res.threads = 1;
+		res.bytes = count * sizeof(T);
+		res.ratio = vec.current_compression_ratio();
+		res.ns_per_element = t.percentile(0.5) / (double)elements;
+		res.melem_s = 1e3 / res.ns_per_element;
+		printf("| %-26.26s | %-14s | %10.2f | %10.1f |\n", in.name.c_str(), op, res.ns_per_element, res.melem_s);
+		fflush(stdout);
+		results.push_back(res);
+	};
+
+	add("assign", count, measure(opts, [&]() {
+		    vec.assign(vals.data(), vals.size());
+		    vec.shrink_to_fit();
+	    }));
+	add("sequential", count, measure(opts, [&]() {
+		    for (auto it = vec.cbegin(); it != vec.cend(); ++it)
+			    sink ^= *it;
+	    }));
+	add("for_each", count, measure(opts, [&]() { vec.const_for_each(0, vec.size(), [&](const T& v) { sink ^= v; }); }));
+	add("random_read", indexes.size(), measure(opts, [&]() {
+		    for (size_t i : indexes)
+			    sink ^= vec[i];
+	    }));
+	add("random_write", indexes.size(), measure(opts, [&]() {
+		    for (size_t i : indexes)
+			    vec[i] = vals[i];
+	    }));
+	// Avoid removing the reads
+	if (sink == (T)1 && count == 1)
+		printf(" ");
+}
+
+/// @brief cvector access patterns, for inputs with a bytesoftype of 1, 2, 4 or 8
+static void bench_cvector(const Options& opts, const Input& in, std::vector<Result>& results)
+{
+	switch (in.bytesoftype) {
+		case 1:
+			bench_cvector_type<uint8_t>(opts, in, results);
+			break;
+		case 2:
+			bench_cvector_type<uint16_t>(opts, in, results);
+			break;
+		case 4:
+			bench_cvector_type<uint32_t>(opts, in, results);
+			break;
+		case 8:
+			bench_cvector_type<uint64_t>(opts, in, results);
+			break;
+		default:
+			break;
+	}
+}
+
+static std::string escape(const std::string& str)
+{
+	std::string res;
+	for (char c : str) {
+		if (c == '"' || c == '\\')
+			res.push_back('\\');
+		res.push_back(c);
+	}
+	return res;
+}
+
+static void write_json(const Options& opts, const std::vector<Result>& results)
+{
+	std::ofstream oss(opts.json);
+	oss << "{" << std::endl;
+	oss << "\"stenos_version\": \"" << STENOS_VERSION << "\"," << std::endl;
+	oss << "\"hardware_concurrency\": " << std::thread::hardware_concurrency() << "," << std::endl;
+	oss << "\"iterations\": " << opts.iterations << "," << std::endl;
+	oss << "\"results\": [" << std::endl;
+	for (size_t i = 0; i < results.size(); ++i) {
+		const Result& r = results[i];
+		// One result per line, which is what read_baseline() expects
+		oss << "{\"kind\": \"" << r.kind << "\", \"file\": \"" << escape(r.file) << "\", \"op\": \"" << r.op << "\", \"bytesoftype\": " << r.bytesoftype
+		    << ", \"block_shift\": " << r.block_shift << ", \"level\": " << r.level << ", \"threads\": " << r.threads << ", \"bytes\": " << r.bytes
+		    << ", \"compressed\": " << r.compressed << ", \"ratio\": " << r.ratio << ", \"comp_gbs\": " << r.comp_gbs << ", \"decomp_gbs\": " << r.decomp_gbs
+		    << ", \"comp_p50_us\": " << r.comp_p50_us << ", \"comp_p99_us\": " << r.comp_p99_us << ", \"decomp_p50_us\": " << r.decomp_p50_us
+		    << ", \"decomp_p99_us\": " << r.decomp_p99_us << ", \"comp_efficiency\": " << r.comp_efficiency << ", \"decomp_efficiency\": " << r.decomp_efficiency
+		    << ", \"ns_per_element\": " << r.ns_per_element << ", \"melem_s\": " << r.melem_s << "}" << (i + 1 == results.size() ? "" : ",") << std::endl;
+	}
+	oss << "]" << std::endl << "}" << std::endl;
+}
+
+static void write_csv(const Options& opts, const std::vector<Result>& results)
+{
+	std::ofstream oss(opts.csv);
+	oss << "kind,file,op,bytesoftype,block_shift,level,threads,bytes,compressed,ratio,comp_gbs,decomp_gbs,comp_p50_us,comp_p99_us,decomp_p50_us,decomp_p99_us,"
+	       "comp_efficiency,decomp_efficiency,ns_per_element,melem_s"
+	    << std::endl;
+	for (const Result& r : results) {
+		oss << r.kind << "," << r.file << "," << r.op << "," << r.bytesoftype << "," << r.block_shift << "," << r.level << "," << r.threads << "," << r.bytes << ","
+		    << r.compressed << "," << r.ratio << "," << r.comp_gbs << "," << r.decomp_gbs << "," << r.comp_p50_us << "," << r.comp_p99_us << "," << r.decomp_p50_us
+		    << "," << r.decomp_p99_us << "," << r.comp_efficiency << "," << r.decomp_efficiency << "," << r.ns_per_element << "," << r.melem_s << std::endl;
+	}
+}
+
+/// @brief Extract the value of given field from a JSON result line
+static std::string json_field(const std::string& line, const char* name)
+{
+	std::string key = std::string("\"") + name + "\": ";
+	auto pos = line.find(key);
+	if (pos == std::string::npos)
+		return std::string();
+	pos += key.size();
+	if (line[pos] == '"') {
+		std::string res;
+		for (++pos; pos < line.size() && line[pos] != '"'; ++pos) {
+			if (line[pos] == '\\')
+				++pos;
+			res.push_back(line[pos]);
+		}
+		return res;
+	}
+	auto end = line.find_first_of(",}", pos);
+	return line.substr(pos, end - pos);
+}
+
+/// @brief Read results written by write_json()
+static std::vector<Result> read_baseline(const std::string& filename)
+{
+	std::vector<Result> res;
+	std::ifstream iss(filename);
+	std::string line;
+	while (std::getline(iss, line)) {
+		if (line.find("\"kind\"") == std::string::npos)
+			continue;
+		Result r;
+		r.kind = json_field(line, "kind");
+		r.file = json_field(line, "file");
+		r.op = json_field(line, "op");
+		r.bytesoftype = (size_t)atoll(json_field(line, "bytesoftype").c_str());
+		r.block_shift = atoll(json_field(line, "block_shift").c_str());
+		r.level = atoi(json_field(line, "level").c_str());
+		r.threads = atoi(json_field(line, "threads").c_str());
+		r.ratio = atof(json_field(line, "ratio").c_str());
+		r.comp_gbs = atof(json_field(line, "comp_gbs").c_str());
+		r.decomp_gbs = atof(json_field(line, "decomp_gbs").c_str());
+		r.melem_s = atof(json_field(line, "melem_s").c_str());
+		res.push_back(r);
+	}
+	return res;
+}
+
+/// @brief Compare results against the baseline, returns the number of regressions
+static size_t compare_baseline(const Options& opts, const std::vector<Result>& results)
+{
+	std::vector<Result> base = read_baseline(opts.baseline);
+	if (base.empty()) {
+		std::cerr << "cannot read baseline " << opts.baseline << std::endl;
+		return 1;
+	}
+	size_t regressions = 0, compared = 0;
+	auto check = [&](const Result& r, const char* metric, double cur, double ref, double tolerance) {
+		if (ref > 0 && cur < ref * (1 - tolerance)) {
+			printf("REGRESSION %s %s: %.3f -> %.3f (%+.1f%%)\n", r.key().c_str(), metric, ref, cur, (cur / ref - 1) * 100);
+			++regressions;
+		}
+	};
+	for (const Result& r : results) {
+		auto it = std::find_if(base.begin(), base.end(), [&](const Result& b) { return b.key() == r.key(); });
+		if (it == base.end())
+			continue;
+		++compared;
+		if (r.kind == "frame") {
+			// Compression ratio is deterministic
+			check(r, "ratio", r.ratio, it->ratio, 0.001);
+			check(r, "comp_gbs", r.comp_gbs, it->comp_gbs, opts.tolerance);
+			check(r, "decomp_gbs", r.decomp_gbs, it->decomp_gbs, opts.tolerance);
+		}
+		else
+			check(r, "melem_s", r.melem_s, it->melem_s, opts.tolerance);
+	}
+	printf("Compared %d results against %s: %d regression(s)\n", (int)compared, opts.baseline.c_str(), (int)regressions);
+	return regressions;
+}
+
+int main(int argc, char** argv)
+{
+	Options opts;
+	if (!parse_options(argc, argv, opts)) {
+		print_usage();
+		return 1;
+	}
+
+	if (opts.inputs.empty()) {
+		std::string dir = default_dataset();
+		if (dir.empty()) {
+			std::cerr << "stenos_dataset not found, please provide input files or directories" << std::endl;
+			return 1;
+		}
+		opts.inputs.push_back(dir);
+	}
+
+	std::vector<std::string> files;
+	for (const std::string& in : opts.inputs) {
+		if (is_directory(in)) {
+			auto list = list_directory(in);
+			files.insert(files.end(), list.begin(), list.end());
+		}
+		else
+			files.push_back(in);
+	}
+
+	std::vector<Input> inputs;
+	for (const std::string& f : files) {
+		Input in;
+		if (load_input(f, in))
+			inputs.push_back(std::move(in));
+		else
+			std::cerr << "cannot read " << f << std::endl;
+	}
+
+	std::cout << "Stenos " << STENOS_VERSION << ", " << inputs.size() << " file(s), hardware concurrency " << std::thread::hardware_concurrency() << std::endl << std::endl;
+
+	std::vector<Result> results;
+
+	std::cout << "Compression / decompression (throughput in GB/s computed on the median call, p99 latency in us)" << std::endl;
+	printf("| %-26s | %4s | %5s | %5s | %7s | %8s | %8s | %8s | %10s | %10s | %5s | %5s |\n", "file", "bt", "shift", "level", "threads", "ratio", "comp", "decomp", "comp p99", "dec p99", "c eff", "d eff");
+	for (const Input& in : inputs)
+		for (size_t bt : opts.bytesoftypes)
+			for (size_t shift : opts.block_shifts)
+				bench_frame(opts, in, bt ? bt : in.bytesoftype, shift, results);
+
+	if (opts.cvector) {
+		std::cout << std::endl << "cvector access (median ns per element, millions of elements per second)" << std::endl;
+		printf("| %-26s | %-14s | %10s | %10s |\n", "file", "operation", "ns/elem", "Melem/s");
+		for (const Input& in : inputs)
+			bench_cvector(opts, in, results);
+	}
+
+	if (!opts.json.empty())
+		write_json(opts, results);
+	if (!opts.csv.empty())
+		write_csv(opts, results);
+	if (!opts.baseline.empty() && compare_baseline(opts, results))
+		return 1;
+	return 0;
+}
@@ -62,6 +62,69 @@ namespace stenos
 		// Specialization for std::atomic
 	};
 
+	/// @brief Record layout of a cvector value type, see stenos_set_layout().
+	///
+	/// Specialize this trait for struct types mixing fields of different sizes,
+	/// so that cvector compresses each field separately:
+	/// \code{.cpp}
+	/// #pragma pack(push, 1)
+	/// struct Point { int64_t time; float value; uint16_t flags; };
+	/// #pragma pack(pop)
+	///
+	/// template<>
+	/// struct stenos::field_layout<Point>
+	/// {
+	///	static constexpr size_t count = 3;
+	///	static const size_t* sizes() noexcept
+	///	{
+	///		static const size_t s[] = { 8, 4, 2 };
+	///		return s;
+	///	}
+	/// };
+	/// \endcode
+	/// Field sizes must sum to sizeof(T), padding bytes included.
+	///
+	template<class T>
+	struct field_layout
+	{
+		static constexpr size_t count = 0;
+		static const size_t* sizes() noexcept { return nullptr; }
+	};
+
+	/// @brief Eviction policy of the cvector decompressed chunk cache
+	enum class cvector_cache_policy
+	{
+		fifo, // Reuse the oldest decompressed chunk (default)
+		clock // Second chance (CLOCK) policy: recently accessed chunks are kept, approximating LRU
+	};
+
+	/// @brief Statistics of the cvector decompressed chunk cache
+	struct cvector_cache_stats
+	{
+		size_t hits;	  // Chunk accesses served without decompression
+		size_t misses;	  // Chunk decompressions
+		size_t evictions; // Decompressed chunks released to make room for another one
+	};
+
+	/// @brief Statistics of a cvector_block_pool
+	struct cvector_block_pool_stats
+	{
+		size_t reserved_bytes; // Memory obtained from the system (slabs and large blocks)
+		size_t slot_bytes;     // Memory of the slots currently in use
+		size_t used_bytes;     // Compressed bytes currently stored
+		size_t blocks;	       // Number of compressed blocks currently stored
+		float fragmentation;   // 1 - used_bytes / reserved_bytes, 0 if nothing is reserved
+	};
+
+	/// @brief Contiguous values of a cvector decompressed chunk, see cvector::chunks()
+	template<class T>
+	struct cvector_span
+	{
+		size_t index;  // Position of data[0] in the cvector
+		const T* data; // Values
+		size_t size;   // Number of values
+	};
+
 	namespace detail
 	{
 		// forward declaration
@@ -91,6 +154,8 @@ namespace std
 #include <mutex>
 #include <iterator>
 #include <shared_mutex>
+#include <exception>
+#include <stdexcept>
 
 #include "stenos.h"
 #include "bits.hpp"
@@ -465,6 +530,8 @@ namespace stenos
 									// and works all the time since we have an aligned 32 bit variable).
 			size_t block_index;				// block index in list of blocks
 			char* buffer;					// compressed buffer
+			std::atomic<unsigned char> referenced;		// accessed since last examined by the CLOCK policy (relaxed ordering, only a hint)
+			unsigned pinned;				// pin count, pinned buffers are never reused
 			alignas(alignof(T)) char storage[storage_size]; // data storage, aligned on 16 bytes at least
 
 			STENOS_ALWAYS_INLINE void mark_dirty() noexcept
@@ -512,6 +579,8 @@ namespace stenos
 				dirty = 0;
 				block_index = invalid_index;
 				buffer = nullptr;
+				referenced.store(0, std::memory_order_relaxed);
+				pinned = 0;
 			}
 
 			STENOS_ALWAYS_INLINE auto data() noexcept -> T* { return reinterpret_cast<T*>(storage); }
@@ -704,6 +773,8 @@ namespace stenos
 			res->dirty = 0;
 			res->block_index = 0;
 			res->buffer = nullptr;
+			res->referenced.store(0, std::memory_order_relaxed);
+			res->pinned = 0;
 			res->left = res->right = nullptr;
 			return res;
 		}
@@ -825,6 +896,8 @@ namespace stenos
 				auto decompressed = this->_bucket()->load_decompressed();
 				if (!decompressed)
 					decompressed = _c()->decompress_bucket(bucket, exclude);
+				else
+					_c()->cache_hit(decompressed);
 				return decompressed;
 			}
 
@@ -1335,6 +1408,240 @@ namespace stenos
 			return buffer;
 		}
 
+		/// @brief Returns the calling thread block compression/decompression context
+		/// for given block size and level. Each thread owns its context, so that
+		/// blocks of the same cvector are (de)compressed in parallel without locking.
+		template<unsigned block_bytes, int Level>
+		static STENOS_ALWAYS_INLINE stenos_context* get_block_context()
+		{
+			struct BlockContext
+			{
+				stenos_context* ctx;
+				BlockContext()
+				  : ctx(stenos_make_context())
+				{
+					if (ctx)
+						stenos_set_level(ctx, Level);
+				}
+				~BlockContext() noexcept { stenos_destroy_context(ctx); }
+			};
+			thread_local BlockContext c;
+			if STENOS_UNLIKELY (!c.ctx)
+				throw std::bad_alloc();
+			return c.ctx;
+		}
+	}
+
+	/// @brief Size-class slab allocator for cvector compressed chunks.
+	///
+	/// Compressed chunks have variable sizes that change each time a chunk is recompressed.
+	/// The pool rounds sizes up to size classes (1/8 power of 2 granularity) and carves
+	/// slots of the same class from large slabs. This avoids one system allocation per chunk,
+	/// and a recompressed chunk is kept in place as long as its new size still fits its slot.
+	/// An empty slab is released, except the last one of its class.
+	/// Blocks larger than max_slot_bytes are allocated with malloc().
+	///
+	/// A pool can be owned by a single cvector (see cvector::use_block_pool()) or shared
+	/// between several cvectors (see cvector::set_block_pool()). A pool is thread safe and
+	/// allocates its memory with malloc(), not with the cvector allocator.
+	class cvector_block_pool
+	{
+	public:
+		static constexpr size_t slab_bytes = 64u * 1024u;
+		static constexpr size_t max_slot_bytes = slab_bytes / 8u;
+
+	private:
+		struct Slab
+		{
+			Slab* prev;	  // Previous slab with free slots in this class
+			Slab* next;	  // Next slab with free slots in this class
+			char* bump;	  // First slot never used
+			char* end;	  // End of slots
+			void* free;	  // List of released slots
+			size_t slot_size; // Size of a slot
+			size_t used;	  // Number of slots in use
+			unsigned cls;	  // Size class index
+			bool listed;	  // True if the slab is in its class list
+		};
+
+		// 8 classes up to 128 bytes, then 8 classes per power of 2 up to max_slot_bytes (2^13)
+		static constexpr unsigned class_count = 8u + 8u * 6u;
+		static_assert(max_slot_bytes == (128u << 6u), "invalid class count");
+
+		Slab* d_partial[class_count]; // Per class list of slabs with free slots
+		detail::SharedSpinner d_lock;
+		size_t d_slabs{ 0 };
+		size_t d_large_bytes{ 0 };
+		size_t d_slot_bytes{ 0 };
+		size_t d_used_bytes{ 0 };
+		size_t d_blocks{ 0 };
+
+		static STENOS_ALWAYS_INLINE auto slab_of(void* p) noexcept -> Slab* { return reinterpret_cast<Slab*>(reinterpret_cast<uintptr_t>(p) & ~static_cast<uintptr_t>(slab_bytes - 1u)); }
+
+		void link(Slab* s) noexcept
+		{
+			s->prev = nullptr;
+			s->next = d_partial[s->cls];
+			if (s->next)
+				s->next->prev = s;
+			d_partial[s->cls] = s;
+			s->listed = true;
+		}
+		void unlink(Slab* s) noexcept
+		{
+			if (s->prev)
+				s->prev->next = s->next;
+			else
+				d_partial[s->cls] = s->next;
+			if (s->next)
+				s->next->prev = s->prev;
+			s->listed = false;
+		}
+		auto make_slab(unsigned cls, size_t slot_size) -> Slab*
+		{
+			// Slabs are aligned on slab_bytes, so that slab_of() works for any slot
+			Slab* s = static_cast<Slab*>(aligned_malloc(slab_bytes, slab_bytes));
+			if STENOS_UNLIKELY (!s)
+				throw std::bad_alloc();
+			s->bump = reinterpret_cast<char*>(s) + ((sizeof(Slab) + 15u) & ~static_cast<size_t>(15u));
+			s->end = reinterpret_cast<char*>(s) + slab_bytes;
+			s->free = nullptr;
+			s->slot_size = slot_size;
+			s->used = 0;
+			s->cls = cls;
+			link(s);
+			++d_slabs;
+			return s;
+		}
+		void destroy_slab(Slab* s) noexcept
+		{
+			unlink(s);
+			--d_slabs;
+			aligned_free(s);
+		}
+
+	public:
+		/// @brief Returns the slot size used for a block of given size
+		static auto class_size(size_t size) noexcept -> size_t
+		{
+			if (size <= 128u)
+				return size ? (size + 15u) & ~static_cast<size_t>(15u) : 16u;
+			size_t step = static_cast<size_t>(1u) << (bit_scan_reverse(size - 1u) - 3u);
+			return (size + step - 1u) & ~(step - 1u);
+		}
+
+		cvector_block_pool() noexcept
+		{
+			for (unsigned i = 0; i < class_count; ++i)
+				d_partial[i] = nullptr;
+		}
+		cvector_block_pool(const cvector_block_pool&) = delete;
+		cvector_block_pool& operator=(const cvector_block_pool&) = delete;
+
+		/// @brief Destructor. All blocks must have been deallocated.
+		~cvector_block_pool() noexcept
+		{
+			for (unsigned i = 0; i < class_count; ++i)
+				while (d_partial[i])
+					destroy_slab(d_partial[i]);
+		}
+
+		/// @brief Allocate a block of given size, throw std::bad_alloc on error
+		auto allocate(size_t size) -> char*
+		{
+			size_t slot = class_size(size);
+			std::lock_guard<detail::SharedSpinner> ll(d_lock);
+			char* p = nullptr;
+			if (slot > max_slot_bytes) {
+				p = static_cast<char*>(malloc(size));
+				if STENOS_UNLIKELY (!p)
+					throw std::bad_alloc();
+				d_large_bytes += size;
+				slot = size;
+			}
+			else {
+				// Find a slab with free slots, might throw (fine)
+				unsigned cls = static_cast<unsigned>(slot / 16u - 1u);
+				if (slot > 128u) {
+					unsigned e = bit_scan_reverse(slot - 1u);
+					cls = 8u + (e - 7u) * 8u + static_cast<unsigned>((slot >> (e - 3u)) - 9u);
+				}
+				Slab* s = d_partial[cls];
+				if (!s)
+					s = make_slab(cls, slot);
+				if (s->free) {
+					p = static_cast<char*>(s->free);
+					s->free = *reinterpret_cast<void**>(p);
+				}
+				else {
+					p = s->bump;
+					s->bump += s->slot_size;
+				}
+				++s->used;
+				if (!s->free && s->bump + s->slot_size > s->end)
+					unlink(s);
+			}
+			d_slot_bytes += slot;
+			d_used_bytes += size;
+			++d_blocks;
+			return p;
+		}
+
+		/// @brief Deallocate a block previously allocated with allocate().
+		/// size is the current block size, which might differ from the allocated one after resize_in_place().
+		void deallocate(char* p, size_t size) noexcept
+		{
+			if (!p)
+				return;
+			std::lock_guard<detail::SharedSpinner> ll(d_lock);
+			d_used_bytes -= size;
+			--d_blocks;
+			if (class_size(size) > max_slot_bytes) {
+				d_large_bytes -= size;
+				d_slot_bytes -= size;
+				::free(p);
+				return;
+			}
+			Slab* s = slab_of(p);
+			d_slot_bytes -= s->slot_size;
+			*reinterpret_cast<void**>(p) = s->free;
+			s->free = p;
+			if (!s->listed)
+				link(s);
+			// Release the slab if empty, unless this is the last one of its class
+			if (--s->used == 0 && (s->prev || s->next))
+				destroy_slab(s);
+		}
+
+		/// @brief Try to reuse in place the slot of block p, currently of size old_size, for a block of size new_size.
+		/// Returns true on success, in which case the caller might overwrite the block with new_size bytes.
+		/// Fails if new_size does not fit the slot, or if it would waste more than half of it.
+		auto resize_in_place(char* p, size_t old_size, size_t new_size) noexcept -> bool
+		{
+			if (!p || class_size(old_size) > max_slot_bytes || class_size(new_size) > max_slot_bytes)
+				return false;
+			Slab* s = slab_of(p);
+			if (new_size > s->slot_size || new_size * 2u <= s->slot_size)
+				return false;
+			std::lock_guard<detail::SharedSpinner> ll(d_lock);
+			d_used_bytes += new_size;
+			d_used_bytes -= old_size;
+			return true;
+		}
+
+		/// @brief Returns the pool statistics
+		auto stats() const noexcept -> cvector_block_pool_stats
+		{
+			std::lock_guard<detail::SharedSpinner> ll(const_cast<detail::SharedSpinner&>(d_lock));
+			size_t reserved = d_slabs * slab_bytes + d_large_bytes;
+			float frag = reserved ? 1.f - static_cast<float>(d_used_bytes) / static_cast<float>(reserved) : 0.f;
+			return { reserved, d_slot_bytes, d_used_bytes, d_blocks, frag };
+		}
+	};
+
+	namespace detail
+	{
+
 		/// @brief Internal structure used by cvector that gathers all the container logics
 		///
 		template<class T, class Allocator, unsigned Shift = 0, int Level = 1>
@@ -1379,8 +1686,90 @@ namespace stenos
 			ContextType d_contexts;					    // decompression contexts
 			size_t d_size;						    // number of values
 			SharedSpinner d_lock;					    // global Spinlock
-			SharedSpinner d_ctx_lock;
-			stenos_context* d_ctx = stenos_make_context();
+
+			// Decompressed chunk cache settings and statistics
+			struct CacheState
+			{
+				size_t max_contexts{ 0 }; // Maximum number of decompression contexts, 0 for default heuristics
+				cvector_cache_policy policy{ cvector_cache_policy::fifo };
+				bool stats{ false };
+				std::atomic<size_t> hits{ 0 };
+				std::atomic<size_t> misses{ 0 };
+				std::atomic<size_t> evictions{ 0 };
+			} d_cache;
+
+			// Optional per bucket min/max, see bucket_synopsis().
+			// Only used for arithmetic types.
+			using SynopsisValue = typename std::conditional<std::is_arithmetic<T>::value, T, char>::type;
+			struct Synopsis
+			{
+				SynopsisValue min{};
+				SynopsisValue max{};
+				bool valid{ false };
+			};
+			std::vector<Synopsis, RebindAlloc<Synopsis>> d_synopsis;
+			SharedSpinner d_synopsis_lock;
+			bool d_synopsis_enabled{ false };
+
+			// Optional allocator of compressed buffers, see allocate_block()
+			std::shared_ptr<cvector_block_pool> d_pool;
+
+			// Compression level and time budget per chunk, applied to the calling thread context on each compression
+			int d_level{ Level };
+			uint64_t d_max_nanoseconds{ 0 };
+
+			/// @brief Allocate a compressed buffer, from the block pool if any
+			STENOS_ALWAYS_INLINE auto allocate_block(size_t csize) -> char* { return d_pool ? d_pool->allocate(csize) : RebindAlloc<char>(*this).allocate(csize); }
+			/// @brief Deallocate a compressed buffer of given compressed size
+			STENOS_ALWAYS_INLINE void deallocate_block(char* buf, size_t csize) noexcept
+			{
+				if (d_pool)
+					d_pool->deallocate(buf, csize);
+				else
+					RebindAlloc<char>(*this).deallocate(buf, csize);
+			}
+			STENOS_ALWAYS_INLINE void deallocate_block(char* buf) noexcept { deallocate_block(buf, stenos_private_block_csize(buf)); }
+			/// @brief Returns true if buf can be overwritten by a compressed buffer of size csize
+			STENOS_ALWAYS_INLINE bool reuse_block(char* buf, size_t csize) noexcept
+			{
+				size_t old = stenos_private_block_csize(buf);
+				return buf && (old == csize || (d_pool && d_pool->resize_in_place(buf, old, csize)));
+			}
+
+			/// @brief Set the allocator of compressed buffers, and move existing ones to it.
+			/// Strong exception guarantee.
+			void set_block_pool(std::shared_ptr<cvector_block_pool> pool)
+			{
+				if (pool == d_pool)
+					return;
+				std::vector<char*, RebindAlloc<char*>> buffers(d_buckets.size(), nullptr, RebindAlloc<char*>(*this));
+				size_t i = 0;
+				try {
+					for (; i < d_buckets.size(); ++i)
+						if (char* buf = d_buckets[i].data.find_compressed()) {
+							size_t csize = stenos_private_block_csize(buf);
+							buffers[i] = pool ? pool->allocate(csize) : RebindAlloc<char>(*this).allocate(csize);
+							memcpy(buffers[i], buf, csize);
+						}
+				}
+				catch (...) {
+					while (i-- > 0)
+						if (buffers[i]) {
+							size_t csize = stenos_private_block_csize(buffers[i]);
+							pool ? pool->deallocate(buffers[i], csize) : RebindAlloc<char>(*this).deallocate(buffers[i], csize);
+						}
+					throw;
+				}
+				for (i = 0; i < d_buckets.size(); ++i)
+					if (buffers[i]) {
+						deallocate_block(d_buckets[i].data.find_compressed());
+						if (d_buckets[i].data.compressed())
+							d_buckets[i].data.set(buffers[i], Compressed);
+						else
+							d_buckets[i].data.raw()->buffer = buffers[i];
+					}
+				d_pool = std::move(pool);
+			}
 
 			STENOS_ALWAYS_INLINE void check_destroy_bucket(size_t idx) noexcept
 			{
@@ -1391,15 +1780,95 @@ namespace stenos
 
 			STENOS_ALWAYS_INLINE void* compression_buffer() noexcept { return get_compression_buffer<block_bytes>(); }
 
+			/// @brief Record an access to an already decompressed chunk
+			STENOS_ALWAYS_INLINE void cache_hit(const RawType* raw) noexcept
+			{
+				// Concurrent readers (e.g. parallel const_for_each()) might set the bit together
+				if (d_cache.policy == cvector_cache_policy::clock && !raw->referenced.load(std::memory_order_relaxed))
+					const_cast<RawType*>(raw)->referenced.store(1, std::memory_order_relaxed);
+				if STENOS_UNLIKELY (d_cache.stats)
+					d_cache.hits.fetch_add(1, std::memory_order_relaxed);
+			}
+			STENOS_ALWAYS_INLINE void cache_count(std::atomic<size_t>& counter) noexcept
+			{
+				if STENOS_UNLIKELY (d_cache.stats)
+					counter.fetch_add(1, std::memory_order_relaxed);
+			}
+			/// @brief Number of decompression contexts kept before reusing them
+			STENOS_ALWAYS_INLINE size_t context_limit() const noexcept { return d_cache.max_contexts ? d_cache.max_contexts : 2; }
+
+			/// @brief Set the maximum memory used by decompressed chunks, 0 to restore default heuristics
+			void set_max_decompressed_bytes(size_t bytes) noexcept
+			{
+				// At least 2 contexts are required to access 2 different chunks at once
+				d_cache.max_contexts = bytes ? std::max(bytes / sizeof(RawType), (size_t)2) : 0;
+			}
+			auto max_decompressed_bytes() const noexcept -> size_t { return d_cache.max_contexts * sizeof(RawType); }
+			void set_cache_policy(cvector_cache_policy policy) noexcept { d_cache.policy = policy; }
+			void copy_encoding_settings(const CompressedVectorInternal& other) noexcept
+			{
+				d_level = other.d_level;
+				d_max_nanoseconds = other.d_max_nanoseconds;
+				d_pool = other.d_pool;
+			}
+			void copy_cache_settings(const CompressedVectorInternal& other) noexcept
+			{
+				d_cache.max_contexts = other.d_cache.max_contexts;
+				d_cache.policy = other.d_cache.policy;
+				d_cache.stats = other.d_cache.stats;
+			}
+			auto cache_stats() const noexcept -> cvector_cache_stats
+			{
+				return { d_cache.hits.load(std::memory_order_relaxed), d_cache.misses.load(std::memory_order_relaxed), d_cache.evictions.load(std::memory_order_relaxed) };
+			}
+			void reset_cache_stats(bool enable) noexcept
+			{
+				d_cache.stats = enable;
+				d_cache.hits.store(0);
+				d_cache.misses.store(0);
+				d_cache.evictions.store(0);
+			}
+
+			/// @brief Pin or unpin the decompressed chunk at given index
+			void pin_bucket(size_t index, bool pin)
+			{
+				std::shared_lock<SharedSpinner> ll(d_buckets[index].get().ref_count);
+				RawType* raw = pin ? decompress_bucket(index) : d_buckets[index].load_decompressed();
+				std::lock_guard<SharedSpinner> lock(d_lock);
+				if (pin)
+					++raw->pinned;
+				else if (raw && raw->pinned)
+					--raw->pinned;
+			}
+			static STENOS_ALWAYS_INLINE void set_block_layout(stenos_context* ctx) noexcept
+			{
+				// Block contexts are shared by all value types of the same size
+				if (stenos_has_error(stenos_set_layout(ctx, field_layout<T>::sizes(), field_layout<T>::count)))
+					STENOS_ABORT("cvector: abort on invalid field_layout") // no way to recover from this
+			}
+			STENOS_ALWAYS_INLINE stenos_context* block_context() const noexcept
+			{
+				try {
+					return get_block_context<block_bytes, level>();
+				}
+				catch (...) {
+					STENOS_ABORT("cvector: abort on context allocation error") // no way to recover from this
+				}
+				return nullptr;
+			}
+
 			STENOS_ALWAYS_INLINE size_t compress(const void* in, size_t bytes = 0) noexcept
 			{
-				std::lock_guard<SharedSpinner> lock(d_ctx_lock);
-				size_t r = stenos_private_compress_block(d_ctx, in, sizeof(T), block_bytes, bytes ? bytes : block_bytes, compression_buffer(), dst_block_bytes);
+				stenos_context* ctx = block_context();
+				stenos_set_level(ctx, d_level);
+				stenos_set_max_nanoseconds(ctx, d_max_nanoseconds);
+				set_block_layout(ctx);
+				size_t r = stenos_private_compress_block(ctx, in, sizeof(T), block_bytes, bytes ? bytes : block_bytes, compression_buffer(), dst_block_bytes);
 				if (stenos_has_error(r))
 					STENOS_ABORT("cvector: abort on compression error") // no way to recover from this
 #ifndef NDEBUG
 				char out[block_bytes];
-				size_t r2 = stenos_private_decompress_block(d_ctx, compression_buffer(), sizeof(T), block_bytes, r, out, bytes ? bytes : block_bytes);
+				size_t r2 = stenos_private_decompress_block(ctx, compression_buffer(), sizeof(T), block_bytes, r, out, bytes ? bytes : block_bytes);
 				STENOS_ASSERT_DEBUG(r2 == (bytes != 0 ? bytes : block_bytes), "");
 				STENOS_ASSERT_DEBUG(memcmp(in, out, bytes ? bytes : block_bytes) == 0, "");
 #endif
@@ -1412,8 +1881,7 @@ namespace stenos
 				if (!buf)
 					return 0;
 
-				std::lock_guard<SharedSpinner> lock(d_ctx_lock);
-				size_t r = stenos_private_decompress_block(d_ctx, buf, sizeof(T), block_bytes, stenos_private_block_csize(buf), dst, block_bytes);
+				size_t r = stenos_private_decompress_block(block_context(), buf, sizeof(T), block_bytes, stenos_private_block_csize(buf), dst, block_bytes);
 				if (stenos_has_error(r) || r != block_bytes)
 					STENOS_ABORT("cvector: abort on decompression error")
 				return r;
@@ -1421,8 +1889,7 @@ namespace stenos
 
 			///@brief Destroy and deallocate a pack buffer.
 			/// Also destroy and deallocate the uncompressed data.
-			template<class Alloc>
-			void destroy_pack_buffer(BucketType* pack, RawType* tmp, Alloc al) noexcept
+			void destroy_pack_buffer(BucketType* pack, RawType* tmp) noexcept
 			{
 				// Here, tmp is just used to decompress and destroy values
 				if (pack && pack->data) {
@@ -1440,7 +1907,7 @@ namespace stenos
 							tmp->clear_values();
 						}
 					}
-					al.deallocate(buffer, stenos_private_block_csize(buffer));
+					deallocate_block(buffer);
 				}
 			}
 
@@ -1449,10 +1916,10 @@ namespace stenos
 			  : Allocator(al)
 			  , d_buckets(RebindAlloc<BucketType>(al))
 			  , d_size(0)
+			  , d_synopsis(RebindAlloc<Synopsis>(al))
 			{
-				if (!d_ctx)
-					throw std::bad_alloc();
-				stenos_set_level(d_ctx, level);
+				// Make sure the calling thread context can be created
+				get_block_context<block_bytes, level>();
 			}
 
 			~CompressedVectorInternal() noexcept { clear(); }
@@ -1471,7 +1938,7 @@ namespace stenos
 					}
 				}
 				if (data)
-					RebindAlloc<char>(*this).deallocate(data, stenos_private_block_csize(data));
+					deallocate_block(data);
 			}
 
 			/// @brief Clear content
@@ -1505,9 +1972,9 @@ namespace stenos
 					auto raw = d_buckets[i].load_decompressed();
 					if (auto buf = d_buckets[i].data.find_compressed()) {
 						if (raw != tmp)
-							this->destroy_pack_buffer(&d_buckets[i], tmp, RebindAlloc<char>(*this));
+							this->destroy_pack_buffer(&d_buckets[i], tmp);
 						else
-							RebindAlloc<char>(*this).deallocate(buf, stenos_private_block_csize(buf));
+							deallocate_block(buf);
 					}
 					else {
 						if (raw && raw != tmp)
@@ -1529,6 +1996,7 @@ namespace stenos
 				// Reset all
 				d_contexts.clear();
 				d_buckets.clear();
+				synopsis_truncate(0);
 				d_size = 0;
 			}
 
@@ -1573,8 +2041,8 @@ namespace stenos
 				decompressed_size *= block_size * sizeof(T);
 				size_t compress_size = 0;
 				for (size_t i = 0; i < d_buckets.size(); ++i)
-					if (d_buckets[i].buffer)
-						compress_size += stenos_private_block_csize(d_buckets[i].data.find_compressed());
+					if (char* buf = d_buckets[i].data.find_compressed())
+						compress_size += stenos_private_block_csize(buf);
 				return (compress_size && decompressed_size) ? decompressed_size / static_cast<float>(compress_size) : 0.f;
 			}
 
@@ -1592,8 +2060,8 @@ namespace stenos
 					RawType* raw = *it++;
 
 					// Try to reuse the decompression context
-					if (raw->size > 0 && raw->size < elems_per_block) {
-						// Mandatory: reuse a non full decompression context (back context)
+					if ((raw->size > 0 && raw->size < elems_per_block) || raw->pinned) {
+						// Mandatory: reuse a non full decompression context (back context) or a pinned one
 						new_contexts.push_back(raw);
 						continue;
 					}
@@ -1613,12 +2081,13 @@ namespace stenos
 						STENOS_ASSERT_DEBUG(index != RawType::invalid_index, "raw block must belong to an existing bucket");
 						// Compress
 						size_t r = compress(raw->storage);
-						if (r != stenos_private_block_csize(raw->buffer)) {
+						synopsis_update(index, raw->data(), raw->size);
+						if (!reuse_block(raw->buffer, r)) {
 							// Free old buffer, alloc new one, update compressed size, might throw (fine)
 							char* buff = this->allocate_buffer_for_compression((unsigned)r, &d_buckets[index], index, raw);
 
 							if (raw->buffer)
-								RebindAlloc<char>(*this).deallocate(raw->buffer, stenos_private_block_csize(raw->buffer));
+								deallocate_block(raw->buffer);
 							raw->buffer = buff;
 						}
 						memcpy(raw->buffer, compression_buffer(), r);
@@ -1644,10 +2113,12 @@ namespace stenos
 				d_contexts.assign(std::move(new_contexts));
 
 				// Remove empty contexts
-				while (d_contexts.size() > 1) {
+				for (bool erased = true; erased && d_contexts.size() > 1;) {
+					erased = false;
 					for (auto it = d_contexts.begin(); it != d_contexts.end(); ++it) {
 						if ((*it)->size == 0) {
 							erase_context(*it);
+							erased = true;
 							break;
 						}
 					}
@@ -1677,7 +2148,7 @@ namespace stenos
 			{
 				char* buff = nullptr;
 				try {
-					buff = RebindAlloc<char>(*this).allocate(size); //(char*)malloc(r);
+					buff = allocate_block(size); //(char*)malloc(r);
 				}
 				catch (...) {
 					// unlock bucket
@@ -1691,12 +2162,13 @@ namespace stenos
 							this->decompress(bucket, context->storage);
 							context->clear_values();
 						}
-						RebindAlloc<char>(*this).deallocate(buffer, stenos_private_block_csize(buffer));
+						deallocate_block(buffer);
 					}
 					// remove context
 					erase_context(context);
 					// remove bucket
 					d_buckets.erase(d_buckets.begin() + static_cast<difference_type>(bucket_index));
+					synopsis_truncate(bucket_index);
 
 					// update indexes
 					for (size_t i = bucket_index; i < d_buckets.size(); ++i)
@@ -1711,7 +2183,7 @@ namespace stenos
 			/// @brief Returns a decompression context either by creating a new one, or by reusing an existing one
 			auto make_or_find_free_context(RawType* exclude = nullptr) -> RawType*
 			{
-				if (d_contexts.size() >= 2)
+				if (d_contexts.size() >= context_limit())
 					return find_free_context(exclude, nullptr);
 
 				// Create a new context, might throw (fine)
@@ -1722,21 +2194,29 @@ namespace stenos
 
 			auto get_locked_context(RawType* exclude = nullptr, typename ContextType::iterator* start = nullptr) noexcept -> typename ContextType::iterator
 			{
-				// Start by the tail
-				auto found = start ? *start : d_contexts.end();
-				if (d_contexts.size()) {
-					--found;
-					if (found != d_contexts.end()) {
-						while ((((*found)->size && (*found)->size != elems_per_block) || *found == exclude || !try_lock((*found)))) {
-							if (found == d_contexts.begin()) {
-								found = d_contexts.end();
-								break;
+				// Start by the tail.
+				// With the CLOCK policy, recently accessed contexts get a second chance:
+				// their reference bit is cleared and the scan is performed twice at most.
+				const bool clock = d_cache.policy == cvector_cache_policy::clock;
+				for (int pass = 0; pass < (clock ? 2 : 1); ++pass) {
+					auto found = start ? *start : d_contexts.end();
+					if (d_contexts.size()) {
+						--found;
+						if (found != d_contexts.end()) {
+							while ((((*found)->size && (*found)->size != elems_per_block) || *found == exclude || (*found)->pinned ||
+								(clock && (*found)->referenced.load(std::memory_order_relaxed) && ((*found)->referenced.store(0, std::memory_order_relaxed), true)) || !try_lock((*found)))) {
+								if (found == d_contexts.begin()) {
+									found = d_contexts.end();
+									break;
+								}
+								--found;
 							}
-							--found;
 						}
 					}
+					if (found != d_contexts.end())
+						return found;
 				}
-				return found;
+				return d_contexts.end();
 			}
 
 			/// @brief Reuse and return an existing decompression context that cannot be exclude one
@@ -1762,6 +2242,8 @@ namespace stenos
 				RawType* found_raw = *found;
 				BucketType* found_bucket = (*found)->block_index == RawType::invalid_index ? nullptr : &d_buckets[(*found)->block_index];
 				size_t saved_index = (*found)->block_index;
+				if (found_bucket)
+					cache_count(d_cache.evictions);
 
 				// Compress context if dirty
 				if (found_raw->dirty) {
@@ -1769,19 +2251,20 @@ namespace stenos
 					STENOS_ASSERT_DEBUG(found_bucket, "context must belong to an existing bucket");
 
 					size_t r = compress(found_raw->storage);
+					synopsis_update(saved_index, found_raw->data(), found_raw->size);
 
-					if (r != stenos_private_block_csize(found_raw->buffer)) {
+					if (!reuse_block(found_raw->buffer, r)) {
 						// Free old memory, alloc new one
 						char* buff = allocate_buffer_for_compression((unsigned)r, found_bucket, saved_index, found_raw);
 						if (found_raw->buffer)
-							RebindAlloc<char>(*this).deallocate(found_raw->buffer, stenos_private_block_csize(found_raw->buffer));
+							deallocate_block(found_raw->buffer);
 						found_raw->buffer = buff;
 					}
 
 					memcpy(found_raw->buffer, compression_buffer(), r);
 
 					// Use this opportunity to free another context if possible
-					if (!start && d_contexts.size() > d_buckets.size() / 16) {
+					if (!start && d_contexts.size() > (d_cache.max_contexts ? d_cache.max_contexts : d_buckets.size() / 16)) {
 						RawType* raw = find_free_context(exclude, &found);
 						if (raw)
 							erase_context(raw);
@@ -1824,10 +2307,11 @@ namespace stenos
 
 				// Compress
 				size_t r = compress(decompressed->storage);
-				if (r != stenos_private_block_csize(decompressed->buffer)) {
+				synopsis_update(index, decompressed->data(), decompressed->size);
+				if (!reuse_block(decompressed->buffer, r)) {
 					char* buff = allocate_buffer_for_compression((unsigned)r, bucket, index, decompressed);
 					if (decompressed->buffer)
-						RebindAlloc<char>(*this).deallocate(decompressed->buffer, stenos_private_block_csize(decompressed->buffer));
+						deallocate_block(decompressed->buffer);
 					decompressed->buffer = buff;
 				}
 				memcpy(decompressed->buffer, compression_buffer(), r);
@@ -1870,6 +2354,7 @@ namespace stenos
 					BucketType* pack = &d_buckets[index];
 					RawType* raw = make_or_find_free_context(exclude == static_cast<size_t>(-1) ? nullptr : d_buckets[exclude].load_decompressed());
 					raw->block_index = index;
+					cache_count(d_cache.misses);
 
 					this->decompress(pack, raw->storage);
 					char* buffer = pack->data.find_compressed();
@@ -1882,14 +2367,16 @@ namespace stenos
 				return decompressed;
 			}
 
-			/// @brief Returns the class total memory footprint, including sizeof(*this)
+			/// @brief Returns the class total memory footprint, including sizeof(*this).
+			/// Per-thread block contexts are shared by all cvectors and not included.
 			auto memory_footprint() const noexcept -> size_t
 			{
-				size_t res = stenos_memory_footprint(d_ctx);
+				size_t res = 0;
 				for (size_t i = 0; i < d_buckets.size(); ++i)
 					res += stenos_private_block_csize(d_buckets[i].data.find_compressed());
 				res += d_buckets.capacity() * sizeof(BucketType);
 				res += d_contexts.size() * sizeof(RawType);
+				res += d_synopsis.capacity() * sizeof(Synopsis);
 				res += sizeof(*this);
 				return res;
 			}
@@ -1916,7 +2403,7 @@ namespace stenos
 					if (d_buckets.back().load_decompressed()->size == 0) {
 						d_buckets.back().load_decompressed()->block_index = RawType::invalid_index;
 						d_buckets.back().load_decompressed()->mark_not_dirty(); // mark not dirty anymore
-						d_buckets.pop_back();
+						pop_back_bucket();
 					}
 					throw;
 				}
@@ -1937,7 +2424,7 @@ namespace stenos
 			void deallocate_buffer(size_t index) noexcept
 			{
 				if (auto buf = d_buckets[index].data.find_compressed()) {
-					RebindAlloc<char>(*this).deallocate(buf, stenos_private_block_csize(buf));
+					deallocate_block(buf);
 					if (d_buckets[index].data.compressed())
 						d_buckets[index].data.set(nullptr, Compressed);
 					else
@@ -1959,7 +2446,7 @@ namespace stenos
 					// Ensure we can lock the bucket to avoid dangling references
 					check_destroy_bucket(d_buckets.size() - 1);
 
-					d_buckets.pop_back();
+					pop_back_bucket();
 					raw = d_buckets.back().load_decompressed();
 				}
 				// decompress back bucket if necessary
@@ -1987,7 +2474,7 @@ namespace stenos
 					// Ensure we can lock the bucket to avoid dangling references
 					check_destroy_bucket(d_buckets.size() - 1);
 
-					d_buckets.pop_back();
+					pop_back_bucket();
 				}
 			}
 
@@ -2022,7 +2509,7 @@ namespace stenos
 						deallocate_buffer(d_buckets.size() - 1);
 						if (d_buckets.back().load_decompressed())
 							erase_context(d_buckets.back().load_decompressed());
-						d_buckets.pop_back();
+						pop_back_bucket();
 
 						d_size -= block_size;
 					}
@@ -2064,14 +2551,14 @@ namespace stenos
 							char* buff = nullptr;
 							try {
 								// might throw, see below
-								buff = RebindAlloc<char>(*this).allocate(r);
+								buff = allocate_block(r);
 								d_buckets.push_back(BucketType(nullptr, buff, (unsigned)r));
 								memcpy(buff, compression_buffer(), r);
 							}
 							catch (...) {
 								// In case of exception, free buffer if necessary and destroy elements
 								if (buff)
-									RebindAlloc<char>(*this).deallocate(buff, r);
+									deallocate_block(buff, r);
 								raw.clear_values();
 								throw;
 							}
@@ -2117,14 +2604,14 @@ namespace stenos
 
 							char* buff = nullptr;
 							try {
-								buff = RebindAlloc<char>(*this).allocate(r);
+								buff = allocate_block(r);
 								d_buckets.push_back(BucketType(nullptr, buff, (unsigned)r));
 								memcpy(buff, compression_buffer(), r);
 							}
 							catch (...) {
 								// In case of exception, free buffer if necessary and destroy elements
 								if (buff)
-									RebindAlloc<char>(*this).deallocate(buff, r);
+									deallocate_block(buff, r);
 								raw.clear_values();
 								throw;
 							}
@@ -2141,6 +2628,76 @@ namespace stenos
 				}
 			}
 
+			/// @brief Back insertion of n values.
+			/// For trivially copyable types, full chunks are compressed straight from data, in parallel if threads > 1.
+			void append(const T* data, size_t n, int threads)
+			{
+				// finish filling back buffer
+				for (; n && (size() & mask); --n)
+					emplace_back(*data++);
+				append_chunks(data, n, threads, std::is_trivially_copyable<T>{});
+			}
+			void append_chunks(const T* data, size_t n, int, std::false_type)
+			{
+				for (; n; --n)
+					emplace_back(*data++);
+			}
+			void append_chunks(const T* data, size_t n, int threads, std::true_type)
+			{
+				struct Batch
+				{
+					const ThisType* self;
+					const T* src;
+					char* dst;
+					size_t* sizes;
+					int level;
+					uint64_t max_nanoseconds;
+					static void compress_chunk(void* opaque, size_t i) noexcept
+					{
+						// The block context is shared by all cvectors of this thread: apply this container parameters
+						Batch* b = static_cast<Batch*>(opaque);
+						stenos_context* ctx = b->self->block_context();
+						stenos_set_level(ctx, b->level);
+						stenos_set_max_nanoseconds(ctx, b->max_nanoseconds);
+						set_block_layout(ctx);
+						size_t r = stenos_private_compress_block(
+						  ctx, b->src + i * block_size, sizeof(T), block_bytes, block_bytes, b->dst + i * dst_block_bytes, dst_block_bytes);
+						if (stenos_has_error(r))
+							STENOS_ABORT("cvector: abort on compression error") // no way to recover from this
+						b->sizes[i] = r;
+					}
+				};
+
+				if (size_t chunks = n / block_size) {
+					// Chunks are compressed by batches in a temporary buffer, and copied to their
+					// own allocation by the calling thread: the allocator is never used concurrently.
+					const size_t batch_size = std::min(chunks, (size_t)(threads > 1 ? threads : 1) * 16u);
+					std::vector<char, RebindAlloc<char>> dst(batch_size * dst_block_bytes, 0, RebindAlloc<char>(*this));
+					std::vector<size_t, RebindAlloc<size_t>> sizes(batch_size, 0, RebindAlloc<size_t>(*this));
+					d_buckets.reserve(d_buckets.size() + chunks + 1);
+
+					for (size_t c = 0; c < chunks; c += batch_size) {
+						size_t count = std::min(batch_size, chunks - c);
+						Batch b{ this, data + c * block_size, dst.data(), sizes.data(), d_level, d_max_nanoseconds };
+						stenos_private_parallel_for(threads, count, Batch::compress_chunk, &b);
+
+						for (size_t i = 0; i < count; ++i) {
+							size_t r = sizes[i];
+							char* buff = allocate_block(r);
+							memcpy(buff, dst.data() + i * dst_block_bytes, r);
+							d_buckets.push_back(BucketType(nullptr, buff, (unsigned)r)); // cannot throw thanks to reserve()
+							d_size += block_size;
+						}
+					}
+					data += chunks * block_size;
+					n -= chunks * block_size;
+				}
+
+				// finish with last elements
+				for (; n; --n)
+					emplace_back(*data++);
+			}
+
 			/// @brief Erase range
 			auto erase(const_iterator first, const_iterator last) -> const_iterator
 			{
@@ -2268,6 +2825,8 @@ namespace stenos
 					if (!cur) {
 						cur = const_cast<ThisType*>(this)->decompress_bucket(bindex);
 					}
+					else
+						const_cast<ThisType*>(this)->cache_hit(cur);
 					remaining -= to_process;
 					size_t en = pos + to_process;
 					for (size_t p = pos; p != en; ++p, ++res)
@@ -2299,6 +2858,8 @@ namespace stenos
 					if (!cur) {
 						cur = this->decompress_bucket(bindex);
 					}
+					else
+						const_cast<ThisType*>(this)->cache_hit(cur);
 					remaining -= to_process;
 					size_t en = pos + to_process;
 					for (size_t p = pos; p != en; ++p, ++res)
@@ -2332,6 +2893,8 @@ namespace stenos
 					if (!cur) {
 						cur = const_cast<ThisType*>(this)->decompress_bucket(bindex);
 					}
+					else
+						const_cast<ThisType*>(this)->cache_hit(cur);
 					difference_type low = bindex == first_bucket ? first_index : 0;
 					difference_type high = bindex == last_bucket ? last_index : static_cast<difference_type>(block_size - 1);
 					for (difference_type i = high; i >= low; --i, ++res)
@@ -2363,6 +2926,8 @@ namespace stenos
 					if (!cur) {
 						cur = this->decompress_bucket(bindex);
 					}
+					else
+						const_cast<ThisType*>(this)->cache_hit(cur);
 					difference_type low = bindex == first_bucket ? first_index : 0;
 					difference_type high = bindex == last_bucket ? last_index : static_cast<difference_type>(block_size - 1);
 					for (difference_type i = high; i >= low; --i, ++res)
@@ -2373,75 +2938,1003 @@ namespace stenos
 
 				return res;
 			}
-		};
 
-		// Check for input iterator
-		template<typename Iterator>
-		using IfIsInputIterator = typename std::enable_if<std::is_convertible<typename std::iterator_traits<Iterator>::iterator_category, std::input_iterator_tag>::value, bool>::type;
-	}
+			/// @brief Copy values in [start, start + n) to out, chunk by chunk.
+			/// Full chunks that are not already decompressed are decompressed straight to out for trivially copyable types.
+			void copy_to(size_t start, size_t n, T* out) const
+			{
+				STENOS_ASSERT_DEBUG(start + n <= d_size, "copy_to: invalid range");
+				ThisType* self = const_cast<ThisType*>(this);
+				for (size_t end = start + n, bindex = start >> shift; start < end; ++bindex) {
+					size_t pos = start & mask;
+					size_t count = std::min(end - start, block_size - pos);
+					start += count;
 
-	/// @brief vector like class using compression to store its elements
-	/// @tparam T value type, must be relocatable
-	/// @tparam Allocator allocator type
-	/// @tparam Level acceleratio nparameter for the compression algorithm, from 0 to 7
-	/// @tparam Encoder encoder type, default to DefaultEncoder
-	/// @tparam block_size number of elements per chunks, must be a power of 2
-	///
-	/// stenos::cvector is a is a random-access container with an interface similar to std::vector but storing its element in a compressed way.
-	/// Its goal is to reduce the memory footprint of the container while providing performances as close as possible to std::vector.
-	///
-	template<class T, unsigned BlockSize = 0, int Level = 1, class Allocator = std::allocator<T>>
-	class cvector : private Allocator
-	{
-		static_assert(Level <= 9, "invalid compression level");
-		static_assert(sizeof(T) < STENOS_MAX_BYTESOFTYPE, "invalide type size");
-		static_assert(((sizeof(T) * 256) << BlockSize) < STENOS_MAX_BLOCK_BYTES, "invalid block size");
+					std::shared_lock<SharedSpinner> lock(d_buckets[bindex].get().ref_count);
+					const RawType* cur = d_buckets[bindex].load_decompressed();
+					if (!cur && count == block_size && std::is_trivially_copyable<T>::value)
+						self->decompress(&self->d_buckets[bindex], out);
+					else {
+						if (!cur)
+							cur = self->decompress_bucket(bindex);
+						else
+							self->cache_hit(cur);
+						std::copy(cur->data() + pos, cur->data() + pos + count, out);
+					}
+					out += count;
+				}
+			}
 
-		using internal_type = detail::CompressedVectorInternal<T, Allocator, BlockSize, Level>;
-		using bucket_type = typename internal_type::BucketType;
-		template<class U>
-		using RebindAlloc = typename std::allocator_traits<Allocator>::template rebind_alloc<U>;
+			/// @brief Copy n values from in to [start, start + n), chunk by chunk.
+			/// Full chunks that are not already decompressed are compressed straight from in for trivially copyable types.
+			void copy_from(size_t start, const T* in, size_t n)
+			{
+				STENOS_ASSERT_DEBUG(start + n <= d_size, "copy_from: invalid range");
+				for (size_t end = start + n, bindex = start >> shift; start < end; ++bindex) {
+					size_t pos = start & mask;
+					size_t count = std::min(end - start, block_size - pos);
+					start += count;
 
-		static constexpr size_t shift = internal_type::shift;
+					std::lock_guard<SharedSpinner> lock(d_buckets[bindex].ref_count);
+					RawType* cur = d_buckets[bindex].load_decompressed();
+					if (!cur && count == block_size && std::is_trivially_copyable<T>::value) {
+						// Replace the compressed chunk
+						BucketType* pack = &d_buckets[bindex];
+						size_t r = compress(in);
+						synopsis_update(bindex, in, block_size);
+						char* old = pack->data.compressed();
+						char* buff = old;
+						if (!reuse_block(old, r)) {
+							std::lock_guard<SharedSpinner> ll(d_lock);
+							buff = allocate_block(r); // might throw, fine
+							deallocate_block(old);
+						}
+						memcpy(buff, compression_buffer(), r);
+						pack->data.set(buff, Compressed);
+					}
+					else {
+						if (!cur)
+							cur = decompress_bucket(bindex);
+						else
+							cache_hit(cur);
+						std::copy(in, in + count, cur->data() + pos);
+						cur->mark_dirty(this);
+					}
+					in += count;
+				}
+			}
 
-		internal_type* d_data; // Store a pointer to internal data, easier to provide noexcept move constructor/copy and iterator stability on swap
+			/// @brief Remove back bucket
+			STENOS_ALWAYS_INLINE void pop_back_bucket() noexcept
+			{
+				d_buckets.pop_back();
+				synopsis_truncate(d_buckets.size());
+			}
 
-		internal_type* make_internal(const Allocator& al)
-		{
-			RebindAlloc<internal_type> a = al;
-			internal_type* ret = nullptr;
-			try {
-				ret = a.allocate(1);
-				return new (ret) internal_type(al);
+			static auto make_synopsis(const T* values, size_t n) noexcept -> Synopsis
+			{
+				Synopsis res{ values[0], values[0], true };
+				for (size_t i = 1; i < n; ++i) {
+					if (values[i] < res.min)
+						res.min = values[i];
+					if (res.max < values[i])
+						res.max = values[i];
+				}
+				return res;
 			}
-			catch (...) {
-				if (ret)
-					a.deallocate(ret, 1);
-				throw;
+			/// @brief Update the stored synopsis of a bucket that is about to be compressed
+			void synopsis_update(size_t index, const T* values, size_t n) noexcept { synopsis_update(index, values, n, std::is_arithmetic<T>{}); }
+			void synopsis_update(size_t, const T*, size_t, std::false_type) noexcept {}
+			void synopsis_update(size_t index, const T* values, size_t n, std::true_type) noexcept
+			{
+				if (!d_synopsis_enabled)
+					return;
+				std::lock_guard<SharedSpinner> ll(d_synopsis_lock);
+				if (index < d_synopsis.size())
+					d_synopsis[index] = make_synopsis(values, n);
+			}
+			/// @brief Forget stored synopsis of buckets starting from index
+			void synopsis_truncate(size_t index) noexcept
+			{
+				if (!d_synopsis_enabled)
+					return;
+				std::lock_guard<SharedSpinner> ll(d_synopsis_lock);
+				if (index < d_synopsis.size())
+					d_synopsis.resize(index);
+			}
+			void enable_synopsis(bool enable)
+			{
+				std::lock_guard<SharedSpinner> ll(d_synopsis_lock);
+				d_synopsis_enabled = enable;
+				if (!enable)
+					d_synopsis = decltype(d_synopsis)(d_synopsis.get_allocator());
 			}
-			return ret;
-		}
-		void destroy_internal(internal_type* data) noexcept
-		{
-			data->~internal_type();
-			RebindAlloc<internal_type> a = get_allocator();
-			a.deallocate(data, 1);
-		}
 
-		void make_data_if_null()
-		{
-			if (!d_data)
-				d_data = make_internal(get_allocator());
-		}
+			/// @brief Returns the min/max values of given bucket, which must be referenced.
+			/// The synopsis of a non dirty bucket is computed once and stored if enabled.
+			auto bucket_synopsis(size_t index) const -> Synopsis
+			{
+				const RawType* raw = d_buckets[index].load_decompressed();
+				if (raw && raw->dirty)
+					return make_synopsis(raw->data(), raw->size);
+				if (d_synopsis_enabled) {
+					std::shared_lock<SharedSpinner> ll(const_cast<ThisType*>(this)->d_synopsis_lock);
+					if (index < d_synopsis.size() && d_synopsis[index].valid)
+						return d_synopsis[index];
+				}
 
-		/// @brief Returns the compressed buffer for given block.
-		/// This function will compress if necessary the corresponding block and deallocate the decompression context (if any).
-		/// For all blocks except the last one, this function returns a view on compression buffer.
-		/// For the last block, returns a null buffer.
-		std::pair<const char*, size_t> compressed_block(size_t pos)
-		{
-			if (!d_data || pos == d_data->d_buckets.size() - 1)
-				return { nullptr, 0 };
+				Synopsis res;
+				if (raw)
+					res = make_synopsis(raw->data(), raw->size);
+				else {
+					// Decompress without using (and polluting) the decompression contexts
+					alignas(16) char tmp[block_bytes];
+					const_cast<ThisType*>(this)->decompress(&d_buckets[index].get(), tmp);
+					res = make_synopsis(reinterpret_cast<const T*>(tmp), block_size);
+				}
+				if (d_synopsis_enabled) {
+					ThisType* self = const_cast<ThisType*>(this);
+					std::lock_guard<SharedSpinner> ll(self->d_synopsis_lock);
+					if (index >= d_synopsis.size())
+						self->d_synopsis.resize(index + 1);
+					self->d_synopsis[index] = res;
+				}
+				return res;
+			}
+
+			/// @brief Binary search on a sorted vector, returns the first position for which
+			/// comp(value, element) (Upper is true) or !comp(element, value) (Upper is false) holds.
+			template<bool Upper>
+			auto bound(const T& value) const -> size_t
+			{
+				if (!d_synopsis_enabled) {
+					// Regular binary search
+					const_iterator first(this, 0), last(this, d_size);
+					return (size_t)((Upper ? std::upper_bound(first, last, value) : std::lower_bound(first, last, value)) - first);
+				}
+
+				ThisType* self = const_cast<ThisType*>(this);
+				// Find the first bucket which max value is not lower (or greater, for upper bound) than value
+				size_t lo = 0, hi = d_buckets.size();
+				while (lo < hi) {
+					size_t mid = lo + (hi - lo) / 2;
+					std::shared_lock<SharedSpinner> lock(d_buckets[mid].get().ref_count);
+					Synopsis syn = bucket_synopsis(mid);
+					if (Upper ? !(value < syn.max) : syn.max < value)
+						lo = mid + 1;
+					else
+						hi = mid;
+				}
+				if (lo == d_buckets.size())
+					return d_size;
+
+				// Search inside bucket
+				std::shared_lock<SharedSpinner> lock(d_buckets[lo].get().ref_count);
+				const RawType* cur = d_buckets[lo].load_decompressed();
+				if (!cur)
+					cur = self->decompress_bucket(lo);
+				else
+					self->cache_hit(cur);
+				const T* values = cur->data();
+				const T* found = Upper ? std::upper_bound(values, values + cur->size, value) : std::lower_bound(values, values + cur->size, value);
+				return (lo << shift) + (size_t)(found - values);
+			}
+
+			/// @brief Apply fun on values in [start, end), skipping buckets for which pred(min, max) returns false.
+			/// The function can stop early if provided functor returns false.
+			/// @return the number of successfully processed values
+			template<class BlockPred, class Functor>
+			auto const_for_each_if(size_t start, size_t end, BlockPred&& pred, Functor&& fun) const -> size_t
+			{
+				STENOS_ASSERT_DEBUG(start <= end && end <= d_size, "const_for_each_if: invalid range");
+				ThisType* self = const_cast<ThisType*>(this);
+				size_t res = 0;
+				for (size_t bindex = start >> shift; start < end; ++bindex) {
+					size_t pos = start & mask;
+					size_t en = std::min(end - start, block_size - pos) + pos;
+					start += en - pos;
+
+					std::shared_lock<SharedSpinner> lock(d_buckets[bindex].get().ref_count);
+					Synopsis syn = bucket_synopsis(bindex);
+					if (!pred(syn.min, syn.max))
+						continue;
+					const RawType* cur = d_buckets[bindex].load_decompressed();
+					if (!cur)
+						cur = self->decompress_bucket(bindex);
+					else
+						self->cache_hit(cur);
+					for (size_t p = pos; p != en; ++p, ++res)
+						if (!eval_functor(std::forward<Functor>(fun), cur->at(p)))
+							return res;
+				}
+				return res;
+			}
+
+			// Sum type of reduce(), see stenos_reduce()
+			using sum_type = typename std::conditional<std::is_floating_point<T>::value,
+								   double,
+								   typename std::conditional<std::is_signed<T>::value, int64_t, uint64_t>::type>::type;
+
+			/// @brief Result of reduce()
+			struct Reduction
+			{
+				sum_type sum{ 0 };
+				T min{};
+				T max{};
+				uint64_t equal{ 0 };
+				size_t count{ 0 };
+
+				void add(sum_type s, T mn, T mx, uint64_t eq, size_t n) noexcept
+				{
+					// Integer sums wrap modulo 2^64
+					sum = std::is_floating_point<T>::value ? sum + s : (sum_type)((uint64_t)sum + (uint64_t)s);
+					if (!count || mn < min)
+						min = mn;
+					if (!count || max < mx)
+						max = mx;
+					equal += eq;
+					count += n;
+				}
+			};
+
+			/// @brief Apply reduction op (STENOS_REDUCE_SUM...) on values in [start, end).
+			/// Whole compressed buckets are reduced with stenos_private_reduce_block() without full decompression,
+			/// decompressed buckets are scanned in place. STENOS_REDUCE_MIN and STENOS_REDUCE_MAX use the synopsis if enabled.
+			auto reduce(size_t start, size_t end, int op, const T& value) const -> Reduction
+			{
+				STENOS_ASSERT_DEBUG(start <= end && end <= d_size, "reduce: invalid range");
+				static constexpr int type = std::is_floating_point<T>::value ? STENOS_REDUCE_FLOAT : (std::is_signed<T>::value ? STENOS_REDUCE_SIGNED : STENOS_REDUCE_UNSIGNED);
+				ThisType* self = const_cast<ThisType*>(this);
+				Reduction res;
+				for (size_t bindex = start >> shift; start < end; ++bindex) {
+					size_t pos = start & mask;
+					size_t count = std::min(end - start, block_size - pos);
+					start += count;
+
+					std::shared_lock<SharedSpinner> lock(d_buckets[bindex].get().ref_count);
+					const RawType* cur = d_buckets[bindex].load_decompressed();
+					if (count == block_size && d_synopsis_enabled && (op == STENOS_REDUCE_MIN || op == STENOS_REDUCE_MAX)) {
+						Synopsis syn = bucket_synopsis(bindex);
+						res.add(0, syn.min, syn.max, 0, count);
+						continue;
+					}
+					if (!cur && count == block_size) {
+						const char* buf = d_buckets[bindex].data.find_compressed();
+						alignas(8) char out[sizeof(T) > 8 ? sizeof(T) : 8];
+						size_t r = stenos_private_reduce_block(block_context(), buf, sizeof(T), block_bytes, stenos_private_block_csize(buf), block_bytes, op | type, &value, out);
+						if (stenos_has_error(r) || r != block_size)
+							STENOS_ABORT("cvector: abort on reduction error")
+						sum_type s = 0;
+						T v{};
+						uint64_t eq = 0;
+						if (op == STENOS_REDUCE_SUM)
+							memcpy(&s, out, sizeof(s));
+						else if (op == STENOS_REDUCE_COUNT_EQ)
+							memcpy(&eq, out, sizeof(eq));
+						else
+							memcpy(&v, out, sizeof(T));
+						res.add(s, v, v, eq, count);
+						continue;
+					}
+					if (!cur)
+						cur = self->decompress_bucket(bindex);
+					else
+						self->cache_hit(cur);
+
+					const T* p = cur->data() + pos;
+					sum_type s = 0;
+					uint64_t eq = 0;
+					T mn = p[0], mx = p[0];
+					switch (op) {
+						case STENOS_REDUCE_SUM:
+							for (size_t i = 0; i < count; ++i)
+								s = std::is_floating_point<T>::value ? s + (sum_type)p[i] : (sum_type)((uint64_t)s + (uint64_t)(sum_type)p[i]);
+							break;
+						case STENOS_REDUCE_MIN:
+						case STENOS_REDUCE_MAX:
+							for (size_t i = 1; i < count; ++i) {
+								if (p[i] < mn)
+									mn = p[i];
+								if (mx < p[i])
+									mx = p[i];
+							}
+							break;
+						default:
+							// Bitwise equality, like stenos_reduce()
+							for (size_t i = 0; i < count; ++i)
+								eq += memcmp(p + i, &value, sizeof(T)) == 0;
+							break;
+					}
+					res.add(s, mn, mx, eq, count);
+				}
+				return res;
+			}
+
+			/// @brief Returns the number of parts used to process [start, end) with given number of threads
+			auto parallel_parts(size_t start, size_t end, int threads) const noexcept -> size_t
+			{
+				if (start == end)
+					return 0;
+				size_t buckets = ((end - 1) >> shift) - (start >> shift) + 1;
+				return std::min(buckets, (size_t)(threads > 1 ? threads : 1));
+			}
+
+			/// @brief Apply fun(part, value) on [start, end) split in parts of contiguous chunks.
+			/// Parts are processed in parallel using parallel_parts(start, end, threads) threads.
+			/// Chunks that are not already decompressed are decompressed in a buffer owned by the part,
+			/// and recompressed (non const version) by the same worker, without using the shared decompression contexts.
+			template<bool Const, class PartFunctor>
+			void parallel_for_each(size_t start, size_t end, PartFunctor& fun, int threads)
+			{
+				STENOS_ASSERT_DEBUG(start <= end, "for_each: invalid range");
+				STENOS_ASSERT_DEBUG(end <= d_size, "for_each: invalid range");
+				size_t parts = parallel_parts(start, end, threads);
+				if (parts == 0)
+					return;
+
+				struct Job
+				{
+					ThisType* self;
+					PartFunctor* fun;
+					size_t start, end, first_bucket, buckets, parts;
+					std::mutex lock;
+					std::exception_ptr error;
+
+					static void apply(void* opaque, size_t part) noexcept
+					{
+						Job* j = static_cast<Job*>(opaque);
+						try {
+							j->self->template process_part<Const>(*j->fun,
+											       part,
+											       std::max(j->start, (j->first_bucket + j->buckets * part / j->parts) << shift),
+											       std::min(j->end, (j->first_bucket + j->buckets * (part + 1) / j->parts) << shift));
+						}
+						catch (...) {
+							std::lock_guard<std::mutex> ll(j->lock);
+							if (!j->error)
+								j->error = std::current_exception();
+						}
+					}
+				};
+				Job job{ this, &fun, start, end, start >> shift, ((end - 1) >> shift) - (start >> shift) + 1, parts, {}, nullptr };
+				stenos_private_parallel_for(threads, parts, Job::apply, &job);
+				if (job.error)
+					std::rethrow_exception(job.error);
+			}
+
+			/// @brief Re-encode all chunks with given compression level, using up to threads workers
+			void recompress(int new_level, int threads)
+			{
+				d_level = new_level < 0 ? 0 : (new_level > 9 ? 9 : new_level);
+				// Compress dirty chunks and release decompressed ones, then re-encode compressed chunks in place
+				shrink_to_fit();
+				auto fun = [](size_t, T&) noexcept {};
+				parallel_for_each<false>(0, d_size, fun, threads);
+			}
+
+			// sort() first sorts runs of sort_run_chunks chunks, then merges sort_fan_in runs at a time
+			static constexpr size_t sort_run_chunks = 16;
+			static constexpr size_t sort_fan_in = 16;
+
+			/// @brief State of a sort() pass
+			template<class Less>
+			struct SortPass
+			{
+				ThisType* self;
+				Less* less;
+				size_t size;	  // number of values
+				size_t full;	  // number of values in full chunks
+				size_t run;	  // length of input runs
+				size_t fan_in;	  // number of runs merged by a group, 1 to sort runs
+				const T* tail_in; // values of the trailing partial chunk
+				T* tail_out;
+				char** blocks; // new compressed chunks, null for unmodified ones
+				std::mutex lock;
+				std::exception_ptr error;
+
+				static void apply(void* opaque, size_t group) noexcept
+				{
+					SortPass* p = static_cast<SortPass*>(opaque);
+					try {
+						p->self->sort_group(*p, group);
+					}
+					catch (...) {
+						std::lock_guard<std::mutex> ll(p->lock);
+						if (!p->error)
+							p->error = std::current_exception();
+					}
+				}
+			};
+
+			/// @brief Temporary storage of n values, not constructed (trivially copyable types only)
+			struct SortBuffer
+			{
+				RebindAlloc<T> al;
+				size_t n;
+				T* data;
+				SortBuffer(const RebindAlloc<T>& a, size_t count)
+				  : al(a)
+				  , n(count)
+				  , data(count ? std::allocator_traits<RebindAlloc<T>>::allocate(al, count) : nullptr)
+				{
+				}
+				~SortBuffer() noexcept
+				{
+					if (data)
+						std::allocator_traits<RebindAlloc<T>>::deallocate(al, data, n);
+				}
+			};
+
+			/// @brief Load chunk c of a sort() pass input
+			template<class Pass>
+			void sort_load(const Pass& p, size_t c, T* dst) noexcept
+			{
+				if ((c << shift) < p.full)
+					decompress(&d_buckets[c], dst);
+				else
+					memcpy(dst, p.tail_in, (p.size - p.full) * sizeof(T));
+			}
+			/// @brief Store chunk c of a sort() pass output in a new compressed buffer
+			template<class Pass>
+			void sort_store(Pass& p, size_t c, const T* src)
+			{
+				if ((c << shift) >= p.full) {
+					memcpy(p.tail_out, src, (p.size - p.full) * sizeof(T));
+					return;
+				}
+				size_t r = compress(src);
+				char* buff;
+				{
+					std::lock_guard<SharedSpinner> ll(d_lock);
+					buff = allocate_block(r); // might throw, fine
+				}
+				memcpy(buff, compression_buffer(), r);
+				p.blocks[c] = buff;
+			}
+
+			/// @brief Sort a run (fan_in == 1), or merge the runs of given group of a sort() pass
+			template<class Pass>
+			void sort_group(Pass& p, size_t group)
+			{
+				const size_t start = group * p.fan_in * p.run;
+				const size_t end = std::min(p.size, start + p.fan_in * p.run);
+				const size_t first_chunk = start >> shift;
+				const size_t chunks = ((end - start) + block_size - 1) >> shift;
+				auto& less = *p.less;
+
+				if (p.fan_in == 1) {
+					// Sort the run in memory
+					SortBuffer buf(RebindAlloc<T>(*this), chunks * block_size);
+					for (size_t c = 0; c < chunks; ++c)
+						sort_load(p, first_chunk + c, buf.data + (c << shift));
+					std::sort(buf.data, buf.data + (end - start), less);
+					for (size_t c = 0; c < chunks; ++c)
+						sort_store(p, first_chunk + c, buf.data + (c << shift));
+					return;
+				}
+
+				const size_t runs = (end - start + p.run - 1) / p.run;
+				if (runs == 1) {
+					// Nothing to merge, keep the compressed chunks
+					if (end > p.full)
+						memcpy(p.tail_out, p.tail_in, (p.size - p.full) * sizeof(T));
+					return;
+				}
+
+				// One decompressed chunk per run, and one output chunk
+				struct Cursor
+				{
+					size_t next, end;
+					const T* cur;
+					const T* last;
+				};
+				SortBuffer buf(RebindAlloc<T>(*this), (runs + 1) * block_size);
+				Cursor cursors[sort_fan_in];
+				size_t heap[sort_fan_in];
+				auto load = [&](size_t i) {
+					Cursor& c = cursors[i];
+					T* dst = buf.data + i * block_size;
+					sort_load(p, c.next >> shift, dst);
+					size_t count = std::min(block_size, c.end - c.next);
+					c.cur = dst;
+					c.last = dst + count;
+					c.next += count;
+				};
+				for (size_t i = 0; i < runs; ++i) {
+					cursors[i].next = start + i * p.run;
+					cursors[i].end = std::min(end, cursors[i].next + p.run);
+					load(i);
+					heap[i] = i;
+				}
+
+				// Min heap of cursors
+				auto greater = [&](size_t a, size_t b) { return less(*cursors[b].cur, *cursors[a].cur); };
+				std::make_heap(heap, heap + runs, greater);
+				T* out = buf.data + runs * block_size;
+				size_t out_chunk = first_chunk;
+				size_t out_count = 0;
+				for (size_t count = runs; count;) {
+					Cursor& c = cursors[heap[0]];
+					out[out_count++] = *c.cur++;
+					if (out_count == block_size) {
+						sort_store(p, out_chunk++, out);
+						out_count = 0;
+					}
+					if (c.cur == c.last) {
+						if (c.next == c.end) {
+							std::pop_heap(heap, heap + count, greater);
+							--count;
+							continue;
+						}
+						load(heap[0]);
+					}
+					// Sift down the top cursor
+					size_t i = 0, top = heap[0];
+					for (;;) {
+						size_t child = 2 * i + 1;
+						if (child >= count)
+							break;
+						if (child + 1 < count && greater(heap[child], heap[child + 1]))
+							++child;
+						if (!greater(top, heap[child]))
+							break;
+						heap[i] = heap[child];
+						i = child;
+					}
+					heap[i] = top;
+				}
+				if (out_count)
+					sort_store(p, out_chunk, out);
+			}
+
+			/// @brief Sort values using less, see cvector::sort()
+			template<class Less>
+			void sort(Less& less, int threads)
+			{
+				const size_t n = d_size;
+				if (n < 2)
+					return;
+				// Compress dirty chunks and release decompressed ones
+				shrink_to_fit();
+
+				const size_t full = n & ~mask;
+				const size_t tail = n - full;
+				SortBuffer tails(RebindAlloc<T>(*this), tail ? 2 * block_size : 0);
+				T* tail_in = tails.data;
+				T* tail_out = tails.data ? tails.data + block_size : nullptr;
+				if (tail)
+					copy_to(full, tail, tail_in);
+
+				std::vector<char*, RebindAlloc<char*>> blocks(full >> shift, nullptr, RebindAlloc<char*>(*this));
+				size_t run = sort_run_chunks * block_size;
+				size_t fan_in = 1;
+				for (;;) {
+					size_t groups = (n + run * fan_in - 1) / (run * fan_in);
+					SortPass<Less> pass{ this, &less, n, full, run, fan_in, tail_in, tail_out, blocks.data(), {}, nullptr };
+					stenos_private_parallel_for(threads, groups, SortPass<Less>::apply, &pass);
+					if (pass.error) {
+						for (char*& b : blocks)
+							if (b) {
+								deallocate_block(b);
+								b = nullptr;
+							}
+						std::rethrow_exception(pass.error);
+					}
+
+					// Replace the compressed chunks
+					for (size_t c = 0; c < blocks.size(); ++c) {
+						if (!blocks[c])
+							continue;
+						BucketType* pack = &d_buckets[c];
+						deallocate_block(pack->data.find_compressed());
+						if (RawType* raw = pack->load_decompressed()) {
+							raw->buffer = blocks[c];
+							decompress(pack, raw->storage);
+							raw->dirty = 0;
+						}
+						else
+							pack->data.set(blocks[c], Compressed);
+						blocks[c] = nullptr;
+					}
+					std::swap(tail_in, tail_out);
+
+					if (fan_in > 1)
+						run *= fan_in;
+					if (run >= n)
+						break;
+					fan_in = sort_fan_in;
+				}
+
+				synopsis_truncate(0);
+				if (tail)
+					copy_from(full, tail_in, tail);
+			}
+
+			/// @brief Process the range [start, end) of given part for parallel_for_each()
+			template<bool Const, class PartFunctor>
+			void process_part(PartFunctor& fun, size_t part, size_t start, size_t end)
+			{
+				using lock_type = typename std::conditional<Const, std::shared_lock<SharedSpinner>, std::unique_lock<SharedSpinner>>::type;
+				RawType* local = nullptr;
+				struct Release
+				{
+					ThisType* self;
+					RawType*& local;
+					~Release()
+					{
+						if (local) {
+							// Values were relocated to their compressed chunk, just release the memory
+							std::lock_guard<SharedSpinner> ll(self->d_lock);
+							RebindAlloc<char>(*self).deallocate(reinterpret_cast<char*>(local), sizeof(RawType));
+						}
+					}
+				} release{ this, local };
+
+				for (size_t bindex = start >> shift; start < end; ++bindex) {
+					size_t pos = start & mask;
+					size_t en = std::min(end - start, block_size - pos) + pos;
+					start += en - pos;
+
+					lock_type lock(d_buckets[bindex].get().ref_count);
+					BucketType* pack = &d_buckets[bindex];
+					if (RawType* cur = pack->load_decompressed()) {
+						// Already decompressed chunk
+						cache_hit(cur);
+						for (size_t p = pos; p != en; ++p)
+							fun(part, cur->at(p));
+						if (!Const)
+							cur->mark_dirty(this);
+						continue;
+					}
+
+					if (!local) {
+						std::lock_guard<SharedSpinner> ll(d_lock);
+						local = make_raw();
+					}
+					this->decompress(pack, local->storage);
+					if (Const) {
+						for (size_t p = pos; p != en; ++p)
+							fun(part, local->at(p));
+						continue;
+					}
+
+					// Apply on the local chunk and recompress it, even on exception
+					// since the compressed chunk might now reference released memory
+					std::exception_ptr error;
+					try {
+						for (size_t p = pos; p != en; ++p)
+							fun(part, local->at(p));
+					}
+					catch (...) {
+						error = std::current_exception();
+					}
+					size_t r = compress(local->storage);
+					synopsis_update(bindex, local->data(), block_size);
+					char* old = pack->data.compressed();
+					char* buff = old;
+					{
+						std::lock_guard<SharedSpinner> ll(d_lock);
+						if (!reuse_block(old, r)) {
+							buff = allocate_block(r); // might throw, the chunk keeps its previous content
+							deallocate_block(old);
+						}
+					}
+					memcpy(buff, compression_buffer(), r);
+					pack->data.set(buff, Compressed);
+					if (error)
+						std::rethrow_exception(error);
+				}
+			}
+		};
+
+		/// @brief Single pass range over [first, last) of a cvector.
+		/// While the caller consumes a chunk, the next depth chunks are decompressed on the thread pool.
+		/// All chunks of the read-ahead window are referenced, so that concurrent readers cannot steal them.
+		template<class Compressed>
+		class PrefetchRange
+		{
+			using T = typename Compressed::value_type;
+			static constexpr size_t shift = Compressed::shift;
+			static constexpr size_t mask = Compressed::mask;
+
+			struct Slot
+			{
+				Compressed* c;
+				size_t bucket;
+				void* task;
+				const T* values;
+				alignas(16) char storage[Compressed::block_bytes];
+
+				static void decompress(void* opaque) noexcept
+				{
+					Slot* s = static_cast<Slot*>(opaque);
+					s->c->decompress(&s->c->d_buckets[s->bucket], s->storage);
+				}
+			};
+
+			struct State
+			{
+				Compressed* c;
+				size_t pos;	     // current position
+				size_t last;	     // end position
+				size_t chunk_end;    // end position of the current chunk
+				size_t bucket;	     // current bucket
+				size_t next_bucket;  // next bucket to schedule
+				size_t end_bucket;   // one past the last bucket
+				size_t slot_count;   // depth + 1
+				const T* values;     // current chunk values
+				std::unique_ptr<Slot[]> slots;
+			};
+
+		protected:
+			std::unique_ptr<State> d_state;
+
+		private:
+
+			void schedule() noexcept
+			{
+				State& s = *d_state;
+				size_t b = s.next_bucket++;
+				Slot& slot = s.slots[b % s.slot_count];
+				slot.c = s.c;
+				slot.bucket = b;
+				slot.task = nullptr;
+				s.c->d_buckets[b].ref();
+				if (auto* raw = s.c->d_buckets[b].load_decompressed())
+					slot.values = raw->data();
+				else {
+					slot.values = reinterpret_cast<const T*>(slot.storage);
+					// Without read-ahead, decompress in the calling thread
+					if (s.slot_count == 1)
+						Slot::decompress(&slot);
+					else
+						slot.task = stenos_private_async(Slot::decompress, &slot);
+				}
+			}
+			void acquire() noexcept
+			{
+				State& s = *d_state;
+				Slot& slot = s.slots[s.bucket % s.slot_count];
+				if (slot.task) {
+					stenos_private_wait(slot.task);
+					slot.task = nullptr;
+				}
+				s.values = slot.values;
+				s.chunk_end = std::min(s.last, (s.bucket + 1) << shift);
+			}
+			void release() noexcept
+			{
+				// Release current bucket and schedule a new one in its slot
+				State& s = *d_state;
+				s.c->d_buckets[s.bucket].unref();
+				if (s.next_bucket < s.end_bucket)
+					schedule();
+			}
+
+		public:
+			class iterator
+			{
+				PrefetchRange* d_range{ nullptr };
+				bool done() const noexcept { return !d_range || !d_range->d_state || d_range->d_state->pos == d_range->d_state->last; }
+
+			public:
+				using iterator_category = std::input_iterator_tag;
+				using value_type = T;
+				using difference_type = std::ptrdiff_t;
+				using pointer = const T*;
+				using reference = const T&;
+
+				iterator() noexcept = default;
+				explicit iterator(PrefetchRange* r) noexcept
+				  : d_range(r)
+				{
+				}
+				auto operator*() const noexcept -> const T& { return d_range->d_state->values[d_range->d_state->pos & mask]; }
+				auto operator->() const noexcept -> const T* { return &**this; }
+				auto operator++() noexcept -> iterator&
+				{
+					d_range->advance(1);
+					return *this;
+				}
+				void operator++(int) noexcept { ++(*this); }
+				bool operator==(const iterator& other) const noexcept { return done() == other.done(); }
+				bool operator!=(const iterator& other) const noexcept { return done() != other.done(); }
+			};
+
+			PrefetchRange(Compressed* c, size_t first, size_t last, size_t depth)
+			{
+				STENOS_ASSERT_DEBUG(first <= last && last <= (c ? c->size() : 0), "prefetching_range: invalid range");
+				if (first == last)
+					return;
+				d_state.reset(new State());
+				State& s = *d_state;
+				s.c = c;
+				s.pos = first;
+				s.last = last;
+				s.bucket = s.next_bucket = first >> shift;
+				s.end_bucket = ((last - 1) >> shift) + 1;
+				s.slot_count = std::min(depth + 1, s.end_bucket - s.bucket);
+				s.slots.reset(new Slot[s.slot_count]);
+				while (s.next_bucket < s.end_bucket && s.next_bucket - s.bucket < s.slot_count)
+					schedule();
+				acquire();
+			}
+			PrefetchRange(PrefetchRange&&) noexcept = default;
+			PrefetchRange& operator=(PrefetchRange&&) = delete;
+			~PrefetchRange() noexcept
+			{
+				if (!d_state)
+					return;
+				// Wait for pending tasks and release referenced buckets
+				State& s = *d_state;
+				for (size_t b = s.bucket; b < s.next_bucket; ++b) {
+					Slot& slot = s.slots[b % s.slot_count];
+					if (slot.task)
+						stenos_private_wait(slot.task);
+					s.c->d_buckets[b].unref();
+				}
+			}
+
+			/// @brief Advance by count values
+			void advance(size_t count) noexcept
+			{
+				State& s = *d_state;
+				s.pos += count;
+				while (s.pos >= s.chunk_end && s.chunk_end != s.last) {
+					release();
+					++s.bucket;
+					acquire();
+				}
+			}
+
+			auto begin() noexcept -> iterator { return iterator(this); }
+			auto end() noexcept -> iterator { return iterator(); }
+
+			/// @brief Apply functor on all remaining values.
+			/// The function can stop early if provided functor returns false.
+			/// @return the number of successfully processed values.
+			template<class Functor>
+			auto for_each(Functor&& fun) -> size_t
+			{
+				size_t res = 0;
+				while (d_state && d_state->pos != d_state->last) {
+					State& s = *d_state;
+					size_t count = s.chunk_end - s.pos;
+					const T* values = s.values + (s.pos & mask);
+					for (size_t i = 0; i < count; ++i, ++res)
+						if (!eval_functor(std::forward<Functor>(fun), values[i])) {
+							advance(i);
+							return res;
+						}
+					advance(count);
+				}
+				return res;
+			}
+		};
+
+		/// @brief Single pass range over the decompressed chunks of a cvector, see cvector::chunks()
+		template<class Compressed>
+		class ChunkRange : public PrefetchRange<Compressed>
+		{
+			using base_type = PrefetchRange<Compressed>;
+			using T = typename Compressed::value_type;
+
+		public:
+			class iterator
+			{
+				ChunkRange* d_range{ nullptr };
+				bool done() const noexcept { return !d_range || !d_range->d_state || d_range->d_state->pos == d_range->d_state->last; }
+
+			public:
+				using iterator_category = std::input_iterator_tag;
+				using value_type = cvector_span<T>;
+				using difference_type = std::ptrdiff_t;
+				using pointer = const value_type*;
+				using reference = value_type;
+
+				iterator() noexcept = default;
+				explicit iterator(ChunkRange* r) noexcept
+				  : d_range(r)
+				{
+				}
+				auto operator*() const noexcept -> value_type
+				{
+					auto& s = *d_range->d_state;
+					return value_type{ s.pos, s.values + (s.pos & Compressed::mask), s.chunk_end - s.pos };
+				}
+				auto operator++() noexcept -> iterator&
+				{
+					d_range->advance(d_range->d_state->chunk_end - d_range->d_state->pos);
+					return *this;
+				}
+				void operator++(int) noexcept { ++(*this); }
+				bool operator==(const iterator& other) const noexcept { return done() == other.done(); }
+				bool operator!=(const iterator& other) const noexcept { return done() != other.done(); }
+			};
+
+			using base_type::base_type;
+			auto begin() noexcept -> iterator { return iterator(this); }
+			auto end() noexcept -> iterator { return iterator(); }
+		};
+
+		// Check for input iterator
+		template<typename Iterator>
+		using IfIsInputIterator = typename std::enable_if<std::is_convertible<typename std::iterator_traits<Iterator>::iterator_category, std::input_iterator_tag>::value, bool>::type;
+	}
+
+	/// @brief vector like class using compression to store its elements
+	/// @tparam T value type, must be relocatable
+	/// @tparam Allocator allocator type
+	/// @tparam Level acceleratio nparameter for the compression algorithm, from 0 to 7
+	/// @tparam Encoder encoder type, default to DefaultEncoder
+	/// @tparam block_size number of elements per chunks, must be a power of 2
+	///
+	/// stenos::cvector is a is a random-access container with an interface similar to std::vector but storing its element in a compressed way.
+	/// Its goal is to reduce the memory footprint of the container while providing performances as close as possible to std::vector.
+	///
+	template<class T, unsigned BlockSize = 0, int Level = 1, class Allocator = std::allocator<T>>
+	class cvector : private Allocator
+	{
+		static_assert(Level <= 9, "invalid compression level");
+		static_assert(sizeof(T) < STENOS_MAX_BYTESOFTYPE, "invalide type size");
+		static_assert(((sizeof(T) * 256) << BlockSize) < STENOS_MAX_BLOCK_BYTES, "invalid block size");
+
+		using internal_type = detail::CompressedVectorInternal<T, Allocator, BlockSize, Level>;
+		using bucket_type = typename internal_type::BucketType;
+		template<class U>
+		using RebindAlloc = typename std::allocator_traits<Allocator>::template rebind_alloc<U>;
+
+		static constexpr size_t shift = internal_type::shift;
+
+		internal_type* d_data; // Store a pointer to internal data, easier to provide noexcept move constructor/copy and iterator stability on swap
+
+		internal_type* make_internal(const Allocator& al)
+		{
+			RebindAlloc<internal_type> a = al;
+			internal_type* ret = nullptr;
+			try {
+				ret = a.allocate(1);
+				return new (ret) internal_type(al);
+			}
+			catch (...) {
+				if (ret)
+					a.deallocate(ret, 1);
+				throw;
+			}
+			return ret;
+		}
+		void destroy_internal(internal_type* data) noexcept
+		{
+			data->~internal_type();
+			RebindAlloc<internal_type> a = get_allocator();
+			a.deallocate(data, 1);
+		}
+
+		void make_data_if_null()
+		{
+			if (!d_data)
+				d_data = make_internal(get_allocator());
+		}
+
+		template<class Less>
+		void sort_values(Less& comp, int threads, std::true_type)
+		{
+			d_data->sort(comp, threads);
+		}
+		template<class Less>
+		void sort_values(Less& comp, int, std::false_type)
+		{
+			std::sort(begin(), end(), comp);
+		}
+
+		/// @brief Returns the compressed buffer for given block.
+		/// This function will compress if necessary the corresponding block and deallocate the decompression context (if any).
+		/// For all blocks except the last one, this function returns a view on compression buffer.
+		/// For the last block, returns a null buffer.
+		std::pair<const char*, size_t> compressed_block(size_t pos)
+		{
+			if (!d_data || pos == d_data->d_buckets.size() - 1)
+				return { nullptr, 0 };
 
 			auto* bucket = &d_data->d_buckets[pos];
 			auto* buf = bucket->data.find_compressed();
@@ -2527,6 +4020,8 @@ namespace stenos
 		{
 			if (other.size()) {
 				d_data = make_internal(alloc);
+				d_data->d_level = other.d_data->d_level;
+				d_data->d_max_nanoseconds = other.d_data->d_max_nanoseconds;
 				// calling push_back is faster than resize + copy
 				other.for_each(0, other.size(), [this](const T& v) { this->push_back(v); });
 			}
@@ -2613,12 +4108,16 @@ namespace stenos
 					internal_type* tmp = make_internal(get_allocator());
 					try {
 						try {
+							if (d_data)
+								tmp->copy_encoding_settings(*d_data); // keep our own level and block pool
 							other.for_each(0, other.size(), [tmp](const T& v) { tmp->push_back(v); });
 						}
 						catch (...) {
 							destroy_internal(tmp);
 							throw;
 						}
+						if (d_data)
+							tmp->copy_cache_settings(*d_data);
 						destroy_internal(d_data);
 						d_data = tmp;
 					}
@@ -2655,19 +4154,106 @@ namespace stenos
 		/// An iterator holding the past-the-end value in this container will refer to the other container after the operation.
 		void swap(cvector& other) noexcept(noexcept(swap_allocator(std::declval<Allocator&>(), std::declval<Allocator&>())))
 		{
-			if (this != std::addressof(other)) {
-				std::swap(d_data, other.d_data);
-				swap_allocator(get_allocator(), other.get_allocator());
-			}
+			if (this != std::addressof(other)) {
+				std::swap(d_data, other.d_data);
+				swap_allocator(get_allocator(), other.get_allocator());
+			}
+		}
+
+		/// @brief Release all unused memory, and compress all dirty blocks.
+		/// This function does NOT invalidate iterators, except if an exception is thrown.
+		/// Basic exception guarantee only.
+		void shrink_to_fit()
+		{
+			if (d_data)
+				d_data->shrink_to_fit();
+		}
+
+		/// @brief Set the maximum memory (in bytes) used to keep chunks decompressed.
+		/// By default (or when passing 0), cvector keeps very few decompressed chunks, which suits linear accesses.
+		/// Random access workloads on a working set of many chunks should increase this budget
+		/// to avoid repeated compression/decompression of the same chunks.
+		/// The budget is reached progressively as chunks are accessed. Each decompressed chunk uses roughly block_bytes bytes.
+		void set_max_decompressed_bytes(size_t bytes)
+		{
+			make_data_if_null();
+			d_data->set_max_decompressed_bytes(bytes);
+		}
+		/// @brief Returns the maximum memory used to keep chunks decompressed, 0 for default heuristics
+		auto max_decompressed_bytes() const noexcept -> size_t { return d_data ? d_data->max_decompressed_bytes() : 0; }
+
+		/// @brief Set the eviction policy used to select the decompressed chunk to release when the budget is reached
+		void set_cache_policy(cvector_cache_policy policy)
+		{
+			make_data_if_null();
+			d_data->set_cache_policy(policy);
+		}
+		/// @brief Returns the decompressed chunk eviction policy
+		auto cache_policy() const noexcept -> cvector_cache_policy { return d_data ? d_data->d_cache.policy : cvector_cache_policy::fifo; }
+
+		/// @brief Keep the chunk containing the element at pos decompressed until unpin() is called.
+		/// Pins are counted, each pin() must be matched by an unpin().
+		/// Iterators, references and values remain valid.
+		void pin(size_type pos)
+		{
+			STENOS_ASSERT_DEBUG(pos < size(), "pin: invalid position");
+			d_data->pin_bucket(pos >> shift, true);
+		}
+		/// @brief Release a pin acquired with pin()
+		void unpin(size_type pos)
+		{
+			STENOS_ASSERT_DEBUG(pos < size(), "unpin: invalid position");
+			d_data->pin_bucket(pos >> shift, false);
 		}
 
-		/// @brief Release all unused memory, and compress all dirty blocks.
-		/// This function does NOT invalidate iterators, except if an exception is thrown.
-		/// Basic exception guarantee only.
-		void shrink_to_fit()
+		/// @brief Enable or disable decompressed chunk cache statistics, and reset them.
+		/// Statistics are disabled by default.
+		void enable_cache_stats(bool enable)
 		{
-			if (d_data)
-				d_data->shrink_to_fit();
+			make_data_if_null();
+			d_data->reset_cache_stats(enable);
+		}
+		/// @brief Returns the decompressed chunk cache statistics since the last call to enable_cache_stats()
+		auto cache_stats() const noexcept -> cvector_cache_stats { return d_data ? d_data->cache_stats() : cvector_cache_stats{ 0, 0, 0 }; }
+
+		/// @brief Allocate compressed chunks from given pool, or from the container allocator if pool is null.
+		/// The pool might be shared with other cvectors. Existing compressed chunks are moved to the new allocator.
+		/// Strong exception guarantee.
+		void set_block_pool(std::shared_ptr<cvector_block_pool> pool)
+		{
+			make_data_if_null();
+			d_data->set_block_pool(std::move(pool));
+		}
+		/// @brief Allocate compressed chunks from a new pool owned by this container
+		void use_block_pool() { set_block_pool(std::make_shared<cvector_block_pool>()); }
+		/// @brief Returns the pool used to allocate compressed chunks, null if the container allocator is used
+		auto block_pool() const noexcept -> std::shared_ptr<cvector_block_pool> { return d_data ? d_data->d_pool : std::shared_ptr<cvector_block_pool>(); }
+
+		/// @brief Set the compression level (0 to 9) used for chunks compressed from now on, overriding the Level template parameter.
+		/// Already compressed chunks keep their encoding, use recompress() to re-encode them.
+		void set_level(int level)
+		{
+			make_data_if_null();
+			d_data->d_level = level < 0 ? 0 : (level > 9 ? 9 : level);
+		}
+		/// @brief Returns the compression level used for new chunks
+		auto level() const noexcept -> int { return d_data ? d_data->d_level : Level; }
+		/// @brief Set the maximum time in nanoseconds to compress one chunk, 0 to disable (default).
+		/// When set, the compression level is ignored and chosen for each chunk to fit the budget, like stenos_set_max_nanoseconds().
+		void set_max_nanoseconds(uint64_t nanoseconds)
+		{
+			make_data_if_null();
+			d_data->d_max_nanoseconds = nanoseconds;
+		}
+		/// @brief Returns the time budget to compress one chunk, 0 if disabled
+		auto max_nanoseconds() const noexcept -> uint64_t { return d_data ? d_data->d_max_nanoseconds : 0; }
+		/// @brief Re-encode all chunks with given compression level, which becomes the level of new chunks.
+		/// Chunks are decompressed and recompressed in parallel on up to threads workers of the library thread pool.
+		/// Iterators are not invalidated. Basic exception guarantee.
+		void recompress(int level, int threads = 1)
+		{
+			make_data_if_null();
+			d_data->recompress(level, threads);
 		}
 
 		/// @brief Resizes the container to contain count elements.
@@ -2855,6 +4441,28 @@ namespace stenos
 			}
 		}
 
+		/// @brief Replaces the contents with the n values pointed by data.
+		/// For trivially copyable types, full chunks are compressed directly from data using up to \a threads threads,
+		/// without going through element-wise insertion.
+		/// Basic exception guarantee.
+		void assign(const T* data, size_type n, int threads = 1)
+		{
+			clear();
+			append(data, n, threads);
+		}
+
+		/// @brief Appends the n values pointed by data.
+		/// For trivially copyable types, full chunks are compressed directly from data using up to \a threads threads,
+		/// without going through element-wise insertion.
+		/// Basic exception guarantee.
+		void append(const T* data, size_type n, int threads = 1)
+		{
+			if (n == 0)
+				return;
+			make_data_if_null();
+			d_data->append(data, n, threads);
+		}
+
 		/// @brief Replaces the contents with the elements from the initializer list ilist.
 		/// Basic exception guarantee.
 		void assign(std::initializer_list<T> ilist) { assign(ilist.begin(), ilist.end()); }
@@ -3026,6 +4634,246 @@ namespace stenos
 			return for_each_backward(first, last, std::forward<Functor>(fun));
 		}
 
+		/// @brief Apply functor on values in the range [first,last) using up to \a threads threads.
+		/// The range is split on chunk boundaries, and each worker decompresses, processes and recompresses its own chunks.
+		/// The functor is called concurrently from several threads, and the processing order is unspecified.
+		/// Its return value, if any, is ignored (no early stop).
+		/// @tparam Functor functor type
+		/// @param first first index (included)
+		/// @param last last index (excluded)
+		/// @param fun functor to be applied
+		/// @param threads maximum number of threads
+		/// @return the number of processed values.
+		template<class Functor>
+		auto for_each(size_t first, size_t last, Functor&& fun, int threads) -> size_t
+		{
+			if (!d_data)
+				return 0;
+			auto f = [&fun](size_t, T& v) { fun(v); };
+			d_data->template parallel_for_each<false>(first, last, f, threads);
+			return last - first;
+		}
+
+		/// @brief Apply functor on values in the range [first,last) using up to \a threads threads.
+		/// The range is split on chunk boundaries, and each worker decompresses its own chunks.
+		/// The functor is called concurrently from several threads, and the processing order is unspecified.
+		/// Its return value, if any, is ignored (no early stop).
+		/// @tparam Functor functor type
+		/// @param first first index (included)
+		/// @param last last index (excluded)
+		/// @param fun functor to be applied
+		/// @param threads maximum number of threads
+		/// @return the number of processed values.
+		template<class Functor>
+		auto for_each(size_t first, size_t last, Functor&& fun, int threads) const -> size_t
+		{
+			if (!d_data)
+				return 0;
+			auto f = [&fun](size_t, const T& v) { fun(v); };
+			const_cast<internal_type*>(d_data)->template parallel_for_each<true>(first, last, f, threads);
+			return last - first;
+		}
+
+		/// @brief Replace each value v in the range [first,last) by op(v), using up to \a threads threads.
+		/// Like for_each(size_t, size_t, Functor&&, int), each worker decompresses and recompresses its own chunks,
+		/// and values do not go through reference wrappers. op is called concurrently from several threads.
+		template<class UnaryOp>
+		void transform_inplace(size_t first, size_t last, UnaryOp op, int threads = 1)
+		{
+			for_each(first, last, [&op](T& v) { v = op(static_cast<const T&>(v)); }, threads);
+		}
+
+		/// @brief Sort the cvector in ascending order using up to \a threads threads.
+		/// See sort(Less, int).
+		void sort(int threads = 1) { sort(std::less<T>(), threads); }
+
+		/// @brief Sort the cvector according to comp, using up to \a threads threads.
+		/// For trivially copyable types, runs of 16 chunks are first sorted in parallel, and sorted runs are then
+		/// merged 16 at a time, each merge streaming its output into freshly compressed chunks. The extra memory is
+		/// bounded to 17 decompressed chunks per thread, plus a second compressed copy of the values during each pass.
+		/// The last merge passes have fewer runs to merge than threads. comp is called concurrently from several threads.
+		/// Other types are sorted with std::sort() on the cvector iterators.
+		/// The sort is not stable. Basic exception guarantee: on exception, the cvector holds the same values in an unspecified order.
+		template<class Less>
+		void sort(Less comp, int threads = 1)
+		{
+			if (d_data)
+				sort_values(comp, threads, std::is_trivially_copyable<T>{});
+		}
+
+		/// @brief Apply functor on values in the range [first,last) using up to \a threads threads.
+		/// See for_each(size_t, size_t, Functor&&, int) const.
+		template<class Functor>
+		auto const_for_each(size_t first, size_t last, Functor&& fun, int threads) const -> size_t
+		{
+			return for_each(first, last, std::forward<Functor>(fun), threads);
+		}
+
+		/// @brief Enable or disable the per-chunk synopsis (min and max values).
+		/// When enabled, the synopsis of each chunk is computed on first use by lower_bound(), upper_bound()
+		/// or const_for_each_if(), and kept up to date whenever a modified chunk is recompressed.
+		/// This turns the binary search of lower_bound() into a search over stored values, without decompression.
+		/// Only available for arithmetic types.
+		void enable_synopsis(bool enable)
+		{
+			static_assert(std::is_arithmetic<T>::value, "cvector synopsis is only available for arithmetic types");
+			make_data_if_null();
+			d_data->enable_synopsis(enable);
+		}
+		/// @brief Returns true if the per-chunk synopsis is enabled
+		bool synopsis_enabled() const noexcept { return d_data && d_data->d_synopsis_enabled; }
+
+		/// @brief Returns the position of the first value not lower than \a value, or size() if none.
+		/// The cvector must be sorted in ascending order. Only available for arithmetic types.
+		/// Much faster with enable_synopsis(true), as the search then runs on chunk synopses and decompresses a single chunk.
+		auto lower_bound(const T& value) const -> size_t
+		{
+			static_assert(std::is_arithmetic<T>::value, "cvector::lower_bound is only available for arithmetic types");
+			return d_data ? d_data->template bound<false>(value) : 0;
+		}
+		/// @brief Returns the position of the first value greater than \a value, or size() if none.
+		/// The cvector must be sorted in ascending order. Only available for arithmetic types.
+		/// Much faster with enable_synopsis(true), as the search then runs on chunk synopses and decompresses a single chunk.
+		auto upper_bound(const T& value) const -> size_t
+		{
+			static_assert(std::is_arithmetic<T>::value, "cvector::upper_bound is only available for arithmetic types");
+			return d_data ? d_data->template bound<true>(value) : 0;
+		}
+
+		/// @brief Apply functor on values in the range [first,last), skipping whole chunks
+		/// for which block_pred(const T& min, const T& max) returns false.
+		/// The function can stop early if provided functor returns false.
+		/// Only available for arithmetic types, and most useful with enable_synopsis(true).
+		/// @return the number of successfully processed values.
+		///
+		/// Example, sum of values in [10, 20]:
+		/// @code
+		/// vec.const_for_each_if(0, vec.size(), [](int min, int max) { return max >= 10 && min <= 20; }, [&](int v) { if (v >= 10 && v <= 20) sum += v; });
+		/// @endcode
+		template<class BlockPred, class Functor>
+		auto const_for_each_if(size_t first, size_t last, BlockPred&& block_pred, Functor&& fun) const -> size_t
+		{
+			static_assert(std::is_arithmetic<T>::value, "cvector::const_for_each_if is only available for arithmetic types");
+			return d_data ? d_data->const_for_each_if(first, last, std::forward<BlockPred>(block_pred), std::forward<Functor>(fun)) : 0;
+		}
+
+		/// @brief Sum type returned by reduce_sum(): double for floating point types, int64_t or uint64_t for integers
+		using sum_type = typename internal_type::sum_type;
+
+		/// @brief Returns the sum of values in [first,last), computed in double for floating point types
+		/// and modulo 2^64 for integers. Only available for arithmetic types.
+		/// Whole compressed chunks are reduced block by block in the compressed domain (see stenos_reduce()):
+		/// runs of equal values are accumulated without decoding, and no chunk is brought into the cache.
+		auto reduce_sum(size_t first, size_t last) const -> sum_type
+		{
+			static_assert(std::is_arithmetic<T>::value, "cvector::reduce_sum is only available for arithmetic types");
+			return d_data && first != last ? d_data->reduce(first, last, STENOS_REDUCE_SUM, T()).sum : 0;
+		}
+		/// @brief Returns the minimum value in the non empty range [first,last). Only available for arithmetic types.
+		/// Uses the chunk synopses if enabled, see reduce_sum() otherwise.
+		auto reduce_min(size_t first, size_t last) const -> T
+		{
+			static_assert(std::is_arithmetic<T>::value, "cvector::reduce_min is only available for arithmetic types");
+			STENOS_ASSERT_DEBUG(first < last, "reduce_min: empty range");
+			return d_data->reduce(first, last, STENOS_REDUCE_MIN, T()).min;
+		}
+		/// @brief Returns the maximum value in the non empty range [first,last). Only available for arithmetic types.
+		/// Uses the chunk synopses if enabled, see reduce_sum() otherwise.
+		auto reduce_max(size_t first, size_t last) const -> T
+		{
+			static_assert(std::is_arithmetic<T>::value, "cvector::reduce_max is only available for arithmetic types");
+			STENOS_ASSERT_DEBUG(first < last, "reduce_max: empty range");
+			return d_data->reduce(first, last, STENOS_REDUCE_MAX, T()).max;
+		}
+		/// @brief Returns the number of values in [first,last) with the same bits as \a value (0 and -0 differ,
+		/// a NaN matches itself). Only available for arithmetic types, see reduce_sum().
+		auto reduce_count(size_t first, size_t last, const T& value) const -> size_t
+		{
+			static_assert(std::is_arithmetic<T>::value, "cvector::reduce_count is only available for arithmetic types");
+			return d_data && first != last ? (size_t)d_data->reduce(first, last, STENOS_REDUCE_COUNT_EQ, value).equal : 0;
+		}
+
+		/// @brief Copy the n values starting at pos to out.
+		/// Values are copied chunk by chunk, without going through reference wrappers.
+		void copy_to(size_t pos, size_t n, T* out) const
+		{
+			if (n)
+				d_data->copy_to(pos, n, out);
+		}
+
+		/// @brief Copy n values from in to the positions [pos, pos + n).
+		/// The cvector grows if pos + n is greater than size(), in which case pos must be lower or equal to size().
+		/// Values are copied chunk by chunk, without going through reference wrappers.
+		/// Basic exception guarantee.
+		void copy_from(size_t pos, const T* in, size_t n)
+		{
+			STENOS_ASSERT_DEBUG(pos <= size(), "copy_from: invalid position");
+			size_t inside = pos < size() ? std::min(n, size() - pos) : 0;
+			if (inside)
+				d_data->copy_from(pos, in, inside);
+			if (n > inside)
+				append(in + inside, n - inside);
+		}
+
+		/// @brief Returns a single pass range over the decompressed chunks covering [first,last).
+		/// Iterating the range yields cvector_span<T> objects {index, data, size}, one per chunk,
+		/// suitable for SIMD kernels or memcpy. If \a depth is not 0, the next \a depth chunks
+		/// are decompressed ahead on the library thread pool (see prefetching_range()).
+		/// The cvector must not be modified while the range exists.
+		///
+		/// Example:
+		/// @code
+		/// for (auto span : vec.chunks(0, vec.size()))
+		///     sum += simd_sum(span.data, span.size);
+		/// @endcode
+		auto chunks(size_t first, size_t last, size_t depth = 0) const -> detail::ChunkRange<internal_type>
+		{
+			return detail::ChunkRange<internal_type>(d_data, first, last, depth);
+		}
+
+		/// @brief Returns a single pass range over the values in [first,last) that decompresses chunks ahead.
+		/// While the caller consumes a chunk, the next \a depth chunks are decompressed on the library thread pool,
+		/// overlapping decompression with the caller's work. Values are exposed as const references
+		/// through input iterators or the range for_each() member.
+		/// The cvector must not be modified while the range exists.
+		///
+		/// Example:
+		/// @code
+		/// for (const int& v : vec.prefetching_range(0, vec.size(), 4))
+		///     process(v);
+		/// @endcode
+		auto prefetching_range(size_t first, size_t last, size_t depth = 2) const -> detail::PrefetchRange<internal_type>
+		{
+			return detail::PrefetchRange<internal_type>(d_data, first, last, depth);
+		}
+
+		/// @brief Aggregate values in the range [first,last) using up to \a threads threads.
+		/// The range is split on chunk boundaries, and each worker accumulates its values in its own copy of init
+		/// by calling fun(Acc& acc, const T& value). Partial results are then combined with reduce(Acc, Acc) -> Acc.
+		/// init must therefore be an identity value for reduce (like 0 for a sum).
+		/// @return the aggregated value
+		///
+		/// Example, sum of all values:
+		/// @code
+		/// long long sum = vec.const_for_each_reduce(0, vec.size(), 0ll, [](long long& acc, int v) { acc += v; }, std::plus<long long>{}, 8);
+		/// @endcode
+		template<class Acc, class Functor, class Reduce>
+		auto const_for_each_reduce(size_t first, size_t last, Acc init, Functor&& fun, Reduce&& reduce, int threads = 1) const -> Acc
+		{
+			if (!d_data)
+				return init;
+			size_t parts = d_data->parallel_parts(first, last, threads);
+			if (parts == 0)
+				return init;
+			std::vector<Acc> accs(parts, init);
+			auto f = [&fun, &accs](size_t part, const T& v) { fun(accs[part], v); };
+			const_cast<internal_type*>(d_data)->template parallel_for_each<true>(first, last, f, threads);
+			Acc res = std::move(accs[0]);
+			for (size_t i = 1; i < parts; ++i)
+				res = reduce(std::move(res), std::move(accs[i]));
+			return res;
+		}
+
 		///////////////////////////
 		// Serialization/deserialization
 		///////////////////////////
@@ -3129,8 +4977,6 @@ namespace stenos
 			// Number of full blocks
 			size_t full_blocks = s / block_size;
 
-			RebindAlloc<char> al = get_allocator();
-
 			for (size_t i = 0; i < full_blocks; ++i) {
 				size_t bsize = stenos_private_block_size(src, (size_t)(src_end - src));
 				if STENOS_UNLIKELY (stenos_has_error(bsize))
@@ -3139,14 +4985,14 @@ namespace stenos
 					return STENOS_ERROR_SRC_OVERFLOW;
 
 				// might throw, fine
-				char* data = al.allocate(bsize);
+				char* data = d_data->allocate_block(bsize);
 				memcpy(data, src, bsize);
 
 				try {
 					d_data->d_buckets.push_back(bucket_type());
 				}
 				catch (...) {
-					al.deallocate(data, bsize);
+					d_data->deallocate_block(data, bsize);
 					throw;
 				}
 				d_data->d_buckets.back().data.set(data, detail::Compressed);
@@ -3170,7 +5016,7 @@ namespace stenos
 				// add to contexts
 				d_data->d_contexts.push_front(raw);
 
-				size_t r = stenos_private_decompress_block(d_data->d_ctx, src, sizeof(T), block_bytes, bsize, raw->storage, rem * sizeof(T));
+				size_t r = stenos_private_decompress_block(d_data->block_context(), src, sizeof(T), block_bytes, bsize, raw->storage, rem * sizeof(T));
 				if STENOS_UNLIKELY (stenos_has_error(r))
 					return r;
 				if STENOS_UNLIKELY (r != rem * sizeof(T))
@@ -3193,6 +5039,360 @@ namespace stenos
 		size_t deserialize(Istream& iss);
 	};
 
+	/// @brief Read-only view over a serialized cvector.
+	///
+	/// Unlike cvector::deserialize(), cvector_view does not copy the compressed chunks:
+	/// attach() only builds the table of chunk offsets inside a caller-owned buffer
+	/// (for instance a memory mapped file), and chunks are decompressed lazily on access.
+	/// Random access keeps the last accessed chunk decompressed in a cache owned by the view
+	/// and protected by a mutex. const_for_each() and copy() decompress into their own buffer
+	/// and never lock, so they should be preferred for concurrent traversals.
+	/// Functors passed to const_for_each() may access this view or other ones.
+	///
+	/// The attached buffer must outlive the view (or be detached).
+	/// Values are returned by copy, and T must be trivially copyable.
+	/// BlockSize must match the one of the serialized cvector.
+	template<class T, unsigned BlockSize = 0>
+	class cvector_view
+	{
+		static_assert(std::is_trivially_copyable<T>::value, "cvector_view: T must be trivially copyable");
+		static_assert(((sizeof(T) * 256) << BlockSize) < STENOS_MAX_BLOCK_BYTES, "invalid block size");
+
+		static constexpr size_t block_size = (256 << BlockSize);
+		static constexpr size_t block_bytes = block_size * sizeof(T);
+		static constexpr size_t shift = 8 + BlockSize;
+		static constexpr size_t mask = block_size - 1;
+
+		// Decompressed chunk
+		struct Chunk
+		{
+			uint64_t view{ 0 };
+			size_t index{ 0 };
+			alignas(16) char storage[block_bytes];
+		};
+		// Random access cache
+		struct Cache
+		{
+			std::mutex lock;
+			Chunk chunk;
+		};
+
+		std::vector<const uint8_t*> d_blocks; // compressed chunks, followed by the end of the last one
+		size_t d_size{ 0 };
+		uint64_t d_id{ 0 }; // unique identifier of the attached frame
+		std::unique_ptr<Cache> d_cache; // random access cache, allocated by attach()
+
+		static uint64_t next_id() noexcept
+		{
+			static std::atomic<uint64_t> id{ 0 };
+			return ++id;
+		}
+
+		/// @brief Decompress the chunk at given index into c
+		void decompress_chunk(size_t index, Chunk& c) const
+		{
+			c.view = 0;
+			size_t bytes = index == d_blocks.size() - 2 ? (d_size - (index << shift)) * sizeof(T) : block_bytes;
+			size_t r = stenos_private_decompress_block(detail::get_block_context<block_bytes, 1>(),
+								   d_blocks[index],
+								   sizeof(T),
+								   block_bytes,
+								   (size_t)(d_blocks[index + 1] - d_blocks[index]),
+								   c.storage,
+								   bytes);
+			if STENOS_UNLIKELY (stenos_has_error(r) || r != bytes)
+				throw std::runtime_error("cvector_view: invalid compressed chunk");
+			c.view = d_id;
+			c.index = index;
+		}
+
+
+	public:
+		using value_type = T;
+		using size_type = size_t;
+		using difference_type = std::ptrdiff_t;
+
+		/// @brief Random access iterator returning values by copy
+		class const_iterator
+		{
+		public:
+			using iterator_category = std::random_access_iterator_tag;
+			using value_type = T;
+			using difference_type = std::ptrdiff_t;
+			using pointer = const T*;
+			using reference = T;
+
+		private:
+			const cvector_view* d_view{ nullptr };
+			difference_type d_pos{ 0 };
+
+		public:
+
+			const_iterator() noexcept = default;
+			const_iterator(const cvector_view* v, difference_type pos) noexcept
+			  : d_view(v)
+			  , d_pos(pos)
+			{
+			}
+			auto operator*() const -> T { return (*d_view)[(size_t)d_pos]; }
+			auto operator[](difference_type diff) const -> T { return (*d_view)[(size_t)(d_pos + diff)]; }
+			auto operator++() noexcept -> const_iterator&
+			{
+				++d_pos;
+				return *this;
+			}
+			auto operator++(int) noexcept -> const_iterator
+			{
+				const_iterator _Tmp = *this;
+				++d_pos;
+				return _Tmp;
+			}
+			auto operator--() noexcept -> const_iterator&
+			{
+				--d_pos;
+				return *this;
+			}
+			auto operator--(int) noexcept -> const_iterator
+			{
+				const_iterator _Tmp = *this;
+				--d_pos;
+				return _Tmp;
+			}
+			auto operator+=(difference_type diff) noexcept -> const_iterator&
+			{
+				d_pos += diff;
+				return *this;
+			}
+			auto operator-=(difference_type diff) noexcept -> const_iterator&
+			{
+				d_pos -= diff;
+				return *this;
+			}
+			auto operator+(difference_type diff) const noexcept -> const_iterator { return const_iterator(d_view, d_pos + diff); }
+			auto operator-(difference_type diff) const noexcept -> const_iterator { return const_iterator(d_view, d_pos - diff); }
+			auto operator-(const const_iterator& other) const noexcept -> difference_type { return d_pos - other.d_pos; }
+			bool operator==(const const_iterator& other) const noexcept { return d_pos == other.d_pos; }
+			bool operator!=(const const_iterator& other) const noexcept { return d_pos != other.d_pos; }
+			bool operator<(const const_iterator& other) const noexcept { return d_pos < other.d_pos; }
+			bool operator>(const const_iterator& other) const noexcept { return d_pos > other.d_pos; }
+			bool operator<=(const const_iterator& other) const noexcept { return d_pos <= other.d_pos; }
+			bool operator>=(const const_iterator& other) const noexcept { return d_pos >= other.d_pos; }
+		};
+		using iterator = const_iterator;
+
+		/// @brief Construct an empty view
+		cvector_view() noexcept = default;
+		/// @brief Copy constructor. The copy attaches to the same buffer with its own cache.
+		cvector_view(const cvector_view& other)
+		  : d_blocks(other.d_blocks)
+		  , d_size(other.d_size)
+		  , d_id(other.d_id)
+		  , d_cache(other.d_cache ? new Cache : nullptr)
+		{
+		}
+		/// @brief Move constructor
+		cvector_view(cvector_view&& other) noexcept { swap(other); }
+		/// @brief Copy assignment
+		auto operator=(const cvector_view& other) -> cvector_view&
+		{
+			if (this != &other) {
+				cvector_view tmp(other);
+				swap(tmp);
+			}
+			return *this;
+		}
+		/// @brief Move assignment
+		auto operator=(cvector_view&& other) noexcept -> cvector_view&
+		{
+			cvector_view tmp(std::move(other));
+			swap(tmp);
+			return *this;
+		}
+		/// @brief Swap with another view
+		void swap(cvector_view& other) noexcept
+		{
+			d_blocks.swap(other.d_blocks);
+			std::swap(d_size, other.d_size);
+			std::swap(d_id, other.d_id);
+			d_cache.swap(other.d_cache);
+		}
+		/// @brief Construct and attach to a serialized cvector. Throws std::runtime_error on invalid input.
+		cvector_view(const void* src, size_t src_size)
+		{
+			if (stenos_has_error(attach(src, src_size)))
+				throw std::runtime_error("cvector_view: invalid input");
+		}
+
+		/// @brief Attach the view to a serialized cvector (see cvector::serialize()).
+		/// Only the chunk headers are read, chunks are decompressed on access.
+		/// Returns the number of values on success, an error code on error.
+		size_t attach(const void* _src, size_t src_size)
+		{
+			detach();
+
+			const uint8_t* src = (const uint8_t*)_src;
+			const uint8_t* src_end = src + src_size;
+
+			stenos_info info;
+			// Read frame info
+			size_t r = stenos_get_info(src, sizeof(T), src_size, &info);
+			if STENOS_UNLIKELY (stenos_has_error(r))
+				return r;
+			src += r;
+
+			// Invalid superblock size
+			if STENOS_UNLIKELY (block_bytes != info.superblock_size)
+				return STENOS_ERROR_INVALID_INPUT;
+			// Check decompressed size validity
+			if STENOS_UNLIKELY (info.decompressed_size % sizeof(T) != 0)
+				return STENOS_ERROR_INVALID_INPUT;
+
+			size_t s = info.decompressed_size / sizeof(T);
+			size_t blocks = s / block_size + (s % block_size ? 1 : 0);
+
+			// Build chunk offsets, might throw, fine
+			std::vector<const uint8_t*> offsets;
+			offsets.reserve(blocks + 1);
+			for (size_t i = 0; i < blocks; ++i) {
+				size_t bsize = stenos_private_block_size(src, (size_t)(src_end - src));
+				if STENOS_UNLIKELY (stenos_has_error(bsize))
+					return bsize;
+				if STENOS_UNLIKELY (src + bsize > src_end)
+					return STENOS_ERROR_SRC_OVERFLOW;
+				offsets.push_back(src);
+				src += bsize;
+			}
+			offsets.push_back(src);
+
+			// might throw, fine
+			std::unique_ptr<Cache> cache(new Cache);
+
+			d_blocks.swap(offsets);
+			d_cache.swap(cache);
+			d_size = s;
+			d_id = next_id();
+			return s;
+		}
+
+		/// @brief Detach the view from its buffer
+		void detach() noexcept
+		{
+			d_blocks.clear();
+			d_cache.reset();
+			d_size = 0;
+			d_id = 0;
+		}
+
+		/// @brief Returns the number of values
+		auto size() const noexcept -> size_t { return d_size; }
+		/// @brief Returns true if the view is empty
+		bool empty() const noexcept { return d_size == 0; }
+		/// @brief Returns the number of bytes of the attached serialized cvector
+		auto compressed_size() const noexcept -> size_t { return d_blocks.empty() ? 0 : (size_t)(d_blocks.back() - d_blocks.front()); }
+		/// @brief Returns the memory footprint of the view, excluding the attached buffer and sizeof(*this)
+		auto memory_footprint() const noexcept -> size_t { return d_blocks.capacity() * sizeof(const uint8_t*) + (d_cache ? sizeof(Cache) : 0); }
+
+		/// @brief Returns the value at pos, without bounds checking.
+		/// The chunk containing pos is decompressed in the view cache if needed.
+		auto operator[](size_t pos) const -> T
+		{
+			STENOS_ASSERT_DEBUG(pos < d_size, "cvector_view: index out of range");
+			size_t index = pos >> shift;
+			std::lock_guard<std::mutex> ll(d_cache->lock);
+			Chunk& c = d_cache->chunk;
+			if (c.view != d_id || c.index != index)
+				decompress_chunk(index, c);
+			return reinterpret_cast<const T*>(c.storage)[pos & mask];
+		}
+		/// @brief Returns the value at pos, with bounds checking
+		auto at(size_t pos) const -> T
+		{
+			if (pos >= size())
+				throw std::out_of_range("cvector_view::at: index out of range");
+			return (*this)[pos];
+		}
+		auto front() const -> T { return (*this)[0]; }
+		auto back() const -> T { return (*this)[size() - 1]; }
+
+		auto begin() const noexcept -> const_iterator { return const_iterator(this, 0); }
+		auto end() const noexcept -> const_iterator { return const_iterator(this, (difference_type)size()); }
+		auto cbegin() const noexcept -> const_iterator { return begin(); }
+		auto cend() const noexcept -> const_iterator { return end(); }
+
+		/// @brief Apply functor on values in the range [first,last).
+		/// The function can stop early if provided functor returns false.
+		/// @return the number of successfully processed values.
+		template<class Functor>
+		auto const_for_each(size_t first, size_t last, Functor&& fun) const -> size_t
+		{
+			STENOS_ASSERT_DEBUG(first <= last && last <= d_size, "const_for_each: invalid range");
+			if (first == last)
+				return 0;
+			// Per call buffer: the functor might access this view or another one
+			std::unique_ptr<Chunk> c(new Chunk);
+			const T* values = reinterpret_cast<const T*>(c->storage);
+			size_t res = 0;
+			while (first < last) {
+				decompress_chunk(first >> shift, *c);
+				size_t pos = first & mask;
+				size_t en = std::min(last - first, block_size - pos) + pos;
+				first += en - pos;
+				for (size_t p = pos; p != en; ++p, ++res)
+					if (!detail::eval_functor(std::forward<Functor>(fun), values[p]))
+						return res;
+			}
+			return res;
+		}
+
+		/// @brief Apply functor on values in the range [first,last) using up to \a threads threads.
+		/// The range is split on chunk boundaries, the functor is called concurrently and its return value, if any, is ignored.
+		/// @return the number of processed values.
+		template<class Functor>
+		auto const_for_each(size_t first, size_t last, Functor&& fun, int threads) const -> size_t
+		{
+			STENOS_ASSERT_DEBUG(first <= last && last <= d_size, "const_for_each: invalid range");
+			if (first == last)
+				return 0;
+			using F = typename std::remove_reference<Functor>::type;
+			struct Job
+			{
+				const cvector_view* self;
+				F* fun;
+				size_t first, last, first_chunk, chunks, parts;
+				std::mutex lock;
+				std::exception_ptr error;
+
+				static void apply(void* opaque, size_t part) noexcept
+				{
+					Job* j = static_cast<Job*>(opaque);
+					try {
+						size_t start = std::max(j->first, (j->first_chunk + j->chunks * part / j->parts) << shift);
+						size_t end = std::min(j->last, (j->first_chunk + j->chunks * (part + 1) / j->parts) << shift);
+						j->self->const_for_each(start, end, [j](const T& v) { (*j->fun)(v); });
+					}
+					catch (...) {
+						std::lock_guard<std::mutex> ll(j->lock);
+						if (!j->error)
+							j->error = std::current_exception();
+					}
+				}
+			};
+			size_t chunks = ((last - 1) >> shift) - (first >> shift) + 1;
+			size_t parts = std::min(chunks, (size_t)(threads > 1 ? threads : 1));
+			Job job{ this, &fun, first, last, first >> shift, chunks, parts, {}, nullptr };
+			stenos_private_parallel_for(threads, parts, Job::apply, &job);
+			if (job.error)
+				std::rethrow_exception(job.error);
+			return last - first;
+		}
+
+		/// @brief Decompress values in the range [first, first + count) to dst
+		void copy(size_t first, size_t count, T* dst) const
+		{
+			const_for_each(first, first + count, [&dst](const T& v) { *dst++ = v; });
+		}
+	};
+
 } // end namespace stenos
 
 namespace std
@@ -3331,8 +5531,6 @@ namespace stenos
 		// Number of full blocks
 		size_t full_blocks = s / block_size;
 
-		RebindAlloc<char> al = get_allocator();
-
 		for (size_t i = 0; i < full_blocks; ++i) {
 			char bheader[4];
 			iss.read((char*)bheader, 4);
@@ -3345,10 +5543,10 @@ namespace stenos
 
 			iss.seekg(-4, std::ios::cur);
 			// might throw, fine
-			char* data = al.allocate(bsize);
+			char* data = d_data->allocate_block(bsize);
 			iss.read(data, bsize);
 			if STENOS_UNLIKELY (!iss) {
-				al.deallocate(data, bsize);
+				d_data->deallocate_block(data, bsize);
 				return STENOS_ERROR_SRC_OVERFLOW;
 			}
 
@@ -3356,7 +5554,7 @@ namespace stenos
 				d_data->d_buckets.push_back(bucket_type());
 			}
 			catch (...) {
-				al.deallocate(data, bsize);
+				d_data->deallocate_block(data, bsize);
 				throw;
 			}
 			d_data->d_buckets.back().data.set(data, detail::Compressed);
@@ -3387,7 +5585,7 @@ namespace stenos
 			// add to contexts
 			d_data->d_contexts.push_front(raw);
 
-			size_t r = stenos_private_decompress_block(d_data->d_ctx, buffer.data(), sizeof(T), block_bytes, buffer.size(), raw->storage, rem * sizeof(T));
+			size_t r = stenos_private_decompress_block(d_data->block_context(), buffer.data(), sizeof(T), block_bytes, buffer.size(), raw->storage, rem * sizeof(T));
 			if STENOS_UNLIKELY (stenos_has_error(r))
 				return r;
 			if STENOS_UNLIKELY (r != rem * sizeof(T))
@@ -95,9 +95,9 @@ namespace stenos
 
 }
 
-#ifdef __SSE3__
+#if defined(__SSE3__) || defined(STENOS_HAS_NEON)
 
-// RLE compression requires SSE3
+// RLE compression requires SSE3 (or NEON)
 
 #if defined(STENOS_WIDE_TABLE)
 
@@ -297,7 +297,7 @@ namespace stenos
 
 #endif
 
-#ifdef __SSE4_1__
+#if defined(__SSE4_1__) || defined(STENOS_HAS_NEON)
 
 namespace stenos
 {
@@ -318,21 +318,30 @@ namespace stenos
 				// Align buffer on 16 bytes
 				buffer = align_buffer(buffer);
 				this->arrays = reinterpret_cast<vector256*>(buffer);
+				// The partial block is padded to 256 elements, see block_compress_partial()
 				this->partial_buffer = static_cast<char*>(buffer) + 256 * bytesoftype;
-				this->packs = reinterpret_cast<PackBits*>(static_cast<char*>(buffer) + 256 * bytesoftype + 256);
-				this->firsts = (static_cast<char*>(buffer) + 256 * bytesoftype + 256 + sizeof(PackBits) * bytesoftype);
+				this->packs = reinterpret_cast<PackBits*>(static_cast<char*>(buffer) + 512 * bytesoftype);
+				this->firsts = (static_cast<char*>(buffer) + 512 * bytesoftype + sizeof(PackBits) * bytesoftype);
 			}
 		};
 
 		// Size of internal compression buffer for given bytesoftype
 		static STENOS_ALWAYS_INLINE size_t compression_buffer_size(size_t bytesoftype) noexcept
 		{
-			return 256 * bytesoftype + 256 + sizeof(PackBits) * bytesoftype + bytesoftype + 16; // Add 16 for alignment
+			return 512 * bytesoftype + sizeof(PackBits) * bytesoftype + bytesoftype + 16; // Add 16 for alignment
 		}
 
 		// Bit scan reverse on 2 * 16 bytes
 		static STENOS_ALWAYS_INLINE void bit_scan_reverse_8_2(__m128i v1, __m128i v2, __m128i* r1, __m128i* r2) noexcept
 		{
+#ifdef STENOS_HAS_NEON
+			// Number of significant bits (8 - clz), with 7 converted to 8 like the SSE version
+			const uint8x16_t seven = vdupq_n_u8(7);
+			uint8x16_t b1 = vsubq_u8(vdupq_n_u8(8), vclzq_u8(neon::u8(v1)));
+			uint8x16_t b2 = vsubq_u8(vdupq_n_u8(8), vclzq_u8(neon::u8(v2)));
+			*r1 = neon::m128i(vsubq_u8(b1, vceqq_u8(b1, seven)));
+			*r2 = neon::m128i(vsubq_u8(b2, vceqq_u8(b2, seven)));
+#else
 			const __m128i lut_lo = _mm_set_epi8(4, 4, 4, 4, 4, 4, 4, 4, 5, 5, 5, 5, 6, 6, 7, 8);
 			// const __m128i lut_hi = _mm_set_epi8(0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 3, 8);
 			// custom version that convert output 7 to 8, in order to reserve headers 7 and 15 for RLE and RAW
@@ -349,13 +358,18 @@ namespace stenos
 			v2 = _mm_shuffle_epi8(lut_lo, v2);
 			v2 = _mm_min_epu8(v2, t);
 			*r2 = _mm_sub_epi8(_mm_set1_epi8(8), v2);
+#endif
 		}
 
 		// Horizontal sum of 16 bytes
 		static STENOS_ALWAYS_INLINE uint32_t hsum_epu8(__m128i v) noexcept
 		{
+#ifdef STENOS_HAS_NEON
+			return vaddlvq_u8(neon::u8(v));
+#else
 			__m128i vsum = _mm_sad_epu8(v, _mm_setzero_si128());
 			return static_cast<uint32_t>(_mm_extract_epi16(vsum, 0) + _mm_extract_epi16(vsum, 4));
+#endif
 		}
 
 		// Multiplication of 16 bytes
@@ -863,6 +877,35 @@ namespace stenos
 
 		STENOS_ALWAYS_INLINE void transpose_16x16(const __m128i* STENOS_RESTRICT in, __m128i* STENOS_RESTRICT out) noexcept
 		{
+#ifdef STENOS_HAS_NEON
+			// Transpose 2x2 blocks of 1, 2, 4 then 8 bytes
+			uint8x16_t r[16];
+			for (int i = 0; i < 16; ++i)
+				r[i] = vld1q_u8((const uint8_t*)(in + i));
+			for (int i = 0; i < 16; i += 2) {
+				uint8x16x2_t t = vtrnq_u8(r[i], r[i + 1]);
+				r[i] = t.val[0];
+				r[i + 1] = t.val[1];
+			}
+			for (int i = 0; i < 16; i += 4) {
+				for (int j = i; j < i + 2; ++j) {
+					uint16x8x2_t t = vtrnq_u16(vreinterpretq_u16_u8(r[j]), vreinterpretq_u16_u8(r[j + 2]));
+					r[j] = vreinterpretq_u8_u16(t.val[0]);
+					r[j + 2] = vreinterpretq_u8_u16(t.val[1]);
+				}
+			}
+			for (int i = 0; i < 16; i += 8) {
+				for (int j = i; j < i + 4; ++j) {
+					uint32x4x2_t t = vtrnq_u32(vreinterpretq_u32_u8(r[j]), vreinterpretq_u32_u8(r[j + 4]));
+					r[j] = vreinterpretq_u8_u32(t.val[0]);
+					r[j + 4] = vreinterpretq_u8_u32(t.val[1]);
+				}
+			}
+			for (int i = 0; i < 8; ++i) {
+				out[i] = neon::m128i(vcombine_u8(vget_low_u8(r[i]), vget_low_u8(r[i + 8])));
+				out[i + 8] = neon::m128i(vcombine_u8(vget_high_u8(r[i]), vget_high_u8(r[i + 8])));
+			}
+#else
 			__m128i w00, w01, w02, w03;
 			__m128i w10, w11, w12, w13;
 			__m128i w20, w21, w22, w23;
@@ -897,6 +940,7 @@ namespace stenos
 			transpose_4x4_dwords(w01, w11, w21, w31, out[4], out[5], out[6], out[7]);
 			transpose_4x4_dwords(w02, w12, w22, w32, out[8], out[9], out[10], out[11]);
 			transpose_4x4_dwords(w03, w13, w23, w33, out[12], out[13], out[14], out[15]);
+#endif
 		}
 
 		static STENOS_ALWAYS_INLINE uint32_t compute_block_generic(BlockEncoder* encoder, const void* src, char first, uint32_t index, int methods, __m128i* tr) noexcept
@@ -1025,21 +1069,18 @@ namespace stenos
 	{
 		double denom_bytes = 0;
 		double denom_time = 0;
+		double threshold_bytes_per_second = 0;
 		FindCLevel() noexcept {}
 		FindCLevel(const FindCLevel&) noexcept = default;
 		FindCLevel& operator=(const FindCLevel&) noexcept = default;
-		FindCLevel(size_t total_bytes, uint64_t max_time) noexcept
+		FindCLevel(size_t total_bytes, uint64_t max_time, size_t bytesoftype, const RateModel& rates) noexcept
 		  : denom_bytes(1. / total_bytes)
 		  , denom_time(1. / max_time)
+		  , threshold_bytes_per_second(rates.get(STENOS_RATE_BLOCK, 2, bytesoftype)) // observed full block compression rate
 		{
 		}
 		int find_clevel(size_t consummed_bytes, TimeConstraint& t) noexcept
 		{
-#ifdef NDEBUG
-			static constexpr unsigned threshold_bytes_per_second = 2000000000; // 2GB/s
-#else
-			static constexpr unsigned threshold_bytes_per_second = 200000000; // 200MB/s
-#endif
 			consummed_bytes += t.processed_bytes;
 			size_t remaining_bytes = t.total_bytes - (consummed_bytes);
 			auto elapsed = t.timer.tock();
@@ -1131,7 +1172,7 @@ namespace stenos
 		FindCLevel clevel;
 		if (t.nanoseconds) {
 			level = 2;
-			clevel = FindCLevel(t.total_bytes, t.nanoseconds);
+			clevel = FindCLevel(t.total_bytes, t.nanoseconds, bytesoftype, t.rates);
 		}
 
 		void* buff_src = make_compression_buffer(detail::compression_buffer_size(bytesoftype));
@@ -1305,7 +1346,7 @@ namespace stenos
 
 #else
 
-// NO SSE4.1 AVAILABLE!!!!
+// NO SSE4.1 OR NEON AVAILABLE!!!!
 
 namespace stenos
 {
@@ -1878,7 +1919,7 @@ namespace stenos
 		return static_cast<size_t>(src - saved);
 	}
 
-#ifdef __SSE4_1__
+#if defined(__SSE4_1__) || defined(STENOS_HAS_NEON)
 
 	// Faster decoding if SSE4.1 is available
 
@@ -2182,8 +2223,8 @@ namespace stenos
 	static inline size_t block_decompress_generic(const void* STENOS_RESTRICT src, size_t size, size_t bytesoftype, size_t bytes, void* STENOS_RESTRICT dst) noexcept
 	{
 		STENOS_ASSERT_DEBUG(bytesoftype < STENOS_MAX_BYTESOFTYPE, "invalid bytesoftype");
-#ifdef __SSE4_1__
-		if (cpu_features().HAS_SSE3)
+#if defined(__SSE4_1__) || defined(STENOS_HAS_NEON)
+		if (cpu_features().HAS_SSE3 || cpu_features().HAS_NEON)
 			return block_decompress_sse(src, size, bytesoftype, bytes, dst);
 #endif
 		return block_decompress(src, size, bytesoftype, bytes, dst);
@@ -2201,8 +2242,8 @@ namespace stenos
 						    const void* STENOS_RESTRICT __shuffled) noexcept
 	{
 		STENOS_ASSERT_DEBUG(bytesoftype < STENOS_MAX_BYTESOFTYPE, "invalid bytesoftype");
-#ifdef __SSE4_1__
-		if STENOS_LIKELY (cpu_features().HAS_SSE41) {
+#if defined(__SSE4_1__) || defined(STENOS_HAS_NEON)
+		if STENOS_LIKELY (cpu_features().HAS_SSE41 || cpu_features().HAS_NEON) {
 			return block_compress(src, bytesoftype, bytes, dst, dst_size, block_level, full_level, t, target_ratio, __shuffled);
 		}
 #endif
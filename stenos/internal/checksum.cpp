@@ -0,0 +1,119 @@
+/**
+ * MIT License
+ *
+ * Copyright (c) 2025 Victor Moncada <vtr.moncada@gmail.com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include "checksum.h"
+#include "simd.h"
+
+#if defined(__ARM_FEATURE_CRC32) && !defined(_M_ARM64) && !defined(__arm__)
+extern "C" {
+#include <arm_acle.h>
+}
+#endif
+
+namespace stenos
+{
+	namespace detail
+	{
+		// Slicing-by-8 lookup tables for the generic implementation
+		struct CRC32CTable
+		{
+			uint32_t table[8][256];
+			CRC32CTable() noexcept
+			{
+				for (uint32_t i = 0; i < 256; ++i) {
+					uint32_t c = i;
+					for (int k = 0; k < 8; ++k)
+						c = (c & 1) ? (c >> 1) ^ 0x82F63B78u : c >> 1;
+					table[0][i] = c;
+				}
+				for (uint32_t i = 0; i < 256; ++i)
+					for (int t = 1; t < 8; ++t)
+						table[t][i] = (table[t - 1][i] >> 8) ^ table[0][table[t - 1][i] & 0xFF];
+			}
+			static const CRC32CTable& instance() noexcept
+			{
+				static const CRC32CTable t;
+				return t;
+			}
+		};
+	}
+
+	static inline uint32_t crc32c_generic(const uint8_t* src, size_t bytes, uint32_t crc) noexcept
+	{
+		const auto& t = detail::CRC32CTable::instance().table;
+		for (; bytes >= 8; bytes -= 8, src += 8) {
+			uint64_t v = read_LE_64(src) ^ crc;
+			crc = t[7][v & 0xFF] ^ t[6][(v >> 8) & 0xFF] ^ t[5][(v >> 16) & 0xFF] ^ t[4][(v >> 24) & 0xFF] ^ t[3][(v >> 32) & 0xFF] ^
+			      t[2][(v >> 40) & 0xFF] ^ t[1][(v >> 48) & 0xFF] ^ t[0][v >> 56];
+		}
+		for (; bytes; --bytes, ++src)
+			crc = (crc >> 8) ^ t[0][(crc ^ *src) & 0xFF];
+		return crc;
+	}
+
+#ifdef __SSE4_2__
+	static inline uint32_t crc32c_sse42(const uint8_t* src, size_t bytes, uint32_t crc) noexcept
+	{
+#if defined(__x86_64__) || defined(_M_X64)
+		uint64_t c = crc;
+		for (; bytes >= 8; bytes -= 8, src += 8)
+			c = _mm_crc32_u64(c, read_LE_64(src));
+		crc = (uint32_t)c;
+#endif
+		for (; bytes >= 4; bytes -= 4, src += 4)
+			crc = _mm_crc32_u32(crc, read_LE_32(src));
+		for (; bytes; --bytes, ++src)
+			crc = _mm_crc32_u8(crc, *src);
+		return crc;
+	}
+#endif
+
+#if defined(__ARM_FEATURE_CRC32)
+	static inline uint32_t crc32c_arm(const uint8_t* src, size_t bytes, uint32_t crc) noexcept
+	{
+		for (; bytes >= 8; bytes -= 8, src += 8)
+			crc = __crc32cd(crc, read_LE_64(src));
+		for (; bytes; --bytes, ++src)
+			crc = __crc32cb(crc, *src);
+		return crc;
+	}
+#endif
+
+	uint32_t crc32c(const void* _src, size_t bytes, uint32_t crc) noexcept
+	{
+		const uint8_t* src = (const uint8_t*)_src;
+		crc = ~crc;
+
+#ifdef __SSE4_2__
+		if (cpu_features().HAS_SSE42)
+			return ~crc32c_sse42(src, bytes, crc);
+#endif
+
+#if defined(__ARM_FEATURE_CRC32)
+		return ~crc32c_arm(src, bytes, crc);
+#else
+		return ~crc32c_generic(src, bytes, crc);
+#endif
+	}
+}
@@ -23,8 +23,11 @@
  */
 
 #include "delta.h"
+#include "shuffle.h"
 #include "simd.h"
 
+#include <algorithm>
+
 namespace stenos
 {
 	static inline void delta_generic(const void* _src, void* _dst, size_t bytes)
@@ -207,9 +210,72 @@ namespace stenos
 	}
 #endif
 
+#if defined(__AVX512BW__) && defined(__AVX512VBMI__)
+
+	static inline void delta_avx512(const void* _src, void* _dst, size_t bytes)
+	{
+		// AVX512 version of delta_avx2()
+
+		const char* src = (const char*)_src;
+		char* dst = (char*)_dst;
+
+		if (bytes == 0)
+			return;
+
+		if (bytes <= 2048) {
+
+			*dst++ = *src++;
+			--bytes;
+			size_t size64 = bytes & ~(63ull);
+			for (size_t i = 0; i < size64; i += 64) {
+				__m512i in1 = _mm512_loadu_si512((const void*)(src + i));
+				__m512i in2 = _mm512_loadu_si512((const void*)(src + i - 1));
+				_mm512_storeu_si512((void*)(dst + i), _mm512_sub_epi8(in1, in2));
+			}
+			for (size_t i = size64; i < bytes; ++i)
+				dst[i] = src[i] - src[i - 1];
+		}
+		else {
+			size_t bytes4 = bytes / 4;
+			const char* s[4] = { src, src + bytes4, src + bytes4 * 2, src + bytes4 * 3 };
+			char* d[4] = { dst, dst + bytes4, dst + bytes4 * 2, dst + bytes4 * 3 };
+
+			*d[0]++ = *s[0]++;
+			*d[1]++ = *s[1]++;
+			*d[2]++ = *s[2]++;
+			*d[3]++ = *s[3]++;
+
+			--bytes4;
+			size_t size64 = bytes4 & ~(63ull);
+			for (size_t i = 0; i < size64; i += 64) {
+				for (int k = 0; k < 4; ++k) {
+					__m512i in1 = _mm512_loadu_si512((const void*)(s[k] + i));
+					__m512i in2 = _mm512_loadu_si512((const void*)(s[k] + i - 1));
+					_mm512_storeu_si512((void*)(d[k] + i), _mm512_sub_epi8(in1, in2));
+				}
+			}
+			for (size_t i = size64; i < bytes4; ++i) {
+				d[0][i] = s[0][i] - s[0][i - 1];
+				d[1][i] = s[1][i] - s[1][i - 1];
+				d[2][i] = s[2][i] - s[2][i - 1];
+				d[3][i] = s[3][i] - s[3][i - 1];
+			}
+
+			size_t start = (bytes4 + 1) * 4;
+			for (; start != bytes; ++start)
+				dst[start] = src[start] - src[start - 1];
+		}
+	}
+#endif
+
 	void delta(const void* _src, void* _dst, size_t bytes)
 	{
 
+#if defined(__AVX512BW__) && defined(__AVX512VBMI__)
+		if (cpu_features().HAS_AVX512BW && cpu_features().HAS_AVX512VBMI)
+			return delta_avx512(_src, _dst, bytes);
+#endif
+
 #ifdef __AVX2__
 		if (cpu_features().HAS_AVX2)
 			return delta_avx2(_src, _dst, bytes);
@@ -467,11 +533,104 @@ namespace stenos
 		}
 	}
 
+#endif
+
+#if defined(__AVX512BW__) && defined(__AVX512VBMI__)
+
+	static STENOS_ALWAYS_INLINE __m512i prefix_sum_64(__m512i x, __m512i carry) noexcept
+	{
+		// Prefix sum within each 16 bytes lane
+		x = _mm512_add_epi8(x, _mm512_bslli_epi128(x, 1));
+		x = _mm512_add_epi8(x, _mm512_bslli_epi128(x, 2));
+		x = _mm512_add_epi8(x, _mm512_bslli_epi128(x, 4));
+		x = _mm512_add_epi8(x, _mm512_bslli_epi128(x, 8));
+		// Add the last byte of lane l-1 to lane l, then of lane l-2 to lane l
+		const __m512i prev1 = _mm512_setr_epi64(0, 0, 0x0F0F0F0F0F0F0F0FLL, 0x0F0F0F0F0F0F0F0FLL, 0x1F1F1F1F1F1F1F1FLL, 0x1F1F1F1F1F1F1F1FLL, 0x2F2F2F2F2F2F2F2FLL, 0x2F2F2F2F2F2F2F2FLL);
+		const __m512i prev2 = _mm512_setr_epi64(0, 0, 0, 0, 0x0F0F0F0F0F0F0F0FLL, 0x0F0F0F0F0F0F0F0FLL, 0x1F1F1F1F1F1F1F1FLL, 0x1F1F1F1F1F1F1F1FLL);
+		x = _mm512_add_epi8(x, _mm512_maskz_permutexvar_epi8(0xFFFFFFFFFFFF0000ull, prev1, x));
+		x = _mm512_add_epi8(x, _mm512_maskz_permutexvar_epi8(0xFFFFFFFF00000000ull, prev2, x));
+		return _mm512_add_epi8(x, carry);
+	}
+
+	static inline void delta_inv_avx512(const void* _src, void* _dst, size_t bytes)
+	{
+		const char* src = (const char*)_src;
+		char* dst = (char*)_dst;
+
+		if (bytes == 0)
+			return;
+
+		// Broadcast the last byte of a row.
+		// Zero-masked permutations are used as the unmasked ones trigger -Wmaybe-uninitialized with GCC.
+		const __m512i last = _mm512_set1_epi8(63);
+
+		if (bytes <= 2048) {
+
+			auto end = src + bytes;
+			__m512i carry = _mm512_setzero_si512();
+			while (src + 63 < end) {
+				__m512i row = prefix_sum_64(_mm512_loadu_si512((const void*)(src)), carry);
+				_mm512_storeu_si512((void*)(dst), row);
+				carry = _mm512_maskz_permutexvar_epi8((__mmask64)-1, last, row);
+				src += 64;
+				dst += 64;
+			}
+			while (src < end) {
+				*dst = dst[-1] + *src;
+				++src;
+				++dst;
+			}
+		}
+		else {
+			size_t bytes4 = bytes / 4;
+			const char* s[4] = { src, src + bytes4, src + bytes4 * 2, src + bytes4 * 3 };
+			char* d[4] = { dst, dst + bytes4, dst + bytes4 * 2, dst + bytes4 * 3 };
+			__m512i carry[4] = { _mm512_setzero_si512(), _mm512_setzero_si512(), _mm512_setzero_si512(), _mm512_setzero_si512() };
+			const char* en = src + bytes4;
+
+			while (s[0] + 63 < en) {
+				for (int k = 0; k < 4; ++k) {
+					__m512i row = prefix_sum_64(_mm512_loadu_si512((const void*)(s[k])), carry[k]);
+					_mm512_storeu_si512((void*)(d[k]), row);
+					carry[k] = _mm512_maskz_permutexvar_epi8((__mmask64)-1, last, row);
+					s[k] += 64;
+					d[k] += 64;
+				}
+			}
+			while (s[0] < en) {
+				*d[0] = d[0][-1] + *s[0];
+				++s[0];
+				++d[0];
+
+				*d[1] = d[1][-1] + *s[1];
+				++s[1];
+				++d[1];
+
+				*d[2] = d[2][-1] + *s[2];
+				++s[2];
+				++d[2];
+
+				*d[3] = d[3][-1] + *s[3];
+				++s[3];
+				++d[3];
+			}
+
+			size_t start = bytes4 * 4;
+			for (; start != bytes; ++start)
+				dst[start] = dst[start - 1] + src[start];
+		}
+	}
+
 #endif
 
 	void delta_inv(const void* src, void* dst, size_t bytes)
 	{
 
+#if defined(__AVX512BW__) && defined(__AVX512VBMI__)
+		if (cpu_features().HAS_AVX512BW && cpu_features().HAS_AVX512VBMI)
+			return delta_inv_avx512(src, dst, bytes);
+#endif
+
 #ifdef __AVX2__
 		if (cpu_features().HAS_AVX2)
 			return delta_inv_avx2(src, dst, bytes);
@@ -484,4 +643,697 @@ namespace stenos
 
 		delta_inv_generic(src, dst, bytes);
 	}
-}
\ No newline at end of file
+
+	//
+	// Fused inverse byte delta and unshuffle
+	//
+
+	static inline uint8_t sum_bytes_generic(const uint8_t* src, size_t bytes) noexcept
+	{
+		unsigned sum = 0;
+		for (size_t i = 0; i < bytes; ++i)
+			sum += src[i];
+		return (uint8_t)sum;
+	}
+
+	static inline uint8_t prefix_carry_generic(const uint8_t* src, uint8_t* dst, size_t bytes, uint8_t carry) noexcept
+	{
+		for (size_t i = 0; i < bytes; ++i)
+			dst[i] = carry = (uint8_t)(carry + src[i]);
+		return carry;
+	}
+
+	static inline void prefix_carry4_generic(const uint8_t* const* src, uint8_t* const* dst, size_t bytes, uint8_t* carry) noexcept
+	{
+		for (size_t k = 0; k < 4; ++k)
+			carry[k] = prefix_carry_generic(src[k], dst[k], bytes, carry[k]);
+	}
+
+#ifdef __SSE2__
+
+	static inline uint8_t sum_bytes_sse2(const uint8_t* src, size_t bytes) noexcept
+	{
+		// Horizontal byte sum using psadbw
+		__m128i acc = _mm_setzero_si128();
+		const __m128i zero = _mm_setzero_si128();
+		size_t i = 0;
+		for (; i + 16 <= bytes; i += 16)
+			acc = _mm_add_epi64(acc, _mm_sad_epu8(_mm_loadu_si128((const __m128i*)(src + i)), zero));
+		unsigned sum = (unsigned)_mm_cvtsi128_si32(acc) + (unsigned)_mm_cvtsi128_si32(_mm_srli_si128(acc, 8));
+		for (; i < bytes; ++i)
+			sum += src[i];
+		return (uint8_t)sum;
+	}
+
+	static inline uint8_t prefix_carry_sse2(const uint8_t* src, uint8_t* dst, size_t bytes, uint8_t carry) noexcept
+	{
+		size_t i = 0;
+		for (; i + 16 <= bytes; i += 16) {
+			__m128i row = _mm_add_epi8(prefix_sum_16(_mm_loadu_si128((const __m128i*)(src + i))), _mm_set1_epi8((char)carry));
+			_mm_storeu_si128((__m128i*)(dst + i), row);
+			carry = (uint8_t)(_mm_extract_epi16(row, 7) >> 8);
+		}
+		return prefix_carry_generic(src + i, dst + i, bytes - i, carry);
+	}
+
+	static STENOS_ALWAYS_INLINE __m128i broadcast_last_sse2(__m128i x) noexcept
+	{
+		x = _mm_unpackhi_epi8(x, x);
+		x = _mm_shufflehi_epi16(x, _MM_SHUFFLE(3, 3, 3, 3));
+		return _mm_shuffle_epi32(x, _MM_SHUFFLE(3, 3, 3, 3));
+	}
+
+	static inline void prefix_carry4_sse2(const uint8_t* const* src, uint8_t* const* dst, size_t bytes, uint8_t* carry) noexcept
+	{
+		// Inverse delta on 4 independent streams, the carries stay in registers
+		__m128i c[4] = { _mm_set1_epi8((char)carry[0]), _mm_set1_epi8((char)carry[1]), _mm_set1_epi8((char)carry[2]), _mm_set1_epi8((char)carry[3]) };
+		size_t i = 0;
+		for (; i + 16 <= bytes; i += 16) {
+			for (size_t k = 0; k < 4; ++k) {
+				__m128i row = _mm_add_epi8(prefix_sum_16(_mm_loadu_si128((const __m128i*)(src[k] + i))), c[k]);
+				_mm_storeu_si128((__m128i*)(dst[k] + i), row);
+				c[k] = broadcast_last_sse2(row);
+			}
+		}
+		for (size_t k = 0; k < 4; ++k)
+			carry[k] = prefix_carry_generic(src[k] + i, dst[k] + i, bytes - i, (uint8_t)_mm_cvtsi128_si32(c[k]));
+	}
+#endif
+
+#ifdef __AVX2__
+	static inline uint8_t prefix_carry_avx2(const uint8_t* src, uint8_t* dst, size_t bytes, uint8_t carry) noexcept
+	{
+		const __m256i shuffle = _mm256_set_m128i(_mm_set1_epi8(15), _mm_set1_epi8((char)0x80));
+		size_t i = 0;
+		for (; i + 32 <= bytes; i += 32) {
+			__m256i row = _mm256_add_epi8(prefix_sum_32(_mm256_loadu_si256((const __m256i*)(src + i)), shuffle), _mm256_set1_epi8((char)carry));
+			_mm256_storeu_si256((__m256i*)(dst + i), row);
+			carry = (uint8_t)_mm256_extract_epi8(row, 31);
+		}
+		return prefix_carry_generic(src + i, dst + i, bytes - i, carry);
+	}
+
+	static inline void prefix_carry4_avx2(const uint8_t* const* src, uint8_t* const* dst, size_t bytes, uint8_t* carry) noexcept
+	{
+		// Inverse delta on 4 independent streams, the carries stay in registers
+		const __m256i shuffle = _mm256_set_m128i(_mm_set1_epi8(15), _mm_set1_epi8((char)0x80));
+		const __m256i last = _mm256_set1_epi8(15);
+		__m256i c[4] = { _mm256_set1_epi8((char)carry[0]), _mm256_set1_epi8((char)carry[1]), _mm256_set1_epi8((char)carry[2]), _mm256_set1_epi8((char)carry[3]) };
+		size_t i = 0;
+		for (; i + 32 <= bytes; i += 32) {
+			for (size_t k = 0; k < 4; ++k) {
+				__m256i row = _mm256_add_epi8(prefix_sum_32(_mm256_loadu_si256((const __m256i*)(src[k] + i)), shuffle), c[k]);
+				_mm256_storeu_si256((__m256i*)(dst[k] + i), row);
+				c[k] = _mm256_shuffle_epi8(_mm256_permute4x64_epi64(row, _MM_SHUFFLE(3, 3, 3, 3)), last);
+			}
+		}
+		for (size_t k = 0; k < 4; ++k)
+			carry[k] = prefix_carry_generic(src[k] + i, dst[k] + i, bytes - i, (uint8_t)_mm256_cvtsi256_si32(c[k]));
+	}
+#endif
+
+	static STENOS_ALWAYS_INLINE bool restart_in(const size_t* restarts, size_t start, size_t end) noexcept
+	{
+		// Returns true if a chain restart lies within [start, end)
+		for (size_t r = 1; r < 4; ++r)
+			if (restarts[r] >= start && restarts[r] < end)
+				return true;
+		return false;
+	}
+
+	void delta_inv_unshuffle(size_t bytesoftype, size_t bytes, void* _src, void* _dst)
+	{
+		// The delta chains restart at each quarter of the buffer (see delta()), and
+		// the shuffled buffer stores one plane of n bytes per byte of type.
+		// Each tile of elements is inverted plane by plane in a L1 resident buffer,
+		// then unshuffled to dst. The decoded value preceding each plane is first
+		// computed with a (read only) byte sum pass.
+		uint8_t* src = (uint8_t*)_src;
+		uint8_t* dst = (uint8_t*)_dst;
+		const size_t n = bytesoftype ? bytes / bytesoftype : 0;
+
+		if (bytesoftype <= 1)
+			return delta_inv(src, dst, bytes);
+		if (bytesoftype > max_fused_bytesoftype || n < 16) {
+			// Unfused, the inverse delta works in place
+			delta_inv(src, src, bytes);
+			return unshuffle(bytesoftype, bytes, src, dst);
+		}
+
+		using sum_func = uint8_t (*)(const uint8_t*, size_t) noexcept;
+		using prefix_func = uint8_t (*)(const uint8_t*, uint8_t*, size_t, uint8_t) noexcept;
+		using prefix4_func = void (*)(const uint8_t* const*, uint8_t* const*, size_t, uint8_t*) noexcept;
+		sum_func sum_bytes = sum_bytes_generic;
+		prefix_func prefix_carry = prefix_carry_generic;
+		prefix4_func prefix_carry4 = prefix_carry4_generic;
+#ifdef __SSE2__
+		if (cpu_features().HAS_SSE2) {
+			sum_bytes = sum_bytes_sse2;
+			prefix_carry = prefix_carry_sse2;
+			prefix_carry4 = prefix_carry4_sse2;
+		}
+#endif
+#ifdef __AVX2__
+		if (cpu_features().HAS_AVX2) {
+			prefix_carry = prefix_carry_avx2;
+			prefix_carry4 = prefix_carry4_avx2;
+		}
+#endif
+
+		// Chain restart positions
+		const size_t bytes4 = bytes / 4;
+		const size_t restarts[4] = { 0, bytes > 2048 ? bytes4 : bytes, bytes > 2048 ? bytes4 * 2 : bytes, bytes > 2048 ? bytes4 * 3 : bytes };
+
+		// Decoded value preceding each plane (and the remaining bytes)
+		uint8_t carry[max_fused_bytesoftype + 1];
+		{
+			uint8_t running = 0;
+			size_t pos = 0, r = 1;
+			for (size_t j = 1; j <= bytesoftype; ++j) {
+				size_t plane = j * n;
+				for (; r < 4 && restarts[r] <= plane; ++r) {
+					pos = restarts[r];
+					running = 0;
+				}
+				running = (uint8_t)(running + sum_bytes(src + pos, plane - pos));
+				pos = plane;
+				carry[j] = running;
+			}
+			carry[0] = 0;
+		}
+
+		// Tile of at most 16KB, with a multiple of 16 elements
+		static constexpr size_t tile_bytes = 16384;
+		alignas(64) uint8_t tile[tile_bytes];
+		const size_t tile_elems = (tile_bytes / bytesoftype) & ~(size_t)15;
+
+		for (size_t e0 = 0; e0 < n; e0 += tile_elems) {
+			size_t len = std::min(tile_elems, n - e0);
+			size_t j = 0;
+			// Process planes 4 by 4 while their segments do not contain a chain restart
+			for (; j + 4 <= bytesoftype; j += 4) {
+				const uint8_t* s4[4] = { src + j * n + e0, src + (j + 1) * n + e0, src + (j + 2) * n + e0, src + (j + 3) * n + e0 };
+				if (restart_in(restarts, s4[0] - src, s4[0] - src + len) || restart_in(restarts, s4[1] - src, s4[1] - src + len) ||
+				    restart_in(restarts, s4[2] - src, s4[2] - src + len) || restart_in(restarts, s4[3] - src, s4[3] - src + len))
+					break;
+				uint8_t* d4[4] = { tile + j * len, tile + (j + 1) * len, tile + (j + 2) * len, tile + (j + 3) * len };
+				prefix_carry4(s4, d4, len, carry + j);
+			}
+			for (; j < bytesoftype; ++j) {
+				size_t start = j * n + e0, end = start + len;
+				uint8_t* out = tile + j * len;
+				uint8_t c = carry[j];
+				// Split the segment on chain restarts
+				for (size_t r = 1; r < 4; ++r)
+					if (restarts[r] >= start && restarts[r] < end) {
+						prefix_carry(src + start, out, restarts[r] - start, c);
+						out += restarts[r] - start;
+						start = restarts[r];
+						c = 0;
+					}
+				carry[j] = prefix_carry(src + start, out, end - start, c);
+			}
+			unshuffle(bytesoftype, len * bytesoftype, tile, dst + e0 * bytesoftype);
+		}
+
+		// Remaining bytes follow the last plane
+		prefix_carry(src + n * bytesoftype, dst + n * bytesoftype, bytes - n * bytesoftype, carry[bytesoftype - 1]);
+	}
+
+	//
+	// XOR with previous element followed by bit transposition
+	//
+
+	static STENOS_ALWAYS_INLINE uint64_t transpose_bits8(uint64_t x) noexcept
+	{
+		// Transpose the 8x8 bit matrix stored in x (byte r, bit c becomes byte c, bit r)
+		uint64_t t = (x ^ (x >> 7)) & 0x00AA00AA00AA00AAull;
+		x = x ^ t ^ (t << 7);
+		t = (x ^ (x >> 14)) & 0x0000CCCC0000CCCCull;
+		x = x ^ t ^ (t << 14);
+		t = (x ^ (x >> 28)) & 0x00000000F0F0F0F0ull;
+		return x ^ t ^ (t << 28);
+	}
+
+	static inline size_t xor_bitshuffle_plane_generic(const uint8_t* src, size_t start, size_t n8, uint8_t& prev, uint8_t* dst) noexcept
+	{
+		// Encode groups of 8 bytes from start to n8, returns the end position
+		const size_t stride = n8 / 8;
+		for (size_t i = start; i < n8; i += 8) {
+			uint64_t x = read_LE_64(src + i);
+			uint64_t y = transpose_bits8(x ^ ((x << 8) | prev));
+			prev = (uint8_t)(x >> 56);
+			for (size_t k = 0; k < 8; ++k)
+				dst[k * stride + i / 8] = (uint8_t)(y >> (8 * k));
+		}
+		return n8;
+	}
+
+	static inline size_t xor_bitunshuffle_plane_generic(const uint8_t* src, size_t start, size_t end, size_t n8, uint8_t& prev, uint8_t* dst) noexcept
+	{
+		// Decode groups of 8 bytes from start to end (at most n8) to dst, returns the end position
+		const size_t stride = n8 / 8;
+		end = std::min(end, n8);
+		for (size_t i = start; i < end; i += 8) {
+			uint64_t z = 0;
+			for (size_t k = 0; k < 8; ++k)
+				z |= (uint64_t)src[k * stride + i / 8] << (8 * k);
+			uint64_t y = transpose_bits8(z);
+			y ^= y << 8;
+			y ^= y << 16;
+			y ^= y << 32;
+			y ^= prev * 0x0101010101010101ull;
+			prev = (uint8_t)(y >> 56);
+			write_LE_64(dst + i - start, y);
+		}
+		return end > start ? end : start;
+	}
+
+#ifdef __SSE2__
+
+	static inline size_t xor_bitshuffle_plane_sse2(const uint8_t* src, size_t start, size_t n8, uint8_t& prev, uint8_t* dst) noexcept
+	{
+		// Encode groups of 16 bytes, each bit plane being extracted with movemask
+		const size_t stride = n8 / 8;
+		size_t i = start;
+		for (; i + 16 <= n8; i += 16) {
+			__m128i x = _mm_loadu_si128((const __m128i*)(src + i));
+			__m128i y = _mm_xor_si128(x, _mm_or_si128(_mm_slli_si128(x, 1), _mm_cvtsi32_si128(prev)));
+			prev = src[i + 15];
+			for (size_t k = 8; k-- > 0;) {
+				write_LE_16(dst + k * stride + i / 8, (uint16_t)_mm_movemask_epi8(y));
+				y = _mm_add_epi8(y, y);
+			}
+		}
+		return xor_bitshuffle_plane_generic(src, i, n8, prev, dst);
+	}
+
+	static inline size_t xor_bitunshuffle_plane_sse2(const uint8_t* src, size_t start, size_t end, size_t n8, uint8_t& prev, uint8_t* dst) noexcept
+	{
+		// Decode groups of 16 bytes, transposing the 2 bit matrices at once
+		const size_t stride = n8 / 8;
+		const __m128i low = _mm_set1_epi16(0xFF);
+		const __m128i m1 = _mm_set1_epi64x(0x00AA00AA00AA00AAll);
+		const __m128i m2 = _mm_set1_epi64x(0x0000CCCC0000CCCCll);
+		const __m128i m3 = _mm_set1_epi64x(0x00000000F0F0F0F0ll);
+		size_t i = start;
+		end = std::min(end, n8);
+		for (; i + 16 <= end; i += 16) {
+			const uint8_t* s = src + i / 8;
+			__m128i v = _mm_set_epi16((short)read_LE_16(s + 7 * stride),
+						  (short)read_LE_16(s + 6 * stride),
+						  (short)read_LE_16(s + 5 * stride),
+						  (short)read_LE_16(s + 4 * stride),
+						  (short)read_LE_16(s + 3 * stride),
+						  (short)read_LE_16(s + 2 * stride),
+						  (short)read_LE_16(s + stride),
+						  (short)read_LE_16(s));
+			__m128i x = _mm_packus_epi16(_mm_and_si128(v, low), _mm_srli_epi16(v, 8));
+			__m128i t = _mm_and_si128(_mm_xor_si128(x, _mm_srli_epi64(x, 7)), m1);
+			x = _mm_xor_si128(x, _mm_xor_si128(t, _mm_slli_epi64(t, 7)));
+			t = _mm_and_si128(_mm_xor_si128(x, _mm_srli_epi64(x, 14)), m2);
+			x = _mm_xor_si128(x, _mm_xor_si128(t, _mm_slli_epi64(t, 14)));
+			t = _mm_and_si128(_mm_xor_si128(x, _mm_srli_epi64(x, 28)), m3);
+			x = _mm_xor_si128(x, _mm_xor_si128(t, _mm_slli_epi64(t, 28)));
+			// Prefix XOR
+			x = _mm_xor_si128(x, _mm_slli_si128(x, 1));
+			x = _mm_xor_si128(x, _mm_slli_si128(x, 2));
+			x = _mm_xor_si128(x, _mm_slli_si128(x, 4));
+			x = _mm_xor_si128(x, _mm_slli_si128(x, 8));
+			x = _mm_xor_si128(x, _mm_set1_epi8((char)prev));
+			_mm_storeu_si128((__m128i*)(dst + i - start), x);
+			prev = (uint8_t)(_mm_extract_epi16(x, 7) >> 8);
+		}
+		return xor_bitunshuffle_plane_generic(src, i, end, n8, prev, dst + i - start);
+	}
+#endif
+
+	void xor_bitshuffle(size_t bytesoftype, size_t bytes, const void* _src, void* _dst)
+	{
+		const uint8_t* src = (const uint8_t*)_src;
+		uint8_t* dst = (uint8_t*)_dst;
+		const size_t n = bytesoftype ? bytes / bytesoftype : 0;
+		const size_t n8 = n & ~(size_t)7;
+
+		using plane_func = size_t (*)(const uint8_t*, size_t, size_t, uint8_t&, uint8_t*) noexcept;
+		plane_func encode = xor_bitshuffle_plane_generic;
+#ifdef __SSE2__
+		if (cpu_features().HAS_SSE2)
+			encode = xor_bitshuffle_plane_sse2;
+#endif
+
+		for (size_t j = 0; j < bytesoftype; ++j) {
+			const uint8_t* s = src + j * n;
+			uint8_t* d = dst + j * n;
+			uint8_t prev = 0;
+			encode(s, 0, n8, prev, d);
+			// Trailing bytes are only XORed
+			for (size_t i = n8; i < n; ++i) {
+				d[i] = s[i] ^ prev;
+				prev = s[i];
+			}
+		}
+		// Remaining bytes follow the last plane
+		memcpy(dst + n * bytesoftype, src + n * bytesoftype, bytes - n * bytesoftype);
+	}
+
+	void xor_bitunshuffle(size_t bytesoftype, size_t bytes, void* _src, void* _dst)
+	{
+		// Each tile of elements is decoded plane by plane in a L1 resident buffer,
+		// then unshuffled to dst.
+		uint8_t* src = (uint8_t*)_src;
+		uint8_t* dst = (uint8_t*)_dst;
+		const size_t n = bytesoftype ? bytes / bytesoftype : 0;
+		const size_t n8 = n & ~(size_t)7;
+
+		using plane_func = size_t (*)(const uint8_t*, size_t, size_t, size_t, uint8_t&, uint8_t*) noexcept;
+		plane_func decode = xor_bitunshuffle_plane_generic;
+#ifdef __SSE2__
+		if (cpu_features().HAS_SSE2)
+			decode = xor_bitunshuffle_plane_sse2;
+#endif
+
+		auto decode_range = [&](size_t j, size_t e0, size_t len, uint8_t& prev, uint8_t* out) {
+			const uint8_t* s = src + j * n;
+			size_t i = decode(s, e0, e0 + len, n8, prev, out);
+			for (; i < e0 + len; ++i)
+				out[i - e0] = prev = s[i] ^ prev;
+		};
+
+		if (bytesoftype <= 1 || bytesoftype > max_fused_bytesoftype) {
+			// Unfused: decode planes to dst, unshuffle to src and copy back
+			for (size_t j = 0; j < bytesoftype; ++j) {
+				uint8_t prev = 0;
+				decode_range(j, 0, n, prev, dst + j * n);
+			}
+			if (bytesoftype > 1) {
+				unshuffle(bytesoftype, n * bytesoftype, dst, src);
+				memcpy(dst, src, n * bytesoftype);
+			}
+		}
+		else {
+			static constexpr size_t tile_elements = 256;
+			uint8_t tile[max_fused_bytesoftype * tile_elements];
+			uint8_t prev[max_fused_bytesoftype] = { 0 };
+			for (size_t e0 = 0; e0 < n; e0 += tile_elements) {
+				const size_t len = std::min(tile_elements, n - e0);
+				for (size_t j = 0; j < bytesoftype; ++j)
+					decode_range(j, e0, len, prev[j], tile + j * len);
+				unshuffle(bytesoftype, len * bytesoftype, tile, dst + e0 * bytesoftype);
+			}
+		}
+		// Remaining bytes follow the last plane
+		memcpy(dst + n * bytesoftype, src + n * bytesoftype, bytes - n * bytesoftype);
+	}
+
+	//
+	// Element-wise integer delta and delta of delta
+	//
+
+	template<class T>
+	static STENOS_ALWAYS_INLINE T zigzag_encode(T d) noexcept
+	{
+		return (T)((T)(d << 1) ^ (T)(0 - (d >> (sizeof(T) * 8 - 1))));
+	}
+	template<class T>
+	static STENOS_ALWAYS_INLINE T zigzag_decode(T z) noexcept
+	{
+		return (T)((z >> 1) ^ (T)(0 - (z & 1)));
+	}
+
+	template<class T>
+	static inline void delta_pass_generic(const T* in, T* out, size_t n, bool zigzag) noexcept
+	{
+		// out[i] = in[i] - in[i - 1], in[-1] being the previous value
+		if (zigzag)
+			for (size_t i = 0; i < n; ++i)
+				out[i] = zigzag_encode<T>((T)(in[i] - in[i - 1]));
+		else
+			for (size_t i = 0; i < n; ++i)
+				out[i] = (T)(in[i] - in[i - 1]);
+	}
+
+	template<class T>
+	static inline T prefix_pass_generic(T* p, size_t n, T prev, bool zigzag) noexcept
+	{
+		// In place inverse of delta_pass_generic(), returns the last value
+		for (size_t i = 0; i < n; ++i)
+			p[i] = prev = (T)(prev + (zigzag ? zigzag_decode<T>(p[i]) : p[i]));
+		return prev;
+	}
+
+#ifdef __SSE4_1__
+
+	template<class T>
+	struct Lanes128;
+
+	template<>
+	struct Lanes128<uint16_t>
+	{
+		static STENOS_ALWAYS_INLINE __m128i sub(__m128i a, __m128i b) noexcept { return _mm_sub_epi16(a, b); }
+		static STENOS_ALWAYS_INLINE __m128i add(__m128i a, __m128i b) noexcept { return _mm_add_epi16(a, b); }
+		static STENOS_ALWAYS_INLINE __m128i zigzag(__m128i d) noexcept { return _mm_xor_si128(_mm_slli_epi16(d, 1), _mm_srai_epi16(d, 15)); }
+		static STENOS_ALWAYS_INLINE __m128i unzigzag(__m128i z) noexcept
+		{
+			return _mm_xor_si128(_mm_srli_epi16(z, 1), _mm_sub_epi16(_mm_setzero_si128(), _mm_and_si128(z, _mm_set1_epi16(1))));
+		}
+		static STENOS_ALWAYS_INLINE __m128i prefix(__m128i x) noexcept
+		{
+			x = _mm_add_epi16(x, _mm_slli_si128(x, 2));
+			x = _mm_add_epi16(x, _mm_slli_si128(x, 4));
+			return _mm_add_epi16(x, _mm_slli_si128(x, 8));
+		}
+		static STENOS_ALWAYS_INLINE __m128i broadcast_last(__m128i x) noexcept { return _mm_shuffle_epi32(_mm_shufflehi_epi16(x, _MM_SHUFFLE(3, 3, 3, 3)), _MM_SHUFFLE(3, 3, 3, 3)); }
+		static STENOS_ALWAYS_INLINE __m128i set1(uint16_t v) noexcept { return _mm_set1_epi16((short)v); }
+	};
+
+	template<>
+	struct Lanes128<uint32_t>
+	{
+		static STENOS_ALWAYS_INLINE __m128i sub(__m128i a, __m128i b) noexcept { return _mm_sub_epi32(a, b); }
+		static STENOS_ALWAYS_INLINE __m128i add(__m128i a, __m128i b) noexcept { return _mm_add_epi32(a, b); }
+		static STENOS_ALWAYS_INLINE __m128i zigzag(__m128i d) noexcept { return _mm_xor_si128(_mm_slli_epi32(d, 1), _mm_srai_epi32(d, 31)); }
+		static STENOS_ALWAYS_INLINE __m128i unzigzag(__m128i z) noexcept
+		{
+			return _mm_xor_si128(_mm_srli_epi32(z, 1), _mm_sub_epi32(_mm_setzero_si128(), _mm_and_si128(z, _mm_set1_epi32(1))));
+		}
+		static STENOS_ALWAYS_INLINE __m128i prefix(__m128i x) noexcept
+		{
+			x = _mm_add_epi32(x, _mm_slli_si128(x, 4));
+			return _mm_add_epi32(x, _mm_slli_si128(x, 8));
+		}
+		static STENOS_ALWAYS_INLINE __m128i broadcast_last(__m128i x) noexcept { return _mm_shuffle_epi32(x, _MM_SHUFFLE(3, 3, 3, 3)); }
+		static STENOS_ALWAYS_INLINE __m128i set1(uint32_t v) noexcept { return _mm_set1_epi32((int)v); }
+	};
+
+	template<>
+	struct Lanes128<uint64_t>
+	{
+		static STENOS_ALWAYS_INLINE __m128i sub(__m128i a, __m128i b) noexcept { return _mm_sub_epi64(a, b); }
+		static STENOS_ALWAYS_INLINE __m128i add(__m128i a, __m128i b) noexcept { return _mm_add_epi64(a, b); }
+		static STENOS_ALWAYS_INLINE __m128i zigzag(__m128i d) noexcept
+		{
+			return _mm_xor_si128(_mm_slli_epi64(d, 1), _mm_sub_epi64(_mm_setzero_si128(), _mm_srli_epi64(d, 63)));
+		}
+		static STENOS_ALWAYS_INLINE __m128i unzigzag(__m128i z) noexcept
+		{
+			return _mm_xor_si128(_mm_srli_epi64(z, 1), _mm_sub_epi64(_mm_setzero_si128(), _mm_and_si128(z, _mm_set1_epi64x(1))));
+		}
+		static STENOS_ALWAYS_INLINE __m128i prefix(__m128i x) noexcept { return _mm_add_epi64(x, _mm_slli_si128(x, 8)); }
+		static STENOS_ALWAYS_INLINE __m128i broadcast_last(__m128i x) noexcept { return _mm_shuffle_epi32(x, _MM_SHUFFLE(3, 2, 3, 2)); }
+		static STENOS_ALWAYS_INLINE __m128i set1(uint64_t v) noexcept { return _mm_set1_epi64x((long long)v); }
+	};
+
+	template<class T>
+	static inline void delta_pass_sse41(const T* in, T* out, size_t n, bool zigzag) noexcept
+	{
+		using L = Lanes128<T>;
+		static constexpr size_t count = 16 / sizeof(T);
+		size_t i = 0;
+		if (zigzag)
+			for (; i + count <= n; i += count)
+				_mm_storeu_si128((__m128i*)(out + i),
+						 L::zigzag(L::sub(_mm_loadu_si128((const __m128i*)(in + i)), _mm_loadu_si128((const __m128i*)(in + i - 1)))));
+		else
+			for (; i + count <= n; i += count)
+				_mm_storeu_si128((__m128i*)(out + i), L::sub(_mm_loadu_si128((const __m128i*)(in + i)), _mm_loadu_si128((const __m128i*)(in + i - 1))));
+		delta_pass_generic(in + i, out + i, n - i, zigzag);
+	}
+
+	template<class T>
+	static inline T prefix_pass_sse41(T* p, size_t n, T prev, bool zigzag) noexcept
+	{
+		using L = Lanes128<T>;
+		static constexpr size_t count = 16 / sizeof(T);
+		__m128i c = L::set1(prev);
+		size_t i = 0;
+		for (; i + count <= n; i += count) {
+			__m128i x = _mm_loadu_si128((const __m128i*)(p + i));
+			if (zigzag)
+				x = L::unzigzag(x);
+			x = L::add(L::prefix(x), c);
+			_mm_storeu_si128((__m128i*)(p + i), x);
+			c = L::broadcast_last(x);
+		}
+		if (i)
+			prev = p[i - 1];
+		return prefix_pass_generic(p + i, n - i, prev, zigzag);
+	}
+#endif
+
+#ifdef __AVX2__
+
+	template<class T>
+	struct Lanes256;
+
+	template<>
+	struct Lanes256<uint16_t>
+	{
+		static STENOS_ALWAYS_INLINE __m256i sub(__m256i a, __m256i b) noexcept { return _mm256_sub_epi16(a, b); }
+		static STENOS_ALWAYS_INLINE __m256i zigzag(__m256i d) noexcept { return _mm256_xor_si256(_mm256_slli_epi16(d, 1), _mm256_srai_epi16(d, 15)); }
+	};
+	template<>
+	struct Lanes256<uint32_t>
+	{
+		static STENOS_ALWAYS_INLINE __m256i sub(__m256i a, __m256i b) noexcept { return _mm256_sub_epi32(a, b); }
+		static STENOS_ALWAYS_INLINE __m256i zigzag(__m256i d) noexcept { return _mm256_xor_si256(_mm256_slli_epi32(d, 1), _mm256_srai_epi32(d, 31)); }
+	};
+	template<>
+	struct Lanes256<uint64_t>
+	{
+		static STENOS_ALWAYS_INLINE __m256i sub(__m256i a, __m256i b) noexcept { return _mm256_sub_epi64(a, b); }
+		static STENOS_ALWAYS_INLINE __m256i zigzag(__m256i d) noexcept
+		{
+			return _mm256_xor_si256(_mm256_slli_epi64(d, 1), _mm256_sub_epi64(_mm256_setzero_si256(), _mm256_srli_epi64(d, 63)));
+		}
+	};
+
+	template<class T>
+	static inline void delta_pass_avx2(const T* in, T* out, size_t n, bool zigzag) noexcept
+	{
+		using L = Lanes256<T>;
+		static constexpr size_t count = 32 / sizeof(T);
+		size_t i = 0;
+		if (zigzag)
+			for (; i + count <= n; i += count)
+				_mm256_storeu_si256((__m256i*)(out + i),
+						    L::zigzag(L::sub(_mm256_loadu_si256((const __m256i*)(in + i)), _mm256_loadu_si256((const __m256i*)(in + i - 1)))));
+		else
+			for (; i + count <= n; i += count)
+				_mm256_storeu_si256((__m256i*)(out + i), L::sub(_mm256_loadu_si256((const __m256i*)(in + i)), _mm256_loadu_si256((const __m256i*)(in + i - 1))));
+		delta_pass_generic(in + i, out + i, n - i, zigzag);
+	}
+#endif
+
+	template<class T>
+	struct IntDelta
+	{
+		using delta_func = void (*)(const T*, T*, size_t, bool) noexcept;
+		using prefix_func = T (*)(T*, size_t, T, bool) noexcept;
+
+		static constexpr size_t tile_elements = 256;
+
+		delta_func delta_pass = delta_pass_generic<T>;
+		prefix_func prefix_pass = prefix_pass_generic<T>;
+
+		IntDelta() noexcept
+		{
+#ifdef __SSE4_1__
+			if (cpu_features().HAS_SSE41) {
+				delta_pass = delta_pass_sse41<T>;
+				prefix_pass = prefix_pass_sse41<T>;
+			}
+#endif
+#ifdef __AVX2__
+			if (cpu_features().HAS_AVX2)
+				delta_pass = delta_pass_avx2<T>;
+#endif
+		}
+
+		void encode(size_t bytes, int order, const uint8_t* src, uint8_t* dst) const noexcept
+		{
+			// Each tile of elements is predicted in L1 resident buffers, shuffled,
+			// then its planes are copied to dst
+			const size_t n = bytes / sizeof(T);
+			T raw[tile_elements + 1], d1[tile_elements + 1], res[tile_elements];
+			uint8_t tile[tile_elements * sizeof(T)];
+			raw[0] = d1[0] = 0;
+			for (size_t e0 = 0; e0 < n; e0 += tile_elements) {
+				const size_t len = std::min(tile_elements, n - e0);
+				memcpy(raw + 1, src + e0 * sizeof(T), len * sizeof(T));
+				if (order == 1)
+					delta_pass(raw + 1, res, len, true);
+				else {
+					delta_pass(raw + 1, d1 + 1, len, false);
+					delta_pass(d1 + 1, res, len, true);
+					d1[0] = d1[len];
+				}
+				raw[0] = raw[len];
+				shuffle(sizeof(T), len * sizeof(T), (const uint8_t*)res, tile);
+				for (size_t j = 0; j < sizeof(T); ++j)
+					memcpy(dst + j * n + e0, tile + j * len, len);
+			}
+			// Remaining bytes follow the last plane
+			memcpy(dst + n * sizeof(T), src + n * sizeof(T), bytes - n * sizeof(T));
+		}
+
+		void decode(size_t bytes, int order, const uint8_t* src, uint8_t* dst) const noexcept
+		{
+			const size_t n = bytes / sizeof(T);
+			T res[tile_elements];
+			uint8_t tile[tile_elements * sizeof(T)];
+			T prev = 0, prev_delta = 0;
+			for (size_t e0 = 0; e0 < n; e0 += tile_elements) {
+				const size_t len = std::min(tile_elements, n - e0);
+				for (size_t j = 0; j < sizeof(T); ++j)
+					memcpy(tile + j * len, src + j * n + e0, len);
+				unshuffle(sizeof(T), len * sizeof(T), tile, (uint8_t*)res);
+				if (order == 1)
+					prev = prefix_pass(res, len, prev, true);
+				else {
+					prev_delta = prefix_pass(res, len, prev_delta, true);
+					prev = prefix_pass(res, len, prev, false);
+				}
+				memcpy(dst + e0 * sizeof(T), res, len * sizeof(T));
+			}
+			memcpy(dst + n * sizeof(T), src + n * sizeof(T), bytes - n * sizeof(T));
+		}
+
+		static const IntDelta& instance() noexcept
+		{
+			static const IntDelta inst;
+			return inst;
+		}
+	};
+	// Out of class definition, tile_elements is odr-used by std::min (required before C++17)
+	template<class T>
+	constexpr size_t IntDelta<T>::tile_elements;
+
+	void int_delta_shuffle(size_t bytesoftype, size_t bytes, int order, const void* src, void* dst)
+	{
+		switch (bytesoftype) {
+			case 2:
+				return IntDelta<uint16_t>::instance().encode(bytes, order, (const uint8_t*)src, (uint8_t*)dst);
+			case 4:
+				return IntDelta<uint32_t>::instance().encode(bytes, order, (const uint8_t*)src, (uint8_t*)dst);
+			case 8:
+				return IntDelta<uint64_t>::instance().encode(bytes, order, (const uint8_t*)src, (uint8_t*)dst);
+			default:
+				STENOS_ASSERT_DEBUG(false, "unsupported type size for integer delta");
+		}
+	}
+
+	void int_delta_inv_unshuffle(size_t bytesoftype, size_t bytes, int order, const void* src, void* dst)
+	{
+		switch (bytesoftype) {
+			case 2:
+				return IntDelta<uint16_t>::instance().decode(bytes, order, (const uint8_t*)src, (uint8_t*)dst);
+			case 4:
+				return IntDelta<uint32_t>::instance().decode(bytes, order, (const uint8_t*)src, (uint8_t*)dst);
+			case 8:
+				return IntDelta<uint64_t>::instance().decode(bytes, order, (const uint8_t*)src, (uint8_t*)dst);
+			default:
+				STENOS_ASSERT_DEBUG(false, "unsupported type size for integer delta");
+		}
+	}
+}
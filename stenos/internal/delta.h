@@ -30,13 +30,41 @@
 namespace stenos
 {
 	/// @brief Apply byte delta to input buffer
-	/// Uses SSE2 or AVX2 if available
+	/// Uses SSE2, AVX2 or AVX512 if available
 	void delta(const void* src, void* dst, size_t bytes);
 
 	/// @brief Apply byte delta inversion
-	/// Uses SSE2 or AVX2 if available
+	/// Uses SSE2, AVX2 or AVX512 if available
 	/// The buffer size must the same as the one used by delta().
 	void delta_inv(const void* src, void* dst, size_t bytes);
+
+	/// @brief Maximum type size handled by the fused delta_inv_unshuffle() kernel
+	static constexpr size_t max_fused_bytesoftype = 64;
+
+	/// @brief Equivalent to delta_inv() followed by unshuffle(), in a single cache-blocked pass.
+	/// Larger types are processed in 2 passes, src being used (and overwritten) as temporary buffer.
+	/// src and dst must not overlap.
+	void delta_inv_unshuffle(size_t bytesoftype, size_t bytes, void* src, void* dst);
+
+	/// @brief XOR each byte of a shuffled buffer with the previous one of its plane (the same byte of the
+	/// previous element), then transpose the bits of each plane.
+	/// Each plane of n bytes stores 8 bit planes of n/8 bytes followed by the n%8 trailing (XORed) bytes.
+	/// Uses SSE2 if available.
+	void xor_bitshuffle(size_t bytesoftype, size_t bytes, const void* src, void* dst);
+
+	/// @brief Inverse of xor_bitshuffle() followed by unshuffle(), in a single cache-blocked pass.
+	/// Types larger than max_fused_bytesoftype use src as temporary buffer.
+	/// src and dst must not overlap.
+	void xor_bitunshuffle(size_t bytesoftype, size_t bytes, void* src, void* dst);
+
+	/// @brief Element-wise integer delta (order 1) or delta of delta (order 2) with zigzag encoding,
+	/// followed by shuffle(), in a single cache-blocked pass.
+	/// bytesoftype must be 2, 4 or 8. Uses SSE4.1 or AVX2 if available.
+	void int_delta_shuffle(size_t bytesoftype, size_t bytes, int order, const void* src, void* dst);
+
+	/// @brief Inverse of int_delta_shuffle(), in a single cache-blocked pass.
+	/// src and dst must not overlap.
+	void int_delta_inv_unshuffle(size_t bytesoftype, size_t bytes, int order, const void* src, void* dst);
 }
 
 #endif
\ No newline at end of file
@@ -0,0 +1,286 @@
+/**
+ * MIT License
+ *
+ * Copyright (c) 2025 Victor Moncada <vtr.moncada@gmail.com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef STENOS_REDUCE_H
+#define STENOS_REDUCE_H
+
+#include "block_compress.h"
+
+#include <cstring>
+#include <type_traits>
+
+namespace stenos
+{
+	/// @brief Partial result of a reduction (see stenos_reduce()) over elements of type T.
+	/// Sums are accumulated in double for floating point types, and modulo 2^64 for integers.
+	/// STENOS_REDUCE_COUNT_EQ compares the element bits.
+	template<class T>
+	struct Reducer
+	{
+		using acc_type = typename std::conditional<std::is_floating_point<T>::value, double, uint64_t>::type;
+		using ext_type = typename std::conditional<std::is_floating_point<T>::value, double, typename std::conditional<std::is_signed<T>::value, int64_t, uint64_t>::type>::type;
+
+		// Index type storing min/max values comparable with T
+		static constexpr int index_type = std::is_floating_point<T>::value ? STENOS_INDEX_MINMAX_FLOAT : (std::is_signed<T>::value ? STENOS_INDEX_MINMAX_SIGNED : STENOS_INDEX_MINMAX_UNSIGNED);
+
+		int op{ 0 };
+		T value{}; // Value compared by STENOS_REDUCE_COUNT_EQ
+		acc_type sum{ 0 };
+		T min{};
+		T max{};
+		uint64_t equal{ 0 };
+		uint64_t count{ 0 }; // Number of reduced elements
+
+		static STENOS_ALWAYS_INLINE T load(const uint8_t* p) noexcept
+		{
+			T v;
+			memcpy(&v, p, sizeof(T));
+			return v;
+		}
+		static STENOS_ALWAYS_INLINE bool same_bits(T a, T b) noexcept { return memcmp(&a, &b, sizeof(T)) == 0; }
+		static STENOS_ALWAYS_INLINE acc_type widen(T v) noexcept { return (acc_type)(ext_type)v; }
+
+		/// @brief Reduce n elements read from src (possibly unaligned)
+		void scan(const uint8_t* src, size_t n) noexcept
+		{
+			if (n == 0)
+				return;
+			switch (op) {
+				case STENOS_REDUCE_SUM: {
+					acc_type s = 0;
+					for (size_t i = 0; i < n; ++i)
+						s += widen(load(src + i * sizeof(T)));
+					sum += s;
+				} break;
+				case STENOS_REDUCE_MIN: {
+					T m = count ? min : load(src);
+					for (size_t i = 0; i < n; ++i) {
+						T v = load(src + i * sizeof(T));
+						if (v < m)
+							m = v;
+					}
+					min = m;
+				} break;
+				case STENOS_REDUCE_MAX: {
+					T m = count ? max : load(src);
+					for (size_t i = 0; i < n; ++i) {
+						T v = load(src + i * sizeof(T));
+						if (v > m)
+							m = v;
+					}
+					max = m;
+				} break;
+				default: {
+					uint64_t c = 0;
+					for (size_t i = 0; i < n; ++i)
+						c += same_bits(load(src + i * sizeof(T)), value);
+					equal += c;
+				} break;
+			}
+			count += n;
+		}
+
+		/// @brief Reduce n copies of the element stored in src
+		void repeat(const uint8_t* src, size_t n) noexcept
+		{
+			if (n == 0)
+				return;
+			T v = load(src);
+			switch (op) {
+				case STENOS_REDUCE_SUM:
+					sum += widen(v) * (acc_type)n;
+					break;
+				case STENOS_REDUCE_MIN:
+					if (!count || v < min)
+						min = v;
+					break;
+				case STENOS_REDUCE_MAX:
+					if (!count || v > max)
+						max = v;
+					break;
+				default:
+					if (same_bits(v, value))
+						equal += n;
+					break;
+			}
+			count += n;
+		}
+
+		/// @brief Try to reduce n elements from their stored min/max values only.
+		/// Returns false if the elements must be decoded.
+		bool from_index(const uint8_t* pmin, const uint8_t* pmax, size_t n) noexcept
+		{
+			const T mn = load(pmin);
+			const T mx = load(pmax);
+			switch (op) {
+				case STENOS_REDUCE_MIN:
+					repeat(pmin, n);
+					return true;
+				case STENOS_REDUCE_MAX:
+					repeat(pmax, n);
+					return true;
+				default:
+					if (std::is_floating_point<T>::value)
+						// Equal floating point values do not imply equal bits (0 and -0)
+						return false;
+					if (same_bits(mn, mx)) {
+						// All elements are equal
+						repeat(pmin, n);
+						return true;
+					}
+					if (op == STENOS_REDUCE_COUNT_EQ && (value < mn || value > mx)) {
+						count += n;
+						return true;
+					}
+					return false;
+			}
+		}
+
+		/// @brief Merge the partial result of following elements
+		void merge(const Reducer& o) noexcept
+		{
+			if (o.count == 0)
+				return;
+			sum += o.sum;
+			if (!count || o.min < min)
+				min = o.min;
+			if (!count || o.max > max)
+				max = o.max;
+			equal += o.equal;
+			count += o.count;
+		}
+
+		/// @brief Write the result, see stenos_reduce()
+		void write(void* out) const noexcept
+		{
+			switch (op) {
+				case STENOS_REDUCE_SUM: {
+					ext_type s = (ext_type)sum;
+					memcpy(out, &s, sizeof(s));
+				} break;
+				case STENOS_REDUCE_MIN:
+					if (count)
+						memcpy(out, &min, sizeof(T));
+					break;
+				case STENOS_REDUCE_MAX:
+					if (count)
+						memcpy(out, &max, sizeof(T));
+					break;
+				default:
+					memcpy(out, &equal, sizeof(equal));
+					break;
+			}
+		}
+	};
+
+	/// @brief STENOS_REDUCE_COUNT_EQ for elements of any size
+	struct RawCounter
+	{
+		static constexpr int index_type = STENOS_INDEX_NONE;
+
+		const uint8_t* value{ nullptr };
+		size_t bytesoftype{ 0 };
+		uint64_t equal{ 0 };
+		uint64_t count{ 0 };
+
+		void scan(const uint8_t* src, size_t n) noexcept
+		{
+			for (size_t i = 0; i < n; ++i)
+				equal += memcmp(src + i * bytesoftype, value, bytesoftype) == 0;
+			count += n;
+		}
+		void repeat(const uint8_t* src, size_t n) noexcept
+		{
+			if (memcmp(src, value, bytesoftype) == 0)
+				equal += n;
+			count += n;
+		}
+		bool from_index(const uint8_t*, const uint8_t*, size_t) noexcept { return false; }
+		void merge(const RawCounter& o) noexcept
+		{
+			equal += o.equal;
+			count += o.count;
+		}
+		void write(void* out) const noexcept { memcpy(out, &equal, sizeof(equal)); }
+	};
+
+	/// @brief Returns true if all byte planes of a block are __STENOS_BLOCK_ALL_SAME (256 equal elements)
+	static STENOS_ALWAYS_INLINE bool block_all_same(const uint8_t* header, size_t bytesoftype) noexcept
+	{
+		for (size_t i = 0; i < bytesoftype; ++i)
+			if (((header[i >> 1] >> (4 * (i & 1))) & 15) != __STENOS_BLOCK_ALL_SAME)
+				return false;
+		return true;
+	}
+
+	/// @brief Reduce a block compressed buffer (see block_compress()) of given decompressed size.
+	/// Blocks of equal elements and copied blocks are reduced without decoding, other blocks
+	/// are decoded one by one to tmp (at least bytesoftype * 256 bytes).
+	/// Returns 0 on success, or an error code.
+	template<class R>
+	static size_t reduce_block_superblock(const uint8_t* src, size_t size, size_t bytesoftype, size_t bytes, uint8_t* tmp, R& r) noexcept
+	{
+		const size_t block_size = bytesoftype * 256;
+		const size_t header_len = (bytesoftype >> 1) + (bytesoftype & 1);
+		const uint8_t* end = src + size;
+		const size_t block_count = bytes / block_size;
+
+		for (size_t b = 0; b < block_count; ++b) {
+			if STENOS_UNLIKELY ((size_t)(end - src) <= header_len)
+				return STENOS_ERROR_SRC_OVERFLOW;
+
+			if (block_all_same(src, bytesoftype)) {
+				// One byte per plane: the bytes of the repeated element
+				if STENOS_UNLIKELY ((size_t)(end - src) < header_len + bytesoftype)
+					return STENOS_ERROR_SRC_OVERFLOW;
+				r.repeat(src + header_len, 256);
+				src += header_len + bytesoftype;
+			}
+			else if (*src == __STENOS_BLOCK_COPY) {
+				if STENOS_UNLIKELY ((size_t)(end - src) < 1 + block_size)
+					return STENOS_ERROR_SRC_OVERFLOW;
+				r.scan(src + 1, 256);
+				src += 1 + block_size;
+			}
+			else {
+				size_t c = block_decompress_generic(src, (size_t)(end - src), bytesoftype, block_size, tmp);
+				if STENOS_UNLIKELY (has_error(c))
+					return STENOS_ERROR_INVALID_INPUT;
+				r.scan(tmp, 256);
+				src += c;
+			}
+		}
+
+		const size_t remaining = bytes - block_count * block_size;
+		if (remaining) {
+			size_t c = block_decompress_generic(src, (size_t)(end - src), bytesoftype, remaining, tmp);
+			if STENOS_UNLIKELY (has_error(c))
+				return STENOS_ERROR_INVALID_INPUT;
+			r.scan(tmp, remaining / bytesoftype);
+		}
+		return 0;
+	}
+}
+
+#endif
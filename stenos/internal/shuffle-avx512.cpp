@@ -0,0 +1,319 @@
+/**
+ * MIT License
+ *
+ * Copyright (c) 2025 Victor Moncada <vtr.moncada@gmail.com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include "shuffle-avx512.h"
+#include "shuffle-avx2.h"
+#include "shuffle-generic.h"
+#include "simd.h"
+
+#include <cstdlib>
+
+/* Make sure AVX512BW and AVX512VBMI are available for the compilation target and compiler. */
+#if defined(__AVX512BW__) && defined(__AVX512VBMI__) && defined(__AVX2__)
+
+#include <immintrin.h>
+
+/* GCC implements the unmasked permutations on top of _mm512_undefined_epi32(), which triggers
+   -Wmaybe-uninitialized. The zero-masked forms with a full mask produce the same instructions. */
+#define permutexvar_epi8(idx, a) _mm512_maskz_permutexvar_epi8((__mmask64)-1, idx, a)
+#define shuffle_i64x2(a, b, imm) _mm512_maskz_shuffle_i64x2((__mmask8)-1, a, b, imm)
+
+/* Byte k of 32 elements of 2 bytes in 256-bit half k */
+alignas(64) static const uint8_t shuffle2_idx[64] = {
+	0, 2, 4, 6, 8, 10, 12, 14, 16, 18, 20, 22, 24, 26, 28, 30,
+	32, 34, 36, 38, 40, 42, 44, 46, 48, 50, 52, 54, 56, 58, 60, 62,
+	1, 3, 5, 7, 9, 11, 13, 15, 17, 19, 21, 23, 25, 27, 29, 31,
+	33, 35, 37, 39, 41, 43, 45, 47, 49, 51, 53, 55, 57, 59, 61, 63
+};
+
+/* Byte k of 16 elements of 4 bytes in lane k */
+alignas(64) static const uint8_t shuffle4_idx[64] = {
+	0, 4, 8, 12, 16, 20, 24, 28, 32, 36, 40, 44, 48, 52, 56, 60,
+	1, 5, 9, 13, 17, 21, 25, 29, 33, 37, 41, 45, 49, 53, 57, 61,
+	2, 6, 10, 14, 18, 22, 26, 30, 34, 38, 42, 46, 50, 54, 58, 62,
+	3, 7, 11, 15, 19, 23, 27, 31, 35, 39, 43, 47, 51, 55, 59, 63
+};
+
+/* Byte k of 8 elements of 8 bytes in qword k */
+alignas(64) static const uint8_t shuffle8_idx[64] = {
+	0, 8, 16, 24, 32, 40, 48, 56, 1, 9, 17, 25, 33, 41, 49, 57,
+	2, 10, 18, 26, 34, 42, 50, 58, 3, 11, 19, 27, 35, 43, 51, 59,
+	4, 12, 20, 28, 36, 44, 52, 60, 5, 13, 21, 29, 37, 45, 53, 61,
+	6, 14, 22, 30, 38, 46, 54, 62, 7, 15, 23, 31, 39, 47, 55, 63
+};
+
+/* Interleave the first 32 bytes of 2 planes */
+alignas(64) static const uint8_t unshuffle2_lo[64] = {
+	0, 64, 1, 65, 2, 66, 3, 67, 4, 68, 5, 69, 6, 70, 7, 71,
+	8, 72, 9, 73, 10, 74, 11, 75, 12, 76, 13, 77, 14, 78, 15, 79,
+	16, 80, 17, 81, 18, 82, 19, 83, 20, 84, 21, 85, 22, 86, 23, 87,
+	24, 88, 25, 89, 26, 90, 27, 91, 28, 92, 29, 93, 30, 94, 31, 95
+};
+
+/* Interleave the last 32 bytes of 2 planes */
+alignas(64) static const uint8_t unshuffle2_hi[64] = {
+	32, 96, 33, 97, 34, 98, 35, 99, 36, 100, 37, 101, 38, 102, 39, 103,
+	40, 104, 41, 105, 42, 106, 43, 107, 44, 108, 45, 109, 46, 110, 47, 111,
+	48, 112, 49, 113, 50, 114, 51, 115, 52, 116, 53, 117, 54, 118, 55, 119,
+	56, 120, 57, 121, 58, 122, 59, 123, 60, 124, 61, 125, 62, 126, 63, 127
+};
+
+/* Inverse of shuffle4_idx */
+alignas(64) static const uint8_t unshuffle4_idx[64] = {
+	0, 16, 32, 48, 1, 17, 33, 49, 2, 18, 34, 50, 3, 19, 35, 51,
+	4, 20, 36, 52, 5, 21, 37, 53, 6, 22, 38, 54, 7, 23, 39, 55,
+	8, 24, 40, 56, 9, 25, 41, 57, 10, 26, 42, 58, 11, 27, 43, 59,
+	12, 28, 44, 60, 13, 29, 45, 61, 14, 30, 46, 62, 15, 31, 47, 63
+};
+
+/* Inverse of shuffle8_idx */
+alignas(64) static const uint8_t unshuffle8_idx[64] = {
+	0, 8, 16, 24, 32, 40, 48, 56, 1, 9, 17, 25, 33, 41, 49, 57,
+	2, 10, 18, 26, 34, 42, 50, 58, 3, 11, 19, 27, 35, 43, 51, 59,
+	4, 12, 20, 28, 36, 44, 52, 60, 5, 13, 21, 29, 37, 45, 53, 61,
+	6, 14, 22, 30, 38, 46, 54, 62, 7, 15, 23, 31, 39, 47, 55, 63
+};
+
+/* Transpose 4x4 128-bit lanes */
+static STENOS_ALWAYS_INLINE void transpose_4x128(__m512i* r)
+{
+	const __m512i t0 = shuffle_i64x2(r[0], r[1], _MM_SHUFFLE(2, 0, 2, 0));
+	const __m512i t1 = shuffle_i64x2(r[0], r[1], _MM_SHUFFLE(3, 1, 3, 1));
+	const __m512i t2 = shuffle_i64x2(r[2], r[3], _MM_SHUFFLE(2, 0, 2, 0));
+	const __m512i t3 = shuffle_i64x2(r[2], r[3], _MM_SHUFFLE(3, 1, 3, 1));
+	r[0] = shuffle_i64x2(t0, t2, _MM_SHUFFLE(2, 0, 2, 0));
+	r[1] = shuffle_i64x2(t1, t3, _MM_SHUFFLE(2, 0, 2, 0));
+	r[2] = shuffle_i64x2(t0, t2, _MM_SHUFFLE(3, 1, 3, 1));
+	r[3] = shuffle_i64x2(t1, t3, _MM_SHUFFLE(3, 1, 3, 1));
+}
+
+/* Transpose 8x8 64-bit words */
+static STENOS_ALWAYS_INLINE void transpose_8x64(__m512i* r)
+{
+	const __m512i lo1 = _mm512_setr_epi64(0, 8, 2, 10, 4, 12, 6, 14);
+	const __m512i hi1 = _mm512_setr_epi64(1, 9, 3, 11, 5, 13, 7, 15);
+	const __m512i lo2 = _mm512_setr_epi64(0, 1, 8, 9, 4, 5, 12, 13);
+	const __m512i hi2 = _mm512_setr_epi64(2, 3, 10, 11, 6, 7, 14, 15);
+	const __m512i lo4 = _mm512_setr_epi64(0, 1, 2, 3, 8, 9, 10, 11);
+	const __m512i hi4 = _mm512_setr_epi64(4, 5, 6, 7, 12, 13, 14, 15);
+
+	for (int i = 0; i < 8; i += 2) {
+		const __m512i a = r[i], b = r[i + 1];
+		r[i] = _mm512_permutex2var_epi64(a, lo1, b);
+		r[i + 1] = _mm512_permutex2var_epi64(a, hi1, b);
+	}
+	for (int i = 0; i < 8; i += 4) {
+		for (int j = i; j < i + 2; ++j) {
+			const __m512i a = r[j], b = r[j + 2];
+			r[j] = _mm512_permutex2var_epi64(a, lo2, b);
+			r[j + 2] = _mm512_permutex2var_epi64(a, hi2, b);
+		}
+	}
+	for (int j = 0; j < 4; ++j) {
+		const __m512i a = r[j], b = r[j + 4];
+		r[j] = _mm512_permutex2var_epi64(a, lo4, b);
+		r[j + 4] = _mm512_permutex2var_epi64(a, hi4, b);
+	}
+}
+
+/* Routine optimized for shuffling a buffer for a type size of 2 bytes. */
+static void shuffle2_avx512(uint8_t* const dest, const uint8_t* const src, const int32_t vectorizable_elements, const int32_t total_elements)
+{
+	const __m512i idx = _mm512_load_si512((const void*)shuffle2_idx);
+
+	for (int32_t i = 0; i < vectorizable_elements; i += 64) {
+		/* Gather bytes 0 and 1 of 64 elements (128 bytes) */
+		const __m512i a = _mm512_loadu_si512((const void*)(src + i * 2));
+		const __m512i b = _mm512_loadu_si512((const void*)(src + i * 2 + 64));
+		const __m512i pa = permutexvar_epi8(idx, a);
+		const __m512i pb = permutexvar_epi8(idx, b);
+		_mm512_storeu_si512((void*)(dest + i), shuffle_i64x2(pa, pb, _MM_SHUFFLE(1, 0, 1, 0)));
+		_mm512_storeu_si512((void*)(dest + total_elements + i), shuffle_i64x2(pa, pb, _MM_SHUFFLE(3, 2, 3, 2)));
+	}
+}
+
+/* Routine optimized for shuffling a buffer for a type size of 4 bytes. */
+static void shuffle4_avx512(uint8_t* const dest, const uint8_t* const src, const int32_t vectorizable_elements, const int32_t total_elements)
+{
+	const __m512i idx = _mm512_load_si512((const void*)shuffle4_idx);
+	__m512i r[4];
+	for (int32_t i = 0; i < vectorizable_elements; i += 64) {
+		/* Group bytes per lane for 4 x 16 elements, then transpose lanes */
+		for (int j = 0; j < 4; ++j)
+			r[j] = permutexvar_epi8(idx, _mm512_loadu_si512((const void*)(src + i * 4 + j * 64)));
+		transpose_4x128(r);
+		for (int k = 0; k < 4; ++k)
+			_mm512_storeu_si512((void*)(dest + k * total_elements + i), r[k]);
+	}
+}
+
+/* Routine optimized for shuffling a buffer for a type size of 8 bytes. */
+static void shuffle8_avx512(uint8_t* const dest, const uint8_t* const src, const int32_t vectorizable_elements, const int32_t total_elements)
+{
+	const __m512i idx = _mm512_load_si512((const void*)shuffle8_idx);
+	__m512i r[8];
+	for (int32_t i = 0; i < vectorizable_elements; i += 64) {
+		/* Group bytes per qword for 8 x 8 elements, then transpose qwords */
+		for (int j = 0; j < 8; ++j)
+			r[j] = permutexvar_epi8(idx, _mm512_loadu_si512((const void*)(src + i * 8 + j * 64)));
+		transpose_8x64(r);
+		for (int k = 0; k < 8; ++k)
+			_mm512_storeu_si512((void*)(dest + k * total_elements + i), r[k]);
+	}
+}
+
+/* Routine optimized for unshuffling a buffer for a type size of 2 bytes. */
+static void unshuffle2_avx512(uint8_t* const dest, const uint8_t* const src, const int32_t vectorizable_elements, const int32_t total_elements)
+{
+	const __m512i lo = _mm512_load_si512((const void*)unshuffle2_lo);
+	const __m512i hi = _mm512_load_si512((const void*)unshuffle2_hi);
+
+	for (int32_t i = 0; i < vectorizable_elements; i += 64) {
+		/* Interleave bytes 0 and 1 of 64 elements (128 bytes) */
+		const __m512i a = _mm512_loadu_si512((const void*)(src + i));
+		const __m512i b = _mm512_loadu_si512((const void*)(src + total_elements + i));
+		_mm512_storeu_si512((void*)(dest + i * 2), _mm512_permutex2var_epi8(a, lo, b));
+		_mm512_storeu_si512((void*)(dest + i * 2 + 64), _mm512_permutex2var_epi8(a, hi, b));
+	}
+}
+
+/* Routine optimized for unshuffling a buffer for a type size of 4 bytes. */
+static void unshuffle4_avx512(uint8_t* const dest, const uint8_t* const src, const int32_t vectorizable_elements, const int32_t total_elements)
+{
+	const __m512i idx = _mm512_load_si512((const void*)unshuffle4_idx);
+	__m512i r[4];
+	for (int32_t i = 0; i < vectorizable_elements; i += 64) {
+		/* Transpose lanes of 4 x 64 bytes, then interleave bytes within each register */
+		for (int k = 0; k < 4; ++k)
+			r[k] = _mm512_loadu_si512((const void*)(src + k * total_elements + i));
+		transpose_4x128(r);
+		for (int j = 0; j < 4; ++j)
+			_mm512_storeu_si512((void*)(dest + i * 4 + j * 64), permutexvar_epi8(idx, r[j]));
+	}
+}
+
+/* Routine optimized for unshuffling a buffer for a type size of 8 bytes. */
+static void unshuffle8_avx512(uint8_t* const dest, const uint8_t* const src, const int32_t vectorizable_elements, const int32_t total_elements)
+{
+	const __m512i idx = _mm512_load_si512((const void*)unshuffle8_idx);
+	__m512i r[8];
+	for (int32_t i = 0; i < vectorizable_elements; i += 64) {
+		/* Transpose qwords of 8 x 64 bytes, then interleave bytes within each register */
+		for (int k = 0; k < 8; ++k)
+			r[k] = _mm512_loadu_si512((const void*)(src + k * total_elements + i));
+		transpose_8x64(r);
+		for (int j = 0; j < 8; ++j)
+			_mm512_storeu_si512((void*)(dest + i * 8 + j * 64), permutexvar_epi8(idx, r[j]));
+	}
+}
+
+/* Shuffle a block.  This can never fail. */
+void shuffle_avx512(int32_t bytesoftype, int32_t blocksize, const uint8_t* _src, uint8_t* _dest)
+{
+	/* Large shuffles are bound by the scattered 64 bytes stores and run faster with AVX2.
+	   The block codec only shuffles blocks of 256 elements. */
+	if ((bytesoftype != 2 && bytesoftype != 4 && bytesoftype != 8) || blocksize > 16384) {
+		shuffle_avx2(bytesoftype, blocksize, _src, _dest);
+		return;
+	}
+
+	/* 64 elements are processed per iteration */
+	const int32_t vectorized_chunk_size = bytesoftype * (int32_t)sizeof(__m512i);
+	if (blocksize < vectorized_chunk_size) {
+		shuffle_avx2(bytesoftype, blocksize, _src, _dest);
+		return;
+	}
+
+	const int32_t vectorizable_bytes = blocksize - (blocksize % vectorized_chunk_size);
+	const int32_t vectorizable_elements = vectorizable_bytes / bytesoftype;
+	const int32_t total_elements = blocksize / bytesoftype;
+
+	switch (bytesoftype) {
+		case 2:
+			shuffle2_avx512(_dest, _src, vectorizable_elements, total_elements);
+			break;
+		case 4:
+			shuffle4_avx512(_dest, _src, vectorizable_elements, total_elements);
+			break;
+		default:
+			shuffle8_avx512(_dest, _src, vectorizable_elements, total_elements);
+			break;
+	}
+
+	if (vectorizable_bytes < blocksize) {
+		shuffle_generic_inline(bytesoftype, vectorizable_bytes, blocksize, _src, _dest);
+	}
+}
+
+/* Unshuffle a block.  This can never fail. */
+void unshuffle_avx512(int32_t bytesoftype, int32_t blocksize, const uint8_t* _src, uint8_t* _dest)
+{
+	if (bytesoftype != 2 && bytesoftype != 4 && bytesoftype != 8) {
+		unshuffle_avx2(bytesoftype, blocksize, _src, _dest);
+		return;
+	}
+
+	const int32_t vectorized_chunk_size = bytesoftype * (int32_t)sizeof(__m512i);
+	if (blocksize < vectorized_chunk_size) {
+		unshuffle_avx2(bytesoftype, blocksize, _src, _dest);
+		return;
+	}
+
+	const int32_t vectorizable_bytes = blocksize - (blocksize % vectorized_chunk_size);
+	const int32_t vectorizable_elements = vectorizable_bytes / bytesoftype;
+	const int32_t total_elements = blocksize / bytesoftype;
+
+	switch (bytesoftype) {
+		case 2:
+			unshuffle2_avx512(_dest, _src, vectorizable_elements, total_elements);
+			break;
+		case 4:
+			unshuffle4_avx512(_dest, _src, vectorizable_elements, total_elements);
+			break;
+		default:
+			unshuffle8_avx512(_dest, _src, vectorizable_elements, total_elements);
+			break;
+	}
+
+	if (vectorizable_bytes < blocksize) {
+		unshuffle_generic_inline(bytesoftype, vectorizable_bytes, blocksize, _src, _dest);
+	}
+}
+
+#undef permutexvar_epi8
+#undef shuffle_i64x2
+
+#else /* defined(__AVX512BW__) && defined(__AVX512VBMI__) */
+
+void shuffle_avx512(const int32_t, const int32_t, const uint8_t*, uint8_t*)
+{
+	abort();
+}
+
+void unshuffle_avx512(const int32_t, const int32_t, const uint8_t*, uint8_t*)
+{
+	abort();
+}
+
+#endif /* defined(__AVX512BW__) && defined(__AVX512VBMI__) */
@@ -0,0 +1,194 @@
+/**
+ * MIT License
+ *
+ * Copyright (c) 2025 Victor Moncada <vtr.moncada@gmail.com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include "shuffle-neon.h"
+#include "shuffle-generic.h"
+#include "simd.h"
+
+#include <cstdlib>
+
+/* Make sure NEON is available for the compilation target and compiler. */
+#if defined(STENOS_HAS_NEON)
+
+/* Routine optimized for shuffling a buffer for a type size of 2 bytes. */
+static void shuffle2_neon(uint8_t* const dest, const uint8_t* const src, const int32_t vectorizable_elements, const int32_t total_elements)
+{
+	for (int32_t i = 0; i < vectorizable_elements; i += 16) {
+		/* Load and deinterleave 16 elements (32 bytes) */
+		uint8x16x2_t v = vld2q_u8(src + i * 2);
+		vst1q_u8(dest + i, v.val[0]);
+		vst1q_u8(dest + total_elements + i, v.val[1]);
+	}
+}
+
+/* Routine optimized for shuffling a buffer for a type size of 4 bytes. */
+static void shuffle4_neon(uint8_t* const dest, const uint8_t* const src, const int32_t vectorizable_elements, const int32_t total_elements)
+{
+	for (int32_t i = 0; i < vectorizable_elements; i += 16) {
+		/* Load and deinterleave 16 elements (64 bytes) */
+		uint8x16x4_t v = vld4q_u8(src + i * 4);
+		for (int k = 0; k < 4; ++k)
+			vst1q_u8(dest + k * total_elements + i, v.val[k]);
+	}
+}
+
+/* Routine optimized for shuffling a buffer for a type size of 8 bytes. */
+static void shuffle8_neon(uint8_t* const dest, const uint8_t* const src, const int32_t vectorizable_elements, const int32_t total_elements)
+{
+	for (int32_t i = 0; i < vectorizable_elements; i += 16) {
+		/* Load 16 elements (128 bytes). Lane m of a.val[k] holds byte k + 4 * (m & 1) of element m / 2. */
+		uint8x16x4_t a = vld4q_u8(src + i * 8);
+		uint8x16x4_t b = vld4q_u8(src + i * 8 + 64);
+		for (int k = 0; k < 4; ++k) {
+			/* Separate bytes k and k + 4 */
+			uint8x16x2_t v = vuzpq_u8(a.val[k], b.val[k]);
+			vst1q_u8(dest + k * total_elements + i, v.val[0]);
+			vst1q_u8(dest + (k + 4) * total_elements + i, v.val[1]);
+		}
+	}
+}
+
+/* Routine optimized for unshuffling a buffer for a type size of 2 bytes. */
+static void unshuffle2_neon(uint8_t* const dest, const uint8_t* const src, const int32_t vectorizable_elements, const int32_t total_elements)
+{
+	for (int32_t i = 0; i < vectorizable_elements; i += 16) {
+		/* Interleave and store 16 elements (32 bytes) */
+		uint8x16x2_t v;
+		v.val[0] = vld1q_u8(src + i);
+		v.val[1] = vld1q_u8(src + total_elements + i);
+		vst2q_u8(dest + i * 2, v);
+	}
+}
+
+/* Routine optimized for unshuffling a buffer for a type size of 4 bytes. */
+static void unshuffle4_neon(uint8_t* const dest, const uint8_t* const src, const int32_t vectorizable_elements, const int32_t total_elements)
+{
+	for (int32_t i = 0; i < vectorizable_elements; i += 16) {
+		/* Interleave and store 16 elements (64 bytes) */
+		uint8x16x4_t v;
+		for (int k = 0; k < 4; ++k)
+			v.val[k] = vld1q_u8(src + k * total_elements + i);
+		vst4q_u8(dest + i * 4, v);
+	}
+}
+
+/* Routine optimized for unshuffling a buffer for a type size of 8 bytes. */
+static void unshuffle8_neon(uint8_t* const dest, const uint8_t* const src, const int32_t vectorizable_elements, const int32_t total_elements)
+{
+	for (int32_t i = 0; i < vectorizable_elements; i += 16) {
+		/* Interleave bytes k and k + 4, then store 16 elements (128 bytes) */
+		uint8x16x4_t a, b;
+		for (int k = 0; k < 4; ++k) {
+			uint8x16x2_t v = vzipq_u8(vld1q_u8(src + k * total_elements + i), vld1q_u8(src + (k + 4) * total_elements + i));
+			a.val[k] = v.val[0];
+			b.val[k] = v.val[1];
+		}
+		vst4q_u8(dest + i * 8, a);
+		vst4q_u8(dest + i * 8 + 64, b);
+	}
+}
+
+/* Shuffle a block.  This can never fail. */
+void shuffle_neon(int32_t bytesoftype, int32_t blocksize, const uint8_t* _src, uint8_t* _dest)
+{
+	const int32_t vectorized_chunk_size = bytesoftype * 16;
+	/* Round the blocksize down to a multiple of both the typesize and
+	   the vector size. The remaining bytes use the generic implementation. */
+	const int32_t vectorizable_bytes = blocksize - (blocksize % vectorized_chunk_size);
+	const int32_t vectorizable_elements = vectorizable_bytes / bytesoftype;
+	const int32_t total_elements = blocksize / bytesoftype;
+
+	if (blocksize < vectorized_chunk_size) {
+		shuffle_generic(bytesoftype, blocksize, _src, _dest);
+		return;
+	}
+
+	switch (bytesoftype) {
+		case 2:
+			shuffle2_neon(_dest, _src, vectorizable_elements, total_elements);
+			break;
+		case 4:
+			shuffle4_neon(_dest, _src, vectorizable_elements, total_elements);
+			break;
+		case 8:
+			shuffle8_neon(_dest, _src, vectorizable_elements, total_elements);
+			break;
+		default:
+			/* Non-optimized shuffle */
+			shuffle_generic(bytesoftype, blocksize, _src, _dest);
+			return;
+	}
+
+	if (vectorizable_bytes < blocksize) {
+		shuffle_generic_inline(bytesoftype, vectorizable_bytes, blocksize, _src, _dest);
+	}
+}
+
+/* Unshuffle a block.  This can never fail. */
+void unshuffle_neon(int32_t bytesoftype, int32_t blocksize, const uint8_t* _src, uint8_t* _dest)
+{
+	const int32_t vectorized_chunk_size = bytesoftype * 16;
+	const int32_t vectorizable_bytes = blocksize - (blocksize % vectorized_chunk_size);
+	const int32_t vectorizable_elements = vectorizable_bytes / bytesoftype;
+	const int32_t total_elements = blocksize / bytesoftype;
+
+	if (blocksize < vectorized_chunk_size) {
+		unshuffle_generic(bytesoftype, blocksize, _src, _dest);
+		return;
+	}
+
+	switch (bytesoftype) {
+		case 2:
+			unshuffle2_neon(_dest, _src, vectorizable_elements, total_elements);
+			break;
+		case 4:
+			unshuffle4_neon(_dest, _src, vectorizable_elements, total_elements);
+			break;
+		case 8:
+			unshuffle8_neon(_dest, _src, vectorizable_elements, total_elements);
+			break;
+		default:
+			/* Non-optimized unshuffle */
+			unshuffle_generic(bytesoftype, blocksize, _src, _dest);
+			return;
+	}
+
+	if (vectorizable_bytes < blocksize) {
+		unshuffle_generic_inline(bytesoftype, vectorizable_bytes, blocksize, _src, _dest);
+	}
+}
+
+#else /* defined(STENOS_HAS_NEON) */
+
+void shuffle_neon(const int32_t, const int32_t, const uint8_t*, uint8_t*)
+{
+	abort();
+}
+
+void unshuffle_neon(const int32_t, const int32_t, const uint8_t*, uint8_t*)
+{
+	abort();
+}
+
+#endif /* defined(STENOS_HAS_NEON) */
@@ -0,0 +1,42 @@
+/**
+ * MIT License
+ *
+ * Copyright (c) 2025 Victor Moncada <vtr.moncada@gmail.com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+/* NEON-accelerated shuffle/unshuffle routines (AArch64). */
+
+#ifndef STENOS_SHUFFLE_NEON_H
+#define STENOS_SHUFFLE_NEON_H
+
+#include <cstdint>
+
+/**
+  NEON-accelerated shuffle routine.
+*/
+void shuffle_neon(int32_t bytesoftype, int32_t blocksize, const uint8_t* _src, uint8_t* _dest);
+
+/**
+  NEON-accelerated unshuffle routine.
+*/
+void unshuffle_neon(int32_t bytesoftype, int32_t blocksize, const uint8_t* _src, uint8_t* _dest);
+
+#endif /* STENOS_SHUFFLE_NEON_H */
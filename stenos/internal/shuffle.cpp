@@ -19,10 +19,18 @@
 #include "shuffle-avx2.h"
 #endif /* defined(__AVX2__) */
 
+#if defined(__AVX512BW__) && defined(__AVX512VBMI__) && defined(__AVX2__)
+#include "shuffle-avx512.h"
+#endif /* defined(__AVX512BW__) && defined(__AVX512VBMI__) */
+
 #if defined(__SSE2__)
 #include "shuffle-sse2.h"
 #endif /* defined(__SSE2__) */
 
+#if defined(STENOS_HAS_NEON)
+#include "shuffle-neon.h"
+#endif /* defined(STENOS_HAS_NEON) */
+
 namespace stenos
 {
 
@@ -45,6 +53,16 @@ namespace stenos
 	{
 		shuffle_implementation_t impl_generic;
 
+#if defined(__AVX512BW__) && defined(__AVX512VBMI__) && defined(__AVX2__)
+		if (stenos::cpu_features().HAS_AVX512BW && stenos::cpu_features().HAS_AVX512VBMI && stenos::cpu_features().HAS_AVX2) {
+			shuffle_implementation_t impl_avx512;
+			impl_avx512.name = "avx512";
+			impl_avx512.shuffle = (shuffle_func)shuffle_avx512;
+			impl_avx512.unshuffle = (unshuffle_func)unshuffle_avx512;
+			return impl_avx512;
+		}
+#endif /* defined(__AVX512BW__) && defined(__AVX512VBMI__) */
+
 #if defined(__AVX2__)
 		if (stenos::cpu_features().HAS_AVX2) {
 			shuffle_implementation_t impl_avx2;
@@ -65,6 +83,16 @@ namespace stenos
 		}
 #endif /* defined(__SSE2__) */
 
+#if defined(STENOS_HAS_NEON)
+		if (stenos::cpu_features().HAS_NEON) {
+			shuffle_implementation_t impl_neon;
+			impl_neon.name = "neon";
+			impl_neon.shuffle = (shuffle_func)shuffle_neon;
+			impl_neon.unshuffle = (unshuffle_func)unshuffle_neon;
+			return impl_neon;
+		}
+#endif /* defined(STENOS_HAS_NEON) */
+
 		/*  Processor doesn't support any of the hardware-accelerated implementations,
 		    so use the generic implementation. */
 		impl_generic.name = "generic";
@@ -32,7 +32,7 @@
 
 #else
 
-#if defined(_M_ARM64) || defined(__arm__) || defined(__ARM_NEON__)
+#if defined(__aarch64__) || defined(_M_ARM64) || defined(__arm__) || defined(__ARM_NEON) || defined(__ARM_NEON__)
 inline void cpuid(int info[4], int InfoType)
 {
 	info[0] = info[1] = info[2] = info[3] = 0;
@@ -49,6 +49,27 @@ inline void cpuid(int info[4], int InfoType)
 
 #endif
 
+// Read the XCR0 register to check which register states are enabled by the OS
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+#include <immintrin.h>
+static inline unsigned long long read_xcr0()
+{
+	return _xgetbv(0);
+}
+#elif defined(__x86_64__) || defined(__i386__)
+static inline unsigned long long read_xcr0()
+{
+	unsigned eax, edx;
+	__asm__ __volatile__("xgetbv" : "=a"(eax), "=d"(edx) : "c"(0));
+	return ((unsigned long long)edx << 32) | eax;
+}
+#else
+static inline unsigned long long read_xcr0()
+{
+	return 0;
+}
+#endif
+
 // Undef min and max defined in Windows.h
 #ifdef min
 #undef min
@@ -73,9 +94,14 @@ namespace stenos
 			cpuid(info, static_cast<int>(0x80000000));
 			unsigned nExIds = static_cast<unsigned>(info[0]);
 
+			bool os_avx512 = false;
+
 			//  Detect Features
 			if (nIds >= 0x00000001) {
 				cpuid(info, 0x00000001);
+				// OSXSAVE, then opmask and upper ZMM states enabled in XCR0
+				if ((info[2] & (1 << 27)) != 0)
+					os_avx512 = (read_xcr0() & 0xE6) == 0xE6;
 				features.HAS_MMX = (info[3] & (1 << 23)) != 0;
 				features.HAS_SSE = (info[3] & (1 << 25)) != 0;
 				features.HAS_SSE2 = (info[3] & (1 << 26)) != 0;
@@ -110,6 +136,13 @@ namespace stenos
 				features.HAS_AVX512DQ = (info[1] & (1 << 17)) != 0;
 				features.HAS_AVX512IFMA = (info[1] & (1 << 21)) != 0;
 				features.HAS_AVX512VBMI = (info[2] & (1 << 1)) != 0;
+
+				// AVX512 is unusable if the OS does not save ZMM registers
+				if (!os_avx512) {
+					features.HAS_AVX512F = features.HAS_AVX512CD = features.HAS_AVX512PF = features.HAS_AVX512ER = false;
+					features.HAS_AVX512VL = features.HAS_AVX512BW = features.HAS_AVX512DQ = false;
+					features.HAS_AVX512IFMA = features.HAS_AVX512VBMI = false;
+				}
 			}
 			if (nExIds >= 0x80000001) {
 				cpuid(info, static_cast<int>(0x80000001));
@@ -120,6 +153,11 @@ namespace stenos
 				features.HAS_XOP = (info[2] & (1 << 11)) != 0;
 			}
 
+#if defined(STENOS_HAS_NEON)
+			// Advanced SIMD is mandatory on AArch64
+			features.HAS_NEON = true;
+#endif
+
 			return features;
 		}
 	}
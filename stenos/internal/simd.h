@@ -191,6 +191,9 @@ extern "C" {
 }
 #endif
 
+// SSE emulation on AArch64 for the block codec
+#include "simd_neon.h"
+
 #include <cstdint>
 #include <cstdio>
 
@@ -236,6 +239,9 @@ namespace stenos
 		bool HAS_AVX512DQ;   //  AVX512 Doubleword + Quadword
 		bool HAS_AVX512IFMA; //  AVX512 Integer 52-bit Fused Multiply-Add
 		bool HAS_AVX512VBMI; //  AVX512 Vector Byte Manipulation Instructions
+
+		//  ARM
+		bool HAS_NEON; //  AArch64 Advanced SIMD
 	};
 
 }
@@ -269,6 +275,12 @@ namespace stenos
 			std::printf("Has AVX\n");
 		if (cpu_features().HAS_AVX2)
 			std::printf("Has AVX2\n");
+		if (cpu_features().HAS_AVX512BW)
+			std::printf("Has AVX512BW\n");
+		if (cpu_features().HAS_AVX512VBMI)
+			std::printf("Has AVX512VBMI\n");
+		if (cpu_features().HAS_NEON)
+			std::printf("Has NEON\n");
 	}
 
 }
@@ -0,0 +1,310 @@
+/**
+ * MIT License
+ *
+ * Copyright (c) 2025 Victor Moncada <vtr.moncada@gmail.com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef STENOS_SIMD_NEON_H
+#define STENOS_SIMD_NEON_H
+
+// Implementation of the SSE intrinsics used by the block codec on top of AArch64 NEON.
+// Each function is meant to return exactly the same bits as its SSE counterpart, so that
+// the block codec produces identical frames on x86 and ARM.
+// Only the subset of SSE used by block_compress.h is provided.
+// The port has not been validated on AArch64 hardware yet: it is only enabled
+// with STENOS_ENABLE_NEON (cmake option of the same name).
+
+#include "../bits.hpp"
+
+#if defined(STENOS_ENABLE_NEON) && defined(__aarch64__) && (defined(__ARM_NEON) || defined(__ARM_NEON__)) && !defined(__SSE2__)
+
+#include <arm_neon.h>
+
+#define STENOS_HAS_NEON 1
+
+typedef int64x2_t __m128i;
+typedef float32x4_t __m128;
+
+namespace stenos
+{
+	namespace neon
+	{
+		static STENOS_ALWAYS_INLINE uint8x16_t u8(__m128i a) noexcept { return vreinterpretq_u8_s64(a); }
+		static STENOS_ALWAYS_INLINE int8x16_t s8(__m128i a) noexcept { return vreinterpretq_s8_s64(a); }
+		static STENOS_ALWAYS_INLINE uint16x8_t u16(__m128i a) noexcept { return vreinterpretq_u16_s64(a); }
+		static STENOS_ALWAYS_INLINE int16x8_t s16(__m128i a) noexcept { return vreinterpretq_s16_s64(a); }
+		static STENOS_ALWAYS_INLINE uint32x4_t u32(__m128i a) noexcept { return vreinterpretq_u32_s64(a); }
+
+		static STENOS_ALWAYS_INLINE __m128i m128i(uint8x16_t a) noexcept { return vreinterpretq_s64_u8(a); }
+		static STENOS_ALWAYS_INLINE __m128i m128i(int8x16_t a) noexcept { return vreinterpretq_s64_s8(a); }
+		static STENOS_ALWAYS_INLINE __m128i m128i(uint16x8_t a) noexcept { return vreinterpretq_s64_u16(a); }
+		static STENOS_ALWAYS_INLINE __m128i m128i(int16x8_t a) noexcept { return vreinterpretq_s64_s16(a); }
+		static STENOS_ALWAYS_INLINE __m128i m128i(uint32x4_t a) noexcept { return vreinterpretq_s64_u32(a); }
+		static STENOS_ALWAYS_INLINE __m128i m128i(uint64x2_t a) noexcept { return vreinterpretq_s64_u64(a); }
+
+		template<int Imm>
+		static STENOS_ALWAYS_INLINE __m128i slli_si128(__m128i a) noexcept
+		{
+			// Shift bytes toward higher lanes
+			if (Imm <= 0)
+				return a;
+			if (Imm >= 16)
+				return vdupq_n_s64(0);
+			return m128i(vextq_u8(vdupq_n_u8(0), u8(a), (16 - Imm) & 15));
+		}
+
+		template<int Imm>
+		static STENOS_ALWAYS_INLINE __m128i srli_si128(__m128i a) noexcept
+		{
+			// Shift bytes toward lower lanes
+			if (Imm <= 0)
+				return a;
+			if (Imm >= 16)
+				return vdupq_n_s64(0);
+			return m128i(vextq_u8(u8(a), vdupq_n_u8(0), Imm & 15));
+		}
+
+		template<int Imm>
+		static STENOS_ALWAYS_INLINE int extract_epi16(__m128i a) noexcept
+		{
+			return (int)vgetq_lane_u16(u16(a), Imm & 7);
+		}
+
+		template<int Imm>
+		static STENOS_ALWAYS_INLINE __m128 shuffle_ps(__m128 a, __m128 b) noexcept
+		{
+			// Work on integer lanes to keep the exact bits
+			uint32x4_t x = vreinterpretq_u32_f32(a);
+			uint32x4_t y = vreinterpretq_u32_f32(b);
+			uint32x4_t r = vdupq_n_u32(vgetq_lane_u32(x, Imm & 3));
+			r = vsetq_lane_u32(vgetq_lane_u32(x, (Imm >> 2) & 3), r, 1);
+			r = vsetq_lane_u32(vgetq_lane_u32(y, (Imm >> 4) & 3), r, 2);
+			r = vsetq_lane_u32(vgetq_lane_u32(y, (Imm >> 6) & 3), r, 3);
+			return vreinterpretq_f32_u32(r);
+		}
+	}
+}
+
+// Load/store
+
+static STENOS_ALWAYS_INLINE __m128i _mm_loadu_si128(const __m128i* p) noexcept
+{
+	return stenos::neon::m128i(vld1q_u8((const uint8_t*)p));
+}
+static STENOS_ALWAYS_INLINE __m128i _mm_load_si128(const __m128i* p) noexcept
+{
+	return stenos::neon::m128i(vld1q_u8((const uint8_t*)p));
+}
+static STENOS_ALWAYS_INLINE void _mm_storeu_si128(__m128i* p, __m128i a) noexcept
+{
+	vst1q_u8((uint8_t*)p, stenos::neon::u8(a));
+}
+static STENOS_ALWAYS_INLINE void _mm_store_si128(__m128i* p, __m128i a) noexcept
+{
+	vst1q_u8((uint8_t*)p, stenos::neon::u8(a));
+}
+
+// Set
+
+static STENOS_ALWAYS_INLINE __m128i _mm_setzero_si128() noexcept
+{
+	return vdupq_n_s64(0);
+}
+static STENOS_ALWAYS_INLINE __m128i _mm_set1_epi8(char v) noexcept
+{
+	return stenos::neon::m128i(vdupq_n_s8((int8_t)v));
+}
+static STENOS_ALWAYS_INLINE __m128i _mm_set1_epi16(short v) noexcept
+{
+	return stenos::neon::m128i(vdupq_n_s16((int16_t)v));
+}
+static STENOS_ALWAYS_INLINE __m128i _mm_setr_epi8(char e0,
+						char e1,
+						char e2,
+						char e3,
+						char e4,
+						char e5,
+						char e6,
+						char e7,
+						char e8,
+						char e9,
+						char e10,
+						char e11,
+						char e12,
+						char e13,
+						char e14,
+						char e15) noexcept
+{
+	const int8_t d[16] = { (int8_t)e0, (int8_t)e1, (int8_t)e2,  (int8_t)e3,	 (int8_t)e4,  (int8_t)e5,  (int8_t)e6,	(int8_t)e7,
+			       (int8_t)e8, (int8_t)e9, (int8_t)e10, (int8_t)e11, (int8_t)e12, (int8_t)e13, (int8_t)e14, (int8_t)e15 };
+	return stenos::neon::m128i(vld1q_s8(d));
+}
+static STENOS_ALWAYS_INLINE __m128i _mm_set_epi8(char e15,
+					       char e14,
+					       char e13,
+					       char e12,
+					       char e11,
+					       char e10,
+					       char e9,
+					       char e8,
+					       char e7,
+					       char e6,
+					       char e5,
+					       char e4,
+					       char e3,
+					       char e2,
+					       char e1,
+					       char e0) noexcept
+{
+	return _mm_setr_epi8(e0, e1, e2, e3, e4, e5, e6, e7, e8, e9, e10, e11, e12, e13, e14, e15);
+}
+static STENOS_ALWAYS_INLINE __m128i _mm_set_epi64x(long long e1, long long e0) noexcept
+{
+	const int64_t d[2] = { (int64_t)e0, (int64_t)e1 };
+	return vld1q_s64(d);
+}
+
+// Casts
+
+static STENOS_ALWAYS_INLINE __m128 _mm_castsi128_ps(__m128i a) noexcept
+{
+	return vreinterpretq_f32_s64(a);
+}
+static STENOS_ALWAYS_INLINE __m128i _mm_castps_si128(__m128 a) noexcept
+{
+	return vreinterpretq_s64_f32(a);
+}
+
+// Logical
+
+static STENOS_ALWAYS_INLINE __m128i _mm_and_si128(__m128i a, __m128i b) noexcept
+{
+	return vandq_s64(a, b);
+}
+static STENOS_ALWAYS_INLINE __m128i _mm_or_si128(__m128i a, __m128i b) noexcept
+{
+	return vorrq_s64(a, b);
+}
+static STENOS_ALWAYS_INLINE __m128i _mm_andnot_si128(__m128i a, __m128i b) noexcept
+{
+	// (~a) & b
+	return vbicq_s64(b, a);
+}
+
+// Arithmetic
+
+static STENOS_ALWAYS_INLINE __m128i _mm_add_epi8(__m128i a, __m128i b) noexcept
+{
+	using namespace stenos::neon;
+	return m128i(vaddq_u8(u8(a), u8(b)));
+}
+static STENOS_ALWAYS_INLINE __m128i _mm_sub_epi8(__m128i a, __m128i b) noexcept
+{
+	using namespace stenos::neon;
+	return m128i(vsubq_u8(u8(a), u8(b)));
+}
+static STENOS_ALWAYS_INLINE __m128i _mm_mullo_epi16(__m128i a, __m128i b) noexcept
+{
+	using namespace stenos::neon;
+	return m128i(vmulq_s16(s16(a), s16(b)));
+}
+static STENOS_ALWAYS_INLINE __m128i _mm_min_epi8(__m128i a, __m128i b) noexcept
+{
+	using namespace stenos::neon;
+	return m128i(vminq_s8(s8(a), s8(b)));
+}
+static STENOS_ALWAYS_INLINE __m128i _mm_max_epi8(__m128i a, __m128i b) noexcept
+{
+	using namespace stenos::neon;
+	return m128i(vmaxq_s8(s8(a), s8(b)));
+}
+static STENOS_ALWAYS_INLINE __m128i _mm_min_epu8(__m128i a, __m128i b) noexcept
+{
+	using namespace stenos::neon;
+	return m128i(vminq_u8(u8(a), u8(b)));
+}
+static STENOS_ALWAYS_INLINE __m128i _mm_sad_epu8(__m128i a, __m128i b) noexcept
+{
+	// Sum of absolute differences of each 8 bytes half, stored in the low 16 bits of each 64 bits lane
+	using namespace stenos::neon;
+	return m128i(vpaddlq_u32(vpaddlq_u16(vpaddlq_u8(vabdq_u8(u8(a), u8(b))))));
+}
+
+// Comparison
+
+static STENOS_ALWAYS_INLINE __m128i _mm_cmpeq_epi8(__m128i a, __m128i b) noexcept
+{
+	using namespace stenos::neon;
+	return m128i(vceqq_u8(u8(a), u8(b)));
+}
+static STENOS_ALWAYS_INLINE __m128i _mm_cmpeq_epi32(__m128i a, __m128i b) noexcept
+{
+	using namespace stenos::neon;
+	return m128i(vceqq_u32(u32(a), u32(b)));
+}
+static STENOS_ALWAYS_INLINE __m128i _mm_cmplt_epi8(__m128i a, __m128i b) noexcept
+{
+	using namespace stenos::neon;
+	return m128i(vcltq_s8(s8(a), s8(b)));
+}
+static STENOS_ALWAYS_INLINE int _mm_movemask_epi8(__m128i a) noexcept
+{
+	// Gather the most significant bit of each byte
+	using namespace stenos::neon;
+	uint16x8_t high_bits = vreinterpretq_u16_u8(vshrq_n_u8(u8(a), 7));
+	uint32x4_t paired16 = vreinterpretq_u32_u16(vsraq_n_u16(high_bits, high_bits, 7));
+	uint64x2_t paired32 = vreinterpretq_u64_u32(vsraq_n_u32(paired16, paired16, 14));
+	uint8x16_t paired64 = vreinterpretq_u8_u64(vsraq_n_u64(paired32, paired32, 28));
+	return (int)vgetq_lane_u8(paired64, 0) | ((int)vgetq_lane_u8(paired64, 8) << 8);
+}
+
+// Shifts
+
+static STENOS_ALWAYS_INLINE __m128i _mm_srli_epi16(__m128i a, int count) noexcept
+{
+	// Shifts of 16 or more give 0, like SSE
+	using namespace stenos::neon;
+	return m128i(vshlq_u16(u16(a), vdupq_n_s16((int16_t)-count)));
+}
+static STENOS_ALWAYS_INLINE __m128i _mm_slli_epi16(__m128i a, int count) noexcept
+{
+	using namespace stenos::neon;
+	return m128i(vshlq_u16(u16(a), vdupq_n_s16((int16_t)count)));
+}
+
+#define _mm_slli_si128(a, imm) stenos::neon::slli_si128<(imm)>(a)
+#define _mm_srli_si128(a, imm) stenos::neon::srli_si128<(imm)>(a)
+#define _mm_extract_epi16(a, imm) stenos::neon::extract_epi16<(imm)>(a)
+#define _mm_shuffle_ps(a, b, imm) stenos::neon::shuffle_ps<(imm)>(a, b)
+
+// Shuffle
+
+static STENOS_ALWAYS_INLINE __m128i _mm_shuffle_epi8(__m128i a, __m128i b) noexcept
+{
+	// Indices with the most significant bit set select 0, like SSSE3.
+	// Masking with 0x8F keeps such indices out of the table range.
+	using namespace stenos::neon;
+	return m128i(vqtbl1q_u8(u8(a), vandq_u8(u8(b), vdupq_n_u8(0x8F))));
+}
+
+#endif
+
+#endif
@@ -30,16 +30,56 @@
 #include "block_compress.h"
 #include "zstd_wrapper.h"
 #include "delta.h"
-
-#define STENOS_FRAME_HEADER_BLOCK (1)		      // Bytes compressed with block encoder only
-#define STENOS_FRAME_HEADER_ZSTD (2)		      // Bytes compressed with zstd only
-#define STENOS_FRAME_HEADER_TRANSPOSED_ZSTD (3)	      // Bytes compressed with zstd on transposed input
-#define STENOS_FRAME_HEADER_TRANSPOSED_DELTA_ZSTD (4) // Bytes compressed with zstd on transposed + delta input
-#define STENOS_FRAME_HEADER_BLOCK_ZSTD (5)	      // Bytes compressed with blocks + zstd
-#define STENOS_FRAME_HEADER_COPY (6)		      // Bytes memcopied
+#include "checksum.h"
+#include "reduce.h"
+
+#include <zdict.h>
+
+#include <cmath>
+#include <algorithm>
+#include <memory>
+
+#define STENOS_FRAME_HEADER_BLOCK (STENOS_MODE_BLOCK)				  // Bytes compressed with block encoder only
+#define STENOS_FRAME_HEADER_ZSTD (STENOS_MODE_ZSTD)				  // Bytes compressed with zstd only
+#define STENOS_FRAME_HEADER_TRANSPOSED_ZSTD (STENOS_MODE_TRANSPOSED_ZSTD)	  // Bytes compressed with zstd on transposed input
+#define STENOS_FRAME_HEADER_TRANSPOSED_DELTA_ZSTD (STENOS_MODE_TRANSPOSED_DELTA_ZSTD) // Bytes compressed with zstd on transposed + delta input
+#define STENOS_FRAME_HEADER_BLOCK_ZSTD (STENOS_MODE_BLOCK_ZSTD)			  // Bytes compressed with blocks + zstd
+#define STENOS_FRAME_HEADER_COPY (STENOS_MODE_COPY)				  // Bytes memcopied
+#define STENOS_FRAME_HEADER_XOR_ZSTD (STENOS_MODE_XOR_ZSTD)			  // Bytes compressed with zstd on transposed + XOR + bit transposed input
+#define STENOS_FRAME_HEADER_INT_DELTA_ZSTD (STENOS_MODE_INT_DELTA_ZSTD)		  // Bytes compressed with zstd on element-wise delta + transposed input
+#define STENOS_FRAME_HEADER_INT_DELTA2_ZSTD (STENOS_MODE_INT_DELTA2_ZSTD)	  // Bytes compressed with zstd on element-wise delta of delta + transposed input
+#define STENOS_FRAME_HEADER_FIELDS (STENOS_MODE_FIELDS)				  // Fields de-interleaved and compressed as separate superblocks
+
+#define STENOS_FRAME_SHIFT_MASK (0x07)	  // Superblock shift bits of the frame first byte
+#define STENOS_FRAME_SHIFT_CUSTOM (7)	  // Custom superblock size (stored after the decompressed size)
+#define STENOS_FRAME_FLAG_INDEX (0x08)	  // The frame ends with a superblock index
+#define STENOS_FRAME_FLAG_CHECKSUM (0x10) // Each superblock is followed by the CRC32C of its compressed bytes
+#define STENOS_FRAME_FLAG_DICT (0x20)	  // The frame was compressed with a dictionary (ID stored in the header)
+#define STENOS_FRAME_FLAGS_MASK (0x78)	  // All frame flags
+#define STENOS_FRAME_FLAGS_KNOWN (0x38)	  // Frame flags supported by this version
+#define STENOS_FRAME_LEGACY_CUSTOM (255) // Custom superblock size without flags
+
+#define STENOS_RATE_MODEL_MAGIC (0x4d525453u) // "STRM", exported rate model
 
 namespace stenos
 {
+	/// @brief Scratch buffer allocator, see stenos_set_allocator()
+	struct Allocator
+	{
+		stenos_alloc_fn alloc{ nullptr };
+		stenos_free_fn free{ nullptr };
+		void* user_data{ nullptr };
+
+		STENOS_ALWAYS_INLINE void* allocate(size_t bytes) const noexcept { return alloc ? alloc(user_data, bytes) : ::malloc(bytes); }
+		STENOS_ALWAYS_INLINE void deallocate(void* p) const noexcept
+		{
+			if (free)
+				free(user_data, p);
+			else
+				::free(p);
+		}
+	};
+
 	/// @brief Compression/decompression buffer class
 	/// used by steno_compress/decompress functions
 	struct CBuffer
@@ -51,20 +91,43 @@ namespace stenos
 		// Compression buffer
 		char* bytes{ nullptr };
 
-		static CBuffer* make(size_t bytes) noexcept
+		// Usable size of bytes
+		size_t capacity{ 0 };
+
+		// Optional buffer of the same size, stores the de-interleaved fields of a field layout
+		CBuffer* aux{ nullptr };
+
+		/// @brief Total allocation size of a buffer of given capacity
+		static constexpr size_t allocation_size(size_t bytes) noexcept { return bytes + 16 + sizeof(CBuffer); } // Add 16 to ensure aligned access
+
+		static CBuffer* make(const Allocator& a, size_t bytes) noexcept
 		{
-			size_t alloc = bytes + 16 + sizeof(CBuffer); // Add 16 to ensure aligned access
-			CBuffer* res = (CBuffer*)malloc(alloc);
+			CBuffer* res = (CBuffer*)a.allocate(allocation_size(bytes));
 			if (!res)
 				return res;
 
 			new (res) CBuffer();
 			res->bytes = (char*)detail::align_buffer((char*)res + sizeof(CBuffer));
+			res->capacity = bytes;
 			STENOS_ASSERT_DEBUG((uintptr_t)res->bytes % 16 == 0, "Unaligned bytes!");
 			return res;
 		}
 
-		static void destroy(CBuffer* buf) noexcept { free(buf); }
+		static void destroy(const Allocator& a, CBuffer* buf) noexcept
+		{
+			if (buf) {
+				if (buf->aux)
+					a.deallocate(buf->aux);
+				a.deallocate(buf);
+			}
+		}
+
+		/// @brief Returns the memory used by this buffer and its optional auxiliary buffer
+		size_t footprint() const noexcept { return allocation_size(capacity) + (aux ? allocation_size(aux->capacity) : 0); }
+
+		/// @brief Check if this buffer can be kept for a superblock buffer of given size.
+		/// Buffers are kept within the same size class: at least the requested size, and less than twice its value.
+		static STENOS_ALWAYS_INLINE bool fits(const CBuffer* buf, size_t bytes) noexcept { return buf->capacity >= bytes && buf->capacity / 2 < bytes; }
 	};
 
 	/// @brief Helper function, returns the superblock size for given block size (bytesoftype * 256)
@@ -75,8 +138,149 @@ namespace stenos
 		return (STENOS_BLOCK_SIZE / block_size) * block_size;
 	}
 
+	/// @brief Check that given index type can be used for given bytesoftype
+	static STENOS_ALWAYS_INLINE bool index_type_valid(int index_type, size_t bytesoftype) noexcept
+	{
+		switch (index_type) {
+			case STENOS_INDEX_NONE:
+			case STENOS_INDEX_OFFSETS:
+				return true;
+			case STENOS_INDEX_MINMAX_SIGNED:
+			case STENOS_INDEX_MINMAX_UNSIGNED:
+				return bytesoftype == 1 || bytesoftype == 2 || bytesoftype == 4 || bytesoftype == 8;
+			case STENOS_INDEX_MINMAX_FLOAT:
+				return bytesoftype == 4 || bytesoftype == 8;
+			default:
+				return false;
+		}
+	}
+
+	/// @brief Returns the size of a single index entry: superblock offset (8 bytes) followed by optional min/max values
+	static STENOS_ALWAYS_INLINE size_t index_entry_size(int index_type, size_t bytesoftype) noexcept
+	{
+		return index_type >= STENOS_INDEX_MINMAX_SIGNED ? 8 + bytesoftype * 2 : 8;
+	}
+
+	/// @brief Returns the full index size (entries + 4 bytes footer) for given superblock count
+	static STENOS_ALWAYS_INLINE size_t index_size(int index_type, size_t bytesoftype, size_t super_block_count) noexcept
+	{
+		if (index_type == STENOS_INDEX_NONE)
+			return 0;
+		return super_block_count * index_entry_size(index_type, bytesoftype) + 4;
+	}
+
+	/// @brief Adds the elapsed nanoseconds of its scope to *ns, if ns is not null
+	struct StatTimer
+	{
+		uint64_t* ns;
+		stenos::timer timer;
+		STENOS_ALWAYS_INLINE StatTimer(uint64_t* n) noexcept
+		  : ns(n)
+		{
+			if (ns)
+				timer.tick();
+		}
+		STENOS_ALWAYS_INLINE ~StatTimer() noexcept
+		{
+			if (ns)
+				*ns += timer.tock();
+		}
+	};
+
+	/// @brief Lock-free compression statistics of a context
+	struct Stats
+	{
+		std::atomic<uint64_t> superblocks{ 0 };
+		std::atomic<uint64_t> input_bytes{ 0 };
+		std::atomic<uint64_t> output_bytes{ 0 };
+		std::atomic<uint64_t> modes[11];
+		std::atomic<uint64_t> forced_memcpy{ 0 };
+		std::atomic<uint64_t> guess_ns{ 0 };
+		std::atomic<uint64_t> block_ns{ 0 };
+		std::atomic<uint64_t> shuffle_ns{ 0 };
+		std::atomic<uint64_t> zstd_ns{ 0 };
+		std::atomic<uint64_t> memcpy_ns{ 0 };
+
+		Stats() noexcept { reset(); }
+
+		void reset() noexcept
+		{
+			superblocks.store(0);
+			input_bytes.store(0);
+			output_bytes.store(0);
+			for (auto& m : modes)
+				m.store(0);
+			forced_memcpy.store(0);
+			guess_ns.store(0);
+			block_ns.store(0);
+			shuffle_ns.store(0);
+			zstd_ns.store(0);
+			memcpy_ns.store(0);
+		}
+
+		void add(const stenos_superblock_stats& st) noexcept
+		{
+			superblocks.fetch_add(1, std::memory_order_relaxed);
+			input_bytes.fetch_add(st.input_size, std::memory_order_relaxed);
+			output_bytes.fetch_add(st.output_size, std::memory_order_relaxed);
+			if (st.mode >= STENOS_MODE_BLOCK && st.mode <= STENOS_MODE_FIELDS)
+				modes[st.mode].fetch_add(1, std::memory_order_relaxed);
+			forced_memcpy.fetch_add((uint64_t)st.forced_memcpy, std::memory_order_relaxed);
+			guess_ns.fetch_add(st.guess_ns, std::memory_order_relaxed);
+			block_ns.fetch_add(st.block_ns, std::memory_order_relaxed);
+			shuffle_ns.fetch_add(st.shuffle_ns, std::memory_order_relaxed);
+			zstd_ns.fetch_add(st.zstd_ns, std::memory_order_relaxed);
+			memcpy_ns.fetch_add(st.memcpy_ns, std::memory_order_relaxed);
+		}
+	};
+
 }
 
+// Compression dictionary
+struct stenos_dict_s
+{
+	std::vector<uint8_t> content;	    // Dictionary content, used to digest compression dictionaries
+	unsigned id{ 0 };		    // Dictionary ID, never 0
+	ZSTD_DDict* ddict{ nullptr };	    // Digested decompression dictionary
+	std::atomic<ZSTD_CDict*> cdicts[10]; // Digested compression dictionaries for levels 0 to 9, created on first use
+
+	stenos_dict_s() noexcept
+	{
+		for (auto& c : cdicts)
+			c.store(nullptr);
+	}
+	~stenos_dict_s() noexcept
+	{
+		for (auto& c : cdicts)
+			ZSTD_freeCDict(c.load());
+		ZSTD_freeDDict(ddict);
+	}
+
+	ZSTD_CDict* cdict(int level) const noexcept
+	{
+		// Returns the compression dictionary for given level (0 to 9),
+		// digest it on first use
+		if (level < 0)
+			level = 0;
+		else if (level > 9)
+			level = 9;
+		std::atomic<ZSTD_CDict*>& c = const_cast<std::atomic<ZSTD_CDict*>&>(cdicts[level]);
+		ZSTD_CDict* res = c.load(std::memory_order_acquire);
+		if STENOS_LIKELY (res)
+			return res;
+		res = ZSTD_createCDict(content.data(), content.size(), stenos::zstd_from_reduced_level(level));
+		if STENOS_UNLIKELY (!res)
+			return nullptr;
+		ZSTD_CDict* expected = nullptr;
+		if (!c.compare_exchange_strong(expected, res)) {
+			// Created concurrently by another thread
+			ZSTD_freeCDict(res);
+			res = expected;
+		}
+		return res;
+	}
+};
+
 // Compression/decompression context
 struct stenos_context_s
 {
@@ -85,16 +289,46 @@ struct stenos_context_s
 	std::vector<stenos::CBuffer*> tmp_buffers1;
 	std::vector<stenos::CBuffer*> tmp_buffers2;
 
+	// Reusable zstd decompression contexts, one per buffer slot
+	std::vector<ZSTD_DCtx*> dctxs;
+
+	// Scratch buffer allocator and optional soft memory limit
+	stenos::Allocator allocator;
+	size_t memory_limit{ 0 };
+
 	// Superblock size
 	size_t superblock_size{ 0 };
 
 	// Time constraint
 	stenos::TimeConstraint t;
 
+	// Custom thread pool, global pool if null
+	stenos::thread_pool* pool{ nullptr };
+
+	// External executor, used instead of the thread pool if exec.submit is not null
+	stenos::executor exec{ nullptr, nullptr, nullptr };
+
+	// Optional dictionary
+	const stenos_dict_s* dict{ nullptr };
+
+	// Optional compression statistics and per superblock callback
+	bool stats_enabled{ false };
+	stenos::Stats stats;
+	stenos_superblock_callback stats_callback{ nullptr };
+	void* stats_user_data{ nullptr };
+
+	// Optional field sizes of a record layout, see stenos_set_layout()
+	std::vector<size_t> layout;
+	size_t layout_bytes{ 0 };
+
 	// Parameters
 	int threads{ 1 };
 	int level{ 1 };
+	int exhaustive_level{ 8 };
+	uint64_t min_decompression_speed{ 0 };
 	int shift{ 0 };
+	int index_type{ STENOS_INDEX_NONE };
+	bool checksum{ false };
 	size_t custom_blocksize_shift{ STENOS_NO_BLOCK_SHIFT };
 
 	STENOS_ALWAYS_INLINE void reset_parameters() noexcept
@@ -102,26 +336,53 @@ struct stenos_context_s
 		t.nanoseconds = 0;
 		threads = 1;
 		level = 1;
+		exhaustive_level = 8;
+		min_decompression_speed = 0;
+		index_type = STENOS_INDEX_NONE;
+		checksum = false;
 		custom_blocksize_shift = STENOS_NO_BLOCK_SHIFT;
+		pool = nullptr;
+		exec = stenos::executor{ nullptr, nullptr, nullptr };
+		dict = nullptr;
+		stats_enabled = false;
+		stats_callback = nullptr;
+		stats_user_data = nullptr;
+		layout.clear();
+		layout_bytes = 0;
+		memory_limit = 0;
 	}
 
-	STENOS_ALWAYS_INLINE double requested_speed() noexcept
+	STENOS_ALWAYS_INLINE double requested_speed(size_t bytesoftype) noexcept
 	{
-		// Compute the requested speed in B/s for the remaining bytes
+		// Compute the requested speed in B/s for the remaining bytes.
+		// The speed is expressed for the reference host, based on the observed block compression rate.
 		auto remaining = (t.nanoseconds - t.timer.tock()) * 1e-9;
-		return (t.total_bytes - t.processed_bytes.load(std::memory_order_relaxed)) / remaining;
+		return (t.total_bytes - t.processed_bytes.load(std::memory_order_relaxed)) / remaining * t.rates.host_factor(bytesoftype);
 	}
 
-	size_t prepare(size_t bytesoftype, size_t bytes) noexcept
+	STENOS_ALWAYS_INLINE bool mode_allowed(int mode) const noexcept
 	{
-		// Prepare the compresson of given number of bytes
+		// Check if given superblock mode fulfills the minimum decompression speed
+		return min_decompression_speed == 0 || stenos_mode_decompression_speed(mode) >= min_decompression_speed;
+	}
+
+	STENOS_ALWAYS_INLINE size_t superblock_overhead() const noexcept
+	{
+		// Maximum size added to a compressed superblock: header and optional checksum
+		return checksum ? 8 : 4;
+	}
+
+	size_t compute_superblock_size(size_t bytesoftype, size_t bytes, int& new_shift) const noexcept
+	{
+		// Compute the superblock size and frame shift
+		// used to compress given number of bytes
 
 		if STENOS_UNLIKELY (bytesoftype == 0 || bytesoftype >= STENOS_MAX_BYTESOFTYPE)
 			return STENOS_ERROR_INVALID_BYTESOFTYPE;
 
 		size_t block_size = bytesoftype * 256;
 		size_t new_superblock_size = 0;
-		shift = 0;
+		new_shift = 0;
 
 		if (t.nanoseconds) {
 			// try to have at least thread * 32 super block
@@ -133,13 +394,13 @@ struct stenos_context_s
 				block_count = 1;
 
 			new_superblock_size = block_size * block_count;
-			shift = 255;
+			new_shift = 255;
 			if (new_superblock_size >= STENOS_MAX_BLOCK_BYTES) {
 				// Default strategy for level 9
 				new_superblock_size = stenos::super_block_size(block_size);
 				if (bytes > new_superblock_size) {
-					shift = (9 - 1) / 2;
-					new_superblock_size = new_superblock_size << (size_t)shift;
+					new_shift = (9 - 1) / 2;
+					new_superblock_size = new_superblock_size << (size_t)new_shift;
 				}
 			}
 			else if (new_superblock_size < STENOS_BLOCK_SIZE) {
@@ -152,36 +413,87 @@ struct stenos_context_s
 			if (custom_blocksize_shift != STENOS_NO_BLOCK_SHIFT) {
 				// Custom block shift
 				new_superblock_size = block_size << custom_blocksize_shift;
-				shift = 255;
+				new_shift = 255;
 			}
 			else {
 				// Compute superblock size
 				new_superblock_size = stenos::super_block_size(block_size);
 				if (bytes > new_superblock_size) {
-					shift = level ? (level - 1) / 2 : 0;
-					new_superblock_size = new_superblock_size << (size_t)shift;
+					new_shift = level ? (level - 1) / 2 : 0;
+					new_superblock_size = new_superblock_size << (size_t)new_shift;
 				}
 			}
 		}
 
+		// Reduce the superblock size until one thread fits within the memory limit
+		if (memory_limit && custom_blocksize_shift == STENOS_NO_BLOCK_SHIFT) {
+			while (thread_memory(new_superblock_size) > memory_limit) {
+				if (new_shift != 255 && new_shift > 0) {
+					--new_shift;
+					new_superblock_size >>= 1;
+				}
+				else if (new_shift == 255 && new_superblock_size / 2 >= block_size)
+					new_superblock_size = (new_superblock_size / 2) / block_size * block_size;
+				else
+					break;
+			}
+		}
+
 		// Check superblock size validity
 		if STENOS_UNLIKELY (new_superblock_size < block_size || new_superblock_size >= STENOS_MAX_BLOCK_BYTES)
 			return STENOS_ERROR_INVALID_PARAMETER;
+		return new_superblock_size;
+	}
 
-		// Clear buffers if necessary
-		if (new_superblock_size != superblock_size) {
-			superblock_size = new_superblock_size;
-			clear_buffers();
-		}
+	STENOS_ALWAYS_INLINE size_t thread_memory(size_t sb_size) const noexcept
+	{
+		// Maximum scratch memory owned by a thread for given superblock size:
+		// staging, 2 temporary buffers and the optional layout buffer
+		return (layout.empty() ? 3 : 4) * stenos::CBuffer::allocation_size(sb_size + 8);
+	}
+
+	STENOS_ALWAYS_INLINE size_t thread_count(size_t tasks) const noexcept
+	{
+		// Number of threads used for given number of independent tasks,
+		// reduced to fit within the memory limit
+		size_t res = std::min((size_t)std::max(threads, 1), tasks);
+		if (memory_limit && res > 1)
+			res = std::max((size_t)1, std::min(res, memory_limit / thread_memory(superblock_size)));
+		return res;
+	}
+
+	STENOS_ALWAYS_INLINE stenos::CBuffer* make_buffer() const noexcept
+	{
+		// Add 8 for the superblock header and checksum
+		return stenos::CBuffer::make(allocator, superblock_size + 8);
+	}
+
+	size_t prepare(size_t bytesoftype, size_t bytes) noexcept
+	{
+		// Prepare the compresson of given number of bytes
+
+		size_t new_superblock_size = compute_superblock_size(bytesoftype, bytes, shift);
+		if STENOS_UNLIKELY (stenos::has_error(new_superblock_size))
+			return new_superblock_size;
+
+		// Check index validity
+		if STENOS_UNLIKELY (!stenos::index_type_valid(index_type, bytesoftype))
+			return STENOS_ERROR_INVALID_PARAMETER;
+
+		set_superblock_size(new_superblock_size);
+		start_time_constraint(bytes);
+		return 0;
+	}
 
-		// Initialize the time constraint
+	STENOS_ALWAYS_INLINE void start_time_constraint(size_t bytes) noexcept
+	{
+		// Initialize the time constraint for the compression of given number of bytes
 		if (t.nanoseconds) {
 			t.total_bytes = bytes;
 			t.finish_memcpy.store(false);
 			t.processed_bytes.store(0);
 			t.timer.tick();
 		}
-		return 0;
 	}
 
 	STENOS_ALWAYS_INLINE size_t ensure_has_buffers(int size) noexcept
@@ -193,6 +505,8 @@ struct stenos_context_s
 				tmp_buffers1.resize((size_t)size, nullptr);
 				tmp_buffers2.resize((size_t)size, nullptr);
 			}
+			if (dctxs.size() < (size_t)size)
+				dctxs.resize((size_t)size, nullptr);
 		}
 		catch (...) {
 			return STENOS_ERROR_ALLOC;
@@ -206,18 +520,18 @@ struct stenos_context_s
 
 		for (size_t i = 0; i < thread_buffers.size(); ++i) {
 			if (thread_buffers[i]) {
-				stenos::CBuffer::destroy(thread_buffers[i]);
+				stenos::CBuffer::destroy(allocator, thread_buffers[i]);
 				thread_buffers[i] = nullptr;
 			}
 		}
 		thread_buffers.clear();
 		for (size_t i = 0; i < tmp_buffers1.size(); ++i) {
 			if (tmp_buffers1[i]) {
-				stenos::CBuffer::destroy(tmp_buffers1[i]);
+				stenos::CBuffer::destroy(allocator, tmp_buffers1[i]);
 				tmp_buffers1[i] = nullptr;
 			}
 			if (tmp_buffers2[i]) {
-				stenos::CBuffer::destroy(tmp_buffers2[i]);
+				stenos::CBuffer::destroy(allocator, tmp_buffers2[i]);
 				tmp_buffers2[i] = nullptr;
 			}
 		}
@@ -225,7 +539,41 @@ struct stenos_context_s
 		tmp_buffers2.clear();
 	}
 
-	STENOS_ALWAYS_INLINE ~stenos_context_s() noexcept { clear_buffers(); }
+	STENOS_ALWAYS_INLINE void release_unfit(stenos::CBuffer*& buf, size_t bytes) noexcept
+	{
+		if (!buf)
+			return;
+		if (!stenos::CBuffer::fits(buf, bytes)) {
+			stenos::CBuffer::destroy(allocator, buf);
+			buf = nullptr;
+		}
+		else if (buf->aux && !stenos::CBuffer::fits(buf->aux, bytes)) {
+			allocator.deallocate(buf->aux);
+			buf->aux = nullptr;
+		}
+	}
+
+	void set_superblock_size(size_t new_superblock_size) noexcept
+	{
+		// Set the superblock size, only releasing the buffers of a different size class.
+		// This avoids reallocating all buffers when alternating between close superblock sizes.
+		if (new_superblock_size == superblock_size)
+			return;
+		superblock_size = new_superblock_size;
+		for (stenos::CBuffer*& buf : thread_buffers)
+			release_unfit(buf, superblock_size + 8);
+		for (stenos::CBuffer*& buf : tmp_buffers1)
+			release_unfit(buf, superblock_size + 8);
+		for (stenos::CBuffer*& buf : tmp_buffers2)
+			release_unfit(buf, superblock_size + 8);
+	}
+
+	STENOS_ALWAYS_INLINE ~stenos_context_s() noexcept
+	{
+		clear_buffers();
+		for (ZSTD_DCtx* dctx : dctxs)
+			ZSTD_freeDCtx(dctx);
+	}
 };
 
 stenos_context* stenos_make_context()
@@ -245,9 +593,8 @@ void stenos_destroy_context(stenos_context* ctx)
 void stenos_reset_context(stenos_context* ctx)
 {
 	if (ctx) {
-		ctx->level = 1;
-		ctx->threads = 1;
-		ctx->t.nanoseconds = 0;
+		ctx->reset_parameters();
+		stenos_set_allocator(ctx, nullptr, nullptr, nullptr);
 	}
 }
 
@@ -261,18 +608,195 @@ size_t stenos_set_level(stenos_context* ctx, int level)
 	return 0;
 }
 
+size_t stenos_set_exhaustive_level(stenos_context* ctx, int level)
+{
+	if (level > 10)
+		level = 10;
+	else if (level < 0)
+		level = 0;
+	ctx->exhaustive_level = level;
+	return 0;
+}
+
+size_t stenos_set_min_decompression_speed(stenos_context* ctx, uint64_t bytes_per_second)
+{
+	ctx->min_decompression_speed = bytes_per_second;
+	return 0;
+}
+
+uint64_t stenos_mode_decompression_speed(int mode)
+{
+	// Estimated decompression speeds in bytes/s, measured with bench_decompression_modes()
+	static const uint64_t speeds[11] = { 0,		  3000000000ull, 1200000000ull, 1800000000ull, 1600000000ull, 1000000000ull,
+					     10000000000ull, 1500000000ull, 1500000000ull, 1400000000ull, 1200000000ull };
+	if (mode < STENOS_MODE_BLOCK || mode > STENOS_MODE_FIELDS)
+		return 0;
+	return speeds[mode];
+}
+
+size_t stenos_enable_stats(stenos_context* ctx, int enable)
+{
+	ctx->stats_enabled = enable != 0;
+	return 0;
+}
+
+size_t stenos_set_superblock_callback(stenos_context* ctx, stenos_superblock_callback callback, void* user_data)
+{
+	ctx->stats_callback = callback;
+	ctx->stats_user_data = user_data;
+	return 0;
+}
+
+size_t stenos_get_stats(const stenos_context* ctx, stenos_stats* stats)
+{
+	const stenos::Stats& s = ctx->stats;
+	stats->superblocks = s.superblocks.load(std::memory_order_relaxed);
+	stats->input_bytes = s.input_bytes.load(std::memory_order_relaxed);
+	stats->output_bytes = s.output_bytes.load(std::memory_order_relaxed);
+	for (int i = 0; i < 11; ++i)
+		stats->modes[i] = s.modes[i].load(std::memory_order_relaxed);
+	stats->forced_memcpy = s.forced_memcpy.load(std::memory_order_relaxed);
+	stats->guess_ns = s.guess_ns.load(std::memory_order_relaxed);
+	stats->block_ns = s.block_ns.load(std::memory_order_relaxed);
+	stats->shuffle_ns = s.shuffle_ns.load(std::memory_order_relaxed);
+	stats->zstd_ns = s.zstd_ns.load(std::memory_order_relaxed);
+	stats->memcpy_ns = s.memcpy_ns.load(std::memory_order_relaxed);
+	return 0;
+}
+
+size_t stenos_reset_stats(stenos_context* ctx)
+{
+	ctx->stats.reset();
+	return 0;
+}
+
 size_t stenos_set_threads(stenos_context* ctx, int threads)
 {
 	ctx->threads = threads < 1 ? 1 : threads;
 	return 0;
 }
 
+size_t stenos_set_allocator(stenos_context* ctx, stenos_alloc_fn alloc, stenos_free_fn free, void* user_data)
+{
+	if STENOS_UNLIKELY (!alloc != !free)
+		return STENOS_ERROR_INVALID_PARAMETER;
+	// Release buffers allocated with the previous allocator
+	ctx->clear_buffers();
+	ctx->allocator = stenos::Allocator{ alloc, free, user_data };
+	return 0;
+}
+
+size_t stenos_set_memory_limit(stenos_context* ctx, size_t bytes)
+{
+	ctx->memory_limit = bytes;
+	return 0;
+}
+
 size_t stenos_set_max_nanoseconds(stenos_context* ctx, uint64_t nanoseconds)
 {
 	ctx->t.nanoseconds = nanoseconds;
 	return 0;
 }
 
+size_t stenos_calibrate(stenos_context* ctx, const void* sample, size_t bytesoftype, size_t bytes)
+{
+	// Measure block and zstd compression rates on (at most) STENOS_BLOCK_SIZE bytes of sample
+
+	if STENOS_UNLIKELY (bytesoftype == 0 || bytesoftype >= STENOS_MAX_BYTESOFTYPE)
+		return STENOS_ERROR_INVALID_BYTESOFTYPE;
+	if (bytes > STENOS_BLOCK_SIZE)
+		bytes = STENOS_BLOCK_SIZE;
+	bytes -= bytes % bytesoftype;
+	if STENOS_UNLIKELY (!sample || bytes < bytesoftype * 256)
+		return STENOS_ERROR_INVALID_PARAMETER;
+
+	std::vector<uint8_t> tmp;
+	try {
+		tmp.resize(ZSTD_compressBound(bytes));
+	}
+	catch (...) {
+		return STENOS_ERROR_ALLOC;
+	}
+
+	stenos::TimeConstraint t;
+	stenos::timer timer;
+	auto rate = [bytes](uint64_t ns) { return bytes * 1e9 / (double)(ns ? ns : 1); };
+
+	// Warm up: allocate block and zstd compression buffers
+	stenos::block_compress_generic(sample, bytesoftype, bytes, tmp.data(), bytes, 2, 2, t, nullptr, nullptr);
+	stenos::zstd_compress_with_context(tmp.data(), tmp.size(), sample, bytes, 1);
+
+	for (int level = 0; level <= 2; ++level) {
+		timer.tick();
+		size_t r = stenos::block_compress_generic(sample, bytesoftype, bytes, tmp.data(), bytes, level, level, t, nullptr, nullptr);
+		uint64_t el = timer.tock();
+		// Compression failure (ratio too low) still gives a valid rate
+		if (r != STENOS_ERROR_ALLOC)
+			ctx->t.rates.set(STENOS_RATE_BLOCK, level, bytesoftype, rate(el));
+	}
+	for (int level = 1; level <= 9; ++level) {
+		timer.tick();
+		size_t r = stenos::zstd_compress_with_context(tmp.data(), tmp.size(), sample, bytes, level);
+		uint64_t el = timer.tock();
+		if STENOS_UNLIKELY (stenos::has_error(r))
+			return r;
+		ctx->t.rates.set(STENOS_RATE_ZSTD, level, bytesoftype, rate(el));
+	}
+	return 0;
+}
+
+double stenos_get_rate(const stenos_context* ctx, int mode, int level, size_t bytesoftype)
+{
+	if (mode < STENOS_RATE_BLOCK || mode > STENOS_RATE_ZSTD || level < 0 || level > 9 || bytesoftype == 0)
+		return 0;
+	return ctx->t.rates.get((unsigned)mode, level, bytesoftype);
+}
+
+size_t stenos_export_rates(const stenos_context* ctx, void* dst, size_t dst_size)
+{
+	// Rates are stored in KB/s as little endian 32 bits integers,
+	// after a magic number and the number of rates
+	using namespace stenos;
+	static_assert(STENOS_RATE_MODEL_SIZE == 8 + RateModel::modes * RateModel::levels * RateModel::classes * 4, "invalid rate model size");
+	if STENOS_UNLIKELY (dst_size < STENOS_RATE_MODEL_SIZE)
+		return STENOS_ERROR_DST_OVERFLOW;
+	uint8_t* d = (uint8_t*)dst;
+	write_LE_32(d, STENOS_RATE_MODEL_MAGIC);
+	write_LE_32(d + 4, RateModel::modes * RateModel::levels * RateModel::classes);
+	d += 8;
+	for (unsigned m = 0; m < RateModel::modes; ++m)
+		for (unsigned l = 0; l < RateModel::levels; ++l)
+			for (unsigned c = 0; c < RateModel::classes; ++c, d += 4) {
+				double kbs = ctx->t.rates.rates[m][l][c].load(std::memory_order_relaxed) / 1000.;
+				write_LE_32(d, kbs < 1 ? 1u : (kbs > 4294967295. ? 4294967295u : (unsigned)kbs));
+			}
+	return STENOS_RATE_MODEL_SIZE;
+}
+
+size_t stenos_import_rates(stenos_context* ctx, const void* src, size_t size)
+{
+	using namespace stenos;
+	if (!src) {
+		// Reset to the reference host rates
+		ctx->t.rates.reset();
+		return 0;
+	}
+	const uint8_t* s = (const uint8_t*)src;
+	if STENOS_UNLIKELY (size < STENOS_RATE_MODEL_SIZE || read_LE_32(s) != STENOS_RATE_MODEL_MAGIC ||
+			    read_LE_32(s + 4) != RateModel::modes * RateModel::levels * RateModel::classes)
+		return STENOS_ERROR_INVALID_INPUT;
+	s += 8;
+	for (unsigned m = 0; m < RateModel::modes; ++m)
+		for (unsigned l = 0; l < RateModel::levels; ++l)
+			for (unsigned c = 0; c < RateModel::classes; ++c, s += 4) {
+				unsigned kbs = read_LE_32(s);
+				if STENOS_UNLIKELY (kbs == 0)
+					return STENOS_ERROR_INVALID_INPUT;
+				ctx->t.rates.rates[m][l][c].store(kbs * 1000., std::memory_order_relaxed);
+			}
+	return 0;
+}
+
 size_t stenos_set_block_size(stenos_context* ctx, size_t blocksize_shift)
 {
 	if (blocksize_shift >= 16 && blocksize_shift != STENOS_NO_BLOCK_SHIFT)
@@ -285,25 +809,191 @@ size_t stenos_set_block_size(stenos_context* ctx, size_t blocksize_shift)
 	return 0;
 }
 
+size_t stenos_set_index(stenos_context* ctx, int index_type)
+{
+	if (index_type < STENOS_INDEX_NONE || index_type > STENOS_INDEX_MINMAX_FLOAT)
+		return STENOS_ERROR_INVALID_PARAMETER;
+	ctx->index_type = index_type;
+	return 0;
+}
+
+size_t stenos_set_checksum(stenos_context* ctx, int enable)
+{
+	ctx->checksum = enable != 0;
+	return 0;
+}
+
+size_t stenos_set_layout(stenos_context* ctx, const size_t* field_sizes, size_t count)
+{
+	if (!field_sizes || count == 0) {
+		ctx->layout.clear();
+		ctx->layout_bytes = 0;
+		return 0;
+	}
+	size_t total = 0;
+	for (size_t i = 0; i < count; ++i) {
+		if STENOS_UNLIKELY (field_sizes[i] == 0)
+			return STENOS_ERROR_INVALID_PARAMETER;
+		total += field_sizes[i];
+	}
+	if STENOS_UNLIKELY (total >= STENOS_MAX_BYTESOFTYPE)
+		return STENOS_ERROR_INVALID_PARAMETER;
+	try {
+		ctx->layout.assign(field_sizes, field_sizes + count);
+	}
+	catch (...) {
+		return STENOS_ERROR_ALLOC;
+	}
+	ctx->layout_bytes = total;
+	return 0;
+}
+
+stenos_dict* stenos_make_dictionary(const void* content, size_t size)
+{
+	if (!content || size == 0)
+		return nullptr;
+	stenos_dict* dict = (stenos_dict*)malloc(sizeof(stenos_dict_s));
+	if (!dict)
+		return nullptr;
+	new (dict) stenos_dict_s();
+	try {
+		dict->content.assign((const uint8_t*)content, (const uint8_t*)content + size);
+	}
+	catch (...) {
+		stenos_destroy_dictionary(dict);
+		return nullptr;
+	}
+	dict->ddict = ZSTD_createDDict(dict->content.data(), size);
+	if (!dict->ddict) {
+		stenos_destroy_dictionary(dict);
+		return nullptr;
+	}
+	// Use the zstd dictionary ID if any, or the content checksum for raw content dictionaries
+	dict->id = ZSTD_getDictID_fromDict(content, size);
+	if (dict->id == 0)
+		dict->id = stenos::crc32c(content, size);
+	if (dict->id == 0)
+		dict->id = 1;
+	return dict;
+}
+
+void stenos_destroy_dictionary(stenos_dict* dict)
+{
+	if (dict) {
+		dict->~stenos_dict_s();
+		free(dict);
+	}
+}
+
+unsigned stenos_dictionary_id(const stenos_dict* dict)
+{
+	return dict ? dict->id : 0;
+}
+
+size_t stenos_set_dictionary(stenos_context* ctx, const stenos_dict* dict)
+{
+	ctx->dict = dict;
+	return 0;
+}
+
+size_t stenos_train_dictionary(const void* samples, size_t bytesoftype, const size_t* sample_sizes, size_t nb_samples, void* dict_buffer, size_t dict_capacity)
+{
+	// Train a dictionary over all representations of the samples that can reach zstd:
+	// raw, transposed, transposed + delta, transposed + XOR (4 or 8 bytes types),
+	// element-wise delta (2, 4 or 8 bytes types) and block compressed
+
+	if STENOS_UNLIKELY (bytesoftype == 0 || bytesoftype >= STENOS_MAX_BYTESOFTYPE)
+		return STENOS_ERROR_INVALID_BYTESOFTYPE;
+	if STENOS_UNLIKELY (!samples || !sample_sizes || nb_samples == 0 || !dict_buffer)
+		return STENOS_ERROR_INVALID_PARAMETER;
+
+	std::vector<uint8_t> train;
+	std::vector<size_t> train_sizes;
+	std::vector<uint8_t> tmp1, tmp2;
+	const uint8_t* src = (const uint8_t*)samples;
+	stenos::TimeConstraint t;
+	try {
+		for (size_t i = 0; i < nb_samples; ++i) {
+			size_t bytes = sample_sizes[i];
+			if (bytes == 0)
+				continue;
+
+			// Raw sample
+			train.insert(train.end(), src, src + bytes);
+			train_sizes.push_back(bytes);
+
+			size_t bytes_tr = bytes - bytes % bytesoftype;
+			if (bytesoftype > 1 && bytes_tr) {
+				tmp1.resize(bytes + 16);
+				tmp2.resize(bytes + 16);
+
+				// Transposed sample
+				stenos::shuffle(bytesoftype, bytes_tr, src, tmp1.data());
+				train.insert(train.end(), tmp1.data(), tmp1.data() + bytes_tr);
+				train_sizes.push_back(bytes_tr);
+
+				// Transposed + delta sample
+				stenos::delta(tmp1.data(), tmp2.data(), bytes_tr);
+				train.insert(train.end(), tmp2.data(), tmp2.data() + bytes_tr);
+				train_sizes.push_back(bytes_tr);
+
+				if (bytesoftype == 4 || bytesoftype == 8) {
+					// Transposed + XOR + bit transposed sample
+					stenos::xor_bitshuffle(bytesoftype, bytes_tr, tmp1.data(), tmp2.data());
+					train.insert(train.end(), tmp2.data(), tmp2.data() + bytes_tr);
+					train_sizes.push_back(bytes_tr);
+				}
+				if (bytesoftype == 2 || bytesoftype == 4 || bytesoftype == 8) {
+					// Element-wise delta + transposed sample
+					stenos::int_delta_shuffle(bytesoftype, bytes_tr, 1, src, tmp2.data());
+					train.insert(train.end(), tmp2.data(), tmp2.data() + bytes_tr);
+					train_sizes.push_back(bytes_tr);
+				}
+			}
+
+			if (bytes >= bytesoftype * 256) {
+				// Block compressed sample
+				tmp2.resize(bytes + 16);
+				size_t cblock = stenos::block_compress_generic(src, bytesoftype, bytes, tmp2.data(), bytes, 2, 2, t, nullptr, nullptr);
+				if (!stenos::has_error(cblock) && cblock < bytes) {
+					train.insert(train.end(), tmp2.data(), tmp2.data() + cblock);
+					train_sizes.push_back(cblock);
+				}
+			}
+
+			src += bytes;
+		}
+	}
+	catch (...) {
+		return STENOS_ERROR_ALLOC;
+	}
+
+	if STENOS_UNLIKELY (train_sizes.empty())
+		return STENOS_ERROR_INVALID_PARAMETER;
+	size_t r = ZDICT_trainFromBuffer(dict_buffer, dict_capacity, train.data(), train_sizes.data(), (unsigned)train_sizes.size());
+	if STENOS_UNLIKELY (ZDICT_isError(r))
+		return ZSTD_getErrorCode(r) == ZSTD_error_dstSize_tooSmall ? STENOS_ERROR_DST_OVERFLOW : STENOS_ERROR_ZSTD_INTERNAL;
+	return r;
+}
+
 size_t stenos_memory_footprint(stenos_context* ctx)
 {
 	size_t res = sizeof(stenos_context);
 	res += ctx->thread_buffers.capacity() * sizeof(void*);
 	res += ctx->tmp_buffers1.capacity() * sizeof(void*);
 	res += ctx->tmp_buffers2.capacity() * sizeof(void*);
-	for (size_t i = 0; i < ctx->thread_buffers.size(); ++i) {
-		if (ctx->thread_buffers[i]) {
-			res += ctx->superblock_size + 4 + sizeof(stenos::CBuffer);
-		}
-	}
-	for (size_t i = 0; i < ctx->tmp_buffers1.size(); ++i) {
-		if (ctx->tmp_buffers1[i]) {
-			res += ctx->superblock_size + 4 + sizeof(stenos::CBuffer);
-		}
-		if (ctx->tmp_buffers2[i]) {
-			res += ctx->superblock_size + 4 + sizeof(stenos::CBuffer);
-		}
-	}
+	res += ctx->dctxs.capacity() * sizeof(void*);
+	for (ZSTD_DCtx* dctx : ctx->dctxs)
+		res += ZSTD_sizeof_DCtx(dctx);
+	for (const stenos::CBuffer* buf : ctx->thread_buffers)
+		if (buf)
+			res += buf->footprint();
+	for (const stenos::CBuffer* buf : ctx->tmp_buffers1)
+		if (buf)
+			res += buf->footprint();
+	for (const stenos::CBuffer* buf : ctx->tmp_buffers2)
+		if (buf)
+			res += buf->footprint();
 	return res;
 }
 
@@ -373,11 +1063,251 @@ namespace stenos
 		return bytes + 4;
 	}
 
-	static inline double guess_transposed_lz_ratio(const void* src, size_t bytesoftype, size_t bytes, int level, CBuffer* delta_buffer)
+	static STENOS_ALWAYS_INLINE bool check_superblock(const uint8_t* superblock, size_t csize) noexcept
 	{
-		// Try to guess lz compression ratio on input
-		size_t elements = bytes / bytesoftype;
-		size_t stepsize = elements / (16 / (level - 1)); // Check more bytes for higher levels
+		// Check the checksum following a superblock of csize bytes (header excluded)
+		return crc32c(superblock, csize + 4) == read_LE_32(superblock + csize + 4);
+	}
+
+	static inline size_t write_frame_header(const stenos_context_s* ctx, size_t bytes, void* _dst, size_t dst_size) noexcept
+	{
+		// Write the frame header: shift and flags, decompressed size,
+		// custom superblock size, index type and dictionary ID.
+		// Without flags, the first byte is the shift (or 255 for custom superblock size).
+		// Returns the header size.
+		unsigned flags = (ctx->index_type != STENOS_INDEX_NONE ? STENOS_FRAME_FLAG_INDEX : 0) | (ctx->checksum ? STENOS_FRAME_FLAG_CHECKSUM : 0) |
+				 (ctx->dict ? STENOS_FRAME_FLAG_DICT : 0);
+		bool custom = ctx->shift == 255;
+		size_t header_size = 8 + (custom ? 4 : 0) + (flags & STENOS_FRAME_FLAG_INDEX ? 1 : 0) + (flags & STENOS_FRAME_FLAG_DICT ? 4 : 0);
+		if STENOS_UNLIKELY (dst_size < header_size)
+			return STENOS_ERROR_DST_OVERFLOW;
+		uint8_t* dst = (uint8_t*)_dst;
+		if (flags)
+			*dst++ = (uint8_t)(flags | (custom ? STENOS_FRAME_SHIFT_CUSTOM : (unsigned)ctx->shift));
+		else
+			*dst++ = (uint8_t)ctx->shift;
+		write_uint64_7(dst, bytes);
+		dst += 7;
+		if (custom) {
+			write_LE_32(dst, (unsigned)ctx->superblock_size);
+			dst += 4;
+		}
+		if (flags & STENOS_FRAME_FLAG_INDEX)
+			*dst++ = (uint8_t)ctx->index_type;
+		if (flags & STENOS_FRAME_FLAG_DICT)
+			write_LE_32(dst, ctx->dict->id);
+		return header_size;
+	}
+
+	/// @brief Decoded frame header
+	struct FrameHeader
+	{
+		size_t header_size;
+		size_t decompressed_size;
+		size_t superblock_size;
+		size_t checksum_size; // Size of the checksum following each superblock
+		unsigned flags;
+		int index_type;
+		unsigned dict_id; // Dictionary ID, 0 if none
+	};
+
+	static STENOS_ALWAYS_INLINE size_t frame_header_size(uint8_t first) noexcept
+	{
+		// Returns the frame header size based on its first byte
+		if (first == STENOS_FRAME_LEGACY_CUSTOM)
+			return 12;
+		return 8 + ((first & STENOS_FRAME_SHIFT_MASK) == STENOS_FRAME_SHIFT_CUSTOM ? 4 : 0) + (first & STENOS_FRAME_FLAG_INDEX ? 1 : 0) +
+		       (first & STENOS_FRAME_FLAG_DICT ? 4 : 0);
+	}
+
+	static inline size_t read_frame_header(const void* _src, size_t bytesoftype, size_t bytes, FrameHeader& h) noexcept
+	{
+		// Read and check a frame header.
+		// Returns the header size.
+		const uint8_t* src = (const uint8_t*)_src;
+		const uint8_t* end_src = src + bytes;
+
+		if STENOS_UNLIKELY (src + 8 > end_src)
+			return STENOS_ERROR_SRC_OVERFLOW;
+
+		uint8_t first = *src++;
+		unsigned shift = first;
+		h.flags = 0;
+		h.index_type = STENOS_INDEX_NONE;
+		h.dict_id = 0;
+		if (first != STENOS_FRAME_LEGACY_CUSTOM) {
+			// Check flags and shift validity
+			if STENOS_UNLIKELY (first & ~(STENOS_FRAME_FLAGS_KNOWN | STENOS_FRAME_SHIFT_MASK))
+				return STENOS_ERROR_INVALID_INPUT;
+			h.flags = first & STENOS_FRAME_FLAGS_MASK;
+			shift = first & STENOS_FRAME_SHIFT_MASK;
+			if (shift == STENOS_FRAME_SHIFT_CUSTOM)
+				shift = 255;
+			if STENOS_UNLIKELY (shift > 4 && shift != 255)
+				return STENOS_ERROR_INVALID_INPUT;
+		}
+
+		// Decompressed size
+		h.decompressed_size = (size_t)read_uint64_7(src);
+		src += 7;
+
+		// Superblock size
+		if (shift == 255) {
+			if STENOS_UNLIKELY (src + 4 > end_src)
+				return STENOS_ERROR_SRC_OVERFLOW;
+			h.superblock_size = read_LE_32(src);
+			src += 4;
+		}
+		else
+			h.superblock_size = super_block_size(bytesoftype * 256) << shift;
+		if STENOS_UNLIKELY (h.superblock_size < bytesoftype * 256 || h.superblock_size >= STENOS_MAX_BLOCK_BYTES)
+			return STENOS_ERROR_INVALID_INPUT;
+
+		// Index type
+		if (h.flags & STENOS_FRAME_FLAG_INDEX) {
+			if STENOS_UNLIKELY (src + 1 > end_src)
+				return STENOS_ERROR_SRC_OVERFLOW;
+			h.index_type = *src++;
+			if STENOS_UNLIKELY (h.index_type == STENOS_INDEX_NONE || !index_type_valid(h.index_type, bytesoftype))
+				return STENOS_ERROR_INVALID_INPUT;
+		}
+
+		// Dictionary ID
+		if (h.flags & STENOS_FRAME_FLAG_DICT) {
+			if STENOS_UNLIKELY (src + 4 > end_src)
+				return STENOS_ERROR_SRC_OVERFLOW;
+			h.dict_id = read_LE_32(src);
+			src += 4;
+			if STENOS_UNLIKELY (h.dict_id == 0)
+				return STENOS_ERROR_INVALID_INPUT;
+		}
+
+		h.checksum_size = h.flags & STENOS_FRAME_FLAG_CHECKSUM ? 4 : 0;
+		h.header_size = (size_t)(src - (const uint8_t*)_src);
+		return h.header_size;
+	}
+
+	static STENOS_ALWAYS_INLINE size_t frame_dictionary(const stenos_context_s* ctx, const FrameHeader& h, const ZSTD_DDict*& ddict) noexcept
+	{
+		// Retrieve the decompression dictionary of a frame,
+		// which must match the context dictionary
+		ddict = nullptr;
+		if (!(h.flags & STENOS_FRAME_FLAG_DICT))
+			return 0;
+		if STENOS_UNLIKELY (!ctx->dict || ctx->dict->id != h.dict_id)
+			return STENOS_ERROR_DICTIONARY;
+		ddict = ctx->dict->ddict;
+		return 0;
+	}
+
+	template<class T>
+	static void minmax_values(const void* src, size_t bytes, uint8_t* out) noexcept
+	{
+		// Compute min and max values of input, write them to out
+		const uint8_t* in = (const uint8_t*)src;
+		size_t count = bytes / sizeof(T);
+		T mn, mx;
+		memcpy(&mn, in, sizeof(T));
+		mx = mn;
+		for (size_t i = 1; i < count; ++i) {
+			T v;
+			memcpy(&v, in + i * sizeof(T), sizeof(T));
+			if (v < mn)
+				mn = v;
+			else if (v > mx)
+				mx = v;
+		}
+		memcpy(out, &mn, sizeof(T));
+		memcpy(out + sizeof(T), &mx, sizeof(T));
+	}
+
+	static inline void write_index_entry(int index_type, size_t bytesoftype, size_t offset, const void* src, size_t bytes, uint8_t* dst) noexcept
+	{
+		// Write an index entry: superblock offset and optional min/max values
+		write_LE_64(dst, offset);
+		dst += 8;
+
+		switch (index_type) {
+			case STENOS_INDEX_MINMAX_SIGNED:
+				switch (bytesoftype) {
+					case 1:
+						minmax_values<int8_t>(src, bytes, dst);
+						break;
+					case 2:
+						minmax_values<int16_t>(src, bytes, dst);
+						break;
+					case 4:
+						minmax_values<int32_t>(src, bytes, dst);
+						break;
+					default:
+						minmax_values<int64_t>(src, bytes, dst);
+						break;
+				}
+				break;
+			case STENOS_INDEX_MINMAX_UNSIGNED:
+				switch (bytesoftype) {
+					case 1:
+						minmax_values<uint8_t>(src, bytes, dst);
+						break;
+					case 2:
+						minmax_values<uint16_t>(src, bytes, dst);
+						break;
+					case 4:
+						minmax_values<uint32_t>(src, bytes, dst);
+						break;
+					default:
+						minmax_values<uint64_t>(src, bytes, dst);
+						break;
+				}
+				break;
+			case STENOS_INDEX_MINMAX_FLOAT:
+				if (bytesoftype == 4)
+					minmax_values<float>(src, bytes, dst);
+				else
+					minmax_values<double>(src, bytes, dst);
+				break;
+			default:
+				break;
+		}
+	}
+
+	static inline size_t locate_superblock(const uint8_t* src, size_t size, size_t bytesoftype, const FrameHeader& h, size_t superblock, const uint8_t** entry) noexcept
+	{
+		// Returns the offset of given superblock within the frame,
+		// using the index if available or by walking the superblock headers.
+		// If the frame has an index, entry points to the superblock index entry.
+		size_t super_block_count = h.decompressed_size / h.superblock_size + (h.decompressed_size % h.superblock_size ? 1 : 0);
+		*entry = nullptr;
+		if (h.index_type != STENOS_INDEX_NONE) {
+			size_t entry_size = index_entry_size(h.index_type, bytesoftype);
+			size_t index_bytes = index_size(h.index_type, bytesoftype, super_block_count);
+			if STENOS_UNLIKELY (size < h.header_size + index_bytes)
+				return STENOS_ERROR_SRC_OVERFLOW;
+			if STENOS_UNLIKELY (read_LE_32(src + size - 4) != super_block_count * entry_size)
+				return STENOS_ERROR_INVALID_INPUT;
+			*entry = src + size - index_bytes + superblock * entry_size;
+			size_t offset = (size_t)read_LE_64(*entry);
+			if STENOS_UNLIKELY (offset < h.header_size || offset + 4 > size - index_bytes)
+				return STENOS_ERROR_INVALID_INPUT;
+			return offset;
+		}
+
+		size_t offset = h.header_size;
+		for (size_t i = 0; i < superblock; ++i) {
+			if STENOS_UNLIKELY (offset + 4 > size)
+				return STENOS_ERROR_SRC_OVERFLOW;
+			offset += 4 + read_uint32_3(src + offset + 1) + h.checksum_size;
+		}
+		if STENOS_UNLIKELY (offset + 4 > size)
+			return STENOS_ERROR_SRC_OVERFLOW;
+		return offset;
+	}
+
+	static inline double guess_transposed_lz_ratio(const void* src, size_t bytesoftype, size_t bytes, int level, CBuffer* delta_buffer)
+	{
+		// Try to guess lz compression ratio on input
+		size_t elements = bytes / bytesoftype;
+		size_t stepsize = elements / (16 / (level - 1)); // Check more bytes for higher levels
 		if (stepsize < 64)
 			stepsize = elements; // We need at least 64 bytes to assess something
 		size_t csize = 0;
@@ -400,22 +1330,285 @@ namespace stenos
 		return ((double)(processed) / (double)csize) * (1. + (double)level * 0.02);
 	}
 
+	static inline double guess_int_delta_lz_ratio(const void* src, size_t bytesoftype, size_t bytes, int level, int order, CBuffer* delta_buffer)
+	{
+		// Same as guess_transposed_lz_ratio() for element-wise delta of given order.
+		// Uses a single contiguous range of elements.
+		size_t elements = bytes / bytesoftype;
+		size_t stepsize = elements / (16 / (level - 1)) * bytesoftype;
+		if (stepsize < 64 * bytesoftype)
+			stepsize = elements * bytesoftype;
+		auto input = (const char*)src + ((elements * bytesoftype - stepsize) / (2 * bytesoftype)) * bytesoftype;
+		int_delta_shuffle(bytesoftype, stepsize, order, input, delta_buffer->bytes);
+		size_t csize = stenos::lz4_guess_size(delta_buffer->bytes, stepsize, 10 - level);
+		return ((double)(stepsize) / (double)csize) * (1. + (double)level * 0.02);
+	}
+
+	static inline double guess_xor_lz_ratio(const void* src, size_t bytesoftype, size_t bytes, int level, CBuffer* xor_buffer)
+	{
+		// Same as guess_transposed_lz_ratio() for the XOR + bit transposition of each plane
+		size_t elements = bytes / bytesoftype;
+		size_t stepsize = elements / (16 / (level - 1));
+		if (stepsize < 64)
+			stepsize = elements;
+		stepsize &= ~(size_t)7;
+		size_t csize = 0;
+		size_t processed = 0;
+
+		for (size_t i = 0; i < bytesoftype; ++i) {
+			auto input1 = (const char*)src + i * elements + (elements - stepsize) / 2;
+			auto dst1 = (char*)xor_buffer->bytes + i * stepsize;
+			xor_bitshuffle(1, stepsize, input1, dst1);
+			csize += stenos::lz4_guess_size(dst1, stepsize, 10 - level);
+			processed += stepsize;
+		}
+		return ((double)(processed) / (double)csize) * (1. + (double)level * 0.02);
+	}
+
+	static STENOS_ALWAYS_INLINE double c_log2_c(size_t c) noexcept
+	{
+		// c * log2(c), tabulated for small counts
+		struct Table
+		{
+			double v[2049];
+			Table() noexcept
+			{
+				v[0] = 0;
+				for (size_t i = 1; i < 2049; ++i)
+					v[i] = (double)i * std::log2((double)i);
+			}
+		};
+		static const Table table;
+		return c < 2049 ? table.v[c] : (double)c * std::log2((double)c);
+	}
+
+	static inline double entropy_size(const uint32_t* hist, size_t bytes) noexcept
+	{
+		// Estimated size (bytes) of an order-0 entropy coder for given byte histogram.
+		// Uses the Miller-Madow correction to reduce the bias on small inputs.
+		double bits = c_log2_c(bytes);
+		unsigned distinct = 0;
+		for (unsigned i = 0; i < 256; ++i) {
+			if (hist[i]) {
+				bits -= c_log2_c(hist[i]);
+				++distinct;
+			}
+		}
+		if (distinct)
+			bits += (double)(distinct - 1) / (2. * 0.6931471805599453);
+		return bits / 8.;
+	}
+
+	static STENOS_ALWAYS_INLINE void add_histogram(uint32_t* hist, const uint8_t* src, size_t bytes) noexcept
+	{
+		for (size_t i = 0; i < bytes; ++i)
+			++hist[src[i]];
+	}
+
+	static int guess_superblock_mode(stenos_context_s* ctx, const void* src, const void* shuffled, size_t bytesoftype, size_t bytes, int level, char* scratch) noexcept
+	{
+		// Pick the superblock compression mode up front instead of running trial encodings.
+		// All strategies are scored on up to 4 blocks of 256 elements spread over the superblock
+		// using the byte entropy of raw, transposed, transposed + delta, (for 4 or 8 bytes types)
+		// transposed + XOR + bit transposed and (for 2, 4 or 8 bytes types) element-wise delta data, the dry lz4
+		// estimate, and the actual block compression of the samples.
+		// shuffled is the transposed superblock. scratch must hold 4 blocks of 256 elements.
+		// Returns the superblock header code of the selected mode (STENOS_FRAME_HEADER_BLOCK_ZSTD
+		// meaning block compression followed by zstd), or 0 if undecided.
+
+		const size_t block_size = bytesoftype * 256;
+		const size_t blocks = bytes / block_size;
+		const size_t elements = bytes / bytesoftype;
+		const size_t samples = blocks < 4 ? blocks : 4;
+		uint8_t* transposed = (uint8_t*)scratch;
+		uint8_t* deltas = transposed + block_size;
+		uint8_t* cblock = deltas + block_size;
+		const int accel = 10 - level;
+		const bool floating = bytesoftype == 4 || bytesoftype == 8;
+		const bool integral = bytesoftype == 2 || floating;
+		size_t sample_pos[4];
+
+		// Per mode (indexed by superblock header): bytes given to zstd, entropy estimate and dry lz4 size
+		double in[STENOS_FRAME_HEADER_INT_DELTA2_ZSTD + 1] = { 0 };
+		double ent[STENOS_FRAME_HEADER_INT_DELTA2_ZSTD + 1] = { 0 };
+		double lz[STENOS_FRAME_HEADER_INT_DELTA2_ZSTD + 1] = { 0 };
+		uint32_t raw_hist[256] = { 0 };
+		uint32_t block_hist[256] = { 0 };
+		// Per plane histograms of XOR, delta and delta of delta data
+		uint32_t plane_hist[3][8][256];
+		if (integral)
+			memset(plane_hist, 0, sizeof(plane_hist));
+
+		for (size_t s = 0; s < samples; ++s) {
+
+			const size_t b = sample_pos[s] = (2 * s + 1) * blocks / (2 * samples);
+			const uint8_t* raw = (const uint8_t*)src + b * block_size;
+
+			// Raw data
+			in[STENOS_FRAME_HEADER_ZSTD] += (double)block_size;
+			add_histogram(raw_hist, raw, block_size);
+			lz[STENOS_FRAME_HEADER_ZSTD] += (double)stenos::lz4_guess_size((const char*)raw, block_size, accel);
+
+			// Block compression, followed by zstd
+			size_t c = stenos::block_compress_generic(raw, bytesoftype, block_size, cblock, 2 * block_size, 2, level, ctx->t, nullptr, nullptr);
+			if (has_error(c) || c > block_size) {
+				c = block_size;
+				memcpy(cblock, raw, block_size);
+			}
+			in[STENOS_FRAME_HEADER_BLOCK_ZSTD] += (double)c;
+			add_histogram(block_hist, cblock, c);
+			lz[STENOS_FRAME_HEADER_BLOCK_ZSTD] += (double)stenos::lz4_guess_size((const char*)cblock, c, accel);
+
+			if (bytesoftype == 1)
+				continue;
+
+			// Transposed data, with and without delta
+			for (size_t j = 0; j < bytesoftype; ++j)
+				memcpy(transposed + j * 256, (const uint8_t*)shuffled + j * elements + b * 256, 256);
+			delta(transposed, deltas, block_size);
+			in[STENOS_FRAME_HEADER_TRANSPOSED_ZSTD] += (double)block_size;
+			in[STENOS_FRAME_HEADER_TRANSPOSED_DELTA_ZSTD] += (double)block_size;
+			lz[STENOS_FRAME_HEADER_TRANSPOSED_ZSTD] += (double)stenos::lz4_guess_size((const char*)transposed, block_size, accel);
+			lz[STENOS_FRAME_HEADER_TRANSPOSED_DELTA_ZSTD] += (double)stenos::lz4_guess_size((const char*)deltas, block_size, accel);
+
+			if (floating) {
+				// XOR + bit transposition of each plane, deltas is reused
+				for (size_t j = 0; j < bytesoftype; ++j) {
+					xor_bitshuffle(1, 256, transposed + j * 256, deltas + j * 256);
+					add_histogram(plane_hist[0][j], deltas + j * 256, 256);
+				}
+				in[STENOS_FRAME_HEADER_XOR_ZSTD] += (double)block_size;
+				lz[STENOS_FRAME_HEADER_XOR_ZSTD] += (double)stenos::lz4_guess_size((const char*)deltas, block_size, accel);
+			}
+
+			if (integral) {
+				// Element-wise delta and delta of delta, cblock is reused
+				for (int order = 1; order <= 2; ++order) {
+					const int m = order == 1 ? STENOS_FRAME_HEADER_INT_DELTA_ZSTD : STENOS_FRAME_HEADER_INT_DELTA2_ZSTD;
+					int_delta_shuffle(bytesoftype, block_size, order, raw, cblock);
+					for (size_t j = 0; j < bytesoftype; ++j)
+						add_histogram(plane_hist[order][j], cblock + j * 256, 256);
+					in[m] += (double)block_size;
+					lz[m] += (double)stenos::lz4_guess_size((const char*)cblock, block_size, accel);
+				}
+			}
+		}
+		ent[STENOS_FRAME_HEADER_ZSTD] = entropy_size(raw_hist, (size_t)in[STENOS_FRAME_HEADER_ZSTD]);
+		ent[STENOS_FRAME_HEADER_BLOCK_ZSTD] = entropy_size(block_hist, (size_t)in[STENOS_FRAME_HEADER_BLOCK_ZSTD]);
+
+		if (bytesoftype > 1) {
+			// Entropy of transposed data, with and without delta, computed per byte plane over all samples
+			for (size_t j = 0; j < bytesoftype; ++j) {
+				uint32_t tr_hist[256] = { 0 };
+				uint32_t de_hist[256] = { 0 };
+				for (size_t s = 0; s < samples; ++s) {
+					const uint8_t* p = (const uint8_t*)shuffled + j * elements + sample_pos[s] * 256;
+					uint8_t prev = sample_pos[s] ? p[-1] : 0;
+					for (size_t i = 0; i < 256; ++i) {
+						++tr_hist[p[i]];
+						++de_hist[(uint8_t)(p[i] - prev)];
+						prev = p[i];
+					}
+				}
+				ent[STENOS_FRAME_HEADER_TRANSPOSED_ZSTD] += entropy_size(tr_hist, samples * 256);
+				ent[STENOS_FRAME_HEADER_TRANSPOSED_DELTA_ZSTD] += entropy_size(de_hist, samples * 256);
+				if (floating)
+					ent[STENOS_FRAME_HEADER_XOR_ZSTD] += entropy_size(plane_hist[0][j], samples * 256);
+				if (integral) {
+					ent[STENOS_FRAME_HEADER_INT_DELTA_ZSTD] += entropy_size(plane_hist[1][j], samples * 256);
+					ent[STENOS_FRAME_HEADER_INT_DELTA2_ZSTD] += entropy_size(plane_hist[2][j], samples * 256);
+				}
+			}
+		}
+
+		static const int modes[7] = { STENOS_FRAME_HEADER_BLOCK_ZSTD,
+					      STENOS_FRAME_HEADER_ZSTD,
+					      STENOS_FRAME_HEADER_TRANSPOSED_ZSTD,
+					      STENOS_FRAME_HEADER_TRANSPOSED_DELTA_ZSTD,
+					      STENOS_FRAME_HEADER_INT_DELTA_ZSTD,
+					      STENOS_FRAME_HEADER_INT_DELTA2_ZSTD,
+					      STENOS_FRAME_HEADER_XOR_ZSTD };
+		const int count = bytesoftype == 1 ? 2 : (floating ? 7 : (integral ? 6 : 4));
+		double est[STENOS_FRAME_HEADER_INT_DELTA2_ZSTD + 1] = { 0 };
+		int best = modes[0];
+		for (int i = 0; i < count; ++i) {
+			// The entropy and lz estimates capture different redundancies and cannot be simply combined.
+			// Their product is used when lz finds few matches, otherwise the cheap lz4 heuristic
+			// (zstd ratio at least 1.4 times the lz4 ratio) bounded by the entropy.
+			const int m = modes[i];
+			const double product = ent[m] * (lz[m] < in[m] ? lz[m] / in[m] : 1.);
+			const double bound = std::min(ent[m], lz[m] / 1.4);
+			est[m] = m == STENOS_FRAME_HEADER_BLOCK_ZSTD ? product : std::max(product, bound);
+			if (m == STENOS_FRAME_HEADER_XOR_ZSTD)
+				// Order-0 entropy overestimates zstd gains on bit planes of noisy mantissas
+				est[m] *= 1.2;
+			if (est[m] < est[best])
+				best = m;
+		}
+
+		if (est[best] > 0.98 * in[STENOS_FRAME_HEADER_ZSTD])
+			// Incompressible: zstd quickly falls back to a copy
+			return STENOS_FRAME_HEADER_ZSTD;
+
+		if (est[best] * 32 < in[STENOS_FRAME_HEADER_ZSTD])
+			// Highly compressible: a few bytes of estimate per sample cannot rank the
+			// candidates (e.g. long runs of 1 byte values), and trial encodings are cheap
+			return 0;
+
+		// Undecided: let the caller run the trial encodings
+		for (int i = 0; i < count; ++i)
+			if (modes[i] != best && est[modes[i]] <= est[best] * 1.1)
+				return 0;
+		return best;
+	}
+
 	static STENOS_ALWAYS_INLINE size_t
-	compress_generic_superblock(stenos_context_s* ctx, const void* src, size_t bytesoftype, size_t bytes, void* _dst, size_t dst_size, CBuffer*& buffer1, CBuffer*& buffer2) noexcept
+	zstd_compress_superblock(stenos_context_s* ctx, void* dst, size_t dst_size, const void* src, size_t bytes, int level, size_t bytesoftype = 0) noexcept
+	{
+		// zstd compression using the context dictionary, if any.
+		// If bytesoftype is not 0, the compression rate is recorded in the context rate model.
+		size_t r = 0;
+		stenos::timer timer;
+		timer.tick();
+		if (!ctx->dict)
+			r = zstd_compress_with_context(dst, dst_size, src, bytes, level);
+		else {
+			ZSTD_CDict* cdict = ctx->dict->cdict(level);
+			if STENOS_UNLIKELY (!cdict)
+				return STENOS_ERROR_ALLOC;
+			r = zstd_compress_with_context(dst, dst_size, src, bytes, level, cdict);
+		}
+		if (bytesoftype)
+			ctx->t.rates.record(STENOS_RATE_ZSTD, level, bytesoftype, bytes, timer.tock());
+		return r;
+	}
+
+	static STENOS_ALWAYS_INLINE size_t compress_generic_superblock(stenos_context_s* ctx,
+								       const void* src,
+								       size_t bytesoftype,
+								       size_t bytes,
+								       void* _dst,
+								       size_t dst_size,
+								       CBuffer*& buffer1,
+								       CBuffer*& buffer2,
+								       stenos_superblock_stats* st = nullptr) noexcept
 	{
 		// Compress a superblock and returns the compressed size.
 		// Check different strategies and pick the best one among:
 		//	- SIMD based block compression by chunk of 256 elements. Combination of delta coding, bit packing, RLE, basic LZ (+ ZSTD over block compression)
 		//	- Direct ZSTD compression
 		//	- ZSTD compression on transposed input (similar to blosc)
-		//	- ZSTD compression on transposed input + byte delta.
+		//	- ZSTD compression on transposed input + byte delta
+		//	- ZSTD compression on transposed input XORed with the previous element and bit transposed (floating point data)
+		//	- ZSTD compression on transposed element-wise delta or delta of delta (integers).
 		//
 		// The output size is at most bytes + 4.
+		// If st is not null, time spent in each step, zstd level and forced memcpy are recorded.
 
 		STENOS_ASSERT_DEBUG(bytes % bytesoftype == 0, "invalid input byte size");
 
-		// Check SSE4.1 support
-		static const bool no_sse = !stenos::cpu_features().HAS_SSE41;
+		// Check SSE4.1 (or NEON) support
+		static const bool no_sse = !stenos::cpu_features().HAS_SSE41 && !stenos::cpu_features().HAS_NEON;
 
 		size_t result = 0;
 		uint8_t* dst = (uint8_t*)_dst;
@@ -423,14 +1616,28 @@ namespace stenos
 		const bool time_limited = ctx->t.nanoseconds != 0;
 		int block_level = 2, zstd_level = 0;
 		int level = time_limited ? 9 : ctx->level;
+		int delta_order = 1; // element-wise delta order for INT_DELTA_ZSTD
 
 		if STENOS_UNLIKELY (dst_size < 4)
 			// We need at least 4 bytes to write the superblock header
 			return STENOS_ERROR_DST_OVERFLOW;
 
-		if STENOS_UNLIKELY (bytes == 0 || ctx->t.finish_memcpy.load(std::memory_order_relaxed) || (ctx->level == 0 && !time_limited))
+		if STENOS_UNLIKELY (bytes == 0 || ctx->t.finish_memcpy.load(std::memory_order_relaxed) || (ctx->level == 0 && !time_limited)) {
 			// Empty input or too slow compression: direct copy
+			if (st && time_limited)
+				st->forced_memcpy = 1;
 			goto MEMCPY;
+		}
+
+		if (ctx->min_decompression_speed) {
+			// Minimum decompression speed: discard the slowest modes up front
+			if (!ctx->mode_allowed(STENOS_FRAME_HEADER_BLOCK))
+				goto MEMCPY;
+			if (!ctx->mode_allowed(STENOS_FRAME_HEADER_TRANSPOSED_ZSTD) && !ctx->mode_allowed(STENOS_FRAME_HEADER_TRANSPOSED_DELTA_ZSTD) &&
+			    !ctx->mode_allowed(STENOS_FRAME_HEADER_XOR_ZSTD) && !ctx->mode_allowed(STENOS_FRAME_HEADER_INT_DELTA_ZSTD) &&
+			    !ctx->mode_allowed(STENOS_FRAME_HEADER_INT_DELTA2_ZSTD) && !ctx->mode_allowed(STENOS_FRAME_HEADER_ZSTD))
+				goto BLOCK;
+		}
 
 		if (bytes < 128)
 			// Small input: direct zstd
@@ -466,13 +1673,16 @@ namespace stenos
 			double target_speed = 0;	      // requested speed in bytes/second
 			double lz_transposed_ratio = 0;	      // lz ratio on transposed input
 			double lz_transposed_delta_ratio = 0; // lz ratio on transposed input + delta
+			double lz_xor_ratio = 0;	      // lz ratio on transposed input + XOR + bit transposition
+			double lz_int_delta_ratio = 0;	      // lz ratio on element-wise delta + transposed input
+			double lz_int_delta2_ratio = 0;	      // lz ratio on element-wise delta of delta + transposed input
 			double lz_ratio = 1.1;		      // lz ratio on raw input. 1.1 is high enough to discard block compression on "uncompressible" content (like text)
 
 			if (time_limited) {
 
 				// Compute requested speed in bytes/second.
 				// Uses remaining bytes and time.
-				target_speed = ctx->requested_speed();
+				target_speed = ctx->requested_speed(bytesoftype);
 
 				// Adjust level used to guess lz compression ratio.
 				if (target_speed < 10000000)
@@ -489,8 +1699,13 @@ namespace stenos
 					glevel = 2;
 			}
 
-			if (target_speed < 600000000 && bytes >= bytesoftype * 256) {
+			// Use the sampled mode estimator instead of trial encodings for levels below exhaustive_level.
+			// Requires at least 4 blocks of 256 elements.
+			const bool sampled = !time_limited && !no_sse && level > 2 && level < ctx->exhaustive_level && bytes >= bytesoftype * 256 * 4;
+
+			if (!sampled && target_speed < 600000000 && bytes >= bytesoftype * 256) {
 				// If high speed required (above 600MB/s), don't check for lz ratio
+				StatTimer _t(st ? &st->guess_ns : nullptr);
 				lz_ratio = lz4_guess_ratio((const char*)src, bytes / 16, 10 - glevel);
 			}
 
@@ -501,22 +1716,54 @@ namespace stenos
 
 			// Create the buffers
 			if (!buffer1)
-				buffer1 = CBuffer::make(ctx->superblock_size + 4); // Add 4 for the superblock header
+				buffer1 = ctx->make_buffer();
 			if (!buffer2)
-				buffer2 = CBuffer::make(ctx->superblock_size + 4); // Add 4 for the superblock header
+				buffer2 = ctx->make_buffer();
 			if STENOS_UNLIKELY (!buffer1 || !buffer2)
 				goto ZSTD;
 
 			if (bytesoftype > 1) {
 
 				// Transpose in buffer
+				StatTimer _t(st ? &st->shuffle_ns : nullptr);
 				shuffle(bytesoftype, bytes, (uint8_t*)src, (uint8_t*)buffer1->bytes);
+			}
+
+			// Mode picked by the sampled estimator, 0 to run the trial encodings
+			int mode = 0;
+			if (sampled) {
+				// buffer2 is used as scratch memory
+				{
+					StatTimer _t(st ? &st->guess_ns : nullptr);
+					mode = guess_superblock_mode(ctx, src, buffer1->bytes, bytesoftype, bytes, level, buffer2->bytes);
+				}
+				if (mode == STENOS_FRAME_HEADER_ZSTD)
+					goto ZSTD;
+				if (mode == STENOS_FRAME_HEADER_TRANSPOSED_ZSTD)
+					goto TRANSPOSED_ZSTD;
+				if (mode == STENOS_FRAME_HEADER_TRANSPOSED_DELTA_ZSTD)
+					goto TRANSPOSED_DELTA_ZSTD;
+				if (mode == STENOS_FRAME_HEADER_XOR_ZSTD)
+					goto XOR_ZSTD;
+				if (mode == STENOS_FRAME_HEADER_INT_DELTA_ZSTD || mode == STENOS_FRAME_HEADER_INT_DELTA2_ZSTD) {
+					delta_order = mode == STENOS_FRAME_HEADER_INT_DELTA_ZSTD ? 1 : 2;
+					goto INT_DELTA_ZSTD;
+				}
+				if (mode == 0) {
+					StatTimer _t(st ? &st->guess_ns : nullptr);
+					lz_ratio = lz4_guess_ratio((const char*)src, bytes / 16, 10 - glevel);
+				}
+				// Otherwise block compression (+ zstd), falls back to direct zstd on failure
+			}
+
+			if (mode == 0 && bytesoftype > 1) {
 
 				if (no_sse || (target_speed < 600000000 && bytes >= bytesoftype * 256 && level > 2)) {
 
 					// If high speed required (or level <= 2), don't check for lz ratio on transposed input.
 					// Always do it if SSE4.1 is not available.
 
+					StatTimer _t(st ? &st->guess_ns : nullptr);
 					lz_transposed_ratio = guess_transposed_lz_ratio(buffer1->bytes, bytesoftype, bytes, glevel, 0);
 					if (lz_transposed_ratio > lz_ratio)
 						lz_ratio = lz_transposed_ratio;
@@ -525,6 +1772,23 @@ namespace stenos
 					if (lz_transposed_delta_ratio > lz_ratio)
 						lz_ratio = lz_transposed_delta_ratio;
 
+					if (bytesoftype == 4 || bytesoftype == 8) {
+						// Floating point candidate, penalized as lz4 favors zero bit planes over zstd
+						lz_xor_ratio = guess_xor_lz_ratio(buffer1->bytes, bytesoftype, bytes, glevel, buffer2) * 0.9;
+						if (lz_xor_ratio > lz_ratio)
+							lz_ratio = lz_xor_ratio;
+					}
+
+					if (bytesoftype == 2 || bytesoftype == 4 || bytesoftype == 8) {
+						// Element-wise prediction candidates
+						lz_int_delta_ratio = guess_int_delta_lz_ratio(src, bytesoftype, bytes, glevel, 1, buffer2);
+						if (lz_int_delta_ratio > lz_ratio)
+							lz_ratio = lz_int_delta_ratio;
+						lz_int_delta2_ratio = guess_int_delta_lz_ratio(src, bytesoftype, bytes, glevel, 2, buffer2);
+						if (lz_int_delta2_ratio > lz_ratio)
+							lz_ratio = lz_int_delta2_ratio;
+					}
+
 					if (target_speed < 2000000 ) {
 						// Try to favor ZSTD compression
 						// as it usually always outperform block compression
@@ -532,19 +1796,33 @@ namespace stenos
 						const double factor = 1. + level / 12.;
 						lz_transposed_ratio *= factor;
 						lz_transposed_delta_ratio *= factor;
+						lz_xor_ratio *= factor;
+						lz_int_delta_ratio *= factor;
+						lz_int_delta2_ratio *= factor;
 						lz_ratio *= factor;
 					}
 				}
 			}
-			else if (target_speed < 2000000 /* && level == 9*/) {
+			else if (mode == 0 && target_speed < 2000000 /* && level == 9*/) {
 				const double factor = 1. + level /12.;
 				lz_ratio *= factor;
 			}
 
 			// Try block compression
 			uint64_t tick = time_limited ? ctx->t.timer.tock() : 0;
+			stenos::timer block_timer;
+			block_timer.tick();
 			size_t cblock =
 			  stenos::block_compress_generic(src, bytesoftype, bytes, buffer2->bytes, bytes, block_level, level, ctx->t, &lz_ratio, bytesoftype > 1 ? buffer1->bytes : nullptr);
+			uint64_t block_el = block_timer.tock();
+			if (st)
+				st->block_ns += block_el;
+			if (!ctx->t.finish_memcpy.load(std::memory_order_relaxed)) {
+				if (!has_error(cblock))
+					ctx->t.rates.record(STENOS_RATE_BLOCK, block_level, bytesoftype, bytes, block_el);
+			}
+			else if (st)
+				st->forced_memcpy = 1;
 			if (has_error(cblock) || cblock > bytes) {
 				// Failed: compression ratio too low
 				if (lz_ratio > 1.40) {
@@ -553,6 +1831,12 @@ namespace stenos
 						goto TRANSPOSED_ZSTD;
 					if (lz_ratio == lz_transposed_delta_ratio)
 						goto TRANSPOSED_DELTA_ZSTD;
+					if (lz_ratio == lz_xor_ratio)
+						goto XOR_ZSTD;
+					if (lz_ratio == lz_int_delta_ratio || lz_ratio == lz_int_delta2_ratio) {
+						delta_order = lz_ratio == lz_int_delta_ratio ? 1 : 2;
+						goto INT_DELTA_ZSTD;
+					}
 				}
 				goto ZSTD;
 			}
@@ -562,16 +1846,17 @@ namespace stenos
 				// Compute required compression level for zstd
 
 				auto el = ctx->t.timer.tock();
-				auto block_el = el - tick;
+				auto block_tick_el = el - tick;
 
 				size_t processed = ctx->t.processed_bytes.load(std::memory_order_relaxed) + cblock;
 				double global_block_speed = processed / (el * 1e-9);
-				double current_block_speed = bytes / (block_el * 1e-9);
+				double current_block_speed = bytes / (block_tick_el * 1e-9);
+				double raw_speed = target_speed / ctx->t.rates.host_factor(bytesoftype); // requested speed on this host
 
 				zstd_level = 0;
-				if (global_block_speed > target_speed && current_block_speed > target_speed) {
-					size_t zstd_rate = (size_t)((current_block_speed * target_speed) / (current_block_speed - target_speed));
-					zstd_level = detail::clevel_for_remaining(ctx->t, processed, &zstd_rate, 1);
+				if (global_block_speed > raw_speed && current_block_speed > raw_speed) {
+					size_t zstd_rate = (size_t)((current_block_speed * raw_speed) / (current_block_speed - raw_speed));
+					zstd_level = detail::clevel_for_remaining(ctx->t, bytesoftype, processed, &zstd_rate, 1);
 				}
 
 				if (zstd_level < 1)
@@ -579,8 +1864,15 @@ namespace stenos
 					goto NO_ZSTD;
 			}
 
+			if (!ctx->mode_allowed(STENOS_FRAME_HEADER_BLOCK_ZSTD))
+				// Too slow to decompress
+				goto NO_ZSTD;
+
 			// Try zstd on compressed blocks
-			result = zstd_compress_with_context(dst + 4, dst_size - 4, buffer2->bytes, cblock, zstd_level);
+			{
+				StatTimer _t(st ? &st->zstd_ns : nullptr);
+				result = zstd_compress_superblock(ctx, dst + 4, dst_size - 4, buffer2->bytes, cblock, zstd_level);
+			}
 
 			if (has_error(result) || result > cblock) {
 			NO_ZSTD:
@@ -591,11 +1883,14 @@ namespace stenos
 				*dst++ = STENOS_FRAME_HEADER_BLOCK;
 				write_uint32_3(dst, (unsigned)cblock);
 				dst += 3;
+				StatTimer _t(st ? &st->memcpy_ns : nullptr);
 				memcpy(dst, buffer2->bytes, cblock);
 				return cblock + 4;
 			}
 
 			// Block compression + zstd
+			if (st)
+				st->level = zstd_level;
 			if STENOS_UNLIKELY (dst + 4 + result > dst_end)
 				return STENOS_ERROR_DST_OVERFLOW;
 			*dst++ = STENOS_FRAME_HEADER_BLOCK_ZSTD;
@@ -605,9 +1900,22 @@ namespace stenos
 
 	BLOCK:
 		// Direct block compression
-		result = block_compress_generic(src, bytesoftype, bytes, dst + 4, dst_size - 4, block_level, level, ctx->t, nullptr, nullptr);
-		if (has_error(result) || result > bytes)
-			goto MEMCPY;
+		{
+			stenos::timer block_timer;
+			block_timer.tick();
+			result = block_compress_generic(src, bytesoftype, bytes, dst + 4, dst_size - 4, block_level, level, ctx->t, nullptr, nullptr);
+			uint64_t block_el = block_timer.tock();
+			if (st)
+				st->block_ns += block_el;
+			if (!ctx->t.finish_memcpy.load(std::memory_order_relaxed)) {
+				if (!has_error(result))
+					ctx->t.rates.record(STENOS_RATE_BLOCK, block_level, bytesoftype, bytes, block_el);
+			}
+			else if (st)
+				st->forced_memcpy = 1;
+			if (has_error(result) || result > bytes)
+				goto MEMCPY;
+		}
 		if STENOS_UNLIKELY (dst + 4 + result > dst_end)
 			return STENOS_ERROR_DST_OVERFLOW;
 		*dst++ = STENOS_FRAME_HEADER_BLOCK;
@@ -616,17 +1924,27 @@ namespace stenos
 
 	TRANSPOSED_ZSTD:
 		// zstd over transposed input
+		if (!ctx->mode_allowed(STENOS_FRAME_HEADER_TRANSPOSED_ZSTD))
+			goto BLOCK;
 		if (ctx->t.nanoseconds) {
 			size_t processed = ctx->t.processed_bytes.load(std::memory_order_relaxed);
-			zstd_level = detail::clevel_for_remaining(ctx->t, processed);
-			if (zstd_level <= 0)
+			zstd_level = detail::clevel_for_remaining(ctx->t, bytesoftype, processed);
+			if (zstd_level <= 0) {
+				if (st)
+					st->forced_memcpy = 1;
 				goto MEMCPY;
+			}
 		}
 
 		// Compress
-		result = zstd_compress_with_context(dst + 4, dst_size - 4, buffer1->bytes, bytes, zstd_level);
+		{
+			StatTimer _t(st ? &st->zstd_ns : nullptr);
+			result = zstd_compress_superblock(ctx, dst + 4, dst_size - 4, buffer1->bytes, bytes, zstd_level, bytesoftype);
+		}
 		if STENOS_UNLIKELY (has_error(result) || result > bytes)
 			goto MEMCPY;
+		if (st)
+			st->level = zstd_level;
 		if STENOS_UNLIKELY (dst + 4 + result > dst_end)
 			return STENOS_ERROR_DST_OVERFLOW;
 		*dst++ = STENOS_FRAME_HEADER_TRANSPOSED_ZSTD;
@@ -635,38 +1953,131 @@ namespace stenos
 
 	TRANSPOSED_DELTA_ZSTD:
 		// zstd over transposed input + byte delta
+		if (!ctx->mode_allowed(STENOS_FRAME_HEADER_TRANSPOSED_DELTA_ZSTD))
+			goto BLOCK;
 		if (ctx->t.nanoseconds) {
 			size_t processed = ctx->t.processed_bytes.load(std::memory_order_relaxed);
-			zstd_level = detail::clevel_for_remaining(ctx->t, processed);
-			if (zstd_level <= 0)
+			zstd_level = detail::clevel_for_remaining(ctx->t, bytesoftype, processed);
+			if (zstd_level <= 0) {
+				if (st)
+					st->forced_memcpy = 1;
 				goto MEMCPY;
+			}
 		}
 
 		// Fast byte delta
-		delta(buffer1->bytes, buffer2->bytes, bytes);
+		{
+			StatTimer _t(st ? &st->shuffle_ns : nullptr);
+			delta(buffer1->bytes, buffer2->bytes, bytes);
+		}
 
 		// Compress
-		result = zstd_compress_with_context(dst + 4, dst_size - 4, buffer2->bytes, bytes, zstd_level);
+		{
+			StatTimer _t(st ? &st->zstd_ns : nullptr);
+			result = zstd_compress_superblock(ctx, dst + 4, dst_size - 4, buffer2->bytes, bytes, zstd_level, bytesoftype);
+		}
 		if STENOS_UNLIKELY (has_error(result) || result > bytes)
 			goto MEMCPY;
+		if (st)
+			st->level = zstd_level;
 		if STENOS_UNLIKELY (dst + 4 + result > dst_end)
 			return STENOS_ERROR_DST_OVERFLOW;
 		*dst++ = STENOS_FRAME_HEADER_TRANSPOSED_DELTA_ZSTD;
 		write_uint32_3(dst, (unsigned)result);
 		return result + 4;
 
+	XOR_ZSTD:
+		// zstd over transposed input XORed with the previous element and bit transposed
+		if (!ctx->mode_allowed(STENOS_FRAME_HEADER_XOR_ZSTD))
+			goto BLOCK;
+		if (ctx->t.nanoseconds) {
+			size_t processed = ctx->t.processed_bytes.load(std::memory_order_relaxed);
+			zstd_level = detail::clevel_for_remaining(ctx->t, bytesoftype, processed);
+			if (zstd_level <= 0) {
+				if (st)
+					st->forced_memcpy = 1;
+				goto MEMCPY;
+			}
+		}
+
+		// XOR and bit transposition
+		{
+			StatTimer _t(st ? &st->shuffle_ns : nullptr);
+			xor_bitshuffle(bytesoftype, bytes, buffer1->bytes, buffer2->bytes);
+		}
+
+		// Compress
+		{
+			StatTimer _t(st ? &st->zstd_ns : nullptr);
+			result = zstd_compress_superblock(ctx, dst + 4, dst_size - 4, buffer2->bytes, bytes, zstd_level, bytesoftype);
+		}
+		if STENOS_UNLIKELY (has_error(result) || result > bytes)
+			goto MEMCPY;
+		if (st)
+			st->level = zstd_level;
+		if STENOS_UNLIKELY (dst + 4 + result > dst_end)
+			return STENOS_ERROR_DST_OVERFLOW;
+		*dst++ = STENOS_FRAME_HEADER_XOR_ZSTD;
+		write_uint32_3(dst, (unsigned)result);
+		return result + 4;
+
+	INT_DELTA_ZSTD:
+		// zstd over element-wise delta (delta_order 1) or delta of delta (delta_order 2) + transposed input
+		if (!ctx->mode_allowed(delta_order == 1 ? STENOS_FRAME_HEADER_INT_DELTA_ZSTD : STENOS_FRAME_HEADER_INT_DELTA2_ZSTD))
+			goto BLOCK;
+		if (ctx->t.nanoseconds) {
+			size_t processed = ctx->t.processed_bytes.load(std::memory_order_relaxed);
+			zstd_level = detail::clevel_for_remaining(ctx->t, bytesoftype, processed);
+			if (zstd_level <= 0) {
+				if (st)
+					st->forced_memcpy = 1;
+				goto MEMCPY;
+			}
+		}
+
+		// Element-wise delta and transposition
+		{
+			StatTimer _t(st ? &st->shuffle_ns : nullptr);
+			int_delta_shuffle(bytesoftype, bytes, delta_order, src, buffer2->bytes);
+		}
+
+		// Compress
+		{
+			StatTimer _t(st ? &st->zstd_ns : nullptr);
+			result = zstd_compress_superblock(ctx, dst + 4, dst_size - 4, buffer2->bytes, bytes, zstd_level, bytesoftype);
+		}
+		if STENOS_UNLIKELY (has_error(result) || result > bytes)
+			goto MEMCPY;
+		if (st)
+			st->level = zstd_level;
+		if STENOS_UNLIKELY (dst + 4 + result > dst_end)
+			return STENOS_ERROR_DST_OVERFLOW;
+		*dst++ = delta_order == 1 ? STENOS_FRAME_HEADER_INT_DELTA_ZSTD : STENOS_FRAME_HEADER_INT_DELTA2_ZSTD;
+		write_uint32_3(dst, (unsigned)result);
+		return result + 4;
+
 	ZSTD:
 		// Direct zstd compression
+		if (!ctx->mode_allowed(STENOS_FRAME_HEADER_ZSTD))
+			goto BLOCK;
 		if (ctx->t.nanoseconds) {
 			size_t processed = ctx->t.processed_bytes.load(std::memory_order_relaxed);
-			zstd_level = detail::clevel_for_remaining(ctx->t, processed);
-			if (zstd_level <= 0)
+			zstd_level = detail::clevel_for_remaining(ctx->t, bytesoftype, processed);
+			if (zstd_level <= 0) {
+				if (st)
+					st->forced_memcpy = 1;
 				goto MEMCPY;
+			}
+		}
+		{
+			StatTimer _t(st ? &st->zstd_ns : nullptr);
+			result = zstd_compress_superblock(ctx, dst + 4, dst_size - 4, src, bytes, zstd_level, bytesoftype);
 		}
-		result = zstd_compress_with_context(dst + 4, dst_size - 4, src, bytes, zstd_level);
 
 		if STENOS_UNLIKELY (has_error(result) || result > bytes)
 			goto MEMCPY;
+		if (st)
+			st->level = zstd_level;
 		if STENOS_UNLIKELY (dst + 4 + result > dst_end)
 			return STENOS_ERROR_DST_OVERFLOW;
 		*dst++ = STENOS_FRAME_HEADER_ZSTD;
@@ -675,11 +2086,192 @@ namespace stenos
 
 	MEMCPY:
 		// Use memcpy
+		if (st)
+			st->level = 0;
+		StatTimer _t(st ? &st->memcpy_ns : nullptr);
 		return compress_memcpy(src, bytes, _dst, dst_size);
 	}
 
-	static STENOS_ALWAYS_INLINE size_t
-	decompress_generic_superblock(stenos_context_s* ctx, uint8_t code, const uint8_t* src, size_t bytesoftype, size_t csize, uint8_t* dst, size_t dsize, CBuffer*& buffer) noexcept
+	template<size_t FieldSize>
+	static STENOS_ALWAYS_INLINE void split_field(const uint8_t* src, size_t stride, size_t n, uint8_t* dst) noexcept
+	{
+		for (size_t i = 0; i < n; ++i, src += stride, dst += FieldSize)
+			memcpy(dst, src, FieldSize);
+	}
+	template<size_t FieldSize>
+	static STENOS_ALWAYS_INLINE void merge_field(const uint8_t* src, size_t stride, size_t n, uint8_t* dst) noexcept
+	{
+		for (size_t i = 0; i < n; ++i, src += FieldSize, dst += stride)
+			memcpy(dst, src, FieldSize);
+	}
+
+	static void split_fields(const std::vector<size_t>& layout, size_t bytesoftype, size_t n, const uint8_t* src, uint8_t* dst) noexcept
+	{
+		// De-interleave n records into one column per field
+		for (size_t f : layout) {
+			switch (f) {
+				case 1:
+					split_field<1>(src, bytesoftype, n, dst);
+					break;
+				case 2:
+					split_field<2>(src, bytesoftype, n, dst);
+					break;
+				case 4:
+					split_field<4>(src, bytesoftype, n, dst);
+					break;
+				case 8:
+					split_field<8>(src, bytesoftype, n, dst);
+					break;
+				default:
+					for (size_t i = 0; i < n; ++i)
+						memcpy(dst + i * f, src + i * bytesoftype, f);
+					break;
+			}
+			src += f;
+			dst += n * f;
+		}
+	}
+
+	static void merge_fields(const uint8_t* layout, size_t count, size_t bytesoftype, size_t n, const uint8_t* src, uint8_t* dst) noexcept
+	{
+		// Interleave columns back to n records, inverse of split_fields().
+		// layout stores count field sizes on 2 bytes each.
+		for (size_t j = 0; j < count; ++j) {
+			const size_t f = read_LE_16(layout + j * 2);
+			switch (f) {
+				case 1:
+					merge_field<1>(src, bytesoftype, n, dst);
+					break;
+				case 2:
+					merge_field<2>(src, bytesoftype, n, dst);
+					break;
+				case 4:
+					merge_field<4>(src, bytesoftype, n, dst);
+					break;
+				case 8:
+					merge_field<8>(src, bytesoftype, n, dst);
+					break;
+				default:
+					for (size_t i = 0; i < n; ++i)
+						memcpy(dst + i * bytesoftype, src + i * f, f);
+					break;
+			}
+			src += n * f;
+			dst += f;
+		}
+	}
+
+	static STENOS_NOINLINE(size_t) compress_layout_superblock(stenos_context_s* ctx,
+								   const void* src,
+								   size_t bytesoftype,
+								   size_t bytes,
+								   void* _dst,
+								   size_t dst_size,
+								   CBuffer*& buffer1,
+								   CBuffer*& buffer2,
+								   stenos_superblock_stats* st) noexcept
+	{
+		// Compress a superblock using the context field layout.
+		// Fields are de-interleaved in buffer1->aux and each column is compressed as a nested superblock.
+		// Layout:
+		//	- 4 bytes superblock header (STENOS_FRAME_HEADER_FIELDS and compressed size)
+		//	- 2 bytes field count, followed by 2 bytes per field size
+		//	- One superblock (with its own header) per field
+		// The output size is at most bytes + 4.
+
+		if STENOS_UNLIKELY (bytesoftype != ctx->layout_bytes)
+			return STENOS_ERROR_INVALID_BYTESOFTYPE;
+
+		const size_t count = ctx->layout.size();
+		const size_t header = 4 + 2 + count * 2;
+		if (count == 1 || bytes == 0 || bytes % bytesoftype != 0)
+			// Nothing to de-interleave, or partial trailing record (last superblock only)
+			return compress_generic_superblock(ctx, src, bytesoftype, bytes, _dst, dst_size, buffer1, buffer2, st);
+
+		if (!buffer1)
+			buffer1 = ctx->make_buffer();
+		if (buffer1 && !buffer1->aux)
+			buffer1->aux = ctx->make_buffer();
+		if STENOS_UNLIKELY (!buffer1 || !buffer1->aux)
+			return compress_generic_superblock(ctx, src, bytesoftype, bytes, _dst, dst_size, buffer1, buffer2, st);
+
+		uint8_t* dst = (uint8_t*)_dst;
+		uint8_t* dst_end = dst + std::min(dst_size, bytes + 4);
+		const size_t n = bytes / bytesoftype;
+		{
+			StatTimer _t(st ? &st->shuffle_ns : nullptr);
+			split_fields(ctx->layout, bytesoftype, n, (const uint8_t*)src, (uint8_t*)buffer1->aux->bytes);
+		}
+
+		if STENOS_UNLIKELY (dst + header > dst_end)
+			goto MEMCPY;
+		{
+			uint8_t* out = dst + 4;
+			write_LE_16(out, (uint16_t)count);
+			out += 2;
+			for (size_t f : ctx->layout) {
+				write_LE_16(out, (uint16_t)f);
+				out += 2;
+			}
+
+			const uint8_t* column = (const uint8_t*)buffer1->aux->bytes;
+			for (size_t f : ctx->layout) {
+				size_t r = compress_generic_superblock(ctx, column, f, n * f, out, dst_end - out, buffer1, buffer2, st);
+				if (has_error(r))
+					// Does not fit in bytes + 4
+					goto MEMCPY;
+				out += r;
+				column += n * f;
+			}
+
+			*dst = STENOS_FRAME_HEADER_FIELDS;
+			write_uint32_3(dst + 1, (unsigned)(out - dst - 4));
+			return out - dst;
+		}
+
+	MEMCPY:
+		if (st)
+			st->level = 0;
+		StatTimer _t(st ? &st->memcpy_ns : nullptr);
+		return compress_memcpy(src, bytes, _dst, dst_size);
+	}
+
+	static STENOS_ALWAYS_INLINE size_t compress_any_superblock(stenos_context_s* ctx,
+								   const void* src,
+								   size_t bytesoftype,
+								   size_t bytes,
+								   void* dst,
+								   size_t dst_size,
+								   CBuffer*& buffer1,
+								   CBuffer*& buffer2,
+								   stenos_superblock_stats* st = nullptr) noexcept
+	{
+		// Compress a superblock, using the field layout if any
+		if STENOS_UNLIKELY (ctx->layout_bytes)
+			return compress_layout_superblock(ctx, src, bytesoftype, bytes, dst, dst_size, buffer1, buffer2, st);
+		return compress_generic_superblock(ctx, src, bytesoftype, bytes, dst, dst_size, buffer1, buffer2, st);
+	}
+
+	static STENOS_NOINLINE(size_t) decompress_layout_superblock(stenos_context_s* ctx,
+								     const uint8_t* src,
+								     size_t bytesoftype,
+								     size_t csize,
+								     uint8_t* dst,
+								     size_t dsize,
+								     CBuffer*& buffer,
+								     ZSTD_DCtx*& dctx,
+								     const ZSTD_DDict* ddict) noexcept;
+
+	static STENOS_ALWAYS_INLINE size_t decompress_generic_superblock(stenos_context_s* ctx,
+									 uint8_t code,
+									 const uint8_t* src,
+									 size_t bytesoftype,
+									 size_t csize,
+									 uint8_t* dst,
+									 size_t dsize,
+									 CBuffer*& buffer,
+									 ZSTD_DCtx*& dctx,
+									 const ZSTD_DDict* ddict) noexcept
 	{
 		// Decompress a superblock
 
@@ -693,17 +2285,17 @@ namespace stenos
 			} break;
 			case STENOS_FRAME_HEADER_ZSTD: {
 				// Direct zstd compression
-				auto r = ZSTD_decompress(dst, dsize, src, csize);
+				auto r = zstd_decompress_with_context(dctx, dst, dsize, src, csize, ddict);
 				if STENOS_UNLIKELY (ZSTD_isError(r))
 					return STENOS_ERROR_INVALID_INPUT;
 			} break;
 			case STENOS_FRAME_HEADER_TRANSPOSED_ZSTD: {
 				// zstd on transposed input
 				if (!buffer)
-					buffer = CBuffer::make(ctx->superblock_size + 4); // Add 4 for the superblock header
+					buffer = ctx->make_buffer();
 				if STENOS_UNLIKELY (!buffer)
 					return STENOS_ERROR_ALLOC;
-				auto r = ZSTD_decompress(buffer->bytes, dsize, src, csize);
+				auto r = zstd_decompress_with_context(dctx, buffer->bytes, dsize, src, csize, ddict);
 				if STENOS_UNLIKELY (ZSTD_isError(r) || r != dsize)
 					return STENOS_ERROR_INVALID_INPUT;
 				unshuffle(bytesoftype, dsize, (uint8_t*)buffer->bytes, dst);
@@ -711,29 +2303,56 @@ namespace stenos
 			case STENOS_FRAME_HEADER_TRANSPOSED_DELTA_ZSTD: {
 				// zstd on transposed input + byte delta
 				if (!buffer)
-					buffer = CBuffer::make(ctx->superblock_size + 4); // Add 4 for the superblock header
+					buffer = ctx->make_buffer();
 				if STENOS_UNLIKELY (!buffer)
 					return STENOS_ERROR_ALLOC;
-				// Decomrpess to dst
-				auto r = ZSTD_decompress(dst, dsize, src, csize);
+				// Decompress to buffer
+				auto r = zstd_decompress_with_context(dctx, buffer->bytes, dsize, src, csize, ddict);
 				if STENOS_UNLIKELY (ZSTD_isError(r) || r != dsize)
 					return STENOS_ERROR_INVALID_INPUT;
-				// Byte delta inverse to buffer
-				delta_inv(dst, buffer->bytes, dsize);
-				// Unshuffle to dst
-				unshuffle(bytesoftype, dsize, (uint8_t*)buffer->bytes, dst);
+				// Byte delta inverse and unshuffle to dst in one pass
+				delta_inv_unshuffle(bytesoftype, dsize, buffer->bytes, dst);
 			} break;
-			case STENOS_FRAME_HEADER_BLOCK_ZSTD: {
+			case STENOS_FRAME_HEADER_XOR_ZSTD: {
+				// zstd on transposed input + XOR + bit transposition
 				if (!buffer)
-					buffer = CBuffer::make(ctx->superblock_size + 4); // Add 4 for the superblock header
+					buffer = ctx->make_buffer();
 				if STENOS_UNLIKELY (!buffer)
 					return STENOS_ERROR_ALLOC;
-				// zstd decompression
-				auto r = ZSTD_decompress(buffer->bytes, ctx->superblock_size, src, csize);
-				if STENOS_UNLIKELY (ZSTD_isError(r))
+				// Decompress to buffer
+				auto r = zstd_decompress_with_context(dctx, buffer->bytes, dsize, src, csize, ddict);
+				if STENOS_UNLIKELY (ZSTD_isError(r) || r != dsize)
 					return STENOS_ERROR_INVALID_INPUT;
-				// block decompression
-				r = block_decompress_generic(buffer->bytes, r, bytesoftype, dsize, dst);
+				// Inverse bit transposition, XOR and unshuffle to dst in one pass
+				xor_bitunshuffle(bytesoftype, dsize, buffer->bytes, dst);
+			} break;
+			case STENOS_FRAME_HEADER_INT_DELTA_ZSTD:
+			case STENOS_FRAME_HEADER_INT_DELTA2_ZSTD: {
+				// zstd on element-wise delta (or delta of delta) + transposed input
+				if STENOS_UNLIKELY (bytesoftype != 2 && bytesoftype != 4 && bytesoftype != 8)
+					return STENOS_ERROR_INVALID_INPUT;
+				if (!buffer)
+					buffer = ctx->make_buffer();
+				if STENOS_UNLIKELY (!buffer)
+					return STENOS_ERROR_ALLOC;
+				// Decompress to buffer
+				auto r = zstd_decompress_with_context(dctx, buffer->bytes, dsize, src, csize, ddict);
+				if STENOS_UNLIKELY (ZSTD_isError(r) || r != dsize)
+					return STENOS_ERROR_INVALID_INPUT;
+				// Unshuffle and inverse delta to dst in one pass
+				int_delta_inv_unshuffle(bytesoftype, dsize, code == STENOS_FRAME_HEADER_INT_DELTA_ZSTD ? 1 : 2, buffer->bytes, dst);
+			} break;
+			case STENOS_FRAME_HEADER_BLOCK_ZSTD: {
+				if (!buffer)
+					buffer = ctx->make_buffer();
+				if STENOS_UNLIKELY (!buffer)
+					return STENOS_ERROR_ALLOC;
+				// zstd decompression
+				auto r = zstd_decompress_with_context(dctx, buffer->bytes, ctx->superblock_size, src, csize, ddict);
+				if STENOS_UNLIKELY (ZSTD_isError(r))
+					return STENOS_ERROR_INVALID_INPUT;
+				// block decompression
+				r = block_decompress_generic(buffer->bytes, r, bytesoftype, dsize, dst);
 				if STENOS_UNLIKELY (has_error(r))
 					return STENOS_ERROR_INVALID_INPUT;
 
@@ -744,6 +2363,9 @@ namespace stenos
 					return STENOS_ERROR_INVALID_INPUT;
 				memcpy(dst, src, csize);
 				break;
+			case STENOS_FRAME_HEADER_FIELDS:
+				// Fields compressed separately
+				return decompress_layout_superblock(ctx, src, bytesoftype, csize, dst, dsize, buffer, dctx, ddict);
 
 			default:
 				// Unknown code
@@ -752,38 +2374,329 @@ namespace stenos
 		return dsize;
 	}
 
-	static inline stenos::tiny_pool& get_pool()
+	static STENOS_NOINLINE(size_t) decompress_layout_superblock(stenos_context_s* ctx,
+								     const uint8_t* src,
+								     size_t bytesoftype,
+								     size_t csize,
+								     uint8_t* dst,
+								     size_t dsize,
+								     CBuffer*& buffer,
+								     ZSTD_DCtx*& dctx,
+								     const ZSTD_DDict* ddict) noexcept
+	{
+		// Decompress a superblock compressed with a field layout (see compress_layout_superblock()).
+		// Columns are decompressed to dst, copied to buffer, and interleaved back to dst.
+		if STENOS_UNLIKELY (csize < 2)
+			return STENOS_ERROR_INVALID_INPUT;
+		const size_t count = read_LE_16(src);
+		if STENOS_UNLIKELY (count == 0 || count > bytesoftype || csize < 2 + count * 2 || dsize % bytesoftype != 0)
+			return STENOS_ERROR_INVALID_INPUT;
+		const uint8_t* layout = src + 2; // Field sizes
+		size_t total = 0;
+		for (size_t j = 0; j < count; ++j) {
+			const size_t f = read_LE_16(layout + j * 2);
+			total += f;
+			if STENOS_UNLIKELY (f == 0 || total > bytesoftype)
+				return STENOS_ERROR_INVALID_INPUT;
+		}
+		if STENOS_UNLIKELY (total != bytesoftype)
+			return STENOS_ERROR_INVALID_INPUT;
+
+		const size_t n = dsize / bytesoftype;
+		const uint8_t* end = src + csize;
+		src += 2 + count * 2;
+		uint8_t* column = dst;
+		for (size_t j = 0; j < count; ++j) {
+			if STENOS_UNLIKELY (src + 4 > end)
+				return STENOS_ERROR_INVALID_INPUT;
+			const uint8_t code = *src;
+			const size_t size = read_uint32_3(src + 1);
+			src += 4;
+			// Nested field layouts are not allowed
+			if STENOS_UNLIKELY (src + size > end || code == STENOS_FRAME_HEADER_FIELDS)
+				return STENOS_ERROR_INVALID_INPUT;
+			const size_t f = read_LE_16(layout + j * 2);
+			size_t r = decompress_generic_superblock(ctx, code, src, f, size, column, n * f, buffer, dctx, ddict);
+			if STENOS_UNLIKELY (has_error(r))
+				return r;
+			src += size;
+			column += n * f;
+		}
+
+		if (!buffer)
+			buffer = ctx->make_buffer();
+		if STENOS_UNLIKELY (!buffer)
+			return STENOS_ERROR_ALLOC;
+		memcpy(buffer->bytes, dst, dsize);
+		merge_fields(layout, count, bytesoftype, n, (const uint8_t*)buffer->bytes, dst);
+		return dsize;
+	}
+
+	static STENOS_ALWAYS_INLINE size_t compress_checksum_superblock(stenos_context_s* ctx,
+									const void* src,
+									size_t bytesoftype,
+									size_t bytes,
+									void* _dst,
+									size_t dst_size,
+									CBuffer*& buffer1,
+									CBuffer*& buffer2,
+									bool checksum,
+									stenos_superblock_stats* st) noexcept
+	{
+		// Compress a superblock followed by its optional checksum.
+		// The output size is at most bytes + ctx->superblock_overhead().
+		if (!checksum)
+			return compress_any_superblock(ctx, src, bytesoftype, bytes, _dst, dst_size, buffer1, buffer2, st);
+
+		if STENOS_UNLIKELY (dst_size < 4)
+			return STENOS_ERROR_DST_OVERFLOW;
+		uint8_t* dst = (uint8_t*)_dst;
+		size_t r = compress_any_superblock(ctx, src, bytesoftype, bytes, dst, dst_size - 4, buffer1, buffer2, st);
+		if STENOS_UNLIKELY (has_error(r))
+			return r;
+		write_LE_32(dst + r, crc32c(dst, r));
+		return r + 4;
+	}
+
+	static STENOS_NOINLINE(size_t) compress_superblock_stats(stenos_context_s* ctx,
+								  size_t index,
+								  const void* src,
+								  size_t bytesoftype,
+								  size_t bytes,
+								  void* dst,
+								  size_t dst_size,
+								  CBuffer*& buffer1,
+								  CBuffer*& buffer2,
+								  bool checksum) noexcept
+	{
+		// Compress a superblock, update the context statistics
+		// and call the superblock callback, if any
+		stenos_superblock_stats st;
+		memset(&st, 0, sizeof(st));
+		st.index = index;
+		st.input_size = bytes;
+		size_t r = compress_checksum_superblock(ctx, src, bytesoftype, bytes, dst, dst_size, buffer1, buffer2, checksum, &st);
+		if STENOS_UNLIKELY (has_error(r))
+			return r;
+		st.mode = *(const uint8_t*)dst;
+		st.output_size = r;
+		ctx->stats.add(st);
+		if (ctx->stats_callback)
+			ctx->stats_callback(ctx->stats_user_data, &st);
+		return r;
+	}
+
+	static STENOS_ALWAYS_INLINE size_t compress_frame_superblock(stenos_context_s* ctx,
+								     size_t index,
+								     const void* src,
+								     size_t bytesoftype,
+								     size_t bytes,
+								     void* dst,
+								     size_t dst_size,
+								     CBuffer*& buffer1,
+								     CBuffer*& buffer2) noexcept
+	{
+		// Compress the superblock at given index of a frame
+		if STENOS_UNLIKELY (ctx->stats_enabled || ctx->stats_callback)
+			return compress_superblock_stats(ctx, index, src, bytesoftype, bytes, dst, dst_size, buffer1, buffer2, ctx->checksum);
+		return compress_checksum_superblock(ctx, src, bytesoftype, bytes, dst, dst_size, buffer1, buffer2, ctx->checksum, nullptr);
+	}
+
+	static STENOS_ALWAYS_INLINE CBuffer* get_staging_buffer(stenos_context_s* ctx) noexcept
+	{
+		// Returns the buffer used to store a partial superblock
+		if (!ctx->thread_buffers[0])
+			ctx->thread_buffers[0] = ctx->make_buffer();
+		return ctx->thread_buffers[0];
+	}
+
+	template<class R>
+	static size_t reduce_superblock(stenos_context_s* ctx,
+					uint8_t code,
+					const uint8_t* src,
+					size_t bytesoftype,
+					size_t csize,
+					size_t dsize,
+					size_t slot,
+					const ZSTD_DDict* ddict,
+					R& r) noexcept
+	{
+		// Reduce a superblock (see stenos_reduce()) using the buffers of given slot.
+		// Block compressed superblocks are evaluated on their encoding,
+		// other ones are decompressed to the staging buffer.
+
+		if (code == STENOS_FRAME_HEADER_COPY) {
+			if STENOS_UNLIKELY (dsize != csize)
+				return STENOS_ERROR_INVALID_INPUT;
+			r.scan(src, dsize / bytesoftype);
+			return 0;
+		}
+
+		CBuffer*& staging = ctx->tmp_buffers2[slot];
+		if (!staging)
+			staging = ctx->make_buffer();
+		if STENOS_UNLIKELY (!staging)
+			return STENOS_ERROR_ALLOC;
+
+		switch (code) {
+			case STENOS_FRAME_HEADER_BLOCK:
+				return reduce_block_superblock(src, csize, bytesoftype, dsize, (uint8_t*)staging->bytes, r);
+			case STENOS_FRAME_HEADER_BLOCK_ZSTD: {
+				CBuffer*& buffer = ctx->tmp_buffers1[slot];
+				if (!buffer)
+					buffer = ctx->make_buffer();
+				if STENOS_UNLIKELY (!buffer)
+					return STENOS_ERROR_ALLOC;
+				auto ret = zstd_decompress_with_context(ctx->dctxs[slot], buffer->bytes, ctx->superblock_size, src, csize, ddict);
+				if STENOS_UNLIKELY (ZSTD_isError(ret))
+					return STENOS_ERROR_INVALID_INPUT;
+				return reduce_block_superblock((const uint8_t*)buffer->bytes, ret, bytesoftype, dsize, (uint8_t*)staging->bytes, r);
+			}
+			default: {
+				size_t ret = decompress_generic_superblock(ctx, code, src, bytesoftype, csize, (uint8_t*)staging->bytes, dsize, ctx->tmp_buffers1[slot], ctx->dctxs[slot], ddict);
+				if STENOS_UNLIKELY (ret != dsize)
+					return stenos::has_error(ret) ? ret : STENOS_ERROR_INVALID_INPUT;
+				r.scan((const uint8_t*)staging->bytes, dsize / bytesoftype);
+				return 0;
+			}
+		}
+	}
+
+	template<class Fn>
+	static size_t with_reducer(size_t bytesoftype, int op, const void* value, Fn&& fn) noexcept
+	{
+		// Call fn(reducer) with the reducer matching the operation and element type, see stenos_reduce()
+		const int type = op & (STENOS_REDUCE_UNSIGNED | STENOS_REDUCE_FLOAT);
+		op &= ~type;
+		if STENOS_UNLIKELY (op < STENOS_REDUCE_SUM || op > STENOS_REDUCE_COUNT_EQ || (op == STENOS_REDUCE_COUNT_EQ && !value) ||
+				    type == (STENOS_REDUCE_UNSIGNED | STENOS_REDUCE_FLOAT))
+			return STENOS_ERROR_INVALID_PARAMETER;
+
+		auto typed = [&](auto tag) -> size_t {
+			Reducer<decltype(tag)> r;
+			r.op = op;
+			if (value)
+				memcpy(&r.value, value, sizeof(r.value));
+			return fn(r);
+		};
+		if (type == STENOS_REDUCE_FLOAT) {
+			if (bytesoftype == 4)
+				return typed(float());
+			if (bytesoftype == 8)
+				return typed(double());
+		}
+		else {
+			const bool is_signed = type == STENOS_REDUCE_SIGNED;
+			switch (bytesoftype) {
+				case 1:
+					return is_signed ? typed(int8_t()) : typed(uint8_t());
+				case 2:
+					return is_signed ? typed(int16_t()) : typed(uint16_t());
+				case 4:
+					return is_signed ? typed(int32_t()) : typed(uint32_t());
+				case 8:
+					return is_signed ? typed(int64_t()) : typed(uint64_t());
+				default:
+					break;
+			}
+		}
+		if (op != STENOS_REDUCE_COUNT_EQ)
+			return STENOS_ERROR_INVALID_BYTESOFTYPE;
+		RawCounter r;
+		r.value = (const uint8_t*)value;
+		r.bytesoftype = bytesoftype;
+		return fn(r);
+	}
+
+	static inline stenos::thread_pool& get_pool()
 	{
-		// Create static thread pool
-		static stenos::tiny_pool pool(std::thread::hardware_concurrency() * 2u);
+		// Global thread pool used for multithreaded compression/decompression
+		// by contexts without a custom pool or executor
+		static stenos::thread_pool pool(std::thread::hardware_concurrency());
 		return pool;
 	}
 
-	// Global thread pool used for multithreaded compression/decompression.
-	// Make sure that threads are created at program initialization.
-	static stenos::tiny_pool* pool = &get_pool();
+	static STENOS_ALWAYS_INLINE thread_pool* context_pool(stenos_context_s* ctx) noexcept
+	{
+		// Returns the thread pool used by a context:
+		// null if the context uses an external executor, custom pool,
+		// or global pool lazily created on first multithreaded call.
+		if (ctx->exec.submit)
+			return nullptr;
+		return ctx->pool ? ctx->pool : &get_pool();
+	}
+
+}
+
+// Thread pool object
+struct stenos_pool_s
+{
+	stenos::thread_pool pool;
+	stenos_pool_s(unsigned threads)
+	  : pool(threads)
+	{
+	}
+};
+
+stenos_pool* stenos_make_pool(int threads)
+{
+	stenos_pool* p = (stenos_pool*)malloc(sizeof(stenos_pool_s));
+	if STENOS_UNLIKELY (!p)
+		return nullptr;
+	try {
+		return new (p) stenos_pool_s(threads < 1 ? 1u : (unsigned)threads);
+	}
+	catch (...) {
+		free(p);
+		return nullptr;
+	}
+}
+
+void stenos_destroy_pool(stenos_pool* p)
+{
+	if (p) {
+		p->~stenos_pool_s();
+		free(p);
+	}
+}
+
+size_t stenos_context_set_pool(stenos_context* ctx, stenos_pool* p)
+{
+	ctx->pool = p ? &p->pool : nullptr;
+	return 0;
+}
 
+size_t stenos_set_executor(stenos_context* ctx, stenos_submit_fn submit, stenos_wait_fn wait, void* user_data)
+{
+	if (!submit)
+		ctx->exec = stenos::executor{ nullptr, nullptr, nullptr };
+	else
+		ctx->exec = stenos::executor{ submit, wait, user_data };
+	return 0;
 }
 
 size_t stenos_private_compress_block(stenos_context* ctx, const void* src, size_t bytesoftype, size_t super_block_size, size_t bytes, void* dst, size_t dst_size)
 {
 	// Private API used by cvector, compress a superblock
-	if (ctx->superblock_size != super_block_size) {
-		ctx->superblock_size = super_block_size;
-		ctx->clear_buffers();
-	}
+	ctx->set_superblock_size(super_block_size);
 	if STENOS_UNLIKELY (stenos::has_error(ctx->ensure_has_buffers(1)))
 		return STENOS_ERROR_ALLOC;
-	return stenos::compress_generic_superblock(ctx, src, bytesoftype, bytes, dst, dst_size, ctx->tmp_buffers1[0], ctx->tmp_buffers2[0]);
+	if (ctx->t.nanoseconds) {
+		// The time budget applies to this superblock only
+		ctx->t.total_bytes = bytes;
+		ctx->t.finish_memcpy.store(false);
+		ctx->t.processed_bytes.store(0);
+		ctx->t.timer.tick();
+	}
+	if STENOS_UNLIKELY (ctx->stats_enabled || ctx->stats_callback)
+		return stenos::compress_superblock_stats(ctx, 0, src, bytesoftype, bytes, dst, dst_size, ctx->tmp_buffers1[0], ctx->tmp_buffers2[0], false);
+	return stenos::compress_any_superblock(ctx, src, bytesoftype, bytes, dst, dst_size, ctx->tmp_buffers1[0], ctx->tmp_buffers2[0]);
 }
 
 size_t stenos_private_decompress_block(stenos_context* ctx, const void* _src, size_t bytesoftype, size_t super_block_size, size_t bytes, void* _dst, size_t dst_size)
 {
 	// Private API used by cvector, decompress a superblock
-	if (ctx->superblock_size != super_block_size) {
-		ctx->superblock_size = super_block_size;
-		ctx->clear_buffers();
-	}
+	ctx->set_superblock_size(super_block_size);
 	const uint8_t* src = (const uint8_t*)_src;
 	const uint8_t* end_src = src + bytes;
 	uint8_t* dst = (uint8_t*)_dst;
@@ -800,7 +2713,30 @@ size_t stenos_private_decompress_block(stenos_context* ctx, const void* _src, si
 		return STENOS_ERROR_INVALID_INPUT;
 	if STENOS_UNLIKELY (stenos::has_error(ctx->ensure_has_buffers(1)))
 		return STENOS_ERROR_ALLOC;
-	return stenos::decompress_generic_superblock(ctx, code, src, bytesoftype, csize, dst, dsize, ctx->tmp_buffers1[0]);
+	return stenos::decompress_generic_superblock(ctx, code, src, bytesoftype, csize, dst, dsize, ctx->tmp_buffers1[0], ctx->dctxs[0], nullptr);
+}
+
+size_t stenos_private_reduce_block(
+  stenos_context* ctx, const void* _src, size_t bytesoftype, size_t super_block_size, size_t bytes, size_t decompressed_size, int op, const void* value, void* out)
+{
+	// Private API used by cvector, reduce a superblock (see stenos_reduce())
+	ctx->set_superblock_size(super_block_size);
+	const uint8_t* src = (const uint8_t*)_src;
+	if (bytes < 4)
+		return STENOS_ERROR_SRC_OVERFLOW;
+	uint8_t code = *src;
+	unsigned csize = stenos::read_uint32_3(src + 1);
+	if STENOS_UNLIKELY (4 + (size_t)csize > bytes || decompressed_size > super_block_size)
+		return STENOS_ERROR_INVALID_INPUT;
+	if STENOS_UNLIKELY (stenos::has_error(ctx->ensure_has_buffers(1)))
+		return STENOS_ERROR_ALLOC;
+	return stenos::with_reducer(bytesoftype, op, value, [&](auto& r) -> size_t {
+		size_t ret = stenos::reduce_superblock(ctx, code, src + 4, bytesoftype, csize, decompressed_size, 0, nullptr, r);
+		if STENOS_UNLIKELY (stenos::has_error(ret))
+			return ret;
+		r.write(out);
+		return (size_t)r.count;
+	});
 }
 
 size_t stenos_private_block_size(const void* _src, size_t src_size)
@@ -841,37 +2777,86 @@ size_t stenos_private_create_compression_header(size_t decompressed_size, size_t
 	return (dst - (uint8_t*)_dst);
 }
 
-size_t stenos_compress_generic(stenos_context* opts, const void* _src, size_t bytesoftype, size_t bytes, void* _dst, size_t dst_size)
+void stenos_private_parallel_for(int threads, size_t count, void (*fn)(void* opaque, size_t index), void* opaque)
 {
-	// Public API, generic compression function
+	// Private API used by cvector, call fn(opaque, i) for i in [0, count) on the global thread pool.
+	// The range is split in contiguous parts, one per thread.
+	size_t parts = threads > 1 ? std::min((size_t)threads, count) : 1;
+	if (parts <= 1) {
+		for (size_t i = 0; i < count; ++i)
+			fn(opaque, i);
+		return;
+	}
+	stenos::task_group group(&stenos::get_pool());
+	for (size_t p = 1; p < parts; ++p) {
+		size_t first = count * p / parts;
+		size_t last = count * (p + 1) / parts;
+		auto task = [fn, opaque, first, last]() {
+			for (size_t i = first; i < last; ++i)
+				fn(opaque, i);
+		};
+		// Run in the calling thread if the task cannot be launched
+		if (!group.run(task))
+			task();
+	}
+	for (size_t i = 0, last = count / parts; i < last; ++i)
+		fn(opaque, i);
+	group.wait();
+}
 
-	// Prepare the context for compression
-	size_t prep = opts->prepare(bytesoftype, bytes);
-	if STENOS_UNLIKELY (stenos::has_error(prep))
-		return prep;
+void* stenos_private_async(void (*fn)(void* opaque), void* opaque)
+{
+	// Private API used by cvector, launch fn(opaque) on the global thread pool.
+	// Returns a handle to be passed to stenos_private_wait(), or null if fn was executed in the calling thread.
+	auto* group = new (std::nothrow) stenos::task_group(&stenos::get_pool());
+	if (group && group->run([fn, opaque]() { fn(opaque); }))
+		return group;
+	delete group;
+	fn(opaque);
+	return nullptr;
+}
+
+void stenos_private_wait(void* task)
+{
+	// Private API used by cvector, wait for a task launched with stenos_private_async()
+	delete static_cast<stenos::task_group*>(task); // the destructor waits for the task
+}
+
+static size_t compress_frame_superblocks(stenos_context* opts,
+					 int slot,
+					 const void* _src,
+					 const uint8_t* const* sources,
+					 size_t bytesoftype,
+					 size_t bytes,
+					 void* _dst,
+					 size_t dst_size,
+					 size_t first_superblock = 0)
+{
+	// Compress the frame header and superblocks, the context being already prepared.
+	// If slot is not negative, compress in the calling thread using the buffers of this slot.
+	// If sources is not null, it stores the address of each superblock, and _src is ignored.
+	// Superblocks are reported to the superblock callback starting from index first_superblock.
 
 	// Compute number of superblocks
 	size_t super_block_remaining = bytes % opts->superblock_size;
 	size_t super_block_count = bytes / opts->superblock_size + (super_block_remaining ? 1 : 0);
+
+	// Reserve space for the superblock index
+	size_t index_bytes = stenos::index_size(opts->index_type, bytesoftype, super_block_count);
+	if STENOS_UNLIKELY (dst_size < index_bytes)
+		return STENOS_ERROR_DST_OVERFLOW;
+	dst_size -= index_bytes;
+
 	uint8_t* dst = (uint8_t*)_dst;
 	uint8_t* dst_end = dst + dst_size;
 	const uint8_t* src = (const uint8_t*)_src;
-	const uint8_t* src_end = src + bytes;
-
-	// Write shift and uncompressed size
-	if STENOS_UNLIKELY (dst + 8 > dst_end)
-		return STENOS_ERROR_DST_OVERFLOW;
-	*dst++ = (uint8_t)opts->shift;
-	stenos::write_uint64_7(dst, bytes);
-	dst += 7;
+	auto superblock = [&](size_t idx) { return sources ? sources[idx] : src + idx * opts->superblock_size; };
 
-	if (opts->custom_blocksize_shift != STENOS_NO_BLOCK_SHIFT) {
-		// Write custom superblock size
-		if STENOS_UNLIKELY (dst + 4 > dst_end)
-			return STENOS_ERROR_DST_OVERFLOW;
-		stenos::write_LE_32(dst, (unsigned)opts->superblock_size);
-		dst += 4;
-	}
+	// Write shift, uncompressed size and custom superblock size
+	size_t header_size = stenos::write_frame_header(opts, bytes, dst, dst_size);
+	if STENOS_UNLIKELY (stenos::has_error(header_size))
+		return header_size;
+	dst += header_size;
 
 	// Check for null input
 	if STENOS_UNLIKELY (bytes == 0)
@@ -881,172 +2866,271 @@ size_t stenos_compress_generic(stenos_context* opts, const void* _src, size_t by
 	if STENOS_UNLIKELY (dst > dst_end)
 		return STENOS_ERROR_DST_OVERFLOW;
 
-	if (opts->threads <= 1 || super_block_count == 1) {
+	if (slot >= 0 || opts->thread_count(super_block_count) <= 1) {
 
 		// Mono thread compression
+		const size_t w = slot > 0 ? (size_t)slot : 0;
 
 		// Create buffers
-		if STENOS_UNLIKELY (stenos::has_error(opts->ensure_has_buffers(1)))
+		if STENOS_UNLIKELY (stenos::has_error(opts->ensure_has_buffers((int)w + 1)))
 			return STENOS_ERROR_ALLOC;
 
 		// Loop over blocks
 		for (size_t i = 0; i < super_block_count; ++i) {
-			size_t in_size = (i == super_block_count - 1) ? (size_t)(src_end - src) : opts->superblock_size;
-			size_t r = stenos::compress_generic_superblock(opts, src, bytesoftype, in_size, dst, (dst_end - dst), opts->tmp_buffers1[0], opts->tmp_buffers2[0]);
+			size_t in_size = (i == super_block_count - 1) ? bytes - i * opts->superblock_size : opts->superblock_size;
+			size_t r =
+			  stenos::compress_frame_superblock(opts, first_superblock + i, superblock(i), bytesoftype, in_size, dst, (dst_end - dst), opts->tmp_buffers1[w], opts->tmp_buffers2[w]);
 
 			if (stenos::has_error(r))
 				return r;
 			if (opts->t.nanoseconds)
 				// Update compressed bytes
 				opts->t.processed_bytes.fetch_add(in_size);
-			src += opts->superblock_size;
 			dst += r;
 		}
 
 		return dst - (uint8_t*)_dst;
 	}
 
-	// Multithread compression
+	// Multithread compression.
+	// Workers pull superblock indices from a shared counter, and completed
+	// superblocks are committed to dst in order as soon as the prefix is complete.
+	// If dst can hold the worst case output, each superblock is compressed in
+	// place at its worst case position, and the commit only moves it
+	// to its final position (no move at all for uncompressible superblocks).
+	// Otherwise, superblocks are compressed to per-worker buffers and each worker
+	// copies its superblock when its turn comes.
+
+	const int threads = (int)opts->thread_count(super_block_count); // Compute number of threads
+	const size_t overhead = opts->superblock_overhead();
+	const size_t slot_size = opts->superblock_size + overhead;
+	const bool in_place = (size_t)(dst_end - dst) >= bytes + super_block_count * overhead;
+	uint8_t* const slots = dst;
 
-	const bool raw_memcpy = !opts->t.nanoseconds && opts->level == 0;	     // Check for direct memcpy (level 0)
-	const int threads = (int)std::min((size_t)opts->threads, super_block_count); // Compute number of threads
-	size_t res_code = 0;
+	if STENOS_UNLIKELY (stenos::has_error(opts->ensure_has_buffers(threads)))
+		return STENOS_ERROR_ALLOC;
 
-	if (!raw_memcpy) {
-		if STENOS_UNLIKELY (stenos::has_error(opts->ensure_has_buffers(threads)))
-			return STENOS_ERROR_ALLOC;
+	// Shared state
+	std::atomic<size_t> next_superblock{ 0 };
+	std::atomic<size_t> error{ 0 };
+	std::mutex commit_lock;
+	std::condition_variable commit_cond;
+	std::vector<size_t> csizes;
+	size_t committed = 0;
+	try {
+		csizes.resize(super_block_count, 0);
 	}
-	else {
-		// Compute output size
-		size_t out_size = super_block_count * 4 + (super_block_count - 1) * opts->superblock_size + super_block_remaining;
-		if STENOS_UNLIKELY (dst + out_size > dst_end)
-			return STENOS_ERROR_DST_OVERFLOW;
+	catch (...) {
+		return STENOS_ERROR_ALLOC;
 	}
 
-	size_t chunks = super_block_count;
-	while (chunks) {
-
-		int thread_count = threads;
-		if ((size_t)thread_count > chunks)
-			thread_count = (int)chunks;
+	auto commit_in_place = [&](size_t idx, size_t csize) {
+		// Record compressed size and move the completed prefix to its final position
+		std::lock_guard<std::mutex> ll(commit_lock);
+		csizes[idx] = csize;
+		while (committed < super_block_count && csizes[committed]) {
+			uint8_t* slot = slots + committed * slot_size;
+			if (slot != dst)
+				memmove(dst, slot, csizes[committed]);
+			dst += csizes[committed];
+			++committed;
+		}
+	};
 
-		std::atomic<size_t> memcpy_size{ 0 };
+	auto commit_buffer = [&](size_t idx, const stenos::CBuffer* buffer, size_t csize) {
+		// Wait for previous superblocks and copy this one to dst
+		std::unique_lock<std::mutex> ll(commit_lock);
+		commit_cond.wait(ll, [&]() { return committed == idx || error.load() != 0; });
+		if (error.load() == 0) {
+			if STENOS_UNLIKELY ((size_t)(dst_end - dst) < csize)
+				error.store(STENOS_ERROR_DST_OVERFLOW);
+			else {
+				memcpy(dst, buffer->bytes, csize);
+				dst += csize;
+				++committed;
+			}
+		}
+		ll.unlock();
+		commit_cond.notify_all();
+	};
 
-		// Parallel compression using a thread pool
-		for (int i = 0; i < thread_count; ++i) {
-			if (!stenos::pool->push([&, i]() {
-				    size_t idx = (size_t)i;
-				    // Get input pointer
-				    const uint8_t* in = src + idx * opts->superblock_size;
-
-				    if (raw_memcpy) {
-					    // Direct memcpy
-					    size_t in_size = (size_t)(src_end - in) < opts->superblock_size ? (size_t)(src_end - in) : opts->superblock_size;
-					    uint8_t* out = dst + idx * (opts->superblock_size + 4);
-					    stenos::compress_memcpy(in, in_size, out, dst_end - out);
-					    memcpy_size.fetch_add(in_size);
+	stenos::task_group group(stenos::context_pool(opts), &opts->exec);
+	for (int i = 0; i < threads; ++i) {
+		if (!group.run([&, i]() {
+			    size_t w = (size_t)i;
+			    for (;;) {
+				    size_t idx = next_superblock.fetch_add(1);
+				    if (idx >= super_block_count || error.load(std::memory_order_relaxed))
+					    break;
+
+				    const uint8_t* in = superblock(idx);
+				    size_t in_size = std::min(opts->superblock_size, bytes - idx * opts->superblock_size);
+				    size_t r = 0;
+
+				    if (in_place) {
+					    // Compress at the worst case position
+					    r = stenos::compress_frame_superblock(
+					      opts, first_superblock + idx, in, bytesoftype, in_size, slots + idx * slot_size, in_size + overhead, opts->tmp_buffers1[w], opts->tmp_buffers2[w]);
 				    }
 				    else {
-					    // Retrieve a compression buffer
-					    auto* buffer = opts->thread_buffers[idx];
+					    // Compress to the worker buffer
+					    auto* buffer = opts->thread_buffers[w];
 					    if (!buffer)
-						    buffer = opts->thread_buffers[idx] = stenos::CBuffer::make(opts->superblock_size + 4); // Add 4 for the superblock header
-					    if (buffer) {
-						    // Compress with computed level
-						    size_t in_size = (size_t)(src_end - in) < opts->superblock_size ? (size_t)(src_end - in) : opts->superblock_size;
-						    buffer->dst_size = stenos::compress_generic_superblock(
-						      opts, in, bytesoftype, in_size, buffer->bytes, opts->superblock_size + 4, opts->tmp_buffers1[idx], opts->tmp_buffers2[idx]);
-						    if (opts->t.nanoseconds)
-							    opts->t.processed_bytes.fetch_add(in_size);
+						    buffer = opts->thread_buffers[w] = opts->make_buffer();
+					    r = buffer ? stenos::compress_frame_superblock(
+							   opts, first_superblock + idx, in, bytesoftype, in_size, buffer->bytes, slot_size, opts->tmp_buffers1[w], opts->tmp_buffers2[w])
+						       : STENOS_ERROR_ALLOC;
+				    }
+				    if STENOS_UNLIKELY (stenos::has_error(r)) {
+					    {
+						    std::lock_guard<std::mutex> ll(commit_lock);
+						    error.store(r);
 					    }
+					    commit_cond.notify_all();
+					    break;
 				    }
-			    }))
-				return STENOS_ERROR_ALLOC;
+				    if (opts->t.nanoseconds)
+					    opts->t.processed_bytes.fetch_add(in_size);
+
+				    if (in_place)
+					    commit_in_place(idx, r);
+				    else
+					    commit_buffer(idx, opts->thread_buffers[w], r);
+			    }
+		    })) {
+			// Already pushed tasks will stop on error
+			std::lock_guard<std::mutex> ll(commit_lock);
+			error.store(STENOS_ERROR_ALLOC);
+			break;
 		}
-		stenos::pool->wait();
+	}
+	commit_cond.notify_all();
+	group.wait();
 
-		if (raw_memcpy) {
-			src += memcpy_size.load();
-			dst += memcpy_size.load() + (size_t)thread_count * 4;
-			if (dst > dst_end)
-				return STENOS_ERROR_DST_OVERFLOW;
-		}
-		else {
+	if STENOS_UNLIKELY (error.load())
+		return error.load();
+	return dst - (uint8_t*)_dst;
+}
 
-			// Write compressed size to destination and check errors
-			for (size_t i = 0; i < (size_t)thread_count; ++i) {
-				if STENOS_UNLIKELY (!opts->thread_buffers[i]) {
-					res_code = STENOS_ERROR_ALLOC;
-					goto end;
-				}
-				if STENOS_UNLIKELY (stenos::has_error(opts->thread_buffers[i]->dst_size)) {
-					res_code = STENOS_ERROR_DST_OVERFLOW;
-					goto end;
-				}
+static size_t append_frame_index(const stenos_context* opts, const void* src, const uint8_t* const* sources, size_t bytesoftype, size_t bytes, void* _dst, size_t r)
+{
+	// Append the superblock index (if any) to a frame of r bytes compressed from src
+	// (or from the superblock addresses in sources if not null)
+	if (stenos::has_error(r) || opts->index_type == STENOS_INDEX_NONE)
+		return r;
 
-				opts->thread_buffers[i]->dst = dst;
-				dst += opts->thread_buffers[i]->dst_size;
-				src += opts->superblock_size;
-			}
+	// Append the superblock index by walking the superblock headers
+	uint8_t* dst = (uint8_t*)_dst;
+	uint8_t* index = dst + r;
+	size_t super_block_count = bytes / opts->superblock_size + (bytes % opts->superblock_size ? 1 : 0);
+	size_t entry_size = stenos::index_entry_size(opts->index_type, bytesoftype);
+	size_t pos = stenos::frame_header_size(dst[0]);
+	for (size_t i = 0; i < super_block_count; ++i, index += entry_size) {
+		size_t offset = i * opts->superblock_size;
+		size_t in_size = std::min(opts->superblock_size, bytes - offset);
+		const uint8_t* in = sources ? sources[i] : (const uint8_t*)src + offset;
+		stenos::write_index_entry(opts->index_type, bytesoftype, pos, in, in_size, index);
+		pos += 4 + stenos::read_uint32_3(dst + pos + 1) + (opts->checksum ? 4 : 0);
+	}
+	stenos::write_LE_32(index, (unsigned)(super_block_count * entry_size));
+	return r + stenos::index_size(opts->index_type, bytesoftype, super_block_count);
+}
 
-			// copy to destination in parallel
-			for (int i = 0; i < thread_count; ++i) {
-				if (!stenos::pool->push([&, i]() {
-					    if ((uint8_t*)opts->thread_buffers[i]->dst + opts->thread_buffers[i]->dst_size > dst_end) {
-						    res_code = STENOS_ERROR_DST_OVERFLOW;
-					    }
-					    else {
-						    memcpy(opts->thread_buffers[i]->dst, opts->thread_buffers[i]->bytes, opts->thread_buffers[i]->dst_size);
-					    }
-				    }))
-					return STENOS_ERROR_ALLOC;
-			}
-			stenos::pool->wait();
+size_t stenos_compress_generic(stenos_context* opts, const void* src, size_t bytesoftype, size_t bytes, void* _dst, size_t dst_size)
+{
+	// Public API, generic compression function
 
-			if STENOS_UNLIKELY (res_code)
-				goto end;
-		}
-		chunks -= (size_t)thread_count;
-	}
+	// Prepare the context for compression
+	size_t prep = opts->prepare(bytesoftype, bytes);
+	if STENOS_UNLIKELY (stenos::has_error(prep))
+		return prep;
 
-end:
-	if (!res_code)
-		res_code = dst - (uint8_t*)_dst;
+	size_t r = compress_frame_superblocks(opts, -1, src, nullptr, bytesoftype, bytes, _dst, dst_size);
+	return append_frame_index(opts, src, nullptr, bytesoftype, bytes, _dst, r);
+}
 
-	return res_code;
+size_t stenos_context_bound(stenos_context* ctx, size_t bytesoftype, size_t bytes)
+{
+	// Maximum compressed size for given input bytes, using the context parameters
+	int shift = 0;
+	size_t superblock_size = ctx->compute_superblock_size(bytesoftype, bytes, shift);
+	if STENOS_UNLIKELY (stenos::has_error(superblock_size))
+		return superblock_size;
+	size_t super_block_count = bytes / superblock_size + (bytes % superblock_size ? 1 : 0);
+	return 17 + super_block_count * ctx->superblock_overhead() + bytes + stenos::index_size(ctx->index_type, bytesoftype, super_block_count);
 }
 
-size_t stenos_get_info(const void* _src, size_t bytesoftype, size_t bytes, stenos_info* info)
+size_t stenos_get_info(const void* src, size_t bytesoftype, size_t bytes, stenos_info* info)
 {
 	// Retrieve information on a compressed frame
 
-	const uint8_t* src = (const uint8_t*)_src;
-	const uint8_t* end_src = src + bytes;
+	if STENOS_UNLIKELY (bytesoftype == 0 || bytesoftype >= STENOS_MAX_BYTESOFTYPE)
+		return STENOS_ERROR_INVALID_BYTESOFTYPE;
 
-	if STENOS_UNLIKELY (src + 8 > end_src)
-		return STENOS_ERROR_SRC_OVERFLOW;
+	stenos::FrameHeader h;
+	size_t r = stenos::read_frame_header(src, bytesoftype, bytes, h);
+	if STENOS_UNLIKELY (stenos::has_error(r))
+		return r;
 
-	uint8_t shift = *src++;
-	if STENOS_UNLIKELY (shift > 4 && shift != 255)
-		return STENOS_ERROR_INVALID_INPUT;
+	info->decompressed_size = h.decompressed_size;
+	info->superblock_size = h.superblock_size;
+	info->superblock_count = h.decompressed_size / h.superblock_size + (h.decompressed_size % h.superblock_size ? 1 : 0);
+	info->index_type = h.index_type;
+	info->has_checksum = h.checksum_size != 0;
+	info->dict_id = h.dict_id;
+
+	// Returns the frame header size
+	return r;
+}
+
+static size_t decompress_frame_superblocks(stenos_context* opts,
+					   size_t slot,
+					   const stenos::FrameHeader& h,
+					   size_t bytesoftype,
+					   const uint8_t* src,
+					   const uint8_t* end_src,
+					   uint8_t* dst,
+					   uint8_t* end_dst,
+					   const ZSTD_DDict* ddict)
+{
+	// Decompress the superblocks of a frame (src starting after the frame header)
+	// in the calling thread, using the buffers of given slot
 
-	// Decompressed size
-	info->decompressed_size = (size_t)stenos::read_uint64_7(src);
-	src += 7;
+	uint8_t* start = dst;
+	const size_t decompressed = h.decompressed_size;
+	size_t super_block_remaining = decompressed % h.superblock_size;
+	size_t super_block_count = decompressed / h.superblock_size + (super_block_remaining ? 1 : 0);
+	// The last superblock is a full one if the size is a multiple of the superblock size
+	size_t last_superblock_size = super_block_remaining ? super_block_remaining : h.superblock_size;
 
-	// Superblock size
-	if (shift == 255) {
-		if (src + 4 > end_src)
+	// Loop over superblocks
+	for (size_t i = 0; i < super_block_count; ++i) {
+
+		if STENOS_UNLIKELY (src + 4 > end_src)
 			return STENOS_ERROR_SRC_OVERFLOW;
-		info->superblock_size = stenos::read_LE_32(src);
-		src += 4;
-	}
-	else {
-		info->superblock_size = stenos::super_block_size(bytesoftype * 256) << shift;
+
+		uint8_t code = *src++;
+		unsigned csize = stenos::read_uint32_3(src);
+		unsigned dsize = (i == super_block_count - 1) ? (unsigned)last_superblock_size : (unsigned)h.superblock_size;
+		src += 3;
+		if STENOS_UNLIKELY (src + csize + h.checksum_size > end_src || dst + dsize > end_dst)
+			return STENOS_ERROR_INVALID_INPUT;
+		if STENOS_UNLIKELY (h.checksum_size && !stenos::check_superblock(src - 4, csize))
+			return STENOS_ERROR_CHECKSUM;
+
+		size_t ret = stenos::decompress_generic_superblock(opts, code, src, bytesoftype, csize, dst, dsize, opts->tmp_buffers1[slot], opts->dctxs[slot], ddict);
+		if STENOS_UNLIKELY (ret != dsize)
+			// Error
+			return ret;
+
+		dst += dsize;
+		src += csize + h.checksum_size;
 	}
 
-	// Returns the frame header size
-	return (size_t)(src - (const uint8_t*)_src);
+	size_t output_size = dst - start;
+	if STENOS_UNLIKELY (output_size != decompressed)
+		return STENOS_ERROR_INVALID_INPUT;
+	return decompressed;
 }
 
 size_t stenos_decompress_generic(stenos_context* opts, const void* _src, size_t bytesoftype, size_t size, void* _dst, size_t dst_size)
@@ -1071,86 +3155,46 @@ size_t stenos_decompress_generic(stenos_context* opts, const void* _src, size_t
 	const uint8_t* end_src = src + size;
 	uint8_t* dst = (uint8_t*)_dst;
 	uint8_t* end_dst = dst + dst_size;
-	uint64_t decompressed = dst_size;
-	uint8_t shift = 0;
 
-	// Check overflow
-	if STENOS_UNLIKELY (src + 8 > end_src)
-		return STENOS_ERROR_SRC_OVERFLOW;
-	shift = *src++;
+	// Read frame header
+	stenos::FrameHeader h;
+	size_t header_size = stenos::read_frame_header(src, bytesoftype, size, h);
+	if STENOS_UNLIKELY (stenos::has_error(header_size))
+		return header_size;
+	src += header_size;
 
-	// Check shift validity
-	if STENOS_UNLIKELY (shift > 4 && shift != 255)
-		return STENOS_ERROR_INVALID_INPUT;
+	// Frame dictionary
+	const ZSTD_DDict* ddict = nullptr;
+	size_t dr = stenos::frame_dictionary(opts, h, ddict);
+	if STENOS_UNLIKELY (stenos::has_error(dr))
+		return dr;
 
-	// Read decompressed size
-	decompressed = stenos::read_uint64_7(src);
-	src += 7;
+	uint64_t decompressed = h.decompressed_size;
 	if STENOS_UNLIKELY (decompressed > dst_size)
 		return STENOS_ERROR_DST_OVERFLOW;
 	if (decompressed == 0)
 		return 0;
 
-	// Compute superblock size
-	size_t block_size = bytesoftype * 256;
-	size_t superblock_size = 0;
-
-	if (shift == 255) {
-		// Custom superblock size
-		if STENOS_UNLIKELY (src + 4 > end_src)
-			return STENOS_ERROR_SRC_OVERFLOW;
-		superblock_size = stenos::read_LE_32(src);
-		src += 4;
-	}
-	else
-		// Default superblock size
-		superblock_size = stenos::super_block_size(block_size) << shift;
+	size_t superblock_size = h.superblock_size;
 
-	// Clear buffers
-	if (superblock_size != opts->superblock_size)
-		opts->clear_buffers();
-	opts->superblock_size = superblock_size;
+	opts->set_superblock_size(superblock_size);
 
 	// Compute superblock count
 	size_t super_block_remaining = decompressed % opts->superblock_size;
 	size_t super_block_count = decompressed / opts->superblock_size + (super_block_remaining ? 1 : 0);
+	// The last superblock is a full one if the size is a multiple of the superblock size
+	size_t last_superblock_size = super_block_remaining ? super_block_remaining : opts->superblock_size;
 
-	if (opts->threads <= 1 || super_block_count == 1) {
+	if (opts->thread_count(super_block_count) <= 1) {
 		// Mono thread decompression
 		if STENOS_UNLIKELY (stenos::has_error(opts->ensure_has_buffers(1)))
 			return STENOS_ERROR_ALLOC;
-
-		// Loop over superblocks
-		for (size_t i = 0; i < super_block_count; ++i) {
-
-			if STENOS_UNLIKELY (src + 4 > end_src)
-				return STENOS_ERROR_SRC_OVERFLOW;
-
-			uint8_t code = *src++;
-			unsigned csize = stenos::read_uint32_3(src);
-			unsigned dsize = (i == super_block_count - 1) ? (unsigned)super_block_remaining : (unsigned)opts->superblock_size;
-			src += 3;
-			if STENOS_UNLIKELY (src + csize > end_src || dst + dsize > end_dst)
-				return STENOS_ERROR_INVALID_INPUT;
-
-			size_t ret = stenos::decompress_generic_superblock(opts, code, src, bytesoftype, csize, dst, dsize, opts->tmp_buffers1[0]);
-			if STENOS_UNLIKELY (ret != dsize)
-				// Error
-				return ret;
-
-			dst += dsize;
-			src += csize;
-		}
-
-		size_t output_size = dst - (uint8_t*)_dst;
-		if STENOS_UNLIKELY (output_size != decompressed)
-			return STENOS_ERROR_INVALID_INPUT;
-		return decompressed;
+		return decompress_frame_superblocks(opts, 0, h, bytesoftype, src, end_src, dst, end_dst, ddict);
 	}
 
 	// Multithread decompression
 
-	const int threads = (int)std::min((size_t)opts->threads, super_block_count);
+	const int threads = (int)opts->thread_count(super_block_count);
 	std::vector<Block> blocks((size_t)threads);
 	if STENOS_UNLIKELY (stenos::has_error(opts->ensure_has_buffers(threads)))
 		return STENOS_ERROR_ALLOC;
@@ -1170,26 +3214,30 @@ size_t stenos_decompress_generic(stenos_context* opts, const void* _src, size_t
 
 			uint8_t code = *src++;
 			unsigned csize = stenos::read_uint32_3(src);
-			unsigned dsize = (chunks - (size_t)i - 1 == 0) ? (unsigned)super_block_remaining : (unsigned)opts->superblock_size;
+			unsigned dsize = (chunks - (size_t)i - 1 == 0) ? (unsigned)last_superblock_size : (unsigned)opts->superblock_size;
 			src += 3;
-			if STENOS_UNLIKELY (src + csize > end_src || dst + dsize > end_dst)
+			if STENOS_UNLIKELY (src + csize + h.checksum_size > end_src || dst + dsize > end_dst)
 				return STENOS_ERROR_INVALID_INPUT;
 
-			blocks[(size_t)i] = Block{ csize, dsize, code, src, dst };
+			blocks[(size_t)i] = Block{ csize, dsize, code, src, dst, 0 };
 
 			dst += dsize;
-			src += csize;
+			src += csize + h.checksum_size;
 		}
 
 		// Parallel decompress using a thread pool
+		stenos::task_group group(stenos::context_pool(opts), &opts->exec);
 		for (int i = 0; i < thread_count; ++i) {
-			if (!stenos::pool->push([&, i]() {
+			if (!group.run([&, i]() {
 				    Block& bl = blocks[(size_t)i];
-				    bl.ret = stenos::decompress_generic_superblock(opts, bl.code, bl.src, bytesoftype, bl.csize, bl.dst, bl.dsize, opts->thread_buffers[(size_t)i]);
+				    if STENOS_UNLIKELY (h.checksum_size && !stenos::check_superblock(bl.src - 4, bl.csize))
+					    bl.ret = STENOS_ERROR_CHECKSUM;
+				    else
+					    bl.ret = stenos::decompress_generic_superblock(opts, bl.code, bl.src, bytesoftype, bl.csize, bl.dst, bl.dsize, opts->thread_buffers[(size_t)i], opts->dctxs[(size_t)i], ddict);
 			    }))
 				return STENOS_ERROR_ALLOC;
 		}
-		stenos::pool->wait();
+		group.wait();
 
 		// Check results
 		for (int i = 0; i < thread_count; ++i) {
@@ -1207,22 +3255,1255 @@ size_t stenos_decompress_generic(stenos_context* opts, const void* _src, size_t
 	return decompressed;
 }
 
-size_t stenos_compress(const void* src, size_t bytesoftype, size_t bytes, void* dst, size_t dst_size, int level)
+template<class Fn>
+static void run_batch(stenos_context* opts, size_t n, size_t workers, Fn fn)
 {
-	// Public API, simplified compression function only using a compression level as parameter.
+	// Call fn(slot, i) for all items i in [0, n).
+	// Workers pull the next pending item from a shared counter, so that
+	// items of different sizes are balanced over the workers.
+	if (workers <= 1) {
+		for (size_t i = 0; i < n; ++i)
+			fn((size_t)0, i);
+		return;
+	}
+	std::atomic<size_t> next{ 0 };
+	stenos::task_group group(stenos::context_pool(opts), &opts->exec);
+	for (size_t w = 0; w < workers; ++w) {
+		auto task = [&, w]() {
+			for (;;) {
+				size_t i = next.fetch_add(1);
+				if (i >= n)
+					break;
+				fn(w, i);
+			}
+		};
+		// Run in the calling thread if the task cannot be launched
+		if (!group.run(task))
+			task();
+	}
+	group.wait();
+}
 
-	// Create the context on the stack
-	stenos_context_s opts;
-	opts.level = level > 9 ? 9 : (level < 0 ? 0 : level);
-	return stenos_compress_generic(&opts, src, bytesoftype, bytes, dst, dst_size);
+static size_t batch_result(stenos_buffer* outputs, size_t n, size_t error)
+{
+	// Returns the first error of a batch, setting all output sizes to error if not 0
+	for (size_t i = 0; i < n; ++i) {
+		if (error)
+			outputs[i].size = error;
+		else if (stenos::has_error(outputs[i].size))
+			return outputs[i].size;
+	}
+	return error;
 }
-size_t stenos_decompress(const void* src, size_t bytesoftype, size_t bytes, void* dst, size_t dst_size)
+
+size_t stenos_compress_batch(stenos_context* opts, size_t bytesoftype, const stenos_buffer* inputs, size_t n, stenos_buffer* outputs)
 {
-	// Public API, simplified decompression function.
+	// Public API, compress n independent frames
 
-	// Create the context on the stack
-	stenos_context_s opts;
-	return stenos_decompress_generic(&opts, src, bytesoftype, bytes, dst, dst_size);
+	if (n == 0)
+		return 0;
+
+	// Prepare the context once for the largest input,
+	// the time budget applies to the whole batch
+	size_t max_bytes = 0, total = 0;
+	for (size_t i = 0; i < n; ++i) {
+		max_bytes = std::max(max_bytes, inputs[i].size);
+		total += inputs[i].size;
+	}
+	size_t prep = opts->prepare(bytesoftype, max_bytes);
+	if STENOS_UNLIKELY (stenos::has_error(prep))
+		return batch_result(outputs, n, prep);
+	if (opts->t.nanoseconds)
+		opts->t.total_bytes = total;
+
+	const size_t workers = opts->thread_count(n);
+	if STENOS_UNLIKELY (stenos::has_error(opts->ensure_has_buffers((int)workers)))
+		return batch_result(outputs, n, STENOS_ERROR_ALLOC);
+
+	run_batch(opts, n, workers, [&](size_t w, size_t i) {
+		size_t r = compress_frame_superblocks(opts, (int)w, inputs[i].data, nullptr, bytesoftype, inputs[i].size, outputs[i].data, outputs[i].size);
+		outputs[i].size = append_frame_index(opts, inputs[i].data, nullptr, bytesoftype, inputs[i].size, outputs[i].data, r);
+	});
+	return batch_result(outputs, n, 0);
+}
+
+size_t stenos_decompress_batch(stenos_context* opts, size_t bytesoftype, const stenos_buffer* inputs, size_t n, stenos_buffer* outputs)
+{
+	// Public API, decompress n independent frames
+
+	if (n == 0)
+		return 0;
+	if STENOS_UNLIKELY (bytesoftype == 0 || bytesoftype >= STENOS_MAX_BYTESOFTYPE)
+		return batch_result(outputs, n, STENOS_ERROR_INVALID_BYTESOFTYPE);
+
+	// Buffers must hold the largest superblock of all frames
+	size_t superblock_size = 0;
+	for (size_t i = 0; i < n; ++i) {
+		stenos::FrameHeader h;
+		if (!stenos::has_error(stenos::read_frame_header(inputs[i].data, bytesoftype, inputs[i].size, h)))
+			superblock_size = std::max(superblock_size, h.superblock_size);
+	}
+	if (superblock_size > opts->superblock_size)
+		opts->set_superblock_size(superblock_size);
+
+	const size_t workers = opts->thread_count(n);
+	if STENOS_UNLIKELY (stenos::has_error(opts->ensure_has_buffers((int)workers)))
+		return batch_result(outputs, n, STENOS_ERROR_ALLOC);
+
+	run_batch(opts, n, workers, [&](size_t w, size_t i) {
+		const uint8_t* src = (const uint8_t*)inputs[i].data;
+		uint8_t* dst = (uint8_t*)outputs[i].data;
+		stenos::FrameHeader h;
+		const ZSTD_DDict* ddict = nullptr;
+		const size_t header_size = stenos::read_frame_header(src, bytesoftype, inputs[i].size, h);
+		size_t r = header_size;
+		if (!stenos::has_error(r))
+			r = stenos::frame_dictionary(opts, h, ddict);
+		if (!stenos::has_error(r)) {
+			if STENOS_UNLIKELY (h.decompressed_size > outputs[i].size)
+				r = STENOS_ERROR_DST_OVERFLOW;
+			else if (h.decompressed_size == 0)
+				r = 0;
+			else
+				r = decompress_frame_superblocks(
+				  opts, w, h, bytesoftype, src + header_size, src + inputs[i].size, dst, dst + outputs[i].size, ddict);
+		}
+		outputs[i].size = r;
+	});
+	return batch_result(outputs, n, 0);
+}
+
+size_t stenos_compressv(stenos_context* opts, const stenos_buffer* src, size_t n, size_t bytesoftype, void* dst, size_t dst_size)
+{
+	// Public API, compress the concatenation of n segments
+
+	if (n <= 1)
+		return stenos_compress_generic(opts, n ? src[0].data : nullptr, bytesoftype, n ? src[0].size : 0, dst, dst_size);
+
+	size_t total = 0;
+	for (size_t i = 0; i < n; ++i)
+		total += src[i].size;
+
+	// Prepare the context for compression
+	size_t prep = opts->prepare(bytesoftype, total);
+	if STENOS_UNLIKELY (stenos::has_error(prep))
+		return prep;
+
+	// Locate each superblock: superblocks within a single segment are compressed in place,
+	// the ones straddling several segments are gathered in a staging buffer.
+	// At most one superblock starts in each segment but the last one without fitting in it.
+	const size_t superblock_size = opts->superblock_size;
+	const size_t super_block_count = total / superblock_size + (total % superblock_size ? 1 : 0);
+	std::vector<const uint8_t*> sources;
+	std::unique_ptr<uint8_t[]> staging;
+	try {
+		sources.resize(super_block_count);
+		staging.reset(new uint8_t[std::min(n - 1, super_block_count) * superblock_size]);
+	}
+	catch (...) {
+		return STENOS_ERROR_ALLOC;
+	}
+
+	size_t seg = 0, pos = 0, staged = 0;
+	for (size_t i = 0; i < super_block_count; ++i) {
+		size_t len = std::min(superblock_size, total - i * superblock_size);
+		while (pos == src[seg].size) {
+			// Skip consumed and empty segments
+			++seg;
+			pos = 0;
+		}
+		if (src[seg].size - pos >= len) {
+			// In place
+			sources[i] = (const uint8_t*)src[seg].data + pos;
+			pos += len;
+			continue;
+		}
+		// Gather
+		uint8_t* out = staging.get() + (staged++) * superblock_size;
+		sources[i] = out;
+		while (len) {
+			while (pos == src[seg].size) {
+				++seg;
+				pos = 0;
+			}
+			size_t to_copy = std::min(len, src[seg].size - pos);
+			memcpy(out, (const uint8_t*)src[seg].data + pos, to_copy);
+			out += to_copy;
+			pos += to_copy;
+			len -= to_copy;
+		}
+	}
+
+	size_t r = compress_frame_superblocks(opts, -1, nullptr, sources.data(), bytesoftype, total, dst, dst_size);
+	return append_frame_index(opts, nullptr, sources.data(), bytesoftype, total, dst, r);
+}
+
+size_t stenos_decompressv(stenos_context* opts, const void* _src, size_t bytesoftype, size_t size, const stenos_buffer* dst, size_t n)
+{
+	// Public API, decompress a frame to n segments
+
+	struct Block
+	{
+		const uint8_t* src;
+		size_t offset; // Decompressed offset
+		unsigned csize;
+		unsigned dsize;
+		uint8_t code;
+		size_t ret;
+	};
+
+	if (n == 1)
+		return stenos_decompress_generic(opts, _src, bytesoftype, size, dst[0].data, dst[0].size);
+
+	// Check bytesoftype validity
+	if STENOS_UNLIKELY (bytesoftype == 0 || bytesoftype >= STENOS_MAX_BYTESOFTYPE)
+		return STENOS_ERROR_INVALID_BYTESOFTYPE;
+
+	const uint8_t* src = (const uint8_t*)_src;
+	const uint8_t* end_src = src + size;
+
+	// Read frame header
+	stenos::FrameHeader h;
+	size_t header_size = stenos::read_frame_header(src, bytesoftype, size, h);
+	if STENOS_UNLIKELY (stenos::has_error(header_size))
+		return header_size;
+	src += header_size;
+
+	// Frame dictionary
+	const ZSTD_DDict* ddict = nullptr;
+	size_t dr = stenos::frame_dictionary(opts, h, ddict);
+	if STENOS_UNLIKELY (stenos::has_error(dr))
+		return dr;
+
+	// Segment start offsets
+	std::vector<size_t> starts;
+	try {
+		starts.resize(n + 1);
+	}
+	catch (...) {
+		return STENOS_ERROR_ALLOC;
+	}
+	starts[0] = 0;
+	for (size_t i = 0; i < n; ++i)
+		starts[i + 1] = starts[i] + dst[i].size;
+
+	const size_t decompressed = h.decompressed_size;
+	if STENOS_UNLIKELY (decompressed > starts[n])
+		return STENOS_ERROR_DST_OVERFLOW;
+	if (decompressed == 0)
+		return 0;
+
+	opts->set_superblock_size(h.superblock_size);
+
+	// Read superblock headers
+	const size_t super_block_remaining = decompressed % opts->superblock_size;
+	const size_t super_block_count = decompressed / opts->superblock_size + (super_block_remaining ? 1 : 0);
+	std::vector<Block> blocks;
+	try {
+		blocks.resize(super_block_count);
+	}
+	catch (...) {
+		return STENOS_ERROR_ALLOC;
+	}
+	for (size_t i = 0; i < super_block_count; ++i) {
+		if STENOS_UNLIKELY (src + 4 > end_src)
+			return STENOS_ERROR_SRC_OVERFLOW;
+		Block& bl = blocks[i];
+		bl.code = *src;
+		bl.csize = stenos::read_uint32_3(src + 1);
+		bl.offset = i * opts->superblock_size;
+		bl.dsize = (unsigned)std::min(opts->superblock_size, decompressed - bl.offset);
+		bl.src = src + 4;
+		src += 4 + bl.csize + h.checksum_size;
+		if STENOS_UNLIKELY (src > end_src)
+			return STENOS_ERROR_INVALID_INPUT;
+	}
+
+	const size_t workers = opts->thread_count(super_block_count);
+	if STENOS_UNLIKELY (stenos::has_error(opts->ensure_has_buffers((int)workers)))
+		return STENOS_ERROR_ALLOC;
+
+	run_batch(opts, super_block_count, workers, [&](size_t w, size_t i) {
+		Block& bl = blocks[i];
+		if STENOS_UNLIKELY (h.checksum_size && !stenos::check_superblock(bl.src - 4, bl.csize)) {
+			bl.ret = STENOS_ERROR_CHECKSUM;
+			return;
+		}
+		// Segment containing the superblock start
+		size_t seg = (size_t)(std::upper_bound(starts.begin(), starts.end(), bl.offset) - starts.begin()) - 1;
+		size_t pos = bl.offset - starts[seg];
+		if (dst[seg].size - pos >= bl.dsize) {
+			// Decompress in place
+			bl.ret = stenos::decompress_generic_superblock(
+			  opts, bl.code, bl.src, bytesoftype, bl.csize, (uint8_t*)dst[seg].data + pos, bl.dsize, opts->tmp_buffers1[w], opts->dctxs[w], ddict);
+			return;
+		}
+		// Decompress to the staging buffer and scatter
+		stenos::CBuffer*& staging = opts->tmp_buffers2[w];
+		if (!staging)
+			staging = opts->make_buffer();
+		if STENOS_UNLIKELY (!staging) {
+			bl.ret = STENOS_ERROR_ALLOC;
+			return;
+		}
+		bl.ret = stenos::decompress_generic_superblock(
+		  opts, bl.code, bl.src, bytesoftype, bl.csize, (uint8_t*)staging->bytes, bl.dsize, opts->tmp_buffers1[w], opts->dctxs[w], ddict);
+		if STENOS_UNLIKELY (bl.ret != bl.dsize)
+			return;
+		const uint8_t* in = (const uint8_t*)staging->bytes;
+		size_t len = bl.dsize;
+		while (len) {
+			size_t to_copy = std::min(len, dst[seg].size - pos);
+			memcpy((uint8_t*)dst[seg].data + pos, in, to_copy);
+			in += to_copy;
+			len -= to_copy;
+			++seg;
+			pos = 0;
+		}
+	});
+
+	// Check results
+	for (const Block& bl : blocks) {
+		if STENOS_UNLIKELY (bl.ret != bl.dsize)
+			return bl.ret;
+	}
+	return decompressed;
+}
+
+size_t stenos_get_superblock_info(const void* _src, size_t bytesoftype, size_t size, size_t superblock, stenos_superblock_info* info)
+{
+	// Retrieve information on a superblock of a compressed frame
+
+	if STENOS_UNLIKELY (bytesoftype == 0 || bytesoftype >= STENOS_MAX_BYTESOFTYPE)
+		return STENOS_ERROR_INVALID_BYTESOFTYPE;
+
+	const uint8_t* src = (const uint8_t*)_src;
+	stenos::FrameHeader h;
+	size_t r = stenos::read_frame_header(src, bytesoftype, size, h);
+	if STENOS_UNLIKELY (stenos::has_error(r))
+		return r;
+	size_t super_block_count = h.decompressed_size / h.superblock_size + (h.decompressed_size % h.superblock_size ? 1 : 0);
+	if STENOS_UNLIKELY (superblock >= super_block_count)
+		return STENOS_ERROR_INVALID_PARAMETER;
+
+	const uint8_t* entry = nullptr;
+	size_t offset = stenos::locate_superblock(src, size, bytesoftype, h, superblock, &entry);
+	if STENOS_UNLIKELY (stenos::has_error(offset))
+		return offset;
+
+	info->offset = offset;
+	info->compressed_size = 4 + stenos::read_uint32_3(src + offset + 1) + h.checksum_size;
+	info->decompressed_offset = superblock * h.superblock_size;
+	info->decompressed_size = std::min(h.superblock_size, h.decompressed_size - info->decompressed_offset);
+	info->mode = src[offset];
+	info->min = info->max = nullptr;
+	if (h.index_type >= STENOS_INDEX_MINMAX_SIGNED) {
+		info->min = entry + 8;
+		info->max = entry + 8 + bytesoftype;
+	}
+	return 0;
+}
+
+size_t stenos_decompress_range(stenos_context* opts, const void* _src, size_t bytesoftype, size_t size, size_t offset, size_t length, void* _dst)
+{
+	// Public API, decompress a range of bytes from a frame
+
+	if STENOS_UNLIKELY (bytesoftype == 0 || bytesoftype >= STENOS_MAX_BYTESOFTYPE)
+		return STENOS_ERROR_INVALID_BYTESOFTYPE;
+
+	const uint8_t* src = (const uint8_t*)_src;
+	const uint8_t* end_src = src + size;
+	uint8_t* dst = (uint8_t*)_dst;
+
+	// Read frame header
+	stenos::FrameHeader h;
+	size_t r = stenos::read_frame_header(src, bytesoftype, size, h);
+	if STENOS_UNLIKELY (stenos::has_error(r))
+		return r;
+	if STENOS_UNLIKELY (offset > h.decompressed_size || length > h.decompressed_size - offset)
+		return STENOS_ERROR_INVALID_PARAMETER;
+	if (length == 0)
+		return 0;
+	const ZSTD_DDict* ddict = nullptr;
+	r = stenos::frame_dictionary(opts, h, ddict);
+	if STENOS_UNLIKELY (stenos::has_error(r))
+		return r;
+
+	opts->set_superblock_size(h.superblock_size);
+	if STENOS_UNLIKELY (stenos::has_error(opts->ensure_has_buffers(1)))
+		return STENOS_ERROR_ALLOC;
+
+	// Locate the first superblock. Following ones are contiguous.
+	size_t first = offset / h.superblock_size;
+	size_t last = (offset + length - 1) / h.superblock_size;
+	const uint8_t* entry = nullptr;
+	size_t pos = stenos::locate_superblock(src, size, bytesoftype, h, first, &entry);
+	if STENOS_UNLIKELY (stenos::has_error(pos))
+		return pos;
+	src += pos;
+
+	for (size_t i = first; i <= last; ++i) {
+
+		if STENOS_UNLIKELY (src + 4 > end_src)
+			return STENOS_ERROR_SRC_OVERFLOW;
+
+		uint8_t code = *src++;
+		unsigned csize = stenos::read_uint32_3(src);
+		src += 3;
+		if STENOS_UNLIKELY (src + csize + h.checksum_size > end_src)
+			return STENOS_ERROR_INVALID_INPUT;
+		if STENOS_UNLIKELY (h.checksum_size && !stenos::check_superblock(src - 4, csize))
+			return STENOS_ERROR_CHECKSUM;
+
+		// Requested range within this superblock
+		size_t start = i * h.superblock_size;
+		size_t dsize = std::min(h.superblock_size, h.decompressed_size - start);
+		size_t from = offset > start ? offset - start : 0;
+		size_t to = std::min(dsize, offset + length - start);
+
+		if (from == 0 && to == dsize) {
+			// Full superblock, decompress in place
+			size_t ret = stenos::decompress_generic_superblock(opts, code, src, bytesoftype, csize, dst, dsize, opts->tmp_buffers1[0], opts->dctxs[0], ddict);
+			if STENOS_UNLIKELY (ret != dsize)
+				return ret;
+		}
+		else {
+			// Partial superblock, decompress to buffer
+			stenos::CBuffer* buffer = stenos::get_staging_buffer(opts);
+			if STENOS_UNLIKELY (!buffer)
+				return STENOS_ERROR_ALLOC;
+			size_t ret = stenos::decompress_generic_superblock(opts, code, src, bytesoftype, csize, (uint8_t*)buffer->bytes, dsize, opts->tmp_buffers1[0], opts->dctxs[0], ddict);
+			if STENOS_UNLIKELY (ret != dsize)
+				return ret;
+			memcpy(dst, buffer->bytes + from, to - from);
+		}
+		dst += to - from;
+		src += csize + h.checksum_size;
+	}
+
+	return length;
+}
+
+size_t stenos_verify(stenos_context* opts, const void* _src, size_t bytesoftype, size_t size)
+{
+	// Public API, check the superblock checksums of a frame
+
+	if STENOS_UNLIKELY (bytesoftype == 0 || bytesoftype >= STENOS_MAX_BYTESOFTYPE)
+		return STENOS_ERROR_INVALID_BYTESOFTYPE;
+
+	const uint8_t* src = (const uint8_t*)_src;
+	stenos::FrameHeader h;
+	size_t r = stenos::read_frame_header(src, bytesoftype, size, h);
+	if STENOS_UNLIKELY (stenos::has_error(r))
+		return r;
+	if STENOS_UNLIKELY (h.checksum_size == 0)
+		return STENOS_ERROR_INVALID_INPUT;
+
+	size_t super_block_count = h.decompressed_size / h.superblock_size + (h.decompressed_size % h.superblock_size ? 1 : 0);
+	size_t index_bytes = stenos::index_size(h.index_type, bytesoftype, super_block_count);
+	if STENOS_UNLIKELY (size < h.header_size + index_bytes)
+		return STENOS_ERROR_SRC_OVERFLOW;
+	const size_t end = size - index_bytes;
+
+	// Walk the superblock headers to gather their offsets
+	std::vector<size_t> offsets;
+	try {
+		offsets.resize(super_block_count);
+	}
+	catch (...) {
+		return STENOS_ERROR_ALLOC;
+	}
+	size_t pos = h.header_size;
+	for (size_t i = 0; i < super_block_count; ++i) {
+		if STENOS_UNLIKELY (pos + 4 > end)
+			return STENOS_ERROR_SRC_OVERFLOW;
+		offsets[i] = pos;
+		pos += 4 + stenos::read_uint32_3(src + pos + 1) + h.checksum_size;
+	}
+	if STENOS_UNLIKELY (pos > end)
+		return STENOS_ERROR_SRC_OVERFLOW;
+	if STENOS_UNLIKELY (pos != end)
+		return STENOS_ERROR_INVALID_INPUT;
+
+	auto check = [&](size_t first, size_t last) {
+		// Check superblocks in [first, last)
+		for (size_t i = first; i < last; ++i)
+			if (!stenos::check_superblock(src + offsets[i], stenos::read_uint32_3(src + offsets[i] + 1)))
+				return false;
+		return true;
+	};
+
+	const size_t threads = std::min((size_t)std::max(opts->threads, 1), super_block_count);
+	if (threads <= 1)
+		return check(0, super_block_count) ? 0 : STENOS_ERROR_CHECKSUM;
+
+	// Parallel check of contiguous ranges of superblocks
+	std::atomic<bool> valid{ true };
+	stenos::task_group group(stenos::context_pool(opts), &opts->exec);
+	for (size_t i = 0; i < threads; ++i) {
+		size_t first = super_block_count * i / threads;
+		size_t last = super_block_count * (i + 1) / threads;
+		if (!group.run([&, first, last]() {
+			    if (!check(first, last))
+				    valid.store(false);
+		    })) {
+			group.wait();
+			return STENOS_ERROR_ALLOC;
+		}
+	}
+	group.wait();
+	return valid.load() ? 0 : STENOS_ERROR_CHECKSUM;
+}
+
+template<class R>
+static size_t reduce_frame(stenos_context* opts, const uint8_t* src, size_t bytesoftype, size_t size, R& res) noexcept
+{
+	// Reduce all superblocks of a frame in parallel, and merge the partial results in order
+
+	struct Block
+	{
+		const uint8_t* src;
+		const uint8_t* entry; // Index entry with matching min/max values, or null
+		unsigned csize;
+		unsigned dsize;
+		uint8_t code;
+		size_t ret;
+	};
+
+	const uint8_t* end_src = src + size;
+	stenos::FrameHeader h;
+	size_t header_size = stenos::read_frame_header(src, bytesoftype, size, h);
+	if STENOS_UNLIKELY (stenos::has_error(header_size))
+		return header_size;
+	const size_t decompressed = h.decompressed_size;
+	if (decompressed == 0)
+		return 0;
+
+	const ZSTD_DDict* ddict = nullptr;
+	size_t r = stenos::frame_dictionary(opts, h, ddict);
+	if STENOS_UNLIKELY (stenos::has_error(r))
+		return r;
+
+	opts->set_superblock_size(h.superblock_size);
+
+	// Read superblock headers
+	const size_t super_block_count = decompressed / h.superblock_size + (decompressed % h.superblock_size ? 1 : 0);
+	const bool use_index = h.index_type == R::index_type;
+	std::vector<Block> blocks;
+	std::vector<R> partials;
+	try {
+		blocks.resize(super_block_count);
+		partials.resize(super_block_count, res);
+	}
+	catch (...) {
+		return STENOS_ERROR_ALLOC;
+	}
+	const uint8_t* p = src + header_size;
+	for (size_t i = 0; i < super_block_count; ++i) {
+		if STENOS_UNLIKELY (p + 4 > end_src)
+			return STENOS_ERROR_SRC_OVERFLOW;
+		Block& bl = blocks[i];
+		bl.code = *p;
+		bl.csize = stenos::read_uint32_3(p + 1);
+		bl.dsize = (unsigned)std::min(h.superblock_size, decompressed - i * h.superblock_size);
+		bl.src = p + 4;
+		bl.entry = nullptr;
+		bl.ret = 0;
+		if (use_index) {
+			size_t offset = stenos::locate_superblock(src, size, bytesoftype, h, i, &bl.entry);
+			if STENOS_UNLIKELY (stenos::has_error(offset))
+				return offset;
+		}
+		p += 4 + bl.csize + h.checksum_size;
+		if STENOS_UNLIKELY (p > end_src)
+			return STENOS_ERROR_INVALID_INPUT;
+	}
+
+	const size_t workers = opts->thread_count(super_block_count);
+	if STENOS_UNLIKELY (stenos::has_error(opts->ensure_has_buffers((int)workers)))
+		return STENOS_ERROR_ALLOC;
+
+	run_batch(opts, super_block_count, workers, [&](size_t w, size_t i) {
+		Block& bl = blocks[i];
+		if (bl.entry && partials[i].from_index(bl.entry + 8, bl.entry + 8 + bytesoftype, bl.dsize / bytesoftype))
+			return;
+		if STENOS_UNLIKELY (h.checksum_size && !stenos::check_superblock(bl.src - 4, bl.csize)) {
+			bl.ret = STENOS_ERROR_CHECKSUM;
+			return;
+		}
+		bl.ret = stenos::reduce_superblock(opts, bl.code, bl.src, bytesoftype, bl.csize, bl.dsize, w, ddict, partials[i]);
+	});
+
+	for (size_t i = 0; i < super_block_count; ++i) {
+		if STENOS_UNLIKELY (stenos::has_error(blocks[i].ret))
+			return blocks[i].ret;
+		res.merge(partials[i]);
+	}
+	return 0;
+}
+
+size_t stenos_reduce(stenos_context* ctx, const void* src, size_t bytesoftype, size_t bytes, int op, const void* value, void* out)
+{
+	// Public API, compressed-domain reduction of a frame
+
+	if STENOS_UNLIKELY (bytesoftype == 0 || bytesoftype >= STENOS_MAX_BYTESOFTYPE)
+		return STENOS_ERROR_INVALID_BYTESOFTYPE;
+	return stenos::with_reducer(bytesoftype, op, value, [&](auto& r) -> size_t {
+		size_t ret = reduce_frame(ctx, (const uint8_t*)src, bytesoftype, bytes, r);
+		if STENOS_UNLIKELY (stenos::has_error(ret))
+			return ret;
+		r.write(out);
+		return (size_t)r.count;
+	});
+}
+
+namespace stenos
+{
+	/// @brief Use the parameters of an existing frame (superblock size, index, checksum and dictionary)
+	/// to compress superblocks of this frame. Context parameters are restored on destruction.
+	struct FrameEditScope
+	{
+		stenos_context_s* ctx;
+		int index_type;
+		bool checksum;
+		const stenos_dict_s* dict;
+
+		FrameEditScope(stenos_context_s* c, const FrameHeader& h) noexcept
+		  : ctx(c)
+		  , index_type(c->index_type)
+		  , checksum(c->checksum)
+		  , dict(c->dict)
+		{
+			ctx->index_type = h.index_type;
+			ctx->checksum = h.checksum_size != 0;
+			if (!(h.flags & STENOS_FRAME_FLAG_DICT))
+				ctx->dict = nullptr;
+			ctx->set_superblock_size(h.superblock_size);
+		}
+		~FrameEditScope() noexcept
+		{
+			ctx->index_type = index_type;
+			ctx->checksum = checksum;
+			ctx->dict = dict;
+		}
+	};
+}
+
+size_t stenos_append_bound(const void* frame, size_t bytesoftype, size_t frame_size, size_t bytes)
+{
+	// Frame capacity required to append bytes: new superblocks are compressed
+	// after the frame with a temporary header and index before being moved
+	if STENOS_UNLIKELY (bytesoftype == 0 || bytesoftype >= STENOS_MAX_BYTESOFTYPE)
+		return STENOS_ERROR_INVALID_BYTESOFTYPE;
+	stenos::FrameHeader h;
+	size_t r = stenos::read_frame_header(frame, bytesoftype, frame_size, h);
+	if STENOS_UNLIKELY (stenos::has_error(r))
+		return r;
+	size_t total = h.decompressed_size % h.superblock_size + bytes;
+	size_t super_block_count = total / h.superblock_size + (total % h.superblock_size ? 1 : 0);
+	return frame_size + 17 + total + super_block_count * (4 + h.checksum_size) + stenos::index_size(h.index_type, bytesoftype, super_block_count);
+}
+
+size_t stenos_append(stenos_context* ctx, void* _frame, size_t frame_size, size_t frame_capacity, const void* _src, size_t bytesoftype, size_t bytes)
+{
+	// Public API, append bytes to a compressed frame
+
+	if STENOS_UNLIKELY (bytesoftype == 0 || bytesoftype >= STENOS_MAX_BYTESOFTYPE)
+		return STENOS_ERROR_INVALID_BYTESOFTYPE;
+	if STENOS_UNLIKELY (frame_capacity < frame_size)
+		return STENOS_ERROR_INVALID_PARAMETER;
+
+	uint8_t* frame = (uint8_t*)_frame;
+	const uint8_t* src = (const uint8_t*)_src;
+	stenos::FrameHeader h;
+	size_t r = stenos::read_frame_header(frame, bytesoftype, frame_size, h);
+	if STENOS_UNLIKELY (stenos::has_error(r))
+		return r;
+	const ZSTD_DDict* ddict = nullptr;
+	r = stenos::frame_dictionary(ctx, h, ddict);
+	if STENOS_UNLIKELY (stenos::has_error(r))
+		return r;
+	if (bytes == 0)
+		return frame_size;
+	// The decompressed size is stored on 7 bytes
+	if STENOS_UNLIKELY (bytes > (1ull << 56) - 1 - h.decompressed_size)
+		return STENOS_ERROR_INVALID_PARAMETER;
+
+	stenos::FrameEditScope scope(ctx, h);
+	if STENOS_UNLIKELY (stenos::has_error(ctx->ensure_has_buffers(1)))
+		return STENOS_ERROR_ALLOC;
+
+	const size_t superblock_size = h.superblock_size;
+	const size_t tail_size = h.decompressed_size % superblock_size;
+	const size_t super_block_count = h.decompressed_size / superblock_size + (tail_size ? 1 : 0);
+	const size_t index_bytes = stenos::index_size(h.index_type, bytesoftype, super_block_count);
+	const size_t entry_size = stenos::index_entry_size(h.index_type, bytesoftype);
+	if STENOS_UNLIKELY (frame_size < h.header_size + index_bytes)
+		return STENOS_ERROR_SRC_OVERFLOW;
+	if STENOS_UNLIKELY (index_bytes && stenos::read_LE_32(frame + frame_size - 4) != super_block_count * entry_size)
+		return STENOS_ERROR_INVALID_INPUT;
+
+	// The trailing partial superblock (if any) is replaced, and the new bytes
+	// not fitting in it are compressed to new superblocks
+	const size_t end = frame_size - index_bytes; // End of superblocks
+	size_t tail_offset = end;
+	const uint8_t* entry = nullptr;
+	if (tail_size) {
+		tail_offset = stenos::locate_superblock(frame, frame_size, bytesoftype, h, super_block_count - 1, &entry);
+		if STENOS_UNLIKELY (stenos::has_error(tail_offset))
+			return tail_offset;
+	}
+	const size_t fill = tail_size ? std::min(superblock_size - tail_size, bytes) : 0;
+	const size_t rest = bytes - fill;
+	const size_t rest_count = rest / superblock_size + (rest % superblock_size ? 1 : 0);
+	const size_t kept = tail_size ? super_block_count - 1 : super_block_count;
+	const size_t new_count = super_block_count + rest_count;
+
+	// Build the new index, keeping the entries of unmodified superblocks
+	std::vector<uint8_t> index;
+	if (h.index_type != STENOS_INDEX_NONE) {
+		try {
+			index.resize(stenos::index_size(h.index_type, bytesoftype, new_count));
+		}
+		catch (...) {
+			return STENOS_ERROR_ALLOC;
+		}
+		if (kept)
+			memcpy(index.data(), frame + end, kept * entry_size);
+		stenos::write_LE_32(index.data() + index.size() - 4, (unsigned)(new_count * entry_size));
+	}
+
+	// New superblocks are compressed after the frame, which is only modified once everything succeeded
+	uint8_t* out = frame + frame_size;
+	uint8_t* const out_end = frame + frame_capacity;
+	ctx->start_time_constraint(tail_size + bytes);
+
+	size_t tail_csize = 0;
+	if (tail_size) {
+		// Decompress the trailing superblock and complete it with the new bytes
+		const uint8_t* p = frame + tail_offset;
+		uint8_t code = *p;
+		unsigned csize = stenos::read_uint32_3(p + 1);
+		if STENOS_UNLIKELY (tail_offset + 4 + csize + h.checksum_size != end)
+			return STENOS_ERROR_INVALID_INPUT;
+		if STENOS_UNLIKELY (h.checksum_size && !stenos::check_superblock(p, csize))
+			return STENOS_ERROR_CHECKSUM;
+
+		stenos::CBuffer* staging = stenos::get_staging_buffer(ctx);
+		if STENOS_UNLIKELY (!staging)
+			return STENOS_ERROR_ALLOC;
+		size_t ret = stenos::decompress_generic_superblock(ctx, code, p + 4, bytesoftype, csize, (uint8_t*)staging->bytes, tail_size, ctx->tmp_buffers1[0], ctx->dctxs[0], ddict);
+		if STENOS_UNLIKELY (ret != tail_size)
+			return stenos::has_error(ret) ? ret : STENOS_ERROR_INVALID_INPUT;
+		memcpy(staging->bytes + tail_size, src, fill);
+
+		const size_t in_size = tail_size + fill;
+		tail_csize = stenos::compress_frame_superblock(
+		  ctx, super_block_count - 1, staging->bytes, bytesoftype, in_size, out, (size_t)(out_end - out), ctx->tmp_buffers1[0], ctx->tmp_buffers2[0]);
+		if STENOS_UNLIKELY (stenos::has_error(tail_csize))
+			return tail_csize;
+		if (ctx->t.nanoseconds)
+			ctx->t.processed_bytes.fetch_add(in_size);
+		if (index.size())
+			stenos::write_index_entry(h.index_type, bytesoftype, tail_offset, staging->bytes, in_size, index.data() + kept * entry_size);
+	}
+
+	const uint8_t* rest_start = out + tail_csize;
+	size_t rest_csize = 0;
+	if (rest) {
+		// Compress the remaining bytes as a frame whose header and index are dropped
+		uint8_t* dst = out + tail_csize;
+		r = compress_frame_superblocks(ctx, -1, src + fill, nullptr, bytesoftype, rest, dst, (size_t)(out_end - dst), super_block_count);
+		if STENOS_UNLIKELY (stenos::has_error(r))
+			return r;
+		size_t header_size = stenos::frame_header_size(*dst);
+		rest_start = dst + header_size;
+		rest_csize = r - header_size;
+
+		if (index.size()) {
+			uint8_t* e = index.data() + super_block_count * entry_size;
+			size_t pos = 0;
+			for (size_t i = 0; i < rest_count; ++i, e += entry_size) {
+				size_t offset = i * superblock_size;
+				stenos::write_index_entry(
+				  h.index_type, bytesoftype, tail_offset + tail_csize + pos, src + fill + offset, std::min(superblock_size, rest - offset), e);
+				pos += 4 + stenos::read_uint32_3(rest_start + pos + 1) + h.checksum_size;
+			}
+		}
+	}
+
+	const size_t new_size = tail_offset + tail_csize + rest_csize + index.size();
+	if STENOS_UNLIKELY (new_size > frame_capacity)
+		return STENOS_ERROR_DST_OVERFLOW;
+
+	// Move the new superblocks to their final position, write the index and the new decompressed size
+	memmove(frame + tail_offset, out, tail_csize);
+	memmove(frame + tail_offset + tail_csize, rest_start, rest_csize);
+	if (index.size())
+		memcpy(frame + new_size - index.size(), index.data(), index.size());
+	stenos::write_uint64_7(frame + 1, h.decompressed_size + bytes);
+	return new_size;
+}
+
+size_t stenos_replace_superblock(
+  stenos_context* ctx, void* _frame, size_t frame_size, size_t frame_capacity, size_t superblock, const void* src, size_t bytesoftype, size_t bytes)
+{
+	// Public API, replace the content of a superblock
+
+	if STENOS_UNLIKELY (bytesoftype == 0 || bytesoftype >= STENOS_MAX_BYTESOFTYPE)
+		return STENOS_ERROR_INVALID_BYTESOFTYPE;
+	if STENOS_UNLIKELY (frame_capacity < frame_size)
+		return STENOS_ERROR_INVALID_PARAMETER;
+
+	uint8_t* frame = (uint8_t*)_frame;
+	stenos::FrameHeader h;
+	size_t r = stenos::read_frame_header(frame, bytesoftype, frame_size, h);
+	if STENOS_UNLIKELY (stenos::has_error(r))
+		return r;
+	const ZSTD_DDict* ddict = nullptr;
+	r = stenos::frame_dictionary(ctx, h, ddict);
+	if STENOS_UNLIKELY (stenos::has_error(r))
+		return r;
+	size_t super_block_count = h.decompressed_size / h.superblock_size + (h.decompressed_size % h.superblock_size ? 1 : 0);
+	if STENOS_UNLIKELY (superblock >= super_block_count || bytes != std::min(h.superblock_size, h.decompressed_size - superblock * h.superblock_size))
+		return STENOS_ERROR_INVALID_PARAMETER;
+
+	stenos::FrameEditScope scope(ctx, h);
+	if STENOS_UNLIKELY (stenos::has_error(ctx->ensure_has_buffers(1)))
+		return STENOS_ERROR_ALLOC;
+
+	const uint8_t* entry = nullptr;
+	size_t offset = stenos::locate_superblock(frame, frame_size, bytesoftype, h, superblock, &entry);
+	if STENOS_UNLIKELY (stenos::has_error(offset))
+		return offset;
+	const size_t index_bytes = stenos::index_size(h.index_type, bytesoftype, super_block_count);
+	const size_t old_csize = 4 + stenos::read_uint32_3(frame + offset + 1) + h.checksum_size;
+	if STENOS_UNLIKELY (offset + old_csize + index_bytes > frame_size)
+		return STENOS_ERROR_INVALID_INPUT;
+
+	// Compress the new content to the staging buffer
+	stenos::CBuffer* staging = stenos::get_staging_buffer(ctx);
+	if STENOS_UNLIKELY (!staging)
+		return STENOS_ERROR_ALLOC;
+	ctx->start_time_constraint(bytes);
+	size_t csize = stenos::compress_frame_superblock(
+	  ctx, superblock, src, bytesoftype, bytes, staging->bytes, ctx->superblock_size + ctx->superblock_overhead(), ctx->tmp_buffers1[0], ctx->tmp_buffers2[0]);
+	if STENOS_UNLIKELY (stenos::has_error(csize))
+		return csize;
+	const size_t new_size = frame_size - old_csize + csize;
+	if STENOS_UNLIKELY (new_size > frame_capacity)
+		return STENOS_ERROR_DST_OVERFLOW;
+
+	// Move the following superblocks and the index
+	memmove(frame + offset + csize, frame + offset + old_csize, frame_size - offset - old_csize);
+	memcpy(frame + offset, staging->bytes, csize);
+
+	if (index_bytes) {
+		// Update the replaced entry and shift the offsets of following superblocks
+		const size_t entry_size = stenos::index_entry_size(h.index_type, bytesoftype);
+		uint8_t* e = frame + new_size - index_bytes + superblock * entry_size;
+		stenos::write_index_entry(h.index_type, bytesoftype, offset, src, bytes, e);
+		for (size_t i = superblock + 1; i < super_block_count; ++i) {
+			e += entry_size;
+			stenos::write_LE_64(e, (uint64_t)stenos::read_LE_64(e) + csize - old_csize);
+		}
+	}
+	return new_size;
+}
+
+size_t stenos_compress(const void* src, size_t bytesoftype, size_t bytes, void* dst, size_t dst_size, int level)
+{
+	// Public API, simplified compression function only using a compression level as parameter.
+
+	// Create the context on the stack
+	stenos_context_s opts;
+	opts.level = level > 9 ? 9 : (level < 0 ? 0 : level);
+	return stenos_compress_generic(&opts, src, bytesoftype, bytes, dst, dst_size);
+}
+size_t stenos_decompress(const void* src, size_t bytesoftype, size_t bytes, void* dst, size_t dst_size)
+{
+	// Public API, simplified decompression function.
+
+	// Create the context on the stack
+	stenos_context_s opts;
+	return stenos_decompress_generic(&opts, src, bytesoftype, bytes, dst, dst_size);
+}
+
+//
+// Streaming compression/decompression
+//
+
+// Streaming compression state
+struct stenos_cstream_s
+{
+	stenos_context* ctx{ nullptr };
+	size_t bytesoftype{ 0 };
+	size_t total_bytes{ 0 }; // Declared frame size
+	size_t processed{ 0 };	 // Bytes received so far
+	size_t pending{ 0 };	 // Bytes waiting in the staging buffer
+	size_t written{ 0 };	 // Frame bytes written so far
+	size_t superblocks{ 0 }; // Superblocks compressed so far
+	std::vector<uint8_t> index; // Superblock index entries
+	bool started{ false };
+};
+
+// Streaming decompression state
+struct stenos_dstream_s
+{
+	enum State
+	{
+		Idle,
+		Header,
+		Superblocks,
+		Index,
+		Done
+	};
+	stenos_context* ctx{ nullptr };
+	size_t bytesoftype{ 0 };
+	size_t decompressed_size{ 0 }; // Frame size read from header
+	size_t written{ 0 };	       // Bytes decompressed so far
+	size_t pending{ 0 };	       // Bytes waiting in the header or staging buffer
+	size_t index_bytes{ 0 };       // Remaining bytes of the superblock index
+	size_t checksum_size{ 0 };     // Size of the checksum following each superblock
+	const ZSTD_DDict* ddict{ nullptr }; // Dictionary of the frame, if any
+	uint8_t header[24];
+	State state{ Idle };
+};
+
+namespace stenos
+{
+	static inline size_t cstream_compress_superblock(stenos_cstream_s* s, const void* src, size_t bytes, uint8_t* dst, size_t dst_size) noexcept
+	{
+		// Compress one superblock of the stream
+		stenos_context_s* ctx = s->ctx;
+		if (ctx->index_type != STENOS_INDEX_NONE) {
+			// Add index entry
+			size_t entry_size = index_entry_size(ctx->index_type, s->bytesoftype);
+			try {
+				s->index.resize(s->index.size() + entry_size);
+			}
+			catch (...) {
+				return STENOS_ERROR_ALLOC;
+			}
+			write_index_entry(ctx->index_type, s->bytesoftype, s->written, src, bytes, s->index.data() + s->index.size() - entry_size);
+		}
+		size_t r = compress_frame_superblock(ctx, s->superblocks++, src, s->bytesoftype, bytes, dst, dst_size, ctx->tmp_buffers1[0], ctx->tmp_buffers2[0]);
+		if (has_error(r))
+			return r;
+		if (ctx->t.nanoseconds)
+			ctx->t.processed_bytes.fetch_add(bytes);
+		s->written += r;
+		return r;
+	}
+}
+
+stenos_cstream* stenos_make_cstream(stenos_context* ctx)
+{
+	if STENOS_UNLIKELY (!ctx)
+		return nullptr;
+	stenos_cstream* s = (stenos_cstream*)malloc(sizeof(stenos_cstream_s));
+	if STENOS_UNLIKELY (!s)
+		return nullptr;
+	new (s) stenos_cstream_s();
+	s->ctx = ctx;
+	return s;
+}
+
+void stenos_destroy_cstream(stenos_cstream* s)
+{
+	if (s) {
+		s->~stenos_cstream_s();
+		free(s);
+	}
+}
+
+size_t stenos_cstream_begin(stenos_cstream* s, size_t bytesoftype, size_t bytes, void* dst, size_t dst_size)
+{
+	// Start a new frame and write its header
+	s->started = false;
+
+	size_t prep = s->ctx->prepare(bytesoftype, bytes);
+	if STENOS_UNLIKELY (stenos::has_error(prep))
+		return prep;
+	if STENOS_UNLIKELY (stenos::has_error(s->ctx->ensure_has_buffers(1)))
+		return STENOS_ERROR_ALLOC;
+
+	size_t r = stenos::write_frame_header(s->ctx, bytes, dst, dst_size);
+	if STENOS_UNLIKELY (stenos::has_error(r))
+		return r;
+
+	s->bytesoftype = bytesoftype;
+	s->total_bytes = bytes;
+	s->processed = 0;
+	s->pending = 0;
+	s->written = r;
+	s->superblocks = 0;
+	s->index.clear();
+	s->started = true;
+	return r;
+}
+
+size_t stenos_cstream_bound(const stenos_cstream* s, size_t bytes)
+{
+	// Worst case output of stenos_cstream_compress() followed by stenos_cstream_end()
+	size_t total = s->pending + bytes;
+	size_t superblock_size = s->ctx->superblock_size;
+	if STENOS_UNLIKELY (superblock_size == 0)
+		return 0;
+	size_t super_block_count = total / superblock_size + (total % superblock_size ? 1 : 0);
+	size_t frame_super_block_count = s->total_bytes / superblock_size + (s->total_bytes % superblock_size ? 1 : 0);
+	return super_block_count * s->ctx->superblock_overhead() + total + stenos::index_size(s->ctx->index_type, s->bytesoftype, frame_super_block_count);
+}
+
+size_t stenos_cstream_compress(stenos_cstream* s, const void* _src, size_t bytes, void* _dst, size_t dst_size)
+{
+	// Push bytes to the stream and emit each completed superblock
+
+	if STENOS_UNLIKELY (!s->started)
+		return STENOS_ERROR_INVALID_PARAMETER;
+	if STENOS_UNLIKELY (bytes > s->total_bytes - s->processed)
+		return STENOS_ERROR_SRC_OVERFLOW;
+	if STENOS_UNLIKELY (dst_size < stenos_cstream_bound(s, bytes))
+		return STENOS_ERROR_DST_OVERFLOW;
+
+	stenos_context_s* ctx = s->ctx;
+	const size_t superblock_size = ctx->superblock_size;
+	const uint8_t* src = (const uint8_t*)_src;
+	const uint8_t* src_end = src + bytes;
+	uint8_t* dst = (uint8_t*)_dst;
+	uint8_t* dst_end = dst + dst_size;
+
+	if (s->pending) {
+		// Complete the partial superblock
+		stenos::CBuffer* staging = stenos::get_staging_buffer(ctx);
+		if STENOS_UNLIKELY (!staging)
+			return STENOS_ERROR_ALLOC;
+		size_t to_copy = std::min(superblock_size - s->pending, bytes);
+		memcpy(staging->bytes + s->pending, src, to_copy);
+		s->pending += to_copy;
+		src += to_copy;
+		if (s->pending == superblock_size) {
+			size_t r = stenos::cstream_compress_superblock(s, staging->bytes, superblock_size, dst, (size_t)(dst_end - dst));
+			if STENOS_UNLIKELY (stenos::has_error(r))
+				return r;
+			dst += r;
+			s->pending = 0;
+		}
+	}
+
+	// Compress full superblocks directly from the input
+	while ((size_t)(src_end - src) >= superblock_size) {
+		size_t r = stenos::cstream_compress_superblock(s, src, superblock_size, dst, (size_t)(dst_end - dst));
+		if STENOS_UNLIKELY (stenos::has_error(r))
+			return r;
+		dst += r;
+		src += superblock_size;
+	}
+
+	if (src != src_end) {
+		// Store the remaining bytes
+		stenos::CBuffer* staging = stenos::get_staging_buffer(ctx);
+		if STENOS_UNLIKELY (!staging)
+			return STENOS_ERROR_ALLOC;
+		memcpy(staging->bytes + s->pending, src, (size_t)(src_end - src));
+		s->pending += (size_t)(src_end - src);
+	}
+
+	s->processed += bytes;
+	return (size_t)(dst - (uint8_t*)_dst);
+}
+
+size_t stenos_cstream_end(stenos_cstream* s, void* dst, size_t dst_size)
+{
+	// Flush the last partial superblock and finish the frame
+
+	if STENOS_UNLIKELY (!s->started)
+		return STENOS_ERROR_INVALID_PARAMETER;
+	if STENOS_UNLIKELY (s->processed != s->total_bytes)
+		return STENOS_ERROR_SRC_OVERFLOW;
+
+	if STENOS_UNLIKELY (dst_size < stenos_cstream_bound(s, 0))
+		return STENOS_ERROR_DST_OVERFLOW;
+
+	uint8_t* out = (uint8_t*)dst;
+	if (s->pending) {
+		stenos::CBuffer* staging = stenos::get_staging_buffer(s->ctx);
+		if STENOS_UNLIKELY (!staging)
+			return STENOS_ERROR_ALLOC;
+		size_t r = stenos::cstream_compress_superblock(s, staging->bytes, s->pending, out, dst_size);
+		if STENOS_UNLIKELY (stenos::has_error(r))
+			return r;
+		out += r;
+		s->pending = 0;
+	}
+	if (s->ctx->index_type != STENOS_INDEX_NONE) {
+		// Write superblock index
+		if (s->index.size())
+			memcpy(out, s->index.data(), s->index.size());
+		out += s->index.size();
+		stenos::write_LE_32(out, (unsigned)s->index.size());
+		out += 4;
+	}
+	s->started = false;
+	return (size_t)(out - (uint8_t*)dst);
+}
+
+stenos_dstream* stenos_make_dstream(stenos_context* ctx)
+{
+	if STENOS_UNLIKELY (!ctx)
+		return nullptr;
+	stenos_dstream* s = (stenos_dstream*)malloc(sizeof(stenos_dstream_s));
+	if STENOS_UNLIKELY (!s)
+		return nullptr;
+	new (s) stenos_dstream_s();
+	s->ctx = ctx;
+	return s;
+}
+
+void stenos_destroy_dstream(stenos_dstream* s)
+{
+	if (s) {
+		s->~stenos_dstream_s();
+		free(s);
+	}
+}
+
+size_t stenos_dstream_begin(stenos_dstream* s, size_t bytesoftype)
+{
+	// Start decoding a new frame
+	if STENOS_UNLIKELY (bytesoftype == 0 || bytesoftype >= STENOS_MAX_BYTESOFTYPE)
+		return STENOS_ERROR_INVALID_BYTESOFTYPE;
+	s->bytesoftype = bytesoftype;
+	s->decompressed_size = 0;
+	s->written = 0;
+	s->pending = 0;
+	s->state = stenos_dstream_s::Header;
+	return 0;
+}
+
+size_t stenos_dstream_decompress(stenos_dstream* s, const void* _src, size_t* src_size, void* _dst, size_t dst_size)
+{
+	// Push compressed bytes to the stream and decompress each completed superblock
+
+	if STENOS_UNLIKELY (s->state == stenos_dstream_s::Idle)
+		return STENOS_ERROR_INVALID_PARAMETER;
+
+	stenos_context_s* ctx = s->ctx;
+	const uint8_t* src = (const uint8_t*)_src;
+	const uint8_t* src_end = src + *src_size;
+	uint8_t* dst = (uint8_t*)_dst;
+	uint8_t* dst_end = dst + dst_size;
+
+	while (s->state == stenos_dstream_s::Header && src != src_end) {
+		// Accumulate the frame header (8 to 17 bytes)
+		size_t header_size = s->pending ? stenos::frame_header_size(s->header[0]) : 8;
+		size_t to_copy = std::min(header_size - s->pending, (size_t)(src_end - src));
+		memcpy(s->header + s->pending, src, to_copy);
+		s->pending += to_copy;
+		src += to_copy;
+		if (s->pending < stenos::frame_header_size(s->header[0]))
+			continue;
+
+		stenos::FrameHeader h;
+		size_t r = stenos::read_frame_header(s->header, s->bytesoftype, s->pending, h);
+		if STENOS_UNLIKELY (stenos::has_error(r))
+			return r;
+		r = stenos::frame_dictionary(ctx, h, s->ddict);
+		if STENOS_UNLIKELY (stenos::has_error(r))
+			return r;
+
+		ctx->set_superblock_size(h.superblock_size);
+		if STENOS_UNLIKELY (stenos::has_error(ctx->ensure_has_buffers(1)))
+			return STENOS_ERROR_ALLOC;
+
+		size_t super_block_count = h.decompressed_size / h.superblock_size + (h.decompressed_size % h.superblock_size ? 1 : 0);
+		s->decompressed_size = h.decompressed_size;
+		s->index_bytes = stenos::index_size(h.index_type, s->bytesoftype, super_block_count);
+		s->checksum_size = h.checksum_size;
+		s->pending = 0;
+		s->state = s->decompressed_size ? stenos_dstream_s::Superblocks : stenos_dstream_s::Index;
+	}
+
+	while (s->state == stenos_dstream_s::Superblocks) {
+
+		// Check that the next superblock fits in the output
+		size_t dsize = std::min(ctx->superblock_size, s->decompressed_size - s->written);
+		if ((size_t)(dst_end - dst) < dsize)
+			break;
+
+		const uint8_t* block = nullptr;
+		if (s->pending == 0 && src + 4 <= src_end && src + 4 + stenos::read_uint32_3(src + 1) + s->checksum_size <= src_end) {
+			// Full superblock available in the input
+			block = src;
+			src += 4 + stenos::read_uint32_3(src + 1) + s->checksum_size;
+		}
+		else {
+			// Accumulate the superblock in the staging buffer
+			if (src == src_end)
+				break;
+			stenos::CBuffer* staging = stenos::get_staging_buffer(ctx);
+			if STENOS_UNLIKELY (!staging)
+				return STENOS_ERROR_ALLOC;
+			if (s->pending < 4) {
+				size_t to_copy = std::min(4 - s->pending, (size_t)(src_end - src));
+				memcpy(staging->bytes + s->pending, src, to_copy);
+				s->pending += to_copy;
+				src += to_copy;
+				if (s->pending < 4)
+					break;
+			}
+			size_t block_size = 4 + stenos::read_uint32_3(staging->bytes + 1) + s->checksum_size;
+			if STENOS_UNLIKELY (block_size > ctx->superblock_size + 4 + s->checksum_size)
+				return STENOS_ERROR_INVALID_INPUT;
+			size_t to_copy = std::min(block_size - s->pending, (size_t)(src_end - src));
+			memcpy(staging->bytes + s->pending, src, to_copy);
+			s->pending += to_copy;
+			src += to_copy;
+			if (s->pending < block_size)
+				break;
+			block = (const uint8_t*)staging->bytes;
+			s->pending = 0;
+		}
+
+		uint8_t code = block[0];
+		unsigned csize = stenos::read_uint32_3(block + 1);
+		if STENOS_UNLIKELY (s->checksum_size && !stenos::check_superblock(block, csize))
+			return STENOS_ERROR_CHECKSUM;
+		size_t r = stenos::decompress_generic_superblock(ctx, code, block + 4, s->bytesoftype, csize, dst, dsize, ctx->tmp_buffers1[0], ctx->dctxs[0], s->ddict);
+		if STENOS_UNLIKELY (r != dsize)
+			return stenos::has_error(r) ? r : STENOS_ERROR_INVALID_INPUT;
+
+		dst += dsize;
+		s->written += dsize;
+		if (s->written == s->decompressed_size)
+			s->state = stenos_dstream_s::Index;
+	}
+
+	if (s->state == stenos_dstream_s::Index) {
+		// Skip the superblock index
+		size_t to_skip = std::min(s->index_bytes, (size_t)(src_end - src));
+		src += to_skip;
+		s->index_bytes -= to_skip;
+		if (s->index_bytes == 0)
+			s->state = stenos_dstream_s::Done;
+	}
+
+	// No progress possible: the output cannot hold the next superblock
+	if STENOS_UNLIKELY (s->state == stenos_dstream_s::Superblocks && src == (const uint8_t*)_src && dst == (uint8_t*)_dst && *src_size)
+		return STENOS_ERROR_DST_OVERFLOW;
+
+	*src_size = (size_t)(src - (const uint8_t*)_src);
+	return (size_t)(dst - (uint8_t*)_dst);
+}
+
+size_t stenos_dstream_end(stenos_dstream* s)
+{
+	// Finish decoding the current frame
+	if STENOS_UNLIKELY (s->state == stenos_dstream_s::Idle)
+		return STENOS_ERROR_INVALID_PARAMETER;
+	bool done = s->state == stenos_dstream_s::Done;
+	s->state = stenos_dstream_s::Idle;
+	return done ? 0 : STENOS_ERROR_SRC_OVERFLOW;
 }
 
 //
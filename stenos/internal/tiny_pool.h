@@ -34,6 +34,7 @@
 #include <atomic>
 #include <functional>
 #include <queue>
+#include <memory>
 
 namespace stenos
 {
@@ -84,8 +85,9 @@ namespace stenos
 
 				// Allocate
 				TaskBuffer* res = (TaskBuffer*)malloc(s + sizeof(TaskBuffer));
-				if (res)
-					new (res) TaskBuffer{ nullptr, s };
+				if (!res)
+					return nullptr;
+				new (res) TaskBuffer{ nullptr, s };
 				return res->data();
 			}
 
@@ -121,6 +123,7 @@ namespace stenos
 		{
 			BaseTask* left = nullptr;
 			BaseTask* right = nullptr;
+			const void* group = nullptr; // owning task_group, if any
 			virtual ~BaseTask() noexcept {}
 			virtual void apply() noexcept {};
 
@@ -179,6 +182,8 @@ namespace stenos
 			{
 				try {
 					Task<U>* t = (Task<U>*)allocate_task(sizeof(Task<U>));
+					if (!t)
+						return nullptr;
 					return new (t) Task<U>(std::forward<U>(u));
 				}
 				catch (...) {
@@ -214,63 +219,126 @@ namespace stenos
 				return r;
 			}
 
+			BaseTask* pop_back() noexcept
+			{
+				auto r = end.left;
+				r->remove();
+				return r;
+			}
+
+			BaseTask* pop_group(const void* group) noexcept
+			{
+				// Pop the newest task belonging to group, if any
+				for (auto* r = end.left; r != &end; r = r->left)
+					if (r->group == group) {
+						r->remove();
+						return r;
+					}
+				return nullptr;
+			}
+
 			bool empty() const noexcept { return &end == end.right; }
 		};
 	}
 
-	/// @brief Minimalist thread pool class.
-	/// Used to launch compression/decompression jobs using
-	/// a global pool created at program initialization.
+	/// @brief Work-stealing thread pool.
 	///
-	/// Uses a unique queue for all threads as this pattern
-	/// works well in our situation.
-	class tiny_pool
+	/// Each worker owns a task queue. Tasks pushed from a worker
+	/// go to its own queue, other tasks are distributed over
+	/// all queues. Idle workers steal tasks from other queues.
+	///
+	/// Waiting is performed on a task_group, not on the whole pool,
+	/// so that independent users of the same pool never wait for
+	/// each other's tasks.
+	class thread_pool
 	{
+		struct Queue
+		{
+			std::mutex lock;
+			detail::TaskList tasks;
+		};
+
+		std::vector<std::unique_ptr<Queue>> queues;
+		std::vector<std::thread> threads;
 		std::mutex mutex;
 		std::condition_variable condition;
-		std::condition_variable wait_condition;
-		detail::TaskList list;
-		std::vector<std::thread> threads;
+		std::atomic<size_t> queued{ 0 };
+		std::atomic<size_t> next_queue{ 0 };
 		bool finish = false;
-		bool waiting = false;
-		unsigned processing = 0;
 
-		void do_work() noexcept
+		struct CurrentWorker
 		{
-			while (!finish) {
-				std::unique_lock<std::mutex> lock(mutex);
-				--processing;
-
-				if (waiting && processing == 0 && list.empty())
-					wait_condition.notify_all();
+			thread_pool* pool;
+			size_t index;
+		};
+		static STENOS_ALWAYS_INLINE CurrentWorker& current_worker() noexcept
+		{
+			thread_local CurrentWorker w{ nullptr, 0 };
+			return w;
+		}
 
-				condition.wait(lock, [this] { return (!list.empty()) || this->finish; });
-				if STENOS_UNLIKELY (this->finish)
-					break;
+		detail::BaseTask* pop(size_t start) noexcept
+		{
+			// Pop a task from the queue at start position (newest task first),
+			// or steal one from another queue (oldest task first)
+			if (queued.load() == 0)
+				return nullptr;
+			for (size_t i = 0; i < queues.size(); ++i) {
+				Queue& q = *queues[(start + i) % queues.size()];
+				std::lock_guard<std::mutex> ll(q.lock);
+				if (!q.tasks.empty()) {
+					queued.fetch_sub(1);
+					return i == 0 ? q.tasks.pop_back() : q.tasks.pop_front();
+				}
+			}
+			return nullptr;
+		}
 
-				auto r = list.pop_front();
-				++processing;
-				lock.unlock();
+		detail::BaseTask* pop_group(const void* group, size_t start) noexcept
+		{
+			// Pop a task of given group, starting from the queue at start position
+			if (queued.load() == 0)
+				return nullptr;
+			for (size_t i = 0; i < queues.size(); ++i) {
+				Queue& q = *queues[(start + i) % queues.size()];
+				std::lock_guard<std::mutex> ll(q.lock);
+				if (auto* t = q.tasks.pop_group(group)) {
+					queued.fetch_sub(1);
+					return t;
+				}
+			}
+			return nullptr;
+		}
 
-				r->apply();
-				list.destroy_task(r);
+		void do_work(size_t index) noexcept
+		{
+			current_worker() = CurrentWorker{ this, index };
+			for (;;) {
+				if (auto* t = pop(index)) {
+					t->apply();
+					detail::TaskList::destroy_task(t);
+					continue;
+				}
+				std::unique_lock<std::mutex> lock(mutex);
+				condition.wait(lock, [this] { return queued.load() != 0 || finish; });
+				if STENOS_UNLIKELY (finish)
+					break;
 			}
 		}
 
 	public:
 		// Constructor, only function that might throw
-		tiny_pool(unsigned nthreads)
-		  : threads(nthreads)
-		  , processing(nthreads)
+		thread_pool(unsigned nthreads)
 		{
-			if (nthreads == 0) {
-				processing = 1;
-				threads.resize(1);
-			}
+			if (nthreads == 0)
+				nthreads = 1;
 			for (unsigned i = 0; i < nthreads; ++i)
-				threads[i] = std::thread([this]() { this->do_work(); });
+				queues.emplace_back(new Queue());
+			threads.resize(nthreads);
+			for (unsigned i = 0; i < nthreads; ++i)
+				threads[i] = std::thread([this, i]() { this->do_work(i); });
 		}
-		~tiny_pool() noexcept
+		~thread_pool() noexcept
 		{
 			{
 				std::unique_lock<std::mutex> lock(mutex);
@@ -281,24 +349,132 @@ namespace stenos
 				threads[i].join();
 		}
 
-		void wait() noexcept
+		/// @brief Returns the number of worker threads
+		size_t size() const noexcept { return threads.size(); }
+
+		/// @brief Run one pending task of given group in the calling thread, if any.
+		/// Tasks of other groups are never executed, so that a waiting thread
+		/// cannot be blocked by another user's long task.
+		/// Returns true if a task was executed.
+		bool run_one(const void* group) noexcept
 		{
-			std::unique_lock<std::mutex> lock(mutex);
-			waiting = true;
-			wait_condition.wait(lock, [this] { return (this->processing == 0) && this->list.empty(); });
-			waiting = false;
+			CurrentWorker& w = current_worker();
+			auto* t = pop_group(group, w.pool == this ? w.index : 0);
+			if (!t)
+				return false;
+			t->apply();
+			detail::TaskList::destroy_task(t);
+			return true;
 		}
 
+		/// @brief Push a task to the pool, optionally tagged with its owning group.
+		/// Returns false on allocation failure.
 		template<class U>
-		bool push(U&& u) noexcept
+		bool push(U&& u, const void* group = nullptr) noexcept
 		{
-			auto t = list.make_task(std::forward<U>(u));
-			if (t) {
+			auto t = detail::TaskList::make_task(std::forward<U>(u));
+			if (!t)
+				return false;
+			t->group = group;
+			CurrentWorker& w = current_worker();
+			size_t index = w.pool == this ? w.index : next_queue.fetch_add(1) % queues.size();
+			{
+				Queue& q = *queues[index];
+				std::lock_guard<std::mutex> ll(q.lock);
+				q.tasks.push_back(t);
+			}
+			queued.fetch_add(1);
+			{
 				std::lock_guard<std::mutex> lock(mutex);
-				list.push_back(t);
 			}
 			condition.notify_one();
-			return t;
+			return true;
+		}
+	};
+
+	/// @brief External executor used instead of a thread_pool.
+	/// submit(user_data, fn, task) must (eventually) call fn(task) from any thread.
+	/// If not null, wait(user_data) is called once all tasks of a group are submitted.
+	struct executor
+	{
+		void (*submit)(void* user_data, void (*fn)(void*), void* task);
+		void (*wait)(void* user_data);
+		void* user_data;
+	};
+
+	/// @brief Group of tasks launched on a thread_pool or an external executor.
+	/// wait() only waits for the tasks of this group,
+	/// and runs the pending tasks of this group (and only them) while waiting.
+	class task_group
+	{
+		thread_pool* pool;
+		const executor* exec;
+		std::mutex mutex;
+		std::condition_variable condition;
+		std::atomic<size_t> pending{ 0 };
+
+		void finish_one() noexcept
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			if (pending.fetch_sub(1) == 1)
+				condition.notify_all();
+		}
+
+		static void run_external(void* task) noexcept
+		{
+			// Task launched through an external executor
+			detail::BaseTask* t = (detail::BaseTask*)task;
+			t->apply();
+			detail::TaskList::destroy_task(t);
+		}
+
+	public:
+		/// @brief Construct from a thread pool, or from an executor if exec->submit is not null
+		task_group(thread_pool* p, const executor* e = nullptr) noexcept
+		  : pool(p)
+		  , exec(e && e->submit ? e : nullptr)
+		{
+		}
+		~task_group() noexcept { wait(); }
+
+		/// @brief Launch a task within this group.
+		/// Returns false on allocation failure.
+		template<class U>
+		bool run(U&& u) noexcept
+		{
+			pending.fetch_add(1);
+			auto task = [this, u]() mutable {
+				u();
+				finish_one();
+			};
+			bool res = false;
+			if (exec) {
+				// Submit to external executor
+				if (detail::BaseTask* t = detail::TaskList::make_task(std::move(task))) {
+					exec->submit(exec->user_data, run_external, t);
+					res = true;
+				}
+			}
+			else
+				res = pool->push(std::move(task), this);
+			if (!res)
+				finish_one();
+			return res;
+		}
+
+		/// @brief Wait for all tasks of this group
+		void wait() noexcept
+		{
+			if (exec && exec->wait && pending.load() != 0)
+				exec->wait(exec->user_data);
+			while (pending.load() != 0) {
+				if (pool && pool->run_one(this))
+					continue;
+				std::unique_lock<std::mutex> lock(mutex);
+				condition.wait(lock, [this] { return pending.load() == 0; });
+			}
+			// Make sure that the last task released the lock
+			std::lock_guard<std::mutex> lock(mutex);
 		}
 	};
 }
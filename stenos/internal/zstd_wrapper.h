@@ -27,7 +27,7 @@
 
 #include <atomic>
 #include <thread>
-#include <algorithm> // std::lower_bound
+#include <utility> // std::pair
 #include <zstd.h>
 #include <zstd_errors.h>
 #include "../bits.hpp"
@@ -35,6 +35,106 @@
 
 namespace stenos
 {
+	namespace detail
+	{
+		static STENOS_ALWAYS_INLINE const std::pair<unsigned, unsigned>* compress_rates() noexcept
+		{
+			// Returns an estimated compression rate in bytes/s for zstd
+			static const std::pair<unsigned, unsigned> rates[9] = { { 1000000, 9 },	 { 5000000, 8 },  { 7000000, 7 },   { 9000000, 6 },   { 20000000, 5 },
+										{ 40000000, 4 }, { 60000000, 3 }, { 230000000, 2 }, { 300000000u, 1 } };
+			return rates;
+		}
+
+		static STENOS_ALWAYS_INLINE double block_reference_rate() noexcept
+		{
+			// Block compression rate in bytes/s on the reference host
+#ifdef NDEBUG
+			return 2000000000.; // 2GB/s
+#else
+			return 200000000.; // 200MB/s
+#endif
+		}
+	}
+
+	// Online model of the compression rates in bytes/s, per mode (block or zstd),
+	// level and bytesoftype class. Starts from the rates measured on a reference host
+	// and follows observed rates using an exponentially weighted moving average.
+	// Updates are relaxed and might be lost when several threads record at once.
+	struct RateModel
+	{
+		static constexpr unsigned modes = 2;
+		static constexpr unsigned levels = 10;
+		static constexpr unsigned classes = 5; // bytesoftype 1, 2, 3-4, 5-8, 9+
+
+		std::atomic<double> rates[modes][levels][classes];
+
+		RateModel() noexcept { reset(); }
+
+		static STENOS_ALWAYS_INLINE unsigned bytesoftype_class(size_t bytesoftype) noexcept
+		{
+			if (bytesoftype <= 2)
+				return bytesoftype <= 1 ? 0 : 1;
+			return bytesoftype <= 4 ? 2 : (bytesoftype <= 8 ? 3 : 4);
+		}
+
+		static double reference(unsigned mode, unsigned level) noexcept
+		{
+			if (mode == STENOS_RATE_BLOCK)
+				return detail::block_reference_rate();
+			if (level == 0)
+				level = 1;
+			return detail::compress_rates()[9 - level].first;
+		}
+
+		void reset() noexcept
+		{
+			for (unsigned m = 0; m < modes; ++m)
+				for (unsigned l = 0; l < levels; ++l)
+					for (unsigned c = 0; c < classes; ++c)
+						rates[m][l][c].store(reference(m, l), std::memory_order_relaxed);
+		}
+
+		STENOS_ALWAYS_INLINE double get(unsigned mode, int level, size_t bytesoftype) const noexcept
+		{
+			return rates[mode][(unsigned)level][bytesoftype_class(bytesoftype)].load(std::memory_order_relaxed);
+		}
+
+		void set(unsigned mode, int level, size_t bytesoftype, double rate) noexcept
+		{
+			rates[mode][(unsigned)level][bytesoftype_class(bytesoftype)].store(rate, std::memory_order_relaxed);
+		}
+
+		STENOS_ALWAYS_INLINE void record(unsigned mode, int level, size_t bytesoftype, size_t bytes, uint64_t ns) noexcept
+		{
+			// Record an observed compression rate.
+			// Small inputs are ignored as their timing is not reliable.
+			if (bytes < 4096 || ns == 0 || level < 0 || level >= (int)levels)
+				return;
+			auto& r = rates[mode][(unsigned)level][bytesoftype_class(bytesoftype)];
+			double prev = r.load(std::memory_order_relaxed);
+			r.store(prev + (bytes * 1e9 / (double)ns - prev) * 0.25, std::memory_order_relaxed);
+		}
+
+		STENOS_ALWAYS_INLINE double host_factor(size_t bytesoftype) const noexcept
+		{
+			// Ratio between the reference host and this host speeds,
+			// used to express requested speeds in reference host units
+			double f = detail::block_reference_rate() / get(STENOS_RATE_BLOCK, 2, bytesoftype);
+			return f < 0.25 ? 0.25 : (f > 4 ? 4 : f);
+		}
+
+		int zstd_level_for_rate(size_t bytesoftype, size_t rate, unsigned shift) const noexcept
+		{
+			// Returns the best zstd level (0 to 9) reaching provided rate.
+			// 0 means to use memcpy directly.
+			double r = (double)rate / (double)(1u << shift);
+			for (int l = 9; l >= 1; --l)
+				if (get(STENOS_RATE_ZSTD, l, bytesoftype) >= r)
+					return l;
+			return r > get(STENOS_RATE_ZSTD, 1, bytesoftype) * 1.5 ? 0 : 1;
+		}
+	};
+
 	// Small class gathering information on a time constraint
 	struct TimeConstraint
 	{
@@ -43,6 +143,7 @@ namespace stenos
 		uint64_t total_bytes{ 0 };		    // Total number of bytes to compress
 		std::atomic<uint64_t> processed_bytes{ 0 }; // Currently processed bytes
 		std::atomic<bool> finish_memcpy{ false };   // Should we finish with memcpy
+		RateModel rates;			    // Observed compression rates
 	};
 
 	// Convert stenos level to zstd level
@@ -77,8 +178,14 @@ namespace stenos
 			return STENOS_ERROR_ALLOC;
 
 		size_t r = 0;
-		if (dict)
-			r = ZSTD_compress_usingCDict(ctx.ctx, dst, dstCapacity, src, srcSize, dict);
+		if (dict) {
+			// The dictionary ID is stored once in the stenos frame header,
+			// not in each zstd frame
+			ZSTD_CCtx_refCDict(ctx.ctx, dict);
+			ZSTD_CCtx_setParameter(ctx.ctx, ZSTD_c_dictIDFlag, 0);
+			r = ZSTD_compress2(ctx.ctx, dst, dstCapacity, src, srcSize);
+			ZSTD_CCtx_reset(ctx.ctx, ZSTD_reset_session_and_parameters);
+		}
 		else
 			r = ZSTD_compressCCtx(ctx.ctx, dst, dstCapacity, src, srcSize, zstd_from_reduced_level(level));
 
@@ -89,36 +196,27 @@ namespace stenos
 		return r;
 	}
 
-	namespace detail
+	// ZSTD decompression with optional dictionary.
+	// The decompression context is created on first use and reused afterward.
+	static STENOS_ALWAYS_INLINE size_t zstd_decompress_with_context(ZSTD_DCtx*& dctx, void* dst, size_t dstCapacity, const void* src, size_t srcSize, const ZSTD_DDict* dict = nullptr) noexcept
 	{
-
-		static STENOS_ALWAYS_INLINE const std::pair<unsigned, unsigned>* compress_rates() noexcept
-		{
-			// Returns an estimated compression rate in bytes/s for zstd
-			static const std::pair<unsigned, unsigned> rates[9] = { { 1000000, 9 },	 { 5000000, 8 },  { 7000000, 7 },   { 9000000, 6 },   { 20000000, 5 },
-										{ 40000000, 4 }, { 60000000, 3 }, { 230000000, 2 }, { 300000000u, 1 } };
-			return rates;
-		}
-
-		static STENOS_ALWAYS_INLINE int level_for_rate(const std::pair<unsigned, unsigned>* rates, size_t rate, unsigned shift) noexcept
-		{
-			// Returns the best compression level (0 to 9) based on provided rate.
-			// 0 means to use memcpy directly.
-			auto it = std::lower_bound(rates, rates + 9, rate, [shift](const auto& l, const auto& r) { return (l.first << shift) < r; });
-			if (it == rates + 9)
-				return rate > ((rates[8].first << shift) * 1.5) ? 0 : 1;
-			return it->second;
+		if STENOS_UNLIKELY (!dctx) {
+			dctx = ZSTD_createDCtx();
+			if (!dctx)
+				return (size_t)-ZSTD_error_memory_allocation;
 		}
+		if (dict)
+			return ZSTD_decompress_usingDDict(dctx, dst, dstCapacity, src, srcSize, dict);
+		return ZSTD_decompressDCtx(dctx, dst, dstCapacity, src, srcSize);
+	}
 
-		static STENOS_ALWAYS_INLINE int level_for_rate(size_t rate, unsigned shift) noexcept
-		{
-			return level_for_rate(compress_rates(), rate, shift);
-		}
+	namespace detail
+	{
 
-		static inline int clevel_for_remaining(TimeConstraint& t, size_t processed_bytes, size_t* target_rate = nullptr, unsigned shift = 0) noexcept
+		static inline int clevel_for_remaining(TimeConstraint& t, size_t bytesoftype, size_t processed_bytes, size_t* target_rate = nullptr, unsigned shift = 0) noexcept
 		{
 			// Compute the best possible compressoin level for remaining bytes
-			// based on the time constraint and the current compression rate
+			// based on the time constraint and the observed compression rates
 
 			int clevel = 0;
 
@@ -135,7 +233,7 @@ namespace stenos
 
 			{
 				size_t rate = target_rate ? *target_rate : ((size_t)(remaining_bytes / ((t.nanoseconds - el) * 1.e-9)));
-				clevel = detail::level_for_rate(rate, shift);
+				clevel = t.rates.zstd_level_for_rate(bytesoftype, rate, shift);
 				if (processed_bytes == 0)
 					return clevel < 1 ? 1 : clevel;
 
@@ -69,6 +69,29 @@ Disable custom block size with stenos_set_block_size()
 */
 #define STENOS_NO_BLOCK_SHIFT ((size_t)-1)
 
+/**
+Superblock index types used by stenos_set_index()
+*/
+#define STENOS_INDEX_NONE 0	       /* No index */
+#define STENOS_INDEX_OFFSETS 1	       /* Superblock offsets */
+#define STENOS_INDEX_MINMAX_SIGNED 2   /* Superblock offsets + min/max values as signed integers (bytesoftype 1, 2, 4 or 8) */
+#define STENOS_INDEX_MINMAX_UNSIGNED 3 /* Superblock offsets + min/max values as unsigned integers (bytesoftype 1, 2, 4 or 8) */
+#define STENOS_INDEX_MINMAX_FLOAT 4    /* Superblock offsets + min/max values as floating point values (bytesoftype 4 or 8) */
+
+/**
+Superblock compression modes, as reported by stenos_get_superblock_info()
+*/
+#define STENOS_MODE_BLOCK 1		    /* SIMD block compression */
+#define STENOS_MODE_ZSTD 2		    /* zstd compression */
+#define STENOS_MODE_TRANSPOSED_ZSTD 3	    /* zstd compression of transposed input */
+#define STENOS_MODE_TRANSPOSED_DELTA_ZSTD 4 /* zstd compression of transposed input + byte delta */
+#define STENOS_MODE_BLOCK_ZSTD 5	    /* SIMD block compression + zstd */
+#define STENOS_MODE_COPY 6		    /* No compression */
+#define STENOS_MODE_XOR_ZSTD 7		    /* zstd compression of transposed input XORed with previous element and bit transposed (bytesoftype 4 or 8) */
+#define STENOS_MODE_INT_DELTA_ZSTD 8	    /* zstd compression of transposed element-wise zigzag delta (bytesoftype 2, 4 or 8) */
+#define STENOS_MODE_INT_DELTA2_ZSTD 9	    /* zstd compression of transposed element-wise zigzag delta of delta (bytesoftype 2, 4 or 8) */
+#define STENOS_MODE_FIELDS 10		    /* Fields of a record layout compressed separately (see stenos_set_layout()) */
+
 /**
 Stenos error codes
 */
@@ -81,6 +104,8 @@ Stenos error codes
 #define STENOS_ERROR_INVALID_BYTESOFTYPE ((size_t)(-7))
 #define STENOS_ERROR_ZSTD_INTERNAL ((size_t)(-8))
 #define STENOS_ERROR_INVALID_PARAMETER ((size_t)(-9))
+#define STENOS_ERROR_CHECKSUM ((size_t)(-10))
+#define STENOS_ERROR_DICTIONARY ((size_t)(-11))
 #define STENOS_LAST_ERROR_CODE ((size_t)(-100))
 
 #ifdef __cplusplus
@@ -134,11 +159,165 @@ to 9 (maximum compression).
 */
 STENOS_EXPORT size_t stenos_set_level(stenos_context* ctx, int level);
 
+/**
+@brief Set the lowest compression level that selects each superblock compression mode through trial encodings.
+
+Below this level (and from level 3), the mode is picked up front by a cheap estimator scoring all
+strategies on a few sampled blocks. Trial encodings are still used when the estimator cannot decide.
+The default value is 8, so that levels 8 and 9 keep exhaustive trials. Use 10 to always use the estimator,
+or 0 to always use trial encodings. This has no effect when a time budget is set with stenos_set_max_nanoseconds().
+*/
+STENOS_EXPORT size_t stenos_set_exhaustive_level(stenos_context* ctx, int level);
+
+/**
+@brief Set the minimum decompression speed in bytes/s of the produced frames, 0 to disable (default).
+
+Superblock compression modes whose estimated decompression speed (see stenos_mode_decompression_speed())
+is below this value are discarded, usually in favor of the (faster to decode) SIMD block compression.
+For instance, a value of 2GB/s only allows modes STENOS_MODE_BLOCK and STENOS_MODE_COPY.
+This trades compression ratio for decompression speed, and is intended for data decompressed many times.
+*/
+STENOS_EXPORT size_t stenos_set_min_decompression_speed(stenos_context* ctx, uint64_t bytes_per_second);
+
+/**
+@brief Returns the estimated decompression speed in bytes/s (of decompressed data) of given superblock compression mode,
+or 0 for an invalid mode.
+
+Estimates correspond to a single core of a recent x86-64 CPU, and are used by stenos_set_min_decompression_speed().
+*/
+STENOS_EXPORT uint64_t stenos_mode_decompression_speed(int mode);
+
+/**
+@brief Statistics on the compression of a single superblock, passed to the superblock callback.
+*/
+typedef struct stenos_superblock_stats_s
+{
+	size_t index;	     /* Superblock position within its frame */
+	int mode;	     /* Compression mode (STENOS_MODE_BLOCK...) */
+	int level;	     /* Zstd level (1 to 9) used by the zstd stage, 0 if none */
+	int forced_memcpy;   /* 1 if the time budget forced (full or partial) memcpy, 0 otherwise */
+	size_t input_size;   /* Input size (bytes) */
+	size_t output_size;  /* Output size, including the superblock header and checksum (bytes) */
+	uint64_t guess_ns;   /* Time spent guessing the compression mode (LZ ratio estimation) */
+	uint64_t block_ns;   /* Time spent in block compression */
+	uint64_t shuffle_ns; /* Time spent in byte transposition and byte delta */
+	uint64_t zstd_ns;    /* Time spent in zstd compression */
+	uint64_t memcpy_ns;  /* Time spent copying (uncompressed) bytes */
+} stenos_superblock_stats;
+
+/**
+@brief Cumulated compression statistics of a context, see stenos_get_stats().
+*/
+typedef struct stenos_stats_s
+{
+	uint64_t superblocks;	/* Number of compressed superblocks */
+	uint64_t input_bytes;	/* Total input size (bytes) */
+	uint64_t output_bytes;	/* Total output size of superblocks, excluding frame headers and indexes (bytes) */
+	uint64_t modes[11];	/* Number of superblocks per compression mode, indexed by STENOS_MODE_BLOCK... */
+	uint64_t forced_memcpy; /* Number of superblocks for which the time budget forced memcpy */
+	uint64_t guess_ns;	/* Cumulated stenos_superblock_stats::guess_ns */
+	uint64_t block_ns;	/* Cumulated stenos_superblock_stats::block_ns */
+	uint64_t shuffle_ns;	/* Cumulated stenos_superblock_stats::shuffle_ns */
+	uint64_t zstd_ns;	/* Cumulated stenos_superblock_stats::zstd_ns */
+	uint64_t memcpy_ns;	/* Cumulated stenos_superblock_stats::memcpy_ns */
+} stenos_stats;
+
+/**
+@brief Superblock callback, called after the compression of each superblock.
+*/
+typedef void (*stenos_superblock_callback)(void* user_data, const stenos_superblock_stats* stats);
+
+/**
+@brief Enable (or disable) the gathering of compression statistics for a context. Disabled by default.
+
+Statistics are cumulated with lock-free counters over all compression calls of the context, including
+multithreaded ones, and can be read with stenos_get_stats(). The overhead is a few timer calls per superblock.
+*/
+STENOS_EXPORT size_t stenos_enable_stats(stenos_context* ctx, int enable);
+
+/**
+@brief Set a callback called after the compression of each superblock, or NULL to disable it.
+
+Setting a callback also gathers statistics. With multithreaded compression, the callback is
+called from the compression threads, possibly concurrently and not in superblock order.
+*/
+STENOS_EXPORT size_t stenos_set_superblock_callback(stenos_context* ctx, stenos_superblock_callback callback, void* user_data);
+
+/**
+@brief Retrieve the cumulated compression statistics of a context.
+*/
+STENOS_EXPORT size_t stenos_get_stats(const stenos_context* ctx, stenos_stats* stats);
+
+/**
+@brief Reset the cumulated compression statistics of a context.
+*/
+STENOS_EXPORT size_t stenos_reset_stats(stenos_context* ctx);
+
 /**
 @brief Set the number of threads used for compression/decompression.
 */
 STENOS_EXPORT size_t stenos_set_threads(stenos_context* ctx, int threads);
 
+/**
+@brief Thread pool object used for multithreaded compression/decompression.
+
+By default, all contexts share a global thread pool created on first use. A context can use its own pool (or one shared with
+other chosen contexts) using stenos_context_set_pool().
+Each compression/decompression call only waits for its own tasks,
+so several contexts can use the same pool concurrently.
+The pool uses work-stealing between its worker threads.
+*/
+typedef struct stenos_pool_s stenos_pool;
+
+/**
+@brief Creates a thread pool with given number of threads.
+Returns NULL on error.
+*/
+STENOS_EXPORT stenos_pool* stenos_make_pool(int threads);
+
+/**
+@brief Destroy a thread pool.
+The pool must not be used by any context anymore.
+*/
+STENOS_EXPORT void stenos_destroy_pool(stenos_pool* pool);
+
+/**
+@brief Set the thread pool used by a context for multithreaded compression/decompression.
+Passing NULL resets the context to the global thread pool.
+The pool must outlive its use by the context.
+*/
+STENOS_EXPORT size_t stenos_context_set_pool(stenos_context* ctx, stenos_pool* pool);
+
+/**
+@brief Task function passed to an external executor.
+*/
+typedef void (*stenos_task_fn)(void* task);
+
+/**
+@brief Executor submission function: must call fn(task) once, from any thread.
+*/
+typedef void (*stenos_submit_fn)(void* user_data, stenos_task_fn fn, void* task);
+
+/**
+@brief Executor wait function, called after all tasks of a parallel section were submitted.
+*/
+typedef void (*stenos_wait_fn)(void* user_data);
+
+/**
+@brief Set an external executor used by a context for multithreaded compression/decompression.
+
+When set, superblock tasks are dispatched through submit instead of the Stenos thread pool,
+which allows embedding Stenos in an existing scheduler without additional threads.
+The wait function is optional (can be NULL). If provided, it is called once all tasks of a
+parallel section are submitted and may be used to run or help running them.
+In all cases, Stenos blocks until its own tasks are finished.
+
+Passing a NULL submit function disables the executor.
+The global Stenos thread pool is only created on the first multithreaded call
+of a context without executor or custom pool.
+*/
+STENOS_EXPORT size_t stenos_set_executor(stenos_context* ctx, stenos_submit_fn submit, stenos_wait_fn wait, void* user_data);
+
 /**
 @brief Set the maximum time in nanoseconds allowed for compression.
 Set to 0 to disable time bounded compression.
@@ -155,6 +334,52 @@ compression time by more than a millisecond.
 */
 STENOS_EXPORT size_t stenos_set_max_nanoseconds(stenos_context* ctx, uint64_t nanoseconds);
 
+/**
+Compression modes of the rate model
+*/
+#define STENOS_RATE_BLOCK 0 /* Block compression, levels 0 to 2 */
+#define STENOS_RATE_ZSTD 1  /* zstd compression, levels 1 to 9 */
+
+/**
+@brief Size in bytes of a rate model exported with stenos_export_rates().
+*/
+#define STENOS_RATE_MODEL_SIZE (8 + 2 * 10 * 5 * 4)
+
+/**
+@brief Measure the compression rates of this host on given sample.
+
+Time bounded compression picks its compression levels using a model of the block and zstd
+compression rates per level and bytesoftype. This model starts from rates measured on a reference
+host, and is updated with an exponentially weighted moving average of the rates observed by each
+compression call of the context.
+
+This function directly replaces the rates for given bytesoftype with the ones measured on
+(at most) STENOS_BLOCK_SIZE bytes of sample, which must contain at least 256 elements.
+It runs all zstd levels, and might take a few hundred milliseconds.
+*/
+STENOS_EXPORT size_t stenos_calibrate(stenos_context* ctx, const void* sample, size_t bytesoftype, size_t bytes);
+
+/**
+@brief Returns the modeled compression rate in bytes/s for given mode (STENOS_RATE_BLOCK or STENOS_RATE_ZSTD),
+level and bytesoftype, or 0 for invalid parameters.
+*/
+STENOS_EXPORT double stenos_get_rate(const stenos_context* ctx, int mode, int level, size_t bytesoftype);
+
+/**
+@brief Export the context rate model to dst, which must hold at least STENOS_RATE_MODEL_SIZE bytes.
+
+The exported model is portable and can be imported in another context with stenos_import_rates(),
+for instance to reuse a calibration across runs.
+@return STENOS_RATE_MODEL_SIZE, or an error code.
+*/
+STENOS_EXPORT size_t stenos_export_rates(const stenos_context* ctx, void* dst, size_t dst_size);
+
+/**
+@brief Import a rate model exported with stenos_export_rates().
+Passing a NULL src resets the model to the reference host rates.
+*/
+STENOS_EXPORT size_t stenos_import_rates(stenos_context* ctx, const void* src, size_t size);
+
 /**
 @brief Set a custom superblock size. A value of STENOS_NO_BLOCK_SHIFT disable the custom block size.
 
@@ -167,6 +392,137 @@ template parameter of stenos::cvector must be equal to blocksize_shift.
 */
 STENOS_EXPORT size_t stenos_set_block_size(stenos_context* ctx, size_t blocksize_shift);
 
+/**
+@brief Add a superblock index at the end of compressed frames.
+
+The index stores the offset of each superblock within the frame, and optionally
+the minimum and maximum values of each superblock. It allows random access
+decompression with stenos_decompress_range() without scanning the frame.
+The index type must be one of STENOS_INDEX_NONE (default), STENOS_INDEX_OFFSETS,
+STENOS_INDEX_MINMAX_SIGNED, STENOS_INDEX_MINMAX_UNSIGNED or STENOS_INDEX_MINMAX_FLOAT.
+
+Frames containing an index cannot be decompressed by versions of Stenos prior to this feature.
+The destination buffer size should be computed with stenos_context_bound().
+*/
+STENOS_EXPORT size_t stenos_set_index(stenos_context* ctx, int index_type);
+
+/**
+@brief Enable or disable per-superblock checksums in compressed frames.
+
+When enabled, each superblock is followed by the CRC32C of its compressed bytes
+(superblock header included). Checksums are checked during decompression, which
+returns STENOS_ERROR_CHECKSUM on mismatch, and by stenos_verify() without
+decompressing the frame.
+
+Frames containing checksums cannot be decompressed by versions of Stenos prior to this feature.
+The destination buffer size should be computed with stenos_context_bound().
+*/
+STENOS_EXPORT size_t stenos_set_checksum(stenos_context* ctx, int enable);
+
+/**
+@brief Set the record layout of the compressed elements, or clear it if field_sizes is NULL or count is 0.
+
+By default, elements of bytesoftype bytes are transposed as a whole: struct types mixing fields
+of different sizes (like { int64_t; float; uint16_t; }) interleave unrelated byte planes.
+With a layout, each superblock is de-interleaved into one column per field, and each column is compressed
+separately with its own mode, using the field size as bytesoftype (for instance STENOS_MODE_XOR_ZSTD
+for 4 or 8 bytes fields, or STENOS_MODE_INT_DELTA_ZSTD for 2, 4 or 8 bytes fields).
+The layout is stored in the frame, which is decompressed as usual, without calling this function.
+Superblocks whose fields do not compress are stored uncompressed (STENOS_MODE_COPY).
+
+Field sizes are given in their order within the record, and their sum must be equal to the
+bytesoftype passed to the compression functions, otherwise they return STENOS_ERROR_INVALID_BYTESOFTYPE.
+The minimum decompression speed (see stenos_set_min_decompression_speed()) applies to each field.
+Returns STENOS_ERROR_INVALID_PARAMETER if a field size is 0 or if their sum is not a valid bytesoftype.
+*/
+STENOS_EXPORT size_t stenos_set_layout(stenos_context* ctx, const size_t* field_sizes, size_t count);
+
+/**
+@brief Compression dictionary object.
+
+A dictionary is digested once and can be shared read-only by any number
+of contexts and threads. Use stenos_train_dictionary() to build the dictionary
+content from samples of the data to compress.
+*/
+typedef struct stenos_dict_s stenos_dict;
+
+/**
+@brief Creates a dictionary from its content (usually the output of stenos_train_dictionary()).
+The content is copied. Returns NULL on error.
+*/
+STENOS_EXPORT stenos_dict* stenos_make_dictionary(const void* content, size_t size);
+
+/**
+@brief Destroy a dictionary.
+The dictionary must not be used by any context anymore.
+*/
+STENOS_EXPORT void stenos_destroy_dictionary(stenos_dict* dict);
+
+/**
+@brief Returns the dictionary ID, as stored in the frames compressed with this dictionary.
+*/
+STENOS_EXPORT unsigned stenos_dictionary_id(const stenos_dict* dict);
+
+/**
+@brief Train a dictionary from a set of samples.
+
+Samples are stored contiguously in samples, and sample_sizes gives the size in
+bytes of each sample. Each sample is fed to the trainer using all representations
+that can reach the zstd stage: raw bytes, transposed bytes, transposed bytes with
+byte delta, transposed bytes with XOR (4 or 8 bytes types), transposed element-wise
+delta (2, 4 or 8 bytes types) and block compressed bytes. A single dictionary therefore serves all
+compression modes.
+
+Dictionaries are most useful for many small inputs sharing the same structure.
+A typical dictionary size is around 100 times smaller than the total samples size.
+@return the dictionary size written to dict_buffer, or an error code.
+*/
+STENOS_EXPORT size_t
+stenos_train_dictionary(const void* samples, size_t bytesoftype, const size_t* sample_sizes, size_t nb_samples, void* dict_buffer, size_t dict_capacity);
+
+/**
+@brief Set the dictionary used by a context for compression and decompression.
+Passing NULL disables the dictionary.
+
+Frames compressed with a dictionary store its ID in the frame header. Decompressing
+such frames requires a context using the same dictionary, otherwise
+STENOS_ERROR_DICTIONARY is returned.
+The dictionary must outlive its use by the context.
+The destination buffer size should be computed with stenos_context_bound().
+*/
+STENOS_EXPORT size_t stenos_set_dictionary(stenos_context* ctx, const stenos_dict* dict);
+
+/**
+@brief Allocation function used for the scratch buffers of a context.
+Must return a buffer of at least size bytes, or NULL on failure.
+*/
+typedef void* (*stenos_alloc_fn)(void* user_data, size_t size);
+
+/**
+@brief Deallocation function matching a stenos_alloc_fn.
+*/
+typedef void (*stenos_free_fn)(void* user_data, void* ptr);
+
+/**
+@brief Set the allocator used by a context for its superblock scratch buffers.
+
+The functions might be called concurrently from the context threads.
+Buffers currently held by the context are released with the previous allocator.
+Passing NULL functions restores malloc() and free(). Setting only one of the two functions is an error.
+The internal zstd contexts are not allocated through these functions.
+*/
+STENOS_EXPORT size_t stenos_set_allocator(stenos_context* ctx, stenos_alloc_fn alloc, stenos_free_fn free, void* user_data);
+
+/**
+@brief Set a soft limit (in bytes) on the scratch memory used by a context, 0 (default) for no limit.
+
+Each thread owns up to 4 buffers of the superblock size. When compressing, the superblock size is
+first reduced (at most down to the superblock size of levels 1 and 2) until one thread fits within the limit.
+The number of threads used for compression and decompression is then reduced to what fits within
+the limit, with at least one thread. The limit does not change the compressed frame format.
+*/
+STENOS_EXPORT size_t stenos_set_memory_limit(stenos_context* ctx, size_t bytes);
+
 /**
 Returns the memory footprint of a compressoin context.
 */
@@ -184,6 +540,12 @@ STENOS_EXPORT int stenos_has_error(size_t r);
 */
 STENOS_EXPORT size_t stenos_bound(size_t bytes);
 
+/**
+@brief Returns the maximum compressed size for given input size using the context parameters.
+Unlike stenos_bound(), this takes into account the optional superblock index and checksums.
+*/
+STENOS_EXPORT size_t stenos_context_bound(stenos_context* ctx, size_t bytesoftype, size_t bytes);
+
 /**
 @brief Generic compression function.
 @param ctx compression context
@@ -210,6 +572,83 @@ STENOS_EXPORT size_t stenos_compress_generic(stenos_context* ctx, const void* sr
 */
 STENOS_EXPORT size_t stenos_decompress_generic(stenos_context* ctx, const void* src, size_t bytesoftype, size_t bytes, void* dst, size_t dst_size);
 
+/**
+@brief Memory buffer used by the batch functions stenos_compress_batch() and stenos_decompress_batch(),
+and by the scatter-gather functions stenos_compressv() and stenos_decompressv().
+*/
+typedef struct stenos_buffer_s
+{
+	void* data;  /* Buffer address, not modified for input buffers */
+	size_t size; /* Buffer size (bytes) */
+} stenos_buffer;
+
+/**
+@brief Compress n independent buffers in one call, writing one frame per buffer.
+
+Each outputs[i] frame is the same as the one produced by stenos_compress_generic() on inputs[i] with this context,
+apart from the superblock size (selected for the largest input), and can be decompressed with stenos_decompress_generic().
+The context is prepared once for the whole batch, and the items are spread over the context threads:
+each worker pulls the next pending item and compresses it on its own, reusing its buffers and zstd contexts.
+This amortizes the fixed cost of each call for many small inputs (like messages of a few KB).
+A time budget set with stenos_set_max_nanoseconds() applies to the whole batch.
+
+@param ctx compression context
+@param bytesoftype number of bytes of a single element
+@param inputs input buffers
+@param n number of buffers
+@param outputs destination buffers. On return, outputs[i].size is set to the compressed size of inputs[i], or to an error code.
+@return 0 on success, or the error code of the first failing item.
+@warning the input and output buffers cannot overlapp.
+*/
+STENOS_EXPORT size_t stenos_compress_batch(stenos_context* ctx, size_t bytesoftype, const stenos_buffer* inputs, size_t n, stenos_buffer* outputs);
+
+/**
+@brief Decompress n independent frames in one call, see stenos_compress_batch().
+
+@param ctx decompression context
+@param bytesoftype number of bytes of a single element, must be same as used for compression
+@param inputs compressed frames
+@param n number of frames
+@param outputs destination buffers. On return, outputs[i].size is set to the decompressed size of inputs[i], or to an error code.
+@return 0 on success, or the error code of the first failing item.
+@warning the input and output buffers cannot overlapp.
+*/
+STENOS_EXPORT size_t stenos_decompress_batch(stenos_context* ctx, size_t bytesoftype, const stenos_buffer* inputs, size_t n, stenos_buffer* outputs);
+
+/**
+@brief Compress the concatenation of n non contiguous segments into a single frame (scatter-gather input).
+
+The frame is the same as the one produced by stenos_compress_generic() on the concatenated segments, and is
+compressed with the context threads. Superblocks contained in a single segment are compressed in place,
+and only superblocks straddling several segments are copied to a staging buffer.
+The destination buffer size should be computed with stenos_context_bound() for the total input size.
+
+@param ctx compression context
+@param src input segments. Segment sizes do not need to be multiples of bytesoftype, only their sum.
+@param n number of segments
+@param bytesoftype number of bytes of a single element
+@param dst destination buffer
+@param dst_size destination buffer size
+@return the number of bytes compressed, or an error code.
+*/
+STENOS_EXPORT size_t stenos_compressv(stenos_context* ctx, const stenos_buffer* src, size_t n, size_t bytesoftype, void* dst, size_t dst_size);
+
+/**
+@brief Decompress a frame to n non contiguous segments (scatter-gather output).
+
+Segments are filled in order. Superblocks contained in a single segment are decompressed in place,
+and superblocks straddling several segments are decompressed to a staging buffer, then scattered.
+
+@param ctx decompression context
+@param src compressed frame
+@param bytesoftype number of bytes of a single element, must be same as used for compression
+@param bytes compressed frame size
+@param dst destination segments, whose total size must be at least the decompressed size
+@param n number of segments
+@return the number of bytes decompressed, or an error code.
+*/
+STENOS_EXPORT size_t stenos_decompressv(stenos_context* ctx, const void* src, size_t bytesoftype, size_t bytes, const stenos_buffer* dst, size_t n);
+
 /**
 @brief Compression function.
 @param src input bytes
@@ -243,6 +682,10 @@ typedef struct stenos_info_s
 {
 	size_t decompressed_size; /* Total decompressed size (bytes) */
 	size_t superblock_size /* Superblock size (bytes) */;
+	size_t superblock_count;  /* Number of superblocks */
+	int index_type;		  /* Superblock index type, STENOS_INDEX_NONE if the frame has no index */
+	int has_checksum;	  /* 1 if each superblock is followed by a checksum, 0 otherwise */
+	unsigned dict_id;	  /* ID of the dictionary required to decompress the frame, 0 if none */
 } stenos_info;
 
 /**
@@ -251,10 +694,292 @@ typedef struct stenos_info_s
 @param bytesoftype size of a single element. Must be the same one as used in stenos_compress() or stenos_decompress_generic().
 @param bytes input size. Does not need to be the full compressed length.
 @param info output information on the compressed frame.
-@return the number of bytes read to get these information (at most 12 bytes) or an error code on failure.
+@return the number of bytes read to get these information (at most 17 bytes) or an error code on failure.
 */
 STENOS_EXPORT size_t stenos_get_info(const void* src, size_t bytesoftype, size_t bytes, stenos_info* info);
 
+/**
+@brief Small class gathering information on a superblock of a compressed frame.
+*/
+typedef struct stenos_superblock_info_s
+{
+	size_t offset;		    /* Offset of the superblock within the compressed frame (bytes) */
+	size_t compressed_size;	    /* Compressed size including the superblock header and checksum (bytes) */
+	size_t decompressed_offset; /* Offset of the superblock within the decompressed frame (bytes) */
+	size_t decompressed_size;   /* Decompressed size (bytes) */
+	int mode;		    /* Compression mode (STENOS_MODE_BLOCK...) */
+	const void* min;	    /* Minimum value of the superblock stored in the index, or NULL */
+	const void* max;	    /* Maximum value of the superblock stored in the index, or NULL */
+} stenos_superblock_info;
+
+/**
+@brief Gather some information on a superblock of a compressed frame.
+
+If the frame has a superblock index, the superblock is located directly and the min/max values
+(if any) point inside src. Otherwise, all previous superblock headers are scanned.
+@param src compressed frame
+@param bytesoftype size of a single element. Must be the same one as used for compression.
+@param bytes exact compressed frame size, as returned by stenos_compress_generic().
+@param superblock superblock position, lower than stenos_info::superblock_count
+@param info output information on the superblock.
+@return 0 on success, or an error code on failure.
+*/
+STENOS_EXPORT size_t stenos_get_superblock_info(const void* src, size_t bytesoftype, size_t bytes, size_t superblock, stenos_superblock_info* info);
+
+/**
+@brief Decompress a range of a compressed frame.
+
+Only the superblocks overlapping the requested range are decompressed.
+If the frame has a superblock index, the first superblock is located directly.
+Otherwise, all previous superblock headers are scanned.
+@param ctx decompression context
+@param src compressed frame
+@param bytesoftype number of bytes of a single element, must be same as used in stenos_compress_generic()
+@param bytes exact compressed frame size, as returned by stenos_compress_generic().
+@param offset offset of the range within the decompressed frame (bytes)
+@param length length of the range (bytes)
+@param dst destination buffer of at least length bytes
+@return the number of bytes decompressed (length), or an error code.
+*/
+STENOS_EXPORT size_t stenos_decompress_range(stenos_context* ctx, const void* src, size_t bytesoftype, size_t bytes, size_t offset, size_t length, void* dst);
+
+/**
+@brief Check the superblock checksums of a compressed frame without decompressing it.
+
+The frame must have been compressed with checksums enabled (see stenos_set_checksum()).
+The superblocks are verified in parallel using the number of threads and
+the thread pool (or executor) of the context.
+@param ctx context
+@param src compressed frame
+@param bytesoftype number of bytes of a single element, must be same as used in stenos_compress_generic()
+@param bytes exact compressed frame size, as returned by stenos_compress_generic().
+@return 0 if all checksums match, STENOS_ERROR_CHECKSUM on mismatch, STENOS_ERROR_INVALID_INPUT
+if the frame has no checksum, or another error code on failure.
+*/
+STENOS_EXPORT size_t stenos_verify(stenos_context* ctx, const void* src, size_t bytesoftype, size_t bytes);
+
+/**
+Reduction operations used by stenos_reduce(), combined with one of the element types below
+*/
+#define STENOS_REDUCE_SUM 1	 /* Sum of elements: int64_t, uint64_t (modulo 2^64) or double output */
+#define STENOS_REDUCE_MIN 2	 /* Minimum element: bytesoftype bytes output */
+#define STENOS_REDUCE_MAX 3	 /* Maximum element: bytesoftype bytes output */
+#define STENOS_REDUCE_COUNT_EQ 4 /* Number of elements with the same bits as the compared value: uint64_t output */
+
+#define STENOS_REDUCE_SIGNED 0x00   /* Elements are signed integers (bytesoftype 1, 2, 4 or 8), default */
+#define STENOS_REDUCE_UNSIGNED 0x10 /* Elements are unsigned integers (bytesoftype 1, 2, 4 or 8) */
+#define STENOS_REDUCE_FLOAT 0x20    /* Elements are floating point values (bytesoftype 4 or 8) */
+
+/**
+@brief Compute a reduction of all elements of a compressed frame, without fully decompressing it.
+
+Superblocks compressed with STENOS_MODE_BLOCK (and STENOS_MODE_BLOCK_ZSTD after the zstd stage) are evaluated
+directly on their encoding: blocks of 256 equal elements and uncompressed blocks are reduced without decoding,
+and other blocks are decoded one at a time in a small buffer. Uncompressed superblocks are reduced in place,
+and other superblocks are decompressed to a context buffer.
+If the frame has a STENOS_INDEX_MINMAX_* index matching the element type, STENOS_REDUCE_MIN and STENOS_REDUCE_MAX only read
+the index, and superblocks of equal values (or not containing the compared value) are not decoded for other operations.
+
+STENOS_REDUCE_COUNT_EQ accepts any bytesoftype, while other operations require an element type compatible with bytesoftype.
+Floating point sums are computed in double and may differ from a sequential sum by rounding.
+Superblocks are reduced in parallel using the number of threads and the thread pool (or executor) of the context.
+@param ctx context
+@param src compressed frame
+@param bytesoftype number of bytes of a single element, must be same as used in stenos_compress_generic()
+@param bytes exact compressed frame size, as returned by stenos_compress_generic().
+@param op reduction operation (STENOS_REDUCE_SUM...) combined with the element type (STENOS_REDUCE_SIGNED...)
+@param value compared element of bytesoftype bytes for STENOS_REDUCE_COUNT_EQ, ignored (can be NULL) otherwise
+@param out reduction result. For STENOS_REDUCE_MIN and STENOS_REDUCE_MAX, out is not modified if the frame is empty.
+@return the number of reduced elements, or an error code.
+*/
+STENOS_EXPORT size_t stenos_reduce(stenos_context* ctx, const void* src, size_t bytesoftype, size_t bytes, int op, const void* value, void* out);
+
+/**
+@brief Returns the frame capacity required by stenos_append() to append given number of bytes to a compressed frame,
+or an error code.
+@param frame compressed frame
+@param bytesoftype number of bytes of a single element, must be same as used in stenos_compress_generic()
+@param frame_size exact compressed frame size
+@param bytes number of bytes to append
+*/
+STENOS_EXPORT size_t stenos_append_bound(const void* frame, size_t bytesoftype, size_t frame_size, size_t bytes);
+
+/**
+@brief Append bytes to a compressed frame without recompressing the whole frame.
+
+Only the trailing partial superblock (if any) is decompressed and recompressed together with the new bytes,
+which are then compressed to new superblocks. The decompressed size in the frame header and the superblock index
+(if any) are updated, and the result is identical to a frame compressed at once, except for the superblock modes
+that can differ. The superblock size, index type, checksums and dictionary are the ones of the frame,
+while other parameters (level, threads, time limit...) come from the context. If the frame uses a dictionary,
+the context must use the same one.
+
+New superblocks are first compressed in the unused part of the frame buffer (after frame_size bytes),
+and then moved to their final position, so that the frame is left unchanged on error.
+A capacity of stenos_append_bound() is always enough.
+@param ctx compression context
+@param frame compressed frame
+@param frame_size exact compressed frame size
+@param frame_capacity total size of the frame buffer
+@param src bytes to append
+@param bytesoftype number of bytes of a single element, must be same as used in stenos_compress_generic()
+@param bytes number of bytes to append
+@return the new compressed frame size, or an error code.
+*/
+STENOS_EXPORT size_t stenos_append(stenos_context* ctx, void* frame, size_t frame_size, size_t frame_capacity, const void* src, size_t bytesoftype, size_t bytes);
+
+/**
+@brief Replace the content of a superblock of a compressed frame.
+
+The new content is compressed on its own, and following superblocks are moved if the compressed size changes.
+The superblock index (if any) is updated: following superblock offsets are shifted, and the min/max values
+of the replaced superblock are recomputed. With an index, the superblock is located directly, and the cost
+does not depend on the superblock position. Frame parameters are handled like in stenos_append(),
+and the frame is left unchanged on error.
+A capacity of frame_size + decompressed superblock size + 8 is always enough.
+@param ctx compression context
+@param frame compressed frame
+@param frame_size exact compressed frame size
+@param frame_capacity total size of the frame buffer
+@param superblock superblock position, lower than stenos_info::superblock_count
+@param src new superblock content
+@param bytesoftype number of bytes of a single element, must be same as used in stenos_compress_generic()
+@param bytes new content size, must be the decompressed size of the superblock (see stenos_get_superblock_info())
+@return the new compressed frame size, or an error code.
+*/
+STENOS_EXPORT size_t stenos_replace_superblock(
+  stenos_context* ctx, void* frame, size_t frame_size, size_t frame_capacity, size_t superblock, const void* src, size_t bytesoftype, size_t bytes);
+
+/********************************************
+ Streaming API
+********************************************/
+
+/**
+@brief Streaming compression object.
+
+A stenos_cstream compresses a frame whose content is provided
+in successive chunks of arbitrary size. Input bytes are accumulated
+into superblocks, and each superblock is compressed and emitted as
+soon as it is full. The produced frame is identical to the one
+returned by stenos_compress_generic() with a single thread, and
+can be decompressed with stenos_decompress_generic().
+
+The stream uses the parameters (level, time limit, block size) and
+the buffers of the stenos_context it was created with. Compression
+is always performed by the calling thread. The context must not be
+used for anything else while a frame is being compressed.
+*/
+typedef struct stenos_cstream_s stenos_cstream;
+
+/**
+@brief Streaming decompression object.
+
+A stenos_dstream decompresses a frame provided in successive
+chunks of arbitrary size. Each superblock is decompressed
+as soon as it is complete.
+
+The stream uses the buffers of the stenos_context it was created with.
+The context must not be used for anything else while a frame is being decompressed.
+*/
+typedef struct stenos_dstream_s stenos_dstream;
+
+/**
+@brief Creates a streaming compression object using given context.
+Returns NULL on error.
+*/
+STENOS_EXPORT stenos_cstream* stenos_make_cstream(stenos_context* ctx);
+
+/**
+@brief Destroy a streaming compression object.
+This does not destroy the underlying context.
+*/
+STENOS_EXPORT void stenos_destroy_cstream(stenos_cstream* stream);
+
+/**
+@brief Start compressing a new frame.
+@param stream streaming compression object
+@param bytesoftype number of bytes of a single element
+@param bytes total number of bytes that will be pushed to the stream
+@param dst destination buffer
+@param dst_size destination buffer size, at least 12 bytes
+@return the number of bytes written to dst (frame header), or an error code.
+*/
+STENOS_EXPORT size_t stenos_cstream_begin(stenos_cstream* stream, size_t bytesoftype, size_t bytes, void* dst, size_t dst_size);
+
+/**
+@brief Returns the maximum number of bytes written by stenos_cstream_compress() for given input size,
+including the final flush performed by stenos_cstream_end().
+*/
+STENOS_EXPORT size_t stenos_cstream_bound(const stenos_cstream* stream, size_t bytes);
+
+/**
+@brief Push bytes to a compression stream.
+
+All input bytes are consumed. Completed superblocks are compressed to dst,
+remaining bytes are kept in the context buffers until the next call.
+@param stream streaming compression object
+@param src input bytes
+@param bytes number of input bytes
+@param dst destination buffer
+@param dst_size destination buffer size, at least stenos_cstream_bound(stream, bytes)
+@return the number of bytes written to dst, or an error code.
+Returns STENOS_ERROR_SRC_OVERFLOW if the stream receives more bytes than declared in stenos_cstream_begin().
+*/
+STENOS_EXPORT size_t stenos_cstream_compress(stenos_cstream* stream, const void* src, size_t bytes, void* dst, size_t dst_size);
+
+/**
+@brief Finish the current frame by compressing the last partial superblock.
+@param stream streaming compression object
+@param dst destination buffer
+@param dst_size destination buffer size, at least stenos_cstream_bound(stream, 0)
+@return the number of bytes written to dst, or an error code.
+Returns STENOS_ERROR_SRC_OVERFLOW if the stream received less bytes than declared in stenos_cstream_begin().
+*/
+STENOS_EXPORT size_t stenos_cstream_end(stenos_cstream* stream, void* dst, size_t dst_size);
+
+/**
+@brief Creates a streaming decompression object using given context.
+Returns NULL on error.
+*/
+STENOS_EXPORT stenos_dstream* stenos_make_dstream(stenos_context* ctx);
+
+/**
+@brief Destroy a streaming decompression object.
+This does not destroy the underlying context.
+*/
+STENOS_EXPORT void stenos_destroy_dstream(stenos_dstream* stream);
+
+/**
+@brief Start decompressing a new frame.
+@param stream streaming decompression object
+@param bytesoftype number of bytes of a single element, must be same as used for compression
+@return 0 on success, or an error code.
+*/
+STENOS_EXPORT size_t stenos_dstream_begin(stenos_dstream* stream, size_t bytesoftype);
+
+/**
+@brief Push compressed bytes to a decompression stream.
+
+Decompress all completed superblocks that fit in the destination buffer.
+Bytes of an incomplete superblock are kept in the context buffers until the next call.
+Decompression stops when the destination buffer cannot hold the next superblock
+(at most the frame superblock size) or when the frame is complete.
+@param stream streaming decompression object
+@param src compressed input bytes
+@param src_size on input, number of available bytes in src. On output, number of consumed bytes.
+@param dst destination buffer
+@param dst_size destination buffer size
+@return the number of bytes written to dst, or an error code.
+Returns STENOS_ERROR_DST_OVERFLOW if no progress can be made because dst is too small.
+*/
+STENOS_EXPORT size_t stenos_dstream_decompress(stenos_dstream* stream, const void* src, size_t* src_size, void* dst, size_t dst_size);
+
+/**
+@brief Finish decompressing the current frame.
+@return 0 if the frame was fully decompressed, STENOS_ERROR_SRC_OVERFLOW if it is incomplete.
+*/
+STENOS_EXPORT size_t stenos_dstream_end(stenos_dstream* stream);
+
 /********************************************
  Timer API
 ********************************************/
@@ -295,11 +1020,18 @@ STENOS_EXPORT size_t stenos_private_compress_block(stenos_context* ctx, const vo
 
 STENOS_EXPORT size_t stenos_private_decompress_block(stenos_context* ctx, const void* _src, size_t bytesoftype, size_t super_block_size, size_t bytes, void* _dst, size_t dst_size);
 
+STENOS_EXPORT size_t stenos_private_reduce_block(
+  stenos_context* ctx, const void* _src, size_t bytesoftype, size_t super_block_size, size_t bytes, size_t decompressed_size, int op, const void* value, void* out);
+
 STENOS_EXPORT size_t stenos_private_block_size(const void* _src, size_t src_size);
 STENOS_EXPORT size_t stenos_private_block_csize(const void* _src);
 
 STENOS_EXPORT size_t stenos_private_create_compression_header(size_t decompressed_size, size_t super_block_size, void* _dst, size_t dst_size);
 
+STENOS_EXPORT void stenos_private_parallel_for(int threads, size_t count, void (*fn)(void* opaque, size_t index), void* opaque);
+STENOS_EXPORT void* stenos_private_async(void (*fn)(void* opaque), void* opaque);
+STENOS_EXPORT void stenos_private_wait(void* task);
+
 #ifdef __cplusplus
 }
 #endif
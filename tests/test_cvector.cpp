@@ -35,6 +35,9 @@
 #include <random>
 #include <thread>
 #include <sstream>
+#include <stdexcept>
+#include <functional>
+#include <cmath>
 
 #ifdef max
 #undef min
@@ -557,6 +560,58 @@ static void test_serialize()
 		size_t r = stenos_decompress(str.data(), sizeof(size_t), str.size(), v3.data(), v3.size() * sizeof(size_t));
 		STENOS_TEST(r == v3.size() * sizeof(size_t));
 		STENOS_TEST(equal_cvec(v3, v2));
+
+		// Zero copy view over the serialized buffer, with a partial last chunk
+		v.resize(v.size() - 100);
+		str.resize(stenos_bound(v.size() * sizeof(size_t)));
+		str.resize(v.serialize((char*)str.data(), str.size()));
+		stenos::cvector_view<size_t> view;
+		STENOS_TEST(view.attach(str.data(), str.size()) == v.size());
+		STENOS_TEST(view.size() == v.size() && view.compressed_size() <= str.size());
+		STENOS_TEST(std::equal(view.begin(), view.end(), v.begin()));
+		STENOS_TEST(view.back() == v.back() && view[123456] == v[123456]);
+		rng.seed(1);
+		for (int i = 0; i < 10000; ++i) {
+			size_t pos = rng() % view.size();
+			STENOS_TEST(view[pos] == v[pos]);
+		}
+		size_t sum = 0, expect = 0;
+		for (size_t i = 0; i < v.size(); ++i)
+			expect += v[i];
+		view.const_for_each(0, view.size(), [&](size_t i) { sum += i; });
+		STENOS_TEST(sum == expect);
+		std::atomic<size_t> psum{ 0 };
+		STENOS_TEST(view.const_for_each(0, view.size(), [&](size_t i) { psum += i; }, 4) == view.size());
+		STENOS_TEST(psum.load() == expect);
+		std::vector<size_t> part(1000);
+		view.copy(1000, part.size(), part.data());
+		STENOS_TEST(std::equal(part.begin(), part.end(), v.begin() + 1000));
+
+		// Re-entrant accesses: the functor reads other chunks of this view and of a copy
+		stenos::cvector_view<size_t> view2 = view;
+		size_t mismatch = 0, pos = 0, count = std::min(view.size(), (size_t)20000);
+		view.const_for_each(0, count, [&](size_t i) {
+			size_t other = view.size() - 1 - pos;
+			if (view[other] != v[other] || view2[(pos * 7919) % view.size()] != v[(pos * 7919) % view.size()])
+				++mismatch;
+			view2.const_for_each(other, std::min(other + 3, view.size()), [&](size_t j) { mismatch += j != v[other++]; });
+			mismatch += i != v[pos++];
+		});
+		STENOS_TEST(mismatch == 0 && pos == count);
+		bool thrown = false;
+		try {
+			view.at(view.size());
+		}
+		catch (const std::out_of_range& e) {
+			thrown = std::string(e.what()).size() > 0;
+		}
+		STENOS_TEST(thrown);
+
+		// Invalid inputs
+		STENOS_TEST(stenos_has_error(view.attach(str.data(), str.size() / 2)));
+		STENOS_TEST(view.empty());
+		stenos::cvector_view<size_t, 1> bad;
+		STENOS_TEST(stenos_has_error(bad.attach(str.data(), str.size())));
 	}
 	STENOS_TEST(get_alloc_bytes(al) == 0);
 }
@@ -613,10 +668,363 @@ static void test_for_each()
 		STENOS_TEST(walk == v.size() - 5001);
 
 		// Test no walk at all
-		STENOS_TEST(v.for_each(0, 0, [](int i) { return true; }) == 0);
-		STENOS_TEST(v.for_each(0, v.size(), [](int i) { return false; }) == 0);
-		STENOS_TEST(v.for_each_backward(0, 0, [](int i) { return true; }) == 0);
-		STENOS_TEST(v.for_each_backward(0, v.size(), [](int i) { return false; }) == 0);
+		STENOS_TEST(v.for_each(0, 0, [](int) { return true; }) == 0);
+		STENOS_TEST(v.for_each(0, v.size(), [](int) { return false; }) == 0);
+		STENOS_TEST(v.for_each_backward(0, 0, [](int) { return true; }) == 0);
+		STENOS_TEST(v.for_each_backward(0, v.size(), [](int) { return false; }) == 0);
+
+		// Concurrent readers, each thread decompressing with its own context
+		std::thread ths[8];
+		std::atomic<long long> sum{ 0 };
+		for (int t = 0; t < 8; ++t) {
+			ths[t] = std::thread([&, t]() {
+				long long s = 0;
+				size_t first = (size_t)t * v.size() / 8;
+				size_t last = (size_t)(t + 1) * v.size() / 8;
+				v.const_for_each(first, last, [&](int i) { s += i; });
+				for (size_t i = first; i < last; ++i)
+					if (i % 1000 == 0)
+						s += v[i];
+				sum += s;
+			});
+		}
+		for (int t = 0; t < 8; ++t)
+			ths[t].join();
+		long long expect = (long long)v.size() * (long long)(v.size() - 1) / 2;
+		for (size_t i = 0; i < v.size(); i += 1000)
+			expect += (long long)i;
+		STENOS_TEST(sum.load() == expect);
+
+		// Parallel versions, on a range that does not start or end on chunk boundaries
+		for (int threads : { 1, 4 }) {
+			size_t first = 1000, last = v.size() - 1000;
+			v[0] = 0; // keep a decompressed chunk
+			STENOS_TEST(v.for_each(first, last, [](int& i) { i += 1; }, threads) == last - first);
+
+			std::atomic<long long> psum{ 0 };
+			STENOS_TEST(v.const_for_each(first, last, [&](int i) { psum += i; }, threads) == last - first);
+			long long reduced = v.const_for_each_reduce(0, v.size(), 0ll, [](long long& acc, int i) { acc += i; }, std::plus<long long>{}, threads);
+
+			long long expect_range = 0, expect_all = 0;
+			for (size_t i = 0; i < v.size(); ++i) {
+				STENOS_TEST(v[i] == (int)i + (i >= first && i < last ? 1 : 0));
+				expect_all += (long long)v[i];
+				if (i >= first && i < last)
+					expect_range += (long long)v[i];
+			}
+			STENOS_TEST(psum.load() == expect_range);
+			STENOS_TEST(reduced == expect_all);
+			v.for_each(first, last, [](int& i) { i -= 1; }, threads);
+		}
+
+		// Read-ahead ranges
+		for (size_t depth : { 0, 1, 4 }) {
+			size_t first = 777, last = v.size() - 333;
+			v[5000] = 5000; // keep a decompressed chunk
+			size_t pos = first;
+			bool ok = true;
+			for (const int& i : v.prefetching_range(first, last, depth))
+				ok = ok && i == (int)pos++;
+			STENOS_TEST(ok && pos == last);
+
+			auto range = v.prefetching_range(first, last, depth);
+			STENOS_TEST(range.for_each([](int i) { return i < 100000; }) == 100000 - first);
+			STENOS_TEST(*range.begin() == 100000);
+			STENOS_TEST(range.for_each([](int) {}) == last - 100000);
+			STENOS_TEST(range.begin() == range.end());
+		}
+		STENOS_TEST(v.prefetching_range(10, 10).begin() == v.prefetching_range(10, 10).end());
+
+		// Bulk copies and chunk spans
+		{
+			std::vector<int> out(v.size());
+			v.copy_to(0, v.size(), out.data());
+			STENOS_TEST(std::equal(out.begin(), out.end(), v.begin()));
+			v.copy_to(300, 1000, out.data());
+			STENOS_TEST(std::equal(out.begin(), out.begin() + 1000, v.begin() + 300));
+
+			std::vector<int> in(3000);
+			for (size_t i = 0; i < in.size(); ++i)
+				in[i] = -(int)i;
+			v.copy_from(100, in.data(), in.size());
+			v.copy_from(v.size() - 10, in.data(), 20); // grows
+			STENOS_TEST(v.size() == 1000009);
+			STENOS_TEST(std::equal(in.begin(), in.end(), v.begin() + 100));
+			STENOS_TEST(std::equal(in.begin(), in.begin() + 20, v.end() - 20));
+			STENOS_TEST(v[99] == 99 && v[3100] == 3100);
+
+			for (size_t depth : { 0, 2 }) {
+				size_t next = 50, values = 0;
+				bool ok = true;
+				for (auto span : v.chunks(50, v.size() - 50, depth)) {
+					ok = ok && span.index == next && span.size > 0 && span.size <= 256;
+					ok = ok && std::equal(span.data, span.data + span.size, v.begin() + span.index);
+					next += span.size;
+					values += span.size;
+				}
+				STENOS_TEST(ok && values == v.size() - 100);
+			}
+
+			// Restore content
+			v.resize(999999);
+			for (size_t i = 0; i < out.size(); ++i)
+				out[i] = (int)i;
+			v.copy_from(0, out.data(), out.size());
+		}
+
+		// Exceptions are propagated, and processed chunks stay valid
+		bool thrown = false;
+		try {
+			v.for_each(0, v.size(), [](int& i) { if (i == 500000) throw std::runtime_error(""); }, 4);
+		}
+		catch (const std::runtime_error&) {
+			thrown = true;
+		}
+		STENOS_TEST(thrown);
+		for (size_t i = 0; i < v.size(); ++i)
+			STENOS_TEST(v[i] == (int)i);
+	}
+	STENOS_TEST(get_alloc_bytes(al) == 0);
+}
+
+static void test_cache()
+{
+	CountAlloc<size_t> al;
+	{
+		stenos::cvector<int, 0, 1, CountAlloc<size_t>> v(al);
+		for (int i = 0; i < 1000000; ++i)
+			v.push_back(i);
+		const auto& cv = v;
+
+		// Random reads within a working set of 64 chunks
+		auto random_reads = [&](size_t count) {
+			size_t errors = 0;
+			srand(0);
+			for (size_t i = 0; i < count; ++i) {
+				size_t pos = (size_t)(rand() % (64 * 256)) * 15;
+				if (cv[pos] != (int)pos)
+					++errors;
+			}
+			return errors;
+		};
+
+		// Default heuristics: almost each access decompresses a chunk
+		v.enable_cache_stats(true);
+		STENOS_TEST(random_reads(100000) == 0);
+		auto def = v.cache_stats();
+		STENOS_TEST(def.hits + def.misses >= 100000);
+		STENOS_TEST(def.misses > 50000);
+
+		// Budget large enough for the working set
+		for (auto policy : { stenos::cvector_cache_policy::fifo, stenos::cvector_cache_policy::clock }) {
+			v.shrink_to_fit();
+			v.set_cache_policy(policy);
+			v.set_max_decompressed_bytes(2000 * 1024);
+			STENOS_TEST(v.max_decompressed_bytes() > 0 && v.max_decompressed_bytes() <= 2000 * 1024);
+			v.enable_cache_stats(true);
+			STENOS_TEST(random_reads(100000) == 0);
+			auto st = v.cache_stats();
+			STENOS_TEST(st.misses < def.misses / 10);
+			STENOS_TEST(st.evictions < def.misses / 10);
+		}
+
+		// Pinned chunks survive eviction and shrink_to_fit()
+		v.set_max_decompressed_bytes(0);
+		v.set_cache_policy(stenos::cvector_cache_policy::clock);
+		v.pin(0);
+		v.pin(500000);
+		v.shrink_to_fit();
+		v.enable_cache_stats(true);
+		STENOS_TEST(v[0] == 0 && v[500000] == 500000);
+		STENOS_TEST(random_reads(10000) == 0);
+		for (int i = 0; i < 1000000; i += 1000)
+			STENOS_TEST(cv[i] == i);
+		size_t misses = v.cache_stats().misses;
+		STENOS_TEST(v[1] == 1 && v[500001] == 500001);
+		STENOS_TEST(v.cache_stats().misses == misses);
+		v.unpin(0);
+		v.unpin(500000);
+
+		// Destination keeps its own settings on copy-assignment
+		stenos::cvector<int, 0, 1, CountAlloc<size_t>> v2(al);
+		v2.set_max_decompressed_bytes(100000);
+		v2 = v;
+		STENOS_TEST(v2.max_decompressed_bytes() > 0 && v2.cache_policy() == stenos::cvector_cache_policy::fifo);
+		STENOS_TEST(std::equal(v2.begin(), v2.end(), v.begin()));
+	}
+	STENOS_TEST(get_alloc_bytes(al) == 0);
+}
+
+static void test_synopsis()
+{
+	CountAlloc<size_t> al;
+	{
+		stenos::cvector<int64_t, 0, 1, CountAlloc<size_t>> v(al);
+		std::vector<int64_t> ref;
+		for (int64_t i = 0; i < 1000000; ++i) {
+			v.push_back(i * 3);
+			ref.push_back(i * 3);
+		}
+
+		auto check_bounds = [&]() {
+			std::mt19937 rng(0);
+			bool ok = true;
+			for (int i = 0; i < 2000; ++i) {
+				int64_t val = (int64_t)(rng() % (ref.back() + 10)) - 5;
+				ok = ok && v.lower_bound(val) == (size_t)(std::lower_bound(ref.begin(), ref.end(), val) - ref.begin());
+				ok = ok && v.upper_bound(val) == (size_t)(std::upper_bound(ref.begin(), ref.end(), val) - ref.begin());
+			}
+			return ok;
+		};
+
+		// Without stored synopsis
+		STENOS_TEST(check_bounds());
+
+		v.enable_synopsis(true);
+		STENOS_TEST(v.synopsis_enabled());
+		STENOS_TEST(check_bounds());
+		STENOS_TEST(check_bounds());
+
+		// Modified chunks must update their synopsis
+		for (size_t i = 255; i < ref.size(); i += 256 * 7) {
+			v[i] = v[i] + 1;
+			ref[i] += 1;
+		}
+		STENOS_TEST(check_bounds());
+		v.shrink_to_fit();
+		STENOS_TEST(check_bounds());
+		std::vector<int64_t> in(256 * 4);
+		for (size_t i = 0; i < in.size(); ++i)
+			ref[2560 + i] = in[i] = ref[2560 + i] + 2;
+		v.copy_from(2560, in.data(), in.size());
+		STENOS_TEST(check_bounds());
+
+		// Shrink and grow with other values
+		v.resize(300000);
+		ref.resize(300000);
+		STENOS_TEST(check_bounds());
+		for (int64_t i = 0; i < 300000; ++i) {
+			v.push_back(ref.back() + 1);
+			ref.push_back(ref.back() + 1);
+		}
+		STENOS_TEST(check_bounds());
+
+		// Block pruning
+		int64_t lo = ref[400000], hi = ref[400100];
+		size_t tested = 0, blocks = 0;
+		size_t processed = v.const_for_each_if(
+		  0,
+		  v.size(),
+		  [&](int64_t min, int64_t max) {
+			  ++blocks;
+			  return max >= lo && min <= hi;
+		  },
+		  [&](int64_t val) { tested += (val >= lo && val <= hi); });
+		STENOS_TEST(tested == 101);
+		STENOS_TEST(blocks == (v.size() + 255) / 256);
+		STENOS_TEST(processed <= 512);
+
+		v.enable_synopsis(false);
+		STENOS_TEST(check_bounds());
+	}
+	STENOS_TEST(get_alloc_bytes(al) == 0);
+}
+
+static void test_block_pool()
+{
+	CountAlloc<size_t> al;
+	{
+		stenos::cvector<int, 0, 1, CountAlloc<size_t>> v(al);
+		std::vector<int> ref;
+		std::mt19937 rng(0);
+		for (int i = 0; i < 500000; ++i) {
+			int val = i % 1000 + (int)(rng() % 16);
+			v.push_back(val);
+			ref.push_back(val);
+		}
+
+		// Move existing chunks to an owned pool
+		v.use_block_pool();
+		STENOS_TEST(v.block_pool());
+		STENOS_TEST(std::equal(v.begin(), v.end(), ref.begin()));
+		auto st = v.block_pool()->stats();
+		STENOS_TEST(st.blocks >= ref.size() / 256 - 2);
+		STENOS_TEST(st.used_bytes <= st.slot_bytes && st.slot_bytes <= st.reserved_bytes);
+		STENOS_TEST(st.fragmentation >= 0.f && st.fragmentation < 1.f);
+
+		// Random modifications recompress chunks with different sizes
+		for (int i = 0; i < 100000; ++i) {
+			size_t pos = rng() % ref.size();
+			int val = (int)rng();
+			v[pos] = val;
+			ref[pos] = val;
+		}
+		v.shrink_to_fit();
+		STENOS_TEST(std::equal(v.begin(), v.end(), ref.begin()));
+		st = v.block_pool()->stats();
+		STENOS_TEST(st.used_bytes <= st.slot_bytes && st.slot_bytes <= st.reserved_bytes);
+
+		// Share the pool with another cvector
+		{
+			stenos::cvector<int, 0, 1, CountAlloc<size_t>> v2(al);
+			v2.set_block_pool(v.block_pool());
+			v2.append(ref.data(), ref.size());
+			STENOS_TEST(std::equal(v2.begin(), v2.end(), ref.begin()));
+			STENOS_TEST(v.block_pool()->stats().blocks > st.blocks);
+		}
+		STENOS_TEST(v.block_pool()->stats().blocks == st.blocks);
+
+		// Back to the container allocator
+		auto pool = v.block_pool();
+		v.set_block_pool(nullptr);
+		STENOS_TEST(!v.block_pool());
+		STENOS_TEST(pool->stats().blocks == 0 && pool->stats().used_bytes == 0);
+		STENOS_TEST(std::equal(v.begin(), v.end(), ref.begin()));
+	}
+	STENOS_TEST(get_alloc_bytes(al) == 0);
+}
+
+static void test_level()
+{
+	CountAlloc<size_t> al;
+	{
+		stenos::cvector<double, 0, 1, CountAlloc<size_t>> v(al);
+		std::vector<double> ref;
+		for (int i = 0; i < 300000; ++i) {
+			double val = std::floor(std::sin(i * 0.001) * 1000) + (i % 7);
+			v.push_back(val);
+			ref.push_back(val);
+		}
+		STENOS_TEST(v.level() == 1);
+
+		// Re-encode all chunks, modified chunks included
+		v[1000] = ref[1000] = -1;
+		v.recompress(7, 4);
+		STENOS_TEST(v.level() == 7);
+		STENOS_TEST(std::equal(v.begin(), v.end(), ref.begin()));
+		v.recompress(0);
+		STENOS_TEST(v.level() == 0);
+		STENOS_TEST(std::equal(v.begin(), v.end(), ref.begin()));
+
+		// New chunks use the runtime level and time budget
+		v.set_level(12);
+		STENOS_TEST(v.level() == 9);
+		v.set_max_nanoseconds(50000);
+		STENOS_TEST(v.max_nanoseconds() == 50000);
+		for (int i = 0; i < 100000; ++i) {
+			v.push_back(i);
+			ref.push_back(i);
+		}
+		STENOS_TEST(std::equal(v.begin(), v.end(), ref.begin()));
+
+		// Copy construction keeps the source level, copy-assignment keeps the destination one
+		stenos::cvector<double, 0, 1, CountAlloc<size_t>> v2(v);
+		STENOS_TEST(v2.level() == 9 && v2.max_nanoseconds() == 50000);
+		stenos::cvector<double, 0, 1, CountAlloc<size_t>> v3(al);
+		v3.set_level(3);
+		v3 = v;
+		STENOS_TEST(v3.level() == 3 && v3.max_nanoseconds() == 0);
+		STENOS_TEST(std::equal(v3.begin(), v3.end(), ref.begin()));
 	}
 	STENOS_TEST(get_alloc_bytes(al) == 0);
 }
@@ -678,6 +1086,281 @@ struct stenos::is_relocatable<Test> : std::true_type
 {
 };
 
+static void test_bulk()
+{
+	CountAlloc<size_t> al;
+	{
+		std::vector<int> data(1000003);
+		for (size_t i = 0; i < data.size(); ++i)
+			data[i] = (int)(i * 7) ^ (int)(i >> 5);
+
+		for (int threads : { 1, 4 }) {
+			// Bulk assign
+			stenos::cvector<int, 0, 1, CountAlloc<size_t>> v(al);
+			v.assign(data.data(), data.size(), threads);
+			STENOS_TEST(v.size() == data.size());
+			STENOS_TEST(std::equal(v.begin(), v.end(), data.begin()));
+
+			// Bulk append to a vector whose back chunk is partially filled
+			stenos::cvector<int, 0, 1, CountAlloc<size_t>> v2(al);
+			for (int i = 0; i < 100; ++i)
+				v2.push_back(i);
+			v2.append(data.data(), data.size(), threads);
+			v2.append(data.data(), 10, threads);
+			STENOS_TEST(v2.size() == data.size() + 110);
+			STENOS_TEST(std::equal(v2.begin() + 100, v2.begin() + 100 + data.size(), data.begin()));
+			STENOS_TEST(std::equal(v2.end() - 10, v2.end(), data.begin()));
+			for (int i = 0; i < 100; ++i)
+				STENOS_TEST(v2[i] == i);
+
+			// Further modifications
+			v2.push_back(-1);
+			v2[500000] = -2;
+			STENOS_TEST(v2.back() == -1 && v2[500000] == -2);
+			v2.resize(1000);
+			STENOS_TEST(std::equal(v2.begin() + 100, v2.end(), data.begin()));
+		}
+
+		// Bulk insertion uses the container level, whatever the level of the last cvector used on this thread
+		std::vector<int> sorted(data.begin(), data.end());
+		std::sort(sorted.begin(), sorted.end());
+		for (int level : { 0, 9, 1 }) {
+			stenos::cvector<int> ref;
+			ref.set_level(level);
+			for (int val : sorted)
+				ref.push_back(val);
+			ref.shrink_to_fit();
+			for (int threads : { 1, 4 }) {
+				stenos::cvector<int> other;
+				other.set_level(level == 0 ? 9 : 0);
+				other.assign(sorted.data(), sorted.size(), threads);
+				stenos::cvector<int> v;
+				v.set_level(level);
+				v.assign(sorted.data(), sorted.size(), threads);
+				v.shrink_to_fit();
+				STENOS_TEST(std::equal(v.begin(), v.end(), sorted.begin(), sorted.end()));
+				STENOS_TEST(std::abs(v.current_compression_ratio() - ref.current_compression_ratio()) < 0.05 * ref.current_compression_ratio());
+			}
+		}
+
+		// Non trivially copyable type
+		size_t count = Test_count;
+		{
+			std::vector<Test> tdata(data.begin(), data.end());
+			stenos::cvector<Test> v;
+			v.assign(tdata.data(), tdata.size(), 4);
+			STENOS_TEST(std::equal(v.begin(), v.end(), tdata.begin()));
+		}
+		STENOS_TEST(Test_count == count);
+	}
+	STENOS_TEST(get_alloc_bytes(al) == 0);
+}
+
+#pragma pack(push, 1)
+struct Record
+{
+	int64_t time;
+	float value;
+	uint16_t flags;
+};
+struct RawRecord
+{
+	int64_t time;
+	float value;
+	uint16_t flags;
+};
+#pragma pack(pop)
+
+inline bool operator==(const Record& l, const Record& r)
+{
+	return memcmp(&l, &r, sizeof(Record)) == 0;
+}
+
+template<>
+struct stenos::field_layout<Record>
+{
+	static constexpr size_t count = 3;
+	static const size_t* sizes() noexcept
+	{
+		static const size_t s[] = { 8, 4, 2 };
+		return s;
+	}
+};
+
+static void test_field_layout()
+{
+	std::vector<Record> data(300000);
+	for (size_t i = 0; i < data.size(); ++i) {
+		data[i].time = 1000000 + (int64_t)i * 100 + (int64_t)(i % 7);
+		data[i].value = std::round(std::sin(i * 0.0003f) * 1000.f) / 100.f;
+		data[i].flags = (uint16_t)(i % 5000 == 0);
+	}
+
+	for (int threads : { 1, 4 }) {
+		stenos::cvector<Record, 0, 5> v;
+		stenos::cvector<RawRecord, 0, 5> raw;
+		v.assign(data.data(), data.size(), threads);
+		raw.assign(reinterpret_cast<const RawRecord*>(data.data()), data.size(), threads);
+		STENOS_TEST(std::equal(v.begin(), v.end(), data.begin()));
+		STENOS_TEST(v.compression_ratio() > raw.compression_ratio());
+
+		// Modified chunks are recompressed with the layout
+		for (size_t i = 0; i < data.size(); i += 1000)
+			v[i] = data[i + 1];
+		v.recompress(5, threads);
+		for (size_t i = 0; i < data.size(); ++i)
+			STENOS_TEST(v[i] == data[i % 1000 == 0 ? i + 1 : i]);
+	}
+}
+
+template<class T, int Level>
+static void test_reduce_type(std::vector<T> ref)
+{
+	stenos::cvector<T, 0, Level> v;
+	v.assign(ref.data(), ref.size());
+
+	auto check = [&](size_t first, size_t last) {
+		using sum_type = typename stenos::cvector<T, 0, Level>::sum_type;
+		sum_type s = 0;
+		for (size_t i = first; i < last; ++i)
+			s = std::is_floating_point<T>::value ? s + (sum_type)ref[i] : (sum_type)((uint64_t)s + (uint64_t)(sum_type)ref[i]);
+		if (std::is_floating_point<T>::value) {
+			STENOS_TEST(std::abs((double)v.reduce_sum(first, last) - (double)s) <= 1e-6 * std::abs((double)s) + 1e-6);
+		}
+		else {
+			STENOS_TEST(v.reduce_sum(first, last) == s);
+		}
+		if (first == last)
+			return;
+		STENOS_TEST(v.reduce_min(first, last) == *std::min_element(ref.begin() + first, ref.begin() + last));
+		STENOS_TEST(v.reduce_max(first, last) == *std::max_element(ref.begin() + first, ref.begin() + last));
+		T value = ref[(first + last) / 2];
+		STENOS_TEST(v.reduce_count(first, last, value) == (size_t)std::count(ref.begin() + first, ref.begin() + last, value));
+	};
+
+	check(0, ref.size());
+	check(100, ref.size() - 300);
+	check(1000, 1000);
+	check(1000, 1001);
+
+	// Decompressed and modified chunks
+	for (size_t i = 0; i < ref.size(); i += 256 * 5)
+		v[i] = ref[i] = ref[i + 1];
+	check(0, ref.size());
+	check(513, ref.size() / 2);
+
+	v.enable_synopsis(true);
+	check(0, ref.size());
+	check(256, ref.size() - 256);
+}
+
+static void test_reduce()
+{
+	std::mt19937 rng(0);
+	std::vector<int> status(300007);
+	for (size_t i = 0; i < status.size();) {
+		int val = (int)(rng() % 16) - 3;
+		for (size_t n = rng() % 3000 + 1; n && i < status.size(); --n, ++i)
+			status[i] = val;
+	}
+	test_reduce_type<int, 1>(status);
+	test_reduce_type<int, 5>(status);
+
+	std::vector<uint16_t> noise(100000);
+	for (auto& val : noise)
+		val = (uint16_t)rng();
+	test_reduce_type<uint16_t, 2>(noise);
+
+	std::vector<double> sensor(200000);
+	for (size_t i = 0; i < sensor.size(); ++i)
+		sensor[i] = std::round(std::sin(i * 0.001) * 1000.) / 10.;
+	test_reduce_type<double, 3>(sensor);
+
+	stenos::cvector<int> empty;
+	STENOS_TEST(empty.reduce_sum(0, 0) == 0);
+	STENOS_TEST(empty.reduce_count(0, 0, 1) == 0);
+}
+
+static void test_sort()
+{
+	std::mt19937 rng(0);
+	CountAlloc<int> al;
+	{
+		for (size_t size : { (size_t)0, (size_t)1, (size_t)100, (size_t)256, (size_t)257, (size_t)(256 * 16 * 16 + 5), (size_t)1000003 }) {
+			std::vector<int> ref(size);
+			for (auto& val : ref)
+				val = (int)(rng() % 100000);
+
+			for (int threads : { 1, 4 }) {
+				stenos::cvector<int, 0, 1, CountAlloc<int>> v(al);
+				v.assign(ref.data(), ref.size());
+				// Modified chunks must be taken into account
+				std::vector<int> expect = ref;
+				for (size_t i = 0; i < size; i += 1000)
+					v[i] = expect[i] = -(int)i;
+				v.sort(threads);
+				std::sort(expect.begin(), expect.end());
+				STENOS_TEST(std::equal(v.begin(), v.end(), expect.begin(), expect.end()));
+
+				v.sort(std::greater<int>(), threads);
+				STENOS_TEST(std::equal(v.begin(), v.end(), expect.rbegin(), expect.rend()));
+
+				v.transform_inplace(0, v.size(), [](int x) { return x * 2 + 1; }, threads);
+				for (size_t i = 0; i < size; ++i)
+					STENOS_TEST(v[i] == expect[size - 1 - i] * 2 + 1);
+			}
+		}
+
+		// Sort on a key
+		struct Record
+		{
+			int key;
+			float value;
+		};
+		std::vector<Record> records(300000);
+		for (size_t i = 0; i < records.size(); ++i)
+			records[i] = { (int)(rng() % 1000), (float)i };
+		auto by_key = [](const Record& r1, const Record& r2) { return r1.key < r2.key; };
+		auto by_all = [](const Record& r1, const Record& r2) { return r1.key < r2.key || (r1.key == r2.key && r1.value < r2.value); };
+		stenos::cvector<Record, 2> rec;
+		rec.assign(records.data(), records.size());
+		rec.sort(by_key, 4);
+		STENOS_TEST(std::is_sorted(rec.begin(), rec.end(), by_key));
+		std::vector<Record> sorted(rec.begin(), rec.end());
+		std::sort(sorted.begin(), sorted.end(), by_all);
+		std::sort(records.begin(), records.end(), by_all);
+		STENOS_TEST(std::equal(sorted.begin(), sorted.end(), records.begin(), records.end(), [](const Record& r1, const Record& r2) { return r1.key == r2.key && r1.value == r2.value; }));
+
+		// Synopses are rebuilt after sorting
+		std::vector<int64_t> keys(500000);
+		for (auto& k : keys)
+			k = (int64_t)(rng() % 1000000);
+		stenos::cvector<int64_t> s;
+		s.enable_synopsis(true);
+		s.assign(keys.data(), keys.size());
+		STENOS_TEST(s.lower_bound(-1) == 0); // compute synopses
+		s.sort(4);
+		std::sort(keys.begin(), keys.end());
+		for (int i = 0; i < 1000; ++i) {
+			int64_t val = (int64_t)(rng() % 1000000);
+			STENOS_TEST(s.lower_bound(val) == (size_t)(std::lower_bound(keys.begin(), keys.end(), val) - keys.begin()));
+		}
+
+		// Not trivially copyable type
+		stenos::cvector<std::unique_ptr<int>> ptr;
+		std::vector<int> ptr_ref;
+		for (int i = 0; i < 5000; ++i) {
+			ptr_ref.push_back((int)(rng() % 10000));
+			ptr.emplace_back(new int(ptr_ref.back()));
+		}
+		ptr.sort([](const std::unique_ptr<int>& a, const std::unique_ptr<int>& b) { return *a < *b; }, 2);
+		std::sort(ptr_ref.begin(), ptr_ref.end());
+		for (size_t i = 0; i < ptr_ref.size(); ++i)
+			STENOS_TEST(*ptr[i].get() == ptr_ref[i]);
+	}
+	STENOS_TEST(get_alloc_bytes(al) == 0);
+}
+
 int test_cvector(int, char*[])
 {
 
@@ -685,6 +1368,14 @@ int test_cvector(int, char*[])
 
 	test_copy();
 	test_for_each();
+	test_cache();
+	test_bulk();
+	test_synopsis();
+	test_reduce();
+	test_sort();
+	test_block_pool();
+	test_level();
+	test_field_layout();
 	test_serialize();
 
 	{
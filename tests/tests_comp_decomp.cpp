@@ -29,6 +29,11 @@
 #include <random>
 #include <algorithm>
 #include <array>
+#include <thread>
+#include <atomic>
+#include <cmath>
+#include <limits>
+#include <type_traits>
 
 #define TEST(cond)                                                                                                                                                                                     \
 	if (!(cond))                                                                                                                                                                                   \
@@ -84,6 +89,69 @@ std::vector<T> generate_same(size_t size)
 	return res;
 }
 
+template<class T>
+std::vector<T> generate_sensor(size_t size)
+{
+	// Slowly varying signal with a single precision noise
+	std::mt19937 rng(0);
+	std::normal_distribution<double> dist(0., 0.01);
+
+	std::vector<T> res(size);
+	for (size_t i = 0; i < size; ++i)
+		res[i] = (T)(float)(20. + 5. * std::sin((double)i * 1e-4) + dist(rng));
+	return res;
+}
+
+template<class T>
+std::vector<T> generate_status(size_t size)
+{
+	// Low entropy status codes: long runs of a few values
+	std::mt19937 rng(0);
+	std::uniform_int_distribution<int> run(1, 3000);
+	std::uniform_int_distribution<int> code(-3, 12);
+
+	std::vector<T> res(size);
+	for (size_t i = 0; i < size;) {
+		size_t n = std::min(size - i, (size_t)run(rng));
+		std::fill_n(res.begin() + (std::ptrdiff_t)i, n, (T)code(rng));
+		i += n;
+	}
+	return res;
+}
+
+template<class T>
+std::vector<T> generate_timestamps(size_t size)
+{
+	// Increasing timestamps with jitter and a few gaps
+	std::mt19937 rng(0);
+	std::uniform_int_distribution<int> dist(-10, 10);
+
+	std::vector<T> res(size);
+	T t = (T)1000;
+	for (size_t i = 0; i < size; ++i) {
+		t = (T)(t + (i % 1000 == 0 ? 5000 : 100) + dist(rng));
+		res[i] = t;
+	}
+	return res;
+}
+
+inline std::vector<std::array<char, 14>> generate_records(size_t size)
+{
+	// Packed { int64 timestamp; float value; uint16 flags; } records,
+	// values being rounded to 2 decimals
+	auto ts = generate_timestamps<int64_t>(size);
+	auto values = generate_sensor<float>(size);
+	std::vector<std::array<char, 14>> res(size);
+	for (size_t i = 0; i < size; ++i) {
+		uint16_t flags = (uint16_t)(i % 5000 == 0 ? 1 : 0);
+		values[i] = std::round(values[i] * 100.f) / 100.f;
+		memcpy(res[i].data(), &ts[i], 8);
+		memcpy(res[i].data() + 8, &values[i], 4);
+		memcpy(res[i].data() + 12, &flags, 2);
+	}
+	return res;
+}
+
 template<class T>
 void test_vector(const std::vector<T>& vec, const char* distribution, int level, int threads, size_t dst_size)
 {
@@ -215,9 +283,1452 @@ struct TestDistribution<Start, Start>
 	static void apply(const char*) {}
 };
 
+template<class T>
+void test_stream(const std::vector<T>& vec, const char* distribution, int level)
+{
+	// Compare streaming compression against stenos_compress_generic,
+	// and decompress the frame with random chunk sizes
+	const int threads = 1;
+	size_t bytesoftype = sizeof(T);
+	size_t bytes = vec.size() * bytesoftype;
+	size_t dst_size = stenos_bound(bytes);
+
+	std::mt19937 rng(0);
+	std::uniform_int_distribution<size_t> chunk(1, bytes / 4 + 1);
+
+	auto ctx = stenos_make_context();
+	stenos_set_level(ctx, level);
+	std::vector<char> ref(dst_size);
+	size_t r = stenos_compress_generic(ctx, vec.data(), bytesoftype, bytes, ref.data(), ref.size());
+	TEST(!stenos_has_error(r));
+
+	// Streaming compression
+	auto cs = stenos_make_cstream(ctx);
+	std::vector<char> out(12);
+	size_t w = stenos_cstream_begin(cs, bytesoftype, bytes, out.data(), out.size());
+	TEST(!stenos_has_error(w));
+	out.resize(w);
+	const char* src = (const char*)vec.data();
+	for (size_t pos = 0; pos < bytes;) {
+		size_t size = std::min(chunk(rng), bytes - pos);
+		std::vector<char> tmp(stenos_cstream_bound(cs, size));
+		w = stenos_cstream_compress(cs, src + pos, size, tmp.data(), tmp.size());
+		TEST(!stenos_has_error(w));
+		out.insert(out.end(), tmp.begin(), tmp.begin() + (std::ptrdiff_t)w);
+		pos += size;
+	}
+	TEST(stenos_has_error(stenos_cstream_compress(cs, src, 1, nullptr, 0)) || bytes == 0);
+	std::vector<char> tmp(stenos_cstream_bound(cs, 0));
+	w = stenos_cstream_end(cs, tmp.data(), tmp.size());
+	TEST(!stenos_has_error(w));
+	out.insert(out.end(), tmp.begin(), tmp.begin() + (std::ptrdiff_t)w);
+	stenos_destroy_cstream(cs);
+
+	TEST(out.size() == r && memcmp(out.data(), ref.data(), r) == 0);
+
+	// Streaming decompression
+	stenos_info info;
+	TEST(!stenos_has_error(stenos_get_info(out.data(), bytesoftype, out.size(), &info)));
+	std::uniform_int_distribution<size_t> out_chunk(info.superblock_size, info.superblock_size * 3);
+	std::vector<char> dec;
+	auto ds = stenos_make_dstream(ctx);
+	TEST(stenos_dstream_begin(ds, bytesoftype) == 0);
+	for (size_t pos = 0; pos < out.size();) {
+		size_t avail = std::min(chunk(rng), out.size() - pos);
+		while (avail) {
+			size_t consumed = avail;
+			std::vector<char> d(out_chunk(rng));
+			w = stenos_dstream_decompress(ds, out.data() + pos, &consumed, d.data(), d.size());
+			TEST(!stenos_has_error(w));
+			dec.insert(dec.end(), d.begin(), d.begin() + (std::ptrdiff_t)w);
+			pos += consumed;
+			avail -= consumed;
+		}
+	}
+	TEST(stenos_dstream_end(ds) == 0);
+	stenos_destroy_dstream(ds);
+
+	TEST(dec.size() == bytes && memcmp(dec.data(), vec.data(), bytes) == 0);
+	stenos_destroy_context(ctx);
+}
+
+template<class T>
+void test_index(const std::vector<T>& vec, const char* distribution, int level, int threads, int index_type)
+{
+	// Test superblock index, range decompression and superblock information
+	size_t bytesoftype = sizeof(T);
+	size_t bytes = vec.size() * bytesoftype;
+
+	auto ctx = stenos_make_context();
+	stenos_set_level(ctx, level);
+	stenos_set_threads(ctx, threads);
+	size_t set = stenos_set_index(ctx, index_type);
+	size_t dst_size = stenos_context_bound(ctx, bytesoftype, bytes);
+	TEST(set == 0);
+	std::vector<char> dst(dst_size);
+	size_t r = stenos_compress_generic(ctx, vec.data(), bytesoftype, bytes, dst.data(), dst.size());
+	TEST(!stenos_has_error(r));
+	std::vector<char> small(r - 1);
+	TEST(stenos_has_error(stenos_compress_generic(ctx, vec.data(), bytesoftype, bytes, small.data(), small.size())));
+
+	stenos_info info;
+	TEST(!stenos_has_error(stenos_get_info(dst.data(), bytesoftype, r, &info)));
+	TEST(info.index_type == index_type && info.decompressed_size == bytes);
+
+	// Full decompression
+	std::vector<T> out(vec.size());
+	TEST(stenos_decompress_generic(ctx, dst.data(), bytesoftype, r, out.data(), bytes) == bytes);
+	TEST(memcmp(out.data(), vec.data(), bytes) == 0);
+
+	// Superblock information
+	for (size_t i = 0; i < info.superblock_count; ++i) {
+		stenos_superblock_info sinfo;
+		TEST(stenos_get_superblock_info(dst.data(), bytesoftype, r, i, &sinfo) == 0);
+		TEST(sinfo.decompressed_offset == i * info.superblock_size);
+		if (index_type >= STENOS_INDEX_MINMAX_SIGNED) {
+			auto first = vec.begin() + (std::ptrdiff_t)(sinfo.decompressed_offset / bytesoftype);
+			auto last = first + (std::ptrdiff_t)(sinfo.decompressed_size / bytesoftype);
+			T mn, mx;
+			memcpy(&mn, sinfo.min, sizeof(T));
+			memcpy(&mx, sinfo.max, sizeof(T));
+			TEST(mn == *std::min_element(first, last) && mx == *std::max_element(first, last));
+		}
+		else
+			TEST(sinfo.min == nullptr);
+	}
+
+	// Random ranges
+	std::mt19937 rng(0);
+	std::uniform_int_distribution<size_t> dist(0, vec.size());
+	for (int i = 0; i < 20; ++i) {
+		size_t a = dist(rng), b = dist(rng);
+		if (a > b)
+			std::swap(a, b);
+		std::vector<T> range(b - a);
+		TEST(stenos_decompress_range(ctx, dst.data(), bytesoftype, r, a * bytesoftype, (b - a) * bytesoftype, range.data()) == (b - a) * bytesoftype);
+		TEST(memcmp(range.data(), vec.data() + a, range.size() * bytesoftype) == 0);
+	}
+	TEST(stenos_has_error(stenos_decompress_range(ctx, dst.data(), bytesoftype, r, bytes, 1, out.data())));
+
+	if (threads == 1) {
+		// Streaming compression produces the same frame
+		auto cs = stenos_make_cstream(ctx);
+		std::vector<char> sdst(dst_size);
+		size_t w = stenos_cstream_begin(cs, bytesoftype, bytes, sdst.data(), sdst.size());
+		TEST(!stenos_has_error(w));
+		size_t half = (vec.size() / 2) * bytesoftype;
+		size_t w2 = stenos_cstream_compress(cs, vec.data(), half, sdst.data() + w, sdst.size() - w);
+		TEST(!stenos_has_error(w2));
+		w += w2;
+		w2 = stenos_cstream_compress(cs, (const char*)vec.data() + half, bytes - half, sdst.data() + w, sdst.size() - w);
+		TEST(!stenos_has_error(w2));
+		w += w2;
+		w2 = stenos_cstream_end(cs, sdst.data() + w, sdst.size() - w);
+		TEST(!stenos_has_error(w2));
+		w += w2;
+		TEST(w == r && memcmp(sdst.data(), dst.data(), r) == 0);
+		stenos_destroy_cstream(cs);
+
+		// Streaming decompression consumes the index
+		auto ds = stenos_make_dstream(ctx);
+		stenos_dstream_begin(ds, bytesoftype);
+		size_t consumed = r;
+		TEST(stenos_dstream_decompress(ds, dst.data(), &consumed, out.data(), bytes) == bytes);
+		TEST(consumed == r && stenos_dstream_end(ds) == 0);
+		stenos_destroy_dstream(ds);
+	}
+
+	stenos_destroy_context(ctx);
+}
+
+template<class T>
+void test_checksum(const std::vector<T>& vec, const char* distribution, int level, int threads, int index_type)
+{
+	// Test superblock checksums and frame verification
+	size_t bytesoftype = sizeof(T);
+	size_t bytes = vec.size() * bytesoftype;
+
+	auto ctx = stenos_make_context();
+	stenos_set_level(ctx, level);
+	stenos_set_threads(ctx, threads);
+	stenos_set_index(ctx, index_type);
+	size_t dst_size = stenos_context_bound(ctx, bytesoftype, bytes);
+
+	// Frames without checksum cannot be verified
+	std::vector<char> dst(dst_size);
+	size_t r = stenos_compress_generic(ctx, vec.data(), bytesoftype, bytes, dst.data(), dst.size());
+	TEST(!stenos_has_error(r));
+	TEST(stenos_verify(ctx, dst.data(), bytesoftype, r) == STENOS_ERROR_INVALID_INPUT);
+
+	TEST(stenos_set_checksum(ctx, 1) == 0);
+	dst_size = stenos_context_bound(ctx, bytesoftype, bytes);
+	dst.resize(dst_size);
+	r = stenos_compress_generic(ctx, vec.data(), bytesoftype, bytes, dst.data(), dst.size());
+	TEST(!stenos_has_error(r));
+
+	stenos_info info;
+	TEST(!stenos_has_error(stenos_get_info(dst.data(), bytesoftype, r, &info)));
+	TEST(info.has_checksum == 1 && info.decompressed_size == bytes);
+	TEST(stenos_verify(ctx, dst.data(), bytesoftype, r) == 0);
+
+	std::vector<T> out(vec.size());
+	TEST(stenos_decompress_generic(ctx, dst.data(), bytesoftype, r, out.data(), bytes) == bytes);
+	TEST(memcmp(out.data(), vec.data(), bytes) == 0);
+	if (bytes) {
+		TEST(stenos_decompress_range(ctx, dst.data(), bytesoftype, r, bytes / 2, bytes - bytes / 2, out.data()) == bytes - bytes / 2);
+		TEST(memcmp(out.data(), (const char*)vec.data() + bytes / 2, bytes - bytes / 2) == 0);
+	}
+
+	// Streaming decompression, one byte at a time
+	auto ds = stenos_make_dstream(ctx);
+	stenos_dstream_begin(ds, bytesoftype);
+	size_t written = 0;
+	for (size_t i = 0; i < r; ++i) {
+		size_t one = 1;
+		size_t w = stenos_dstream_decompress(ds, dst.data() + i, &one, (char*)out.data() + written, bytes - written);
+		TEST(!stenos_has_error(w) && one == 1);
+		written += w;
+	}
+	TEST(written == bytes && stenos_dstream_end(ds) == 0);
+	stenos_destroy_dstream(ds);
+
+	// Corrupt the last payload byte, then the checksum, of each superblock
+	for (size_t i = 0; i < info.superblock_count; ++i) {
+		stenos_superblock_info sinfo;
+		TEST(stenos_get_superblock_info(dst.data(), bytesoftype, r, i, &sinfo) == 0);
+		for (size_t pos : { sinfo.offset + sinfo.compressed_size - 5, sinfo.offset + sinfo.compressed_size - 1 }) {
+			dst[pos] ^= 1;
+			TEST(stenos_verify(ctx, dst.data(), bytesoftype, r) == STENOS_ERROR_CHECKSUM);
+			TEST(stenos_decompress_generic(ctx, dst.data(), bytesoftype, r, out.data(), bytes) == STENOS_ERROR_CHECKSUM);
+			dst[pos] ^= 1;
+		}
+	}
+	TEST(stenos_verify(ctx, dst.data(), bytesoftype, r) == 0);
+	stenos_destroy_context(ctx);
+}
+
+template<class T>
+void test_dictionary(const char* distribution, int level, int threads)
+{
+	// Test dictionary training and dictionary based compression on small records
+	// sharing the same structure
+	const size_t record_count = 500;
+	const size_t record_size = 256;
+	size_t bytesoftype = sizeof(T);
+	size_t bytes = record_size * bytesoftype;
+	size_t dst_size = 0;
+
+	std::srand(0);
+	std::vector<T> base = generate_random<T>(record_size);
+	std::vector<T> records;
+	std::vector<size_t> sizes(record_count, bytes);
+	for (size_t i = 0; i < record_count; ++i) {
+		std::vector<T> rec = base;
+		for (size_t j = 0; j < record_size / 16; ++j)
+			rec[(size_t)std::rand() % record_size] = rec[(size_t)std::rand() % record_size];
+		records.insert(records.end(), rec.begin(), rec.end());
+	}
+
+	std::vector<char> content(16384);
+	size_t dict_size = stenos_train_dictionary(records.data(), bytesoftype, sizes.data(), record_count - 1, content.data(), content.size());
+	TEST(!stenos_has_error(dict_size));
+	stenos_dict* dict = stenos_make_dictionary(content.data(), dict_size);
+	TEST(dict != nullptr && stenos_dictionary_id(dict) != 0);
+
+	auto ctx = stenos_make_context();
+	stenos_set_level(ctx, level);
+	stenos_set_threads(ctx, threads);
+
+	// Compress the last (untrained) record without, then with dictionary
+	const T* rec = records.data() + (record_count - 1) * record_size;
+	std::vector<char> plain(stenos_context_bound(ctx, bytesoftype, bytes));
+	size_t r_plain = stenos_compress_generic(ctx, rec, bytesoftype, bytes, plain.data(), plain.size());
+	TEST(!stenos_has_error(r_plain));
+
+	TEST(stenos_set_dictionary(ctx, dict) == 0);
+	dst_size = stenos_context_bound(ctx, bytesoftype, bytes);
+	std::vector<char> dst(dst_size);
+	size_t r = stenos_compress_generic(ctx, rec, bytesoftype, bytes, dst.data(), dst.size());
+	TEST(!stenos_has_error(r));
+	if (level > 0)
+		TEST(r < r_plain);
+
+	stenos_info info;
+	TEST(!stenos_has_error(stenos_get_info(dst.data(), bytesoftype, r, &info)));
+	TEST(info.dict_id == stenos_dictionary_id(dict) && info.decompressed_size == bytes);
+
+	std::vector<T> out(record_size);
+	TEST(stenos_decompress_generic(ctx, dst.data(), bytesoftype, r, out.data(), bytes) == bytes);
+	TEST(memcmp(out.data(), rec, bytes) == 0);
+	TEST(stenos_decompress_range(ctx, dst.data(), bytesoftype, r, bytes / 2, bytes - bytes / 2, out.data()) == bytes - bytes / 2);
+	TEST(memcmp(out.data(), (const char*)rec + bytes / 2, bytes - bytes / 2) == 0);
+
+	// Frames without dictionary are still decoded by a context using a dictionary
+	TEST(stenos_decompress_generic(ctx, plain.data(), bytesoftype, r_plain, out.data(), bytes) == bytes);
+	TEST(memcmp(out.data(), rec, bytes) == 0);
+
+	// Streaming decompression
+	auto ds = stenos_make_dstream(ctx);
+	stenos_dstream_begin(ds, bytesoftype);
+	size_t consumed = r;
+	TEST(stenos_dstream_decompress(ds, dst.data(), &consumed, out.data(), bytes) == bytes);
+	TEST(consumed == r && stenos_dstream_end(ds) == 0);
+	stenos_destroy_dstream(ds);
+	TEST(memcmp(out.data(), rec, bytes) == 0);
+
+	// Missing or wrong dictionary
+	auto ctx2 = stenos_make_context();
+	TEST(stenos_decompress_generic(ctx2, dst.data(), bytesoftype, r, out.data(), bytes) == STENOS_ERROR_DICTIONARY);
+	stenos_dict* other = stenos_make_dictionary(rec, bytes);
+	TEST(other != nullptr && stenos_dictionary_id(other) != stenos_dictionary_id(dict));
+	stenos_set_dictionary(ctx2, other);
+	TEST(stenos_decompress_generic(ctx2, dst.data(), bytesoftype, r, out.data(), bytes) == STENOS_ERROR_DICTIONARY);
+
+	stenos_destroy_context(ctx2);
+	stenos_destroy_context(ctx);
+	stenos_destroy_dictionary(other);
+	stenos_destroy_dictionary(dict);
+}
+
+template<class T>
+void test_multithread(const std::vector<T>& vec, const char* distribution, int level)
+{
+	// Multithreaded compression must produce the same frame as mono threaded compression,
+	// whether the destination can hold the worst case output or not
+	int threads = 1;
+	size_t bytesoftype = sizeof(T);
+	size_t bytes = vec.size() * bytesoftype;
+	size_t dst_size = stenos_bound(bytes);
+
+	auto ctx = stenos_make_context();
+	stenos_set_level(ctx, level);
+	std::vector<char> ref(dst_size);
+	size_t r = stenos_compress_generic(ctx, vec.data(), bytesoftype, bytes, ref.data(), ref.size());
+	TEST(!stenos_has_error(r));
+
+	for (threads = 2; threads <= 16; threads *= 2) {
+		stenos_set_threads(ctx, threads);
+		for (size_t size : { dst_size, r }) {
+			std::vector<char> dst(size);
+			size_t r2 = stenos_compress_generic(ctx, vec.data(), bytesoftype, bytes, dst.data(), dst.size());
+			TEST(r2 == r && memcmp(dst.data(), ref.data(), r) == 0);
+		}
+		std::vector<char> dst(r - 1);
+		TEST(stenos_has_error(stenos_compress_generic(ctx, vec.data(), bytesoftype, bytes, dst.data(), dst.size())));
+	}
+	stenos_destroy_context(ctx);
+}
+
+template<class T>
+void test_exhaustive_level(const std::vector<T>& vec, const char* distribution, int level)
+{
+	// Superblock modes picked by the sampled estimator or by trial encodings
+	// must both round trip, and stay close in compression ratio
+	size_t bytesoftype = sizeof(T);
+	size_t bytes = vec.size() * bytesoftype;
+	size_t dst_size = stenos_bound(bytes);
+	int threads = 1;
+	std::vector<char> dst(dst_size);
+	std::vector<T> out(vec.size());
+
+	auto ctx = stenos_make_context();
+	stenos_set_level(ctx, level);
+	size_t sizes[2] = { 0, 0 };
+	for (int i = 0; i < 2; ++i) {
+		stenos_set_exhaustive_level(ctx, i == 0 ? 0 : 10);
+		size_t r = stenos_compress_generic(ctx, vec.data(), bytesoftype, bytes, dst.data(), dst.size());
+		TEST(!stenos_has_error(r));
+		size_t d = stenos_decompress_generic(ctx, dst.data(), bytesoftype, r, out.data(), bytes);
+		TEST(d == bytes && memcmp(out.data(), vec.data(), bytes) == 0);
+		sizes[i] = r;
+	}
+	TEST(sizes[1] < sizes[0] * 1.5);
+	stenos_destroy_context(ctx);
+}
+
+template<class T>
+void test_min_decompression_speed(const std::vector<T>& vec, const char* distribution, int level, int threads)
+{
+	// All superblocks must use a mode fast enough to decompress
+	size_t bytesoftype = sizeof(T);
+	size_t bytes = vec.size() * bytesoftype;
+	size_t dst_size = stenos_bound(bytes);
+	std::vector<char> dst(dst_size);
+	std::vector<T> out(vec.size());
+
+	auto ctx = stenos_make_context();
+	stenos_set_level(ctx, level);
+	stenos_set_threads(ctx, threads);
+	for (uint64_t speed : { 0ull, 1100000000ull, 1700000000ull, 2000000000ull, 20000000000ull }) {
+		stenos_set_min_decompression_speed(ctx, speed);
+		size_t r = stenos_compress_generic(ctx, vec.data(), bytesoftype, bytes, dst.data(), dst.size());
+		TEST(!stenos_has_error(r));
+		TEST(stenos_decompress_generic(ctx, dst.data(), bytesoftype, r, out.data(), bytes) == bytes);
+		TEST(memcmp(out.data(), vec.data(), bytes) == 0);
+
+		stenos_info info;
+		TEST(!stenos_has_error(stenos_get_info(dst.data(), bytesoftype, r, &info)));
+		for (size_t i = 0; i < info.superblock_count; ++i) {
+			stenos_superblock_info sinfo;
+			TEST(stenos_get_superblock_info(dst.data(), bytesoftype, r, i, &sinfo) == 0);
+			TEST(stenos_mode_decompression_speed(sinfo.mode) >= speed || sinfo.mode == STENOS_MODE_COPY);
+		}
+	}
+	stenos_destroy_context(ctx);
+}
+
+template<class T>
+void test_xor_mode(const std::vector<T>& vec, const char* distribution, int level, int threads)
+{
+	// Floating point data must select the XOR mode for some superblocks,
+	// and decompress to the same content for all sizes
+	size_t bytesoftype = sizeof(T);
+	size_t bytes = vec.size() * bytesoftype;
+	size_t dst_size = stenos_bound(bytes);
+	std::vector<char> dst(dst_size);
+	std::vector<T> out(vec.size());
+
+	auto ctx = stenos_make_context();
+	stenos_set_level(ctx, level);
+	stenos_set_threads(ctx, threads);
+	size_t r = stenos_compress_generic(ctx, vec.data(), bytesoftype, bytes, dst.data(), dst.size());
+	TEST(!stenos_has_error(r));
+	TEST(stenos_decompress_generic(ctx, dst.data(), bytesoftype, r, out.data(), bytes) == bytes);
+	TEST(memcmp(out.data(), vec.data(), bytes) == 0);
+
+	stenos_info info;
+	TEST(!stenos_has_error(stenos_get_info(dst.data(), bytesoftype, r, &info)));
+	size_t xor_count = 0;
+	for (size_t i = 0; i < info.superblock_count; ++i) {
+		stenos_superblock_info sinfo;
+		TEST(stenos_get_superblock_info(dst.data(), bytesoftype, r, i, &sinfo) == 0);
+		xor_count += sinfo.mode == STENOS_MODE_XOR_ZSTD;
+	}
+	TEST(xor_count > 0);
+
+	// Sizes that are not a multiple of 8 elements
+	for (size_t count : { (size_t)1000, (size_t)4095, (size_t)70001 }) {
+		size_t b = std::min(count, vec.size()) * bytesoftype;
+		r = stenos_compress_generic(ctx, vec.data(), bytesoftype, b, dst.data(), dst.size());
+		TEST(!stenos_has_error(r));
+		TEST(stenos_decompress_generic(ctx, dst.data(), bytesoftype, r, out.data(), b) == b);
+		TEST(memcmp(out.data(), vec.data(), b) == 0);
+	}
+	stenos_destroy_context(ctx);
+}
+
+template<class T>
+void test_int_delta_mode(const std::vector<T>& vec, const char* distribution, int level, int threads)
+{
+	// Timestamps must select element-wise delta modes for some superblocks,
+	// and decompress to the same content for all sizes
+	size_t bytesoftype = sizeof(T);
+	size_t bytes = vec.size() * bytesoftype;
+	size_t dst_size = stenos_bound(bytes);
+	std::vector<char> dst(dst_size);
+	std::vector<T> out(vec.size());
+
+	auto ctx = stenos_make_context();
+	stenos_set_level(ctx, level);
+	stenos_set_threads(ctx, threads);
+	size_t r = stenos_compress_generic(ctx, vec.data(), bytesoftype, bytes, dst.data(), dst.size());
+	TEST(!stenos_has_error(r));
+	TEST(stenos_decompress_generic(ctx, dst.data(), bytesoftype, r, out.data(), bytes) == bytes);
+	TEST(memcmp(out.data(), vec.data(), bytes) == 0);
+
+	stenos_info info;
+	TEST(!stenos_has_error(stenos_get_info(dst.data(), bytesoftype, r, &info)));
+	size_t delta_count = 0;
+	for (size_t i = 0; i < info.superblock_count; ++i) {
+		stenos_superblock_info sinfo;
+		TEST(stenos_get_superblock_info(dst.data(), bytesoftype, r, i, &sinfo) == 0);
+		delta_count += sinfo.mode == STENOS_MODE_INT_DELTA_ZSTD || sinfo.mode == STENOS_MODE_INT_DELTA2_ZSTD;
+	}
+	TEST(bytesoftype == 2 || delta_count > 0);
+
+	// Sizes that are not a multiple of 256 elements
+	for (size_t count : { (size_t)1000, (size_t)4095, (size_t)70001 }) {
+		size_t b = std::min(count, vec.size()) * bytesoftype;
+		r = stenos_compress_generic(ctx, vec.data(), bytesoftype, b, dst.data(), dst.size());
+		TEST(!stenos_has_error(r));
+		TEST(stenos_decompress_generic(ctx, dst.data(), bytesoftype, r, out.data(), b) == b);
+		TEST(memcmp(out.data(), vec.data(), b) == 0);
+	}
+	stenos_destroy_context(ctx);
+}
+
+template<class T>
+void test_layout(const std::vector<T>& vec, const size_t* fields, size_t count, const char* distribution, int level, int threads)
+{
+	// Records compressed with a field layout must use the fields mode,
+	// compress better than without layout, and decompress without layout
+	size_t bytesoftype = sizeof(T);
+	size_t bytes = vec.size() * bytesoftype;
+	size_t dst_size = stenos_bound(bytes);
+	std::vector<char> dst(dst_size);
+	std::vector<T> out(vec.size());
+
+	auto ctx = stenos_make_context();
+	stenos_set_level(ctx, level);
+	stenos_set_threads(ctx, threads);
+	size_t plain = stenos_compress_generic(ctx, vec.data(), bytesoftype, bytes, dst.data(), dst.size());
+	TEST(!stenos_has_error(plain));
+
+	TEST(stenos_set_layout(ctx, fields, count) == 0);
+	size_t r = stenos_compress_generic(ctx, vec.data(), bytesoftype, bytes, dst.data(), dst.size());
+	TEST(!stenos_has_error(r));
+	TEST(r < plain);
+
+	auto dctx = stenos_make_context();
+	TEST(stenos_decompress_generic(dctx, dst.data(), bytesoftype, r, out.data(), bytes) == bytes);
+	TEST(memcmp(out.data(), vec.data(), bytes) == 0);
+
+	stenos_info info;
+	TEST(!stenos_has_error(stenos_get_info(dst.data(), bytesoftype, r, &info)));
+	size_t fields_count = 0;
+	for (size_t i = 0; i < info.superblock_count; ++i) {
+		stenos_superblock_info sinfo;
+		TEST(stenos_get_superblock_info(dst.data(), bytesoftype, r, i, &sinfo) == 0);
+		fields_count += sinfo.mode == STENOS_MODE_FIELDS;
+	}
+	TEST(fields_count > 0);
+
+	// Partial decompression and sizes that are not a multiple of 256 elements
+	if (info.superblock_count > 1) {
+		size_t offset = bytes / 3 / bytesoftype * bytesoftype;
+		TEST(stenos_decompress_range(dctx, dst.data(), bytesoftype, r, offset, offset, out.data()) == offset);
+		TEST(memcmp(out.data(), (const char*)vec.data() + offset, offset) == 0);
+	}
+	for (size_t n : { (size_t)1, (size_t)1000, (size_t)4095, (size_t)70001 }) {
+		size_t b = std::min(n, vec.size()) * bytesoftype;
+		r = stenos_compress_generic(ctx, vec.data(), bytesoftype, b, dst.data(), dst.size());
+		TEST(!stenos_has_error(r));
+		TEST(stenos_decompress_generic(dctx, dst.data(), bytesoftype, r, out.data(), b) == b);
+		TEST(memcmp(out.data(), vec.data(), b) == 0);
+	}
+
+	// Sizes that are not a multiple of bytesoftype: the trailing partial record must be kept
+	for (size_t b : { bytes - bytesoftype + 1, bytes - 1, bytesoftype * 70001 + 3, (size_t)5 }) {
+		r = stenos_compress_generic(ctx, vec.data(), bytesoftype, b, dst.data(), dst.size());
+		TEST(!stenos_has_error(r));
+		TEST(stenos_decompress_generic(dctx, dst.data(), bytesoftype, r, out.data(), b) == b);
+		TEST(memcmp(out.data(), vec.data(), b) == 0);
+	}
+
+	// Invalid layouts
+	TEST(stenos_compress_generic(ctx, vec.data(), bytesoftype + 1, bytesoftype + 1, dst.data(), dst.size()) == STENOS_ERROR_INVALID_BYTESOFTYPE);
+	size_t invalid[2] = { 4, 0 };
+	TEST(stenos_set_layout(ctx, invalid, 2) == STENOS_ERROR_INVALID_PARAMETER);
+	TEST(stenos_set_layout(ctx, nullptr, 0) == 0);
+
+	stenos_destroy_context(dctx);
+	stenos_destroy_context(ctx);
+}
+
+template<class T>
+void test_batch(const std::vector<T>& vec, const char* distribution, int level, int threads, bool checksum)
+{
+	// Compress many small messages in one call, each frame must be
+	// the same as the one of stenos_compress_generic()
+	size_t bytesoftype = sizeof(T);
+	size_t dst_size = 0;
+	std::mt19937 rng(0);
+	std::uniform_int_distribution<size_t> dist(1, 16384 / sizeof(T));
+
+	// Split the input in messages of 1 to 16KB
+	std::vector<stenos_buffer> inputs, outputs, decompressed;
+	std::vector<std::vector<char>> storage;
+	for (size_t pos = 0; pos < vec.size();) {
+		size_t count = std::min(dist(rng), vec.size() - pos);
+		inputs.push_back(stenos_buffer{ (void*)(vec.data() + pos), count * bytesoftype });
+		pos += count;
+	}
+	storage.resize(inputs.size() * 2);
+	for (size_t i = 0; i < inputs.size(); ++i) {
+		storage[i * 2].resize(stenos_bound(inputs[i].size) + 8);
+		storage[i * 2 + 1].resize(inputs[i].size);
+		outputs.push_back(stenos_buffer{ storage[i * 2].data(), storage[i * 2].size() });
+		decompressed.push_back(stenos_buffer{ storage[i * 2 + 1].data(), storage[i * 2 + 1].size() });
+	}
+
+	auto ctx = stenos_make_context();
+	stenos_set_level(ctx, level);
+	stenos_set_threads(ctx, threads);
+	stenos_set_checksum(ctx, checksum);
+	TEST(stenos_compress_batch(ctx, bytesoftype, inputs.data(), inputs.size(), outputs.data()) == 0);
+
+	std::vector<char> frame(stenos_bound(16384) + 8);
+	for (size_t i = 0; i < inputs.size(); ++i) {
+		size_t r = stenos_compress_generic(ctx, inputs[i].data, bytesoftype, inputs[i].size, frame.data(), frame.size());
+		TEST(r == outputs[i].size);
+		TEST(memcmp(frame.data(), outputs[i].data, r) == 0);
+	}
+
+	TEST(stenos_decompress_batch(ctx, bytesoftype, outputs.data(), outputs.size(), decompressed.data()) == 0);
+	for (size_t i = 0; i < inputs.size(); ++i) {
+		TEST(decompressed[i].size == inputs[i].size);
+		TEST(memcmp(decompressed[i].data, inputs[i].data, inputs[i].size) == 0);
+	}
+
+	// A failing item does not prevent the others to be processed
+	outputs[1].size = 2;
+	for (auto& d : decompressed)
+		memset(d.data, 0, d.size);
+	TEST(stenos_decompress_batch(ctx, bytesoftype, outputs.data(), outputs.size(), decompressed.data()) == STENOS_ERROR_SRC_OVERFLOW);
+	TEST(decompressed[1].size == STENOS_ERROR_SRC_OVERFLOW);
+	for (size_t i = 0; i < inputs.size(); ++i) {
+		if (i != 1)
+			TEST(decompressed[i].size == inputs[i].size && memcmp(decompressed[i].data, inputs[i].data, inputs[i].size) == 0);
+	}
+	stenos_destroy_context(ctx);
+}
+
+inline std::vector<stenos_buffer> split_segments(void* data, size_t bytes, size_t max_segment, unsigned seed)
+{
+	// Split a buffer in segments of random sizes (empty ones included)
+	std::mt19937 rng(seed);
+	std::uniform_int_distribution<size_t> dist(0, max_segment);
+	std::vector<stenos_buffer> res;
+	for (size_t pos = 0; pos < bytes;) {
+		size_t size = std::min(dist(rng), bytes - pos);
+		res.push_back(stenos_buffer{ (char*)data + pos, size });
+		pos += size;
+	}
+	return res;
+}
+
+template<class T>
+void test_iovec(const std::vector<T>& vec, const char* distribution, int level, int threads, int index_type)
+{
+	// Scatter-gather compression must produce the same frame as stenos_compress_generic(),
+	// and decompress to any segment list
+	size_t bytesoftype = sizeof(T);
+	size_t bytes = vec.size() * bytesoftype;
+	std::vector<char> ref(stenos_bound(bytes) + 1024);
+	std::vector<T> out(vec.size());
+
+	auto ctx = stenos_make_context();
+	stenos_set_level(ctx, level);
+	stenos_set_threads(ctx, threads);
+	stenos_set_index(ctx, index_type);
+	size_t dst_size = stenos_context_bound(ctx, bytesoftype, bytes);
+	std::vector<char> dst(dst_size);
+	size_t r = stenos_compress_generic(ctx, vec.data(), bytesoftype, bytes, ref.data(), ref.size());
+	TEST(!stenos_has_error(r));
+
+	for (size_t max_segment : { (size_t)100, (size_t)50000, (size_t)3000000 }) {
+		auto src = split_segments((void*)vec.data(), bytes, max_segment, (unsigned)max_segment);
+		size_t rv = stenos_compressv(ctx, src.data(), src.size(), bytesoftype, dst.data(), dst.size());
+		TEST(rv == r);
+		TEST(memcmp(dst.data(), ref.data(), r) == 0);
+
+		memset(out.data(), 0, bytes);
+		auto segments = split_segments(out.data(), bytes, max_segment, (unsigned)max_segment + 1);
+		TEST(stenos_decompressv(ctx, dst.data(), bytesoftype, r, segments.data(), segments.size()) == bytes);
+		TEST(memcmp(out.data(), vec.data(), bytes) == 0);
+	}
+
+	// Single segment and too small output
+	stenos_buffer whole{ out.data(), bytes };
+	TEST(stenos_compressv(ctx, &whole, 1, bytesoftype, dst.data(), dst.size()) == r);
+	stenos_buffer halves[2] = { { out.data(), bytes / 2 }, { (char*)out.data() + bytes / 2, bytes / 2 - 1 } };
+	TEST(stenos_decompressv(ctx, dst.data(), bytesoftype, r, halves, 2) == STENOS_ERROR_DST_OVERFLOW);
+	stenos_destroy_context(ctx);
+}
+
+struct StatsCallback
+{
+	std::atomic<size_t> calls{ 0 };
+	std::atomic<size_t> output_bytes{ 0 };
+	std::atomic<size_t> modes[11];
+	std::atomic<size_t> bad_levels{ 0 }; // zstd level reported for a superblock without zstd stage
+	StatsCallback()
+	{
+		for (auto& m : modes)
+			m.store(0);
+	}
+	static void apply(void* user_data, const stenos_superblock_stats* st)
+	{
+		StatsCallback* c = (StatsCallback*)user_data;
+		c->calls.fetch_add(1);
+		c->output_bytes.fetch_add(st->output_size);
+		c->modes[st->mode].fetch_add(1);
+		if ((st->mode == STENOS_MODE_COPY || st->mode == STENOS_MODE_BLOCK) && st->level != 0)
+			c->bad_levels.fetch_add(1);
+	}
+};
+
+template<class T>
+void test_stats(const std::vector<T>& vec, const char* distribution, int level, int threads)
+{
+	// Statistics and superblock callback must match the compressed frame
+	size_t bytesoftype = sizeof(T);
+	size_t bytes = vec.size() * bytesoftype;
+	std::vector<T> out(vec.size());
+
+	StatsCallback cb;
+	auto ctx = stenos_make_context();
+	stenos_set_level(ctx, level);
+	stenos_set_threads(ctx, threads);
+	stenos_set_checksum(ctx, 1);
+	size_t dst_size = stenos_context_bound(ctx, bytesoftype, bytes);
+	std::vector<char> dst(dst_size);
+	stenos_set_superblock_callback(ctx, StatsCallback::apply, &cb);
+	size_t r = stenos_compress_generic(ctx, vec.data(), bytesoftype, bytes, dst.data(), dst.size());
+	TEST(!stenos_has_error(r));
+	TEST(stenos_decompress_generic(ctx, dst.data(), bytesoftype, r, out.data(), bytes) == bytes);
+	TEST(memcmp(out.data(), vec.data(), bytes) == 0);
+
+	stenos_stats st;
+	stenos_info info;
+	TEST(stenos_get_stats(ctx, &st) == 0);
+	TEST(!stenos_has_error(stenos_get_info(dst.data(), bytesoftype, r, &info)));
+	TEST(st.superblocks == info.superblock_count && cb.calls == info.superblock_count);
+	TEST(st.input_bytes == bytes);
+	size_t csize = 0;
+	size_t modes[11] = { 0 };
+	for (size_t i = 0; i < info.superblock_count; ++i) {
+		stenos_superblock_info sinfo;
+		TEST(stenos_get_superblock_info(dst.data(), bytesoftype, r, i, &sinfo) == 0);
+		csize += sinfo.compressed_size;
+		modes[sinfo.mode]++;
+	}
+	TEST(st.output_bytes == csize && cb.output_bytes == csize);
+	for (int m = 0; m < 11; ++m)
+		TEST(st.modes[m] == modes[m] && cb.modes[m] == modes[m]);
+	TEST(cb.bad_levels == 0);
+
+	// Statistics are cumulated until reset
+	stenos_set_superblock_callback(ctx, nullptr, nullptr);
+	stenos_enable_stats(ctx, 1);
+	r = stenos_compress_generic(ctx, vec.data(), bytesoftype, bytes, dst.data(), dst.size());
+	TEST(stenos_get_stats(ctx, &st) == 0 && st.superblocks == 2 * info.superblock_count && cb.calls == info.superblock_count);
+	stenos_reset_stats(ctx);
+	TEST(stenos_get_stats(ctx, &st) == 0 && st.superblocks == 0 && st.input_bytes == 0 && st.zstd_ns == 0);
+
+	// A very short time budget forces memcpy
+	stenos_set_max_nanoseconds(ctx, 1);
+	stenos_set_superblock_callback(ctx, StatsCallback::apply, &cb);
+	dst.resize(stenos_context_bound(ctx, bytesoftype, bytes));
+	r = stenos_compress_generic(ctx, vec.data(), bytesoftype, bytes, dst.data(), dst.size());
+	TEST(!stenos_has_error(r));
+	TEST(stenos_get_stats(ctx, &st) == 0 && (bytes == 0 || st.forced_memcpy > 0));
+	TEST(cb.bad_levels == 0);
+	stenos_destroy_context(ctx);
+}
+
+template<class T>
+void test_rate_model(const std::vector<T>& vec, const char* distribution, int threads)
+{
+	// Calibrate, export and import the rate model, then use it for time bounded compression
+	size_t bytesoftype = sizeof(T);
+	size_t bytes = vec.size() * bytesoftype;
+	size_t dst_size = stenos_bound(bytes);
+	int level = 0;
+	std::vector<char> dst(dst_size);
+	std::vector<T> out(vec.size());
+
+	auto ctx = stenos_make_context();
+	TEST(stenos_get_rate(ctx, STENOS_RATE_ZSTD, 1, bytesoftype) > stenos_get_rate(ctx, STENOS_RATE_ZSTD, 9, bytesoftype));
+	TEST(stenos_calibrate(ctx, vec.data(), bytesoftype, bytes) == 0);
+	TEST(stenos_calibrate(ctx, vec.data(), bytesoftype, bytesoftype * 255) == STENOS_ERROR_INVALID_PARAMETER);
+
+	char model[STENOS_RATE_MODEL_SIZE];
+	TEST(stenos_export_rates(ctx, model, sizeof(model) - 1) == STENOS_ERROR_DST_OVERFLOW);
+	TEST(stenos_export_rates(ctx, model, sizeof(model)) == STENOS_RATE_MODEL_SIZE);
+
+	auto ctx2 = stenos_make_context();
+	TEST(stenos_import_rates(ctx2, model, sizeof(model) - 1) == STENOS_ERROR_INVALID_INPUT);
+	TEST(stenos_import_rates(ctx2, model, sizeof(model)) == 0);
+	for (int l = 0; l <= 9; ++l) {
+		for (int mode = STENOS_RATE_BLOCK; mode <= STENOS_RATE_ZSTD; ++mode) {
+			// Exported rates are rounded to KB/s
+			double r1 = stenos_get_rate(ctx, mode, l, bytesoftype);
+			double r2 = stenos_get_rate(ctx2, mode, l, bytesoftype);
+			TEST(r2 > 0 && std::abs(r1 - r2) <= 1000);
+		}
+	}
+
+	stenos_set_threads(ctx2, threads);
+	for (uint64_t ns = 1000000; ns <= 100000000; ns *= 10) {
+		stenos_set_max_nanoseconds(ctx2, ns);
+		size_t r = stenos_compress_generic(ctx2, vec.data(), bytesoftype, bytes, dst.data(), dst.size());
+		TEST(!stenos_has_error(r));
+		TEST(stenos_decompress_generic(ctx2, dst.data(), bytesoftype, r, out.data(), bytes) == bytes);
+		TEST(memcmp(out.data(), vec.data(), bytes) == 0);
+	}
+
+	// Reset to reference rates
+	TEST(stenos_import_rates(ctx, nullptr, 0) == 0);
+	auto ctx3 = stenos_make_context();
+	TEST(stenos_get_rate(ctx, STENOS_RATE_ZSTD, 5, bytesoftype) == stenos_get_rate(ctx3, STENOS_RATE_ZSTD, 5, bytesoftype));
+
+	stenos_destroy_context(ctx);
+	stenos_destroy_context(ctx2);
+	stenos_destroy_context(ctx3);
+}
+
+template<class T>
+void test_pool(const std::vector<T>& vec, const char* distribution, int level, stenos_pool* pool)
+{
+	// Concurrent multithreaded compression/decompression from several threads sharing a pool
+	size_t bytesoftype = sizeof(T);
+	size_t bytes = vec.size() * bytesoftype;
+	size_t dst_size = stenos_bound(bytes);
+
+	std::vector<int> ok(8, 0);
+	std::vector<std::thread> ths;
+	for (size_t t = 0; t < ok.size(); ++t) {
+		ths.emplace_back([&, t]() {
+			auto ctx = stenos_make_context();
+			stenos_set_level(ctx, level);
+			stenos_set_threads(ctx, 4);
+			stenos_context_set_pool(ctx, pool);
+			std::vector<char> dst(dst_size);
+			std::vector<T> out(vec.size());
+			size_t r = stenos_compress_generic(ctx, vec.data(), bytesoftype, bytes, dst.data(), dst.size());
+			size_t r2 = stenos_has_error(r) ? r : stenos_decompress_generic(ctx, dst.data(), bytesoftype, r, out.data(), bytes);
+			ok[t] = r2 == bytes && memcmp(out.data(), vec.data(), bytes) == 0;
+			stenos_destroy_context(ctx);
+		});
+	}
+	for (auto& th : ths)
+		th.join();
+
+	int threads = 4;
+	for (int v : ok)
+		TEST(v);
+}
+
+// Executor launching one thread per task
+struct ThreadExecutor
+{
+	std::vector<std::thread> threads;
+	size_t submitted = 0;
+
+	static void submit(void* user_data, stenos_task_fn fn, void* task)
+	{
+		ThreadExecutor* e = (ThreadExecutor*)user_data;
+		++e->submitted;
+		e->threads.emplace_back([fn, task]() { fn(task); });
+	}
+	static void wait(void* user_data)
+	{
+		ThreadExecutor* e = (ThreadExecutor*)user_data;
+		for (auto& th : e->threads)
+			th.join();
+		e->threads.clear();
+	}
+	static void submit_inline(void* user_data, stenos_task_fn fn, void* task)
+	{
+		++((ThreadExecutor*)user_data)->submitted;
+		fn(task);
+	}
+};
+
+template<class T>
+void test_executor(const std::vector<T>& vec, const char* distribution, int level)
+{
+	// Multithreaded compression/decompression through an external executor
+	int threads = 4;
+	size_t bytesoftype = sizeof(T);
+	size_t bytes = vec.size() * bytesoftype;
+
+	for (int inline_exec = 0; inline_exec < 2; ++inline_exec) {
+		for (size_t dst_size : { stenos_bound(bytes), bytes / 2 }) {
+			ThreadExecutor exec;
+			auto ctx = stenos_make_context();
+			stenos_set_level(ctx, level);
+			stenos_set_threads(ctx, threads);
+			stenos_set_executor(ctx, inline_exec ? ThreadExecutor::submit_inline : ThreadExecutor::submit, inline_exec ? nullptr : ThreadExecutor::wait, &exec);
+			std::vector<char> dst(dst_size);
+			std::vector<T> out(vec.size());
+			size_t r = stenos_compress_generic(ctx, vec.data(), bytesoftype, bytes, dst.data(), dst.size());
+			if (stenos_has_error(r)) {
+				TEST(dst_size < stenos_bound(bytes));
+			}
+			else {
+				TEST(stenos_decompress_generic(ctx, dst.data(), bytesoftype, r, out.data(), bytes) == bytes);
+				TEST(memcmp(out.data(), vec.data(), bytes) == 0);
+			}
+			TEST(exec.submitted > 0 && exec.threads.empty());
+			stenos_destroy_context(ctx);
+		}
+	}
+}
+
+// Allocator counting allocations and live bytes
+struct CountingAllocator
+{
+	std::atomic<size_t> allocations{ 0 };
+	std::atomic<size_t> live{ 0 };
+	std::atomic<size_t> peak{ 0 };
+
+	static void* alloc(void* user_data, size_t size)
+	{
+		CountingAllocator* a = (CountingAllocator*)user_data;
+		char* p = (char*)malloc(size + 16);
+		if (!p)
+			return nullptr;
+		memcpy(p, &size, sizeof(size));
+		++a->allocations;
+		size_t l = a->live += size;
+		size_t pk = a->peak.load();
+		while (l > pk && !a->peak.compare_exchange_weak(pk, l)) {
+		}
+		return p + 16;
+	}
+	static void free(void* user_data, void* ptr)
+	{
+		CountingAllocator* a = (CountingAllocator*)user_data;
+		char* p = (char*)ptr - 16;
+		size_t size;
+		memcpy(&size, p, sizeof(size));
+		a->live -= size;
+		::free(p);
+	}
+};
+
+template<class T>
+void test_allocator(const std::vector<T>& vec, const char* distribution, int level, int threads)
+{
+	// Custom allocator, buffer retention across superblock sizes and memory limit
+	size_t bytesoftype = sizeof(T);
+	size_t bytes = vec.size() * bytesoftype;
+	size_t dst_size = stenos_bound(bytes);
+	std::vector<char> dst(dst_size);
+	std::vector<T> out(vec.size());
+
+	{
+		CountingAllocator a;
+		auto ctx = stenos_make_context();
+		stenos_set_level(ctx, level);
+		stenos_set_threads(ctx, threads);
+		TEST(stenos_set_allocator(ctx, CountingAllocator::alloc, nullptr, &a) == STENOS_ERROR_INVALID_PARAMETER);
+		TEST(stenos_set_allocator(ctx, CountingAllocator::alloc, CountingAllocator::free, &a) == 0);
+
+		size_t r = stenos_compress_generic(ctx, vec.data(), bytesoftype, bytes, dst.data(), dst.size());
+		TEST(!stenos_has_error(r));
+		TEST(stenos_decompress_generic(ctx, dst.data(), bytesoftype, r, out.data(), bytes) == bytes);
+		TEST(memcmp(out.data(), vec.data(), bytes) == 0);
+		TEST(a.live < stenos_memory_footprint(ctx));
+
+		if (threads == 1) {
+			// Alternating between 2 close superblock sizes does not reallocate buffers
+			size_t bytes2 = bytes / (bytesoftype - 1) * (bytesoftype - 1);
+			for (int i = 0; i < 4; ++i) {
+				size_t count = a.allocations;
+				TEST(!stenos_has_error(stenos_compress_generic(ctx, vec.data(), bytesoftype - 1, bytes2, dst.data(), dst.size())));
+				TEST(!stenos_has_error(stenos_compress_generic(ctx, vec.data(), bytesoftype, bytes, dst.data(), dst.size())));
+				if (i > 0)
+					TEST(a.allocations == count);
+			}
+		}
+
+		// All buffers are released with the custom allocator
+		stenos_destroy_context(ctx);
+		TEST(a.live == 0);
+	}
+
+	{
+		const size_t limit = 1000000;
+		CountingAllocator a;
+		auto ctx = stenos_make_context();
+		stenos_set_level(ctx, level);
+		stenos_set_threads(ctx, threads);
+		stenos_set_allocator(ctx, CountingAllocator::alloc, CountingAllocator::free, &a);
+		stenos_set_memory_limit(ctx, limit);
+
+		size_t r = stenos_compress_generic(ctx, vec.data(), bytesoftype, bytes, dst.data(), dst.size());
+		TEST(!stenos_has_error(r));
+		TEST(stenos_decompress_generic(ctx, dst.data(), bytesoftype, r, out.data(), bytes) == bytes);
+		TEST(memcmp(out.data(), vec.data(), bytes) == 0);
+		TEST(a.peak <= limit);
+		TEST(stenos_memory_footprint(ctx) > a.live);
+		stenos_destroy_context(ctx);
+		TEST(a.live == 0);
+	}
+}
+
+template<class T>
+void test_reduce(const std::vector<T>& vec, const char* distribution, int level, int threads, int index_type)
+{
+	// Compressed-domain reductions, compared to a scan of the input
+	using sum_type = typename std::conditional<std::is_floating_point<T>::value, double, typename std::conditional<std::is_signed<T>::value, int64_t, uint64_t>::type>::type;
+	const int type = std::is_floating_point<T>::value ? STENOS_REDUCE_FLOAT : (std::is_signed<T>::value ? STENOS_REDUCE_SIGNED : STENOS_REDUCE_UNSIGNED);
+	size_t bytesoftype = sizeof(T);
+	size_t bytes = vec.size() * bytesoftype;
+
+	auto ctx = stenos_make_context();
+	stenos_set_level(ctx, level);
+	stenos_set_threads(ctx, threads);
+	stenos_set_index(ctx, index_type);
+	size_t dst_size = stenos_context_bound(ctx, bytesoftype, bytes);
+	std::vector<char> dst(dst_size);
+	size_t r = stenos_compress_generic(ctx, vec.data(), bytesoftype, bytes, dst.data(), dst.size());
+	TEST(!stenos_has_error(r));
+
+	// Reference values
+	sum_type sum = 0;
+	uint64_t usum = 0;
+	double abs_sum = 0;
+	for (const T& v : vec) {
+		if (std::is_floating_point<T>::value)
+			sum += (sum_type)v;
+		else
+			usum += (uint64_t)(sum_type)v;
+		abs_sum += std::abs((double)v);
+	}
+	if (!std::is_floating_point<T>::value)
+		memcpy(&sum, &usum, sizeof(sum));
+	const T mn = *std::min_element(vec.begin(), vec.end());
+	const T mx = *std::max_element(vec.begin(), vec.end());
+	const T value = vec[vec.size() / 2];
+	const uint64_t equal = (uint64_t)std::count_if(vec.begin(), vec.end(), [&](const T& v) { return memcmp(&v, &value, sizeof(T)) == 0; });
+
+	sum_type s = 0;
+	TEST(stenos_reduce(ctx, dst.data(), bytesoftype, r, STENOS_REDUCE_SUM | type, nullptr, &s) == vec.size());
+	if (std::is_floating_point<T>::value) {
+		TEST(std::abs((double)(s - sum)) <= abs_sum * 1e-12);
+	}
+	else {
+		TEST(s == sum);
+	}
+	T m = T();
+	TEST(stenos_reduce(ctx, dst.data(), bytesoftype, r, STENOS_REDUCE_MIN | type, nullptr, &m) == vec.size());
+	TEST(m == mn);
+	TEST(stenos_reduce(ctx, dst.data(), bytesoftype, r, STENOS_REDUCE_MAX | type, nullptr, &m) == vec.size());
+	TEST(m == mx);
+	uint64_t c = 0;
+	TEST(stenos_reduce(ctx, dst.data(), bytesoftype, r, STENOS_REDUCE_COUNT_EQ | type, &value, &c) == vec.size());
+	TEST(c == equal);
+
+	// Value outside of the input range
+	if (!std::is_floating_point<T>::value && mx < std::numeric_limits<T>::max()) {
+		T none = (T)(mx + 1);
+		TEST(stenos_reduce(ctx, dst.data(), bytesoftype, r, STENOS_REDUCE_COUNT_EQ | type, &none, &c) == vec.size());
+		TEST(c == 0);
+	}
+
+	// Invalid parameters
+	TEST(stenos_reduce(ctx, dst.data(), bytesoftype, r, 0, nullptr, &c) == STENOS_ERROR_INVALID_PARAMETER);
+	TEST(stenos_reduce(ctx, dst.data(), bytesoftype, r, STENOS_REDUCE_COUNT_EQ, nullptr, &c) == STENOS_ERROR_INVALID_PARAMETER);
+	stenos_destroy_context(ctx);
+}
+
+template<size_t N>
+void test_reduce_count(const std::vector<std::array<char, N>>& vec, const char* distribution, int level, int threads)
+{
+	// STENOS_REDUCE_COUNT_EQ on elements of any size
+	size_t bytesoftype = N;
+	size_t bytes = vec.size() * bytesoftype;
+	size_t dst_size = stenos_bound(bytes);
+	std::vector<char> dst(dst_size);
+
+	auto ctx = stenos_make_context();
+	stenos_set_level(ctx, level);
+	stenos_set_threads(ctx, threads);
+	size_t r = stenos_compress_generic(ctx, vec.data(), bytesoftype, bytes, dst.data(), dst.size());
+	TEST(!stenos_has_error(r));
+
+	const std::array<char, N> value = vec[vec.size() / 3];
+	uint64_t c = 0;
+	TEST(stenos_reduce(ctx, dst.data(), bytesoftype, r, STENOS_REDUCE_COUNT_EQ, value.data(), &c) == vec.size());
+	TEST(c == (uint64_t)std::count(vec.begin(), vec.end(), value));
+	TEST(stenos_reduce(ctx, dst.data(), bytesoftype, r, STENOS_REDUCE_SUM, nullptr, &c) == STENOS_ERROR_INVALID_BYTESOFTYPE);
+	stenos_destroy_context(ctx);
+}
+
+template<class T>
+void test_append(const std::vector<T>& vec, const char* distribution, int level, int threads, int index_type, bool checksum)
+{
+	// Appending to a frame must give the same content as compressing at once,
+	// using the frame parameters instead of the context ones
+	size_t bytesoftype = sizeof(T);
+	size_t bytes = vec.size() * bytesoftype;
+	size_t dst_size = 0;
+
+	auto ctx = stenos_make_context();
+	stenos_set_index(ctx, index_type);
+	stenos_set_checksum(ctx, checksum);
+	auto edit = stenos_make_context();
+	stenos_set_level(edit, level);
+	stenos_set_threads(edit, threads);
+
+	std::vector<char> frame(stenos_context_bound(ctx, bytesoftype, 1000 * bytesoftype));
+	size_t size = stenos_compress_generic(ctx, vec.data(), bytesoftype, 1000 * bytesoftype, frame.data(), frame.size());
+	TEST(!stenos_has_error(size));
+	stenos_info first;
+	TEST(!stenos_has_error(stenos_get_info(frame.data(), bytesoftype, size, &first)));
+
+	std::vector<T> out(vec.size());
+	auto check = [&](size_t count) {
+		stenos_info info;
+		TEST(!stenos_has_error(stenos_get_info(frame.data(), bytesoftype, size, &info)));
+		TEST(info.decompressed_size == count * bytesoftype);
+		TEST(info.superblock_size == first.superblock_size);
+		TEST(info.index_type == index_type);
+		TEST(info.has_checksum == (int)checksum);
+		TEST(stenos_decompress_generic(ctx, frame.data(), bytesoftype, size, out.data(), count * bytesoftype) == count * bytesoftype);
+		TEST(memcmp(out.data(), vec.data(), count * bytesoftype) == 0);
+		if (checksum) {
+			TEST(stenos_verify(ctx, frame.data(), bytesoftype, size) == 0);
+		}
+		size_t offset = count / 3 * bytesoftype;
+		TEST(stenos_decompress_range(ctx, frame.data(), bytesoftype, size, offset, count * bytesoftype - offset, out.data()) == count * bytesoftype - offset);
+		TEST(memcmp(out.data(), vec.data() + count / 3, count * bytesoftype - offset) == 0);
+	};
+	check(1000);
+
+	std::mt19937 rng(level);
+	size_t count = 1000;
+	while (count < vec.size()) {
+		size_t n = std::min(vec.size() - count, (size_t)(rng() % 3 == 0 ? 1 + rng() % 10 : rng() % 150000));
+		size_t bound = stenos_append_bound(frame.data(), bytesoftype, size, n * bytesoftype);
+		TEST(!stenos_has_error(bound));
+		if (n > 1000) {
+			// Too small buffer: the frame must be left unchanged
+			TEST(stenos_append(edit, frame.data(), size, size + 16, vec.data() + count, bytesoftype, n * bytesoftype) == STENOS_ERROR_DST_OVERFLOW);
+			check(count);
+		}
+		frame.resize(bound);
+		size_t r = stenos_append(edit, frame.data(), size, frame.size(), vec.data() + count, bytesoftype, n * bytesoftype);
+		TEST(!stenos_has_error(r) && r <= bound);
+		size = r;
+		count += n;
+		check(count);
+	}
+
+	// Replace superblocks with the content of other superblocks
+	stenos_info info;
+	TEST(!stenos_has_error(stenos_get_info(frame.data(), bytesoftype, size, &info)));
+	std::vector<T> ref = vec;
+	for (size_t sb : { (size_t)0, info.superblock_count / 2, info.superblock_count - 1 }) {
+		stenos_superblock_info sinfo;
+		TEST(stenos_get_superblock_info(frame.data(), bytesoftype, size, sb, &sinfo) == 0);
+		size_t n = sinfo.decompressed_size / bytesoftype;
+		std::vector<T> content(n);
+		for (size_t i = 0; i < n; ++i)
+			content[i] = vec[(i * 7) % vec.size()];
+		TEST(stenos_replace_superblock(edit, frame.data(), size, frame.size(), sb, content.data(), bytesoftype, sinfo.decompressed_size + 1) ==
+		     STENOS_ERROR_INVALID_PARAMETER);
+		frame.resize(size + sinfo.decompressed_size + 8);
+		size_t r = stenos_replace_superblock(edit, frame.data(), size, frame.size(), sb, content.data(), bytesoftype, sinfo.decompressed_size);
+		TEST(!stenos_has_error(r));
+		size = r;
+		std::copy(content.begin(), content.end(), ref.begin() + sinfo.decompressed_offset / bytesoftype);
+
+		TEST(stenos_decompress_generic(ctx, frame.data(), bytesoftype, size, out.data(), bytes) == bytes);
+		TEST(memcmp(out.data(), ref.data(), bytes) == 0);
+		if (checksum) {
+			TEST(stenos_verify(ctx, frame.data(), bytesoftype, size) == 0);
+		}
+		TEST(stenos_get_superblock_info(frame.data(), bytesoftype, size, sb, &sinfo) == 0);
+		if (sinfo.min) {
+			T mn, mx;
+			memcpy(&mn, sinfo.min, sizeof(T));
+			memcpy(&mx, sinfo.max, sizeof(T));
+			TEST(mn == *std::min_element(content.begin(), content.end()));
+			TEST(mx == *std::max_element(content.begin(), content.end()));
+		}
+		// Following superblocks are located through the shifted index
+		if (sb + 1 < info.superblock_count) {
+			size_t offset = sinfo.decompressed_offset + sinfo.decompressed_size;
+			TEST(stenos_decompress_range(ctx, frame.data(), bytesoftype, size, offset, bytes - offset, out.data()) == bytes - offset);
+			TEST(memcmp(out.data(), (const char*)ref.data() + offset, bytes - offset) == 0);
+		}
+	}
+
+	stenos_destroy_context(ctx);
+	stenos_destroy_context(edit);
+}
+
+template<size_t N>
+void test_partial_block(int threads)
+{
+	// Block compression (level 1) of a trailing partial block (less than 256 elements) for wide types
+	using T = std::array<uint8_t, N>;
+	const char* distribution = "partial";
+	const int level = 1;
+	size_t bytesoftype = sizeof(T);
+	for (size_t count : { (size_t)100, (size_t)255, (size_t)(256 * 10 + 1), (size_t)(256 * 10 + 255) }) {
+		std::vector<T> vec(count);
+		for (size_t i = 0; i < count; ++i)
+			for (size_t j = 0; j < N; ++j)
+				vec[i][j] = (uint8_t)((i / 8 + j) & 7);
+		size_t bytes = count * bytesoftype;
+		size_t dst_size = stenos_bound(bytes);
+		std::vector<char> dst(dst_size);
+		std::vector<T> out(count);
+
+		auto ctx = stenos_make_context();
+		stenos_set_level(ctx, level);
+		stenos_set_threads(ctx, threads);
+		size_t r = stenos_compress_generic(ctx, vec.data(), bytesoftype, bytes, dst.data(), dst.size());
+		TEST(!stenos_has_error(r));
+		stenos_info info;
+		TEST(!stenos_has_error(stenos_get_info(dst.data(), bytesoftype, r, &info)));
+		stenos_superblock_info sinfo;
+		TEST(stenos_get_superblock_info(dst.data(), bytesoftype, r, info.superblock_count - 1, &sinfo) == 0);
+		TEST(sinfo.mode == STENOS_MODE_BLOCK);
+		TEST(stenos_decompress_generic(ctx, dst.data(), bytesoftype, r, out.data(), bytes) == bytes);
+		TEST(memcmp(out.data(), vec.data(), bytes) == 0);
+		stenos_destroy_context(ctx);
+	}
+}
+
+template<class T>
+void test_superblock_multiple(std::vector<T> vec, const char* distribution, int level, int threads)
+{
+	// Frames whose size is an exact multiple of the superblock size: the last superblock is a full one
+	size_t bytesoftype = sizeof(T);
+	size_t bytes = vec.size() * bytesoftype;
+	size_t dst_size = stenos_bound(bytes);
+	std::vector<char> dst(dst_size);
+
+	auto ctx = stenos_make_context();
+	stenos_set_level(ctx, level);
+	stenos_set_threads(ctx, threads);
+	size_t r = stenos_compress_generic(ctx, vec.data(), bytesoftype, bytes, dst.data(), dst.size());
+	TEST(!stenos_has_error(r));
+	stenos_info info;
+	TEST(!stenos_has_error(stenos_get_info(dst.data(), bytesoftype, r, &info)));
+	size_t superblocks = std::min(info.superblock_count - 1, (size_t)5);
+	TEST(superblocks > 0);
+
+	for (size_t count = 1; count <= superblocks; count += 2) {
+		bytes = count * info.superblock_size;
+		vec.resize(bytes / bytesoftype);
+		std::vector<T> out(vec.size());
+		r = stenos_compress_generic(ctx, vec.data(), bytesoftype, bytes, dst.data(), dst.size());
+		TEST(!stenos_has_error(r));
+		stenos_info info2;
+		TEST(!stenos_has_error(stenos_get_info(dst.data(), bytesoftype, r, &info2)));
+		TEST(info2.superblock_size == info.superblock_size && info2.superblock_count == count);
+		TEST(stenos_decompress_generic(ctx, dst.data(), bytesoftype, r, out.data(), bytes) == bytes);
+		TEST(memcmp(out.data(), vec.data(), bytes) == 0);
+	}
+	stenos_destroy_context(ctx);
+}
+
+template<class T>
+void test_reset_context(const std::vector<T>& vec, const char* distribution)
+{
+	// A reset context must produce the same frame as a new one
+	size_t bytesoftype = sizeof(T);
+	size_t bytes = vec.size() * bytesoftype;
+	size_t dst_size = stenos_bound(bytes);
+	int level = 1, threads = 1;
+	std::vector<char> ref(dst_size), dst(dst_size);
+
+	auto ctx = stenos_make_context();
+	size_t r = stenos_compress_generic(ctx, vec.data(), bytesoftype, bytes, ref.data(), ref.size());
+	TEST(!stenos_has_error(r));
+
+	const size_t fields[2] = { bytesoftype / 2, bytesoftype - bytesoftype / 2 };
+	stenos_set_level(ctx, 9);
+	stenos_set_threads(ctx, 4);
+	stenos_set_block_size(ctx, 2);
+	stenos_set_exhaustive_level(ctx, 2);
+	stenos_set_min_decompression_speed(ctx, 1000000000ull);
+	stenos_set_index(ctx, STENOS_INDEX_OFFSETS);
+	stenos_set_checksum(ctx, 1);
+	stenos_set_layout(ctx, fields, 2);
+	stenos_reset_context(ctx);
+
+	size_t r2 = stenos_compress_generic(ctx, vec.data(), bytesoftype, bytes, dst.data(), dst.size());
+	TEST(r2 == r && memcmp(dst.data(), ref.data(), r) == 0);
+	stenos_destroy_context(ctx);
+}
+
 int tests_comp_decomp(int, char*[])
 {
 
+	for (int level = 0; level <= 9; level += 3) {
+		printf("Test external executor with level %i...", level);
+		test_executor(generate_random_sorted<int>(1000000), "sorted", level);
+		printf("done\n");
+	}
+
+	stenos_pool* pool = stenos_make_pool(3);
+	for (int level = 0; level <= 9; level += 3) {
+		printf("Test concurrent compression with level %i...", level);
+		test_pool(generate_random_sorted<int>(1000000), "sorted", level, pool);
+		test_pool(generate_random_sorted<int>(1000000), "sorted", level, nullptr);
+		printf("done\n");
+	}
+	stenos_destroy_pool(pool);
+
+	for (int level = 0; level <= 9; level += 3) {
+		printf("Test multithreaded compression with level %i...", level);
+		test_multithread(generate_random_sorted<int>(2000000), "sorted", level);
+		test_multithread(generate_random<std::array<char, 6>>(500000), "random", level);
+		printf("done\n");
+	}
+
+	for (int level = 3; level <= 9; level += 2) {
+		printf("Test sampled mode selection with level %i...", level);
+		test_exhaustive_level(generate_random_sorted<int>(1000000), "sorted", level);
+		test_exhaustive_level(generate_random<std::array<char, 6>>(300000), "random", level);
+		test_exhaustive_level(generate_random_sorted<double>(250000), "sorted", level);
+		test_exhaustive_level(generate_random_sorted<char>(1000000), "sorted", level);
+		printf("done\n");
+	}
+
+	for (int level = 0; level <= 9; level += 3) {
+		printf("Test compression statistics with level %i...", level);
+		test_stats(generate_random_sorted<int>(1000000), "sorted", level, 1);
+		test_stats(generate_random<std::array<char, 3>>(300000), "random", level, 4);
+		test_stats(generate_same<uint16_t>(100000), "same", level, 4);
+		printf("done\n");
+	}
+
+	for (int level = 1; level <= 9; level += 4) {
+		printf("Test minimum decompression speed with level %i...", level);
+		test_min_decompression_speed(generate_random_sorted<int>(1000000), "sorted", level, 1);
+		test_min_decompression_speed(generate_random<std::array<char, 3>>(300000), "random", level, 4);
+		test_min_decompression_speed(generate_random_sorted<char>(1000000), "sorted", level, 1);
+		printf("done\n");
+	}
+
+	for (int level = 3; level <= 7; level += 2) {
+		printf("Test XOR floating point mode with level %i...", level);
+		test_xor_mode(generate_sensor<double>(300000), "sensor", level, 1);
+		test_xor_mode(generate_sensor<double>(300000), "sensor", level, 4);
+		printf("done\n");
+	}
+
+	for (int level = 3; level <= 9; level += 3) {
+		printf("Test integer delta mode with level %i...", level);
+		test_int_delta_mode(generate_timestamps<int64_t>(300000), "timestamps", level, 1);
+		test_int_delta_mode(generate_timestamps<int64_t>(300000), "timestamps", level, 4);
+		test_int_delta_mode(generate_timestamps<uint32_t>(300000), "timestamps", level, 1);
+		test_int_delta_mode(generate_timestamps<uint16_t>(300000), "timestamps", level, 1);
+		printf("done\n");
+	}
+
+	for (int level = 1; level <= 9; level += 4) {
+		printf("Test scatter-gather compression with level %i...", level);
+		test_iovec(generate_random_sorted<int>(1000000), "sorted", level, 1, STENOS_INDEX_NONE);
+		test_iovec(generate_random_sorted<int>(1000000), "sorted", level, 4, STENOS_INDEX_MINMAX_SIGNED);
+		test_iovec(generate_random<std::array<char, 3>>(300000), "random", level, 4, STENOS_INDEX_OFFSETS);
+		printf("done\n");
+	}
+
+	for (int level = 1; level <= 9; level += 4) {
+		printf("Test compressed-domain reductions with level %i...", level);
+		test_reduce(generate_status<int32_t>(1000000), "status", level, 1, STENOS_INDEX_NONE);
+		test_reduce(generate_status<int32_t>(1000000), "status", level, 4, STENOS_INDEX_MINMAX_SIGNED);
+		test_reduce(generate_status<uint16_t>(1000000), "status", level, 4, STENOS_INDEX_MINMAX_UNSIGNED);
+		test_reduce(generate_status<int64_t>(300000), "status", level, 1, STENOS_INDEX_OFFSETS);
+		test_reduce(generate_random_sorted<int>(1000000), "sorted", level, 4, STENOS_INDEX_NONE);
+		test_reduce(generate_random<uint8_t>(1000000), "random", level, 1, STENOS_INDEX_NONE);
+		test_reduce(generate_sensor<float>(300000), "sensor", level, 4, STENOS_INDEX_MINMAX_FLOAT);
+		test_reduce(generate_sensor<double>(300000), "sensor", level, 1, STENOS_INDEX_NONE);
+		test_reduce_count(generate_random_subpart<std::array<char, 3>, 0, 1>(300000), "random", level, 4);
+		printf("done\n");
+	}
+
+	for (int level = 1; level <= 9; level += 4) {
+		printf("Test frame append and superblock replacement with level %i...", level);
+		test_append(generate_random_sorted<int>(1000000), "sorted", level, 1, STENOS_INDEX_NONE, false);
+		test_append(generate_random_sorted<int>(1000000), "sorted", level, 4, STENOS_INDEX_MINMAX_SIGNED, true);
+		test_append(generate_status<uint16_t>(1000000), "status", level, 4, STENOS_INDEX_OFFSETS, false);
+		test_append(generate_sensor<double>(300000), "sensor", level, 1, STENOS_INDEX_MINMAX_FLOAT, true);
+		printf("done\n");
+	}
+
+	printf("Test partial block compression of wide types...");
+	test_partial_block<16>(1);
+	test_partial_block<16>(4);
+	test_partial_block<40>(1);
+	printf("done\n");
+
+	for (int level = 1; level <= 9; level += 4) {
+		printf("Test frames made of full superblocks with level %i...", level);
+		test_superblock_multiple(generate_random_sorted<int>(1000000), "sorted", level, 1);
+		test_superblock_multiple(generate_random_sorted<int>(1000000), "sorted", level, 4);
+		printf("done\n");
+	}
+
+	printf("Test context reset...");
+	test_reset_context(generate_random_sorted<int>(1000000), "sorted");
+	printf("done\n");
+
+	for (int level = 1; level <= 9; level += 4) {
+		printf("Test custom allocator and memory limit with level %i...", level);
+		test_allocator(generate_random_sorted<int>(1000000), "sorted", level, 1);
+		test_allocator(generate_random_sorted<int>(1000000), "sorted", level, 4);
+		printf("done\n");
+	}
+
+	for (int level = 1; level <= 9; level += 4) {
+		printf("Test batch compression with level %i...", level);
+		test_batch(generate_random_sorted<int>(1000000), "sorted", level, 1, false);
+		test_batch(generate_random_sorted<int>(1000000), "sorted", level, 4, true);
+		test_batch(generate_timestamps<int64_t>(300000), "timestamps", level, 4, false);
+		printf("done\n");
+	}
+
+	for (int level = 2; level <= 8; level += 3) {
+		printf("Test field layout with level %i...", level);
+		const size_t fields[3] = { 8, 4, 2 };
+		test_layout(generate_records(300000), fields, 3, "records", level, 1);
+		test_layout(generate_records(300000), fields, 3, "records", level, 4);
+		printf("done\n");
+	}
+
+	for (int threads = 1; threads <= 4; threads += 3) {
+		printf("Test rate model calibration with %i threads...", threads);
+		test_rate_model(generate_random_sorted<int>(1000000), "sorted", threads);
+		test_rate_model(generate_random<std::array<char, 3>>(100000), "random", threads);
+		printf("done\n");
+	}
+
+	for (int level = 0; level <= 9; level += 3) {
+		printf("Test streaming with level %i...", level);
+		test_stream(generate_random_sorted<std::array<char, 4>>(300000), "sorted", level);
+		test_stream(generate_random<std::array<char, 3>>(100000), "random", level);
+		test_stream(generate_same<std::array<char, 8>>(77777), "same", level);
+		test_stream(generate_random_sorted<char>(0), "sorted", level);
+		printf("done\n");
+	}
+
+	for (int threads = 1; threads <= 4; threads += 3) {
+		for (int level = 0; level <= 9; level += 3) {
+			printf("Test superblock index with level %i, %i threads...", level, threads);
+			test_index(generate_random_sorted<int>(1000000), "sorted", level, threads, STENOS_INDEX_MINMAX_SIGNED);
+			test_index(generate_random<uint16_t>(300000), "random", level, threads, STENOS_INDEX_MINMAX_UNSIGNED);
+			auto ints = generate_random<int>(200000);
+			test_index(std::vector<double>(ints.begin(), ints.end()), "random", level, threads, STENOS_INDEX_MINMAX_FLOAT);
+			test_index(generate_random_sorted<std::array<char, 3>>(100000), "sorted", level, threads, STENOS_INDEX_OFFSETS);
+			test_index(generate_same<std::array<char, 5>>(100000), "same", level, threads, STENOS_INDEX_NONE);
+			test_index(generate_same<int>(0), "same", level, threads, STENOS_INDEX_OFFSETS);
+			printf("done\n");
+		}
+	}
+
+	for (int threads = 1; threads <= 4; threads += 3) {
+		for (int level = 0; level <= 9; level += 3) {
+			printf("Test checksums with level %i, %i threads...", level, threads);
+			test_checksum(generate_random_sorted<int>(1000000), "sorted", level, threads, STENOS_INDEX_NONE);
+			test_checksum(generate_random<std::array<char, 3>>(100000), "random", level, threads, STENOS_INDEX_OFFSETS);
+			test_checksum(generate_same<uint16_t>(100000), "same", level, threads, STENOS_INDEX_MINMAX_UNSIGNED);
+			test_checksum(generate_same<int>(0), "same", level, threads, STENOS_INDEX_NONE);
+			printf("done\n");
+		}
+	}
+
+	for (int threads = 1; threads <= 4; threads += 3) {
+		for (int level = 0; level <= 9; level += 3) {
+			printf("Test dictionaries with level %i, %i threads...", level, threads);
+			test_dictionary<int>("records", level, threads);
+			test_dictionary<uint16_t>("records", level, threads);
+			test_dictionary<std::array<char, 3>>("records", level, threads);
+			printf("done\n");
+		}
+	}
+
 	TestDistribution<1, 16>::apply("same");
 	TestDistribution<1, 16>::apply("sorted");
 	TestDistribution<1, 16>::apply("random");